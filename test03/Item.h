@@ -10,13 +10,20 @@ public:
     // 构造函数：工具类物品（不可堆叠，数量固定为 1）
     Item(const QString &name, const QString &toolType, const QString &desc, const QPixmap &icon)
         : m_name(name), m_toolType(toolType), m_desc(desc), m_icon(icon), m_count(1) {}
+    // 由 ItemDatabase 创建：带上编译好的类型编号和拼好的使用提示
+    Item(const QString &name, const QString &toolType, const QString &desc, const QPixmap &icon,
+         int typeId, const QString &useText)
+        : m_name(name), m_toolType(toolType), m_desc(desc), m_icon(icon), m_count(1),
+          m_typeId(typeId), m_useText(useText) {}
 
     // Getter 方法
     QString name() const { return m_name; }       // 物品名称（如“生锈的菜刀”）
-    QString toolType() const { return m_toolType; } // 工具类型（菜刀/锅铲/汤勺，统一标识）
+    QString toolType() const { return m_toolType; } // 工具类型（菜刀/锅铲/汤勺……，统一标识）
     QString description() const { return m_desc; }  // 工具描述（如“砍树专用”）
     QPixmap icon() const { return m_icon; }
     int count() const { return m_count; }         // 工具不可堆叠，数量固定为 1
+    int typeId() const { return m_typeId; }       // ItemDatabase 里的类型编号，-1 表示没有
+    QString useText() const { return m_useText; } // 使用时显示的提示
 
     // 工具类物品不可修改数量（重写 setCount 禁止堆叠）
     void setCount(int count) { m_count = 1; } // 强制数量为 1
@@ -28,10 +35,12 @@ public:
 
 private:
     QString m_name;        // 物品名称（如“锋利的锅铲”）
-    QString m_toolType;    // 核心：工具类型（仅支持“菜刀”“锅铲”“汤勺”）
+    QString m_toolType;    // 核心：工具类型（数据文件 items.json 里定义）
     QString m_desc;        // 工具功能描述
     QPixmap m_icon;        // 工具图标
     int m_count = 0;       // 数量（工具固定为 1）
+    int m_typeId = -1;     // 类型编号（ItemDatabase 加载时分配）
+    QString m_useText;     // “使用【名称】→ 描述（动作）”
 };
 
 #endif // ITEM_H
@@ -0,0 +1,319 @@
+// assetpack.cpp - 单文件资源包实现
+#include "assetpack.h"
+#include "tracing.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QBuffer>
+#include <QImageReader>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#if Q_BYTE_ORDER != Q_LITTLE_ENDIAN
+#error "AssetPack maps little-endian pack files directly"
+#endif
+
+namespace {
+const char MAGIC[4] = { 'L', 'Z', 'P', 'K' };
+const qint64 DATA_ALIGN = 16;
+}
+
+AssetPack &AssetPack::instance()
+{
+    static AssetPack pack;
+    return pack;
+}
+
+quint64 AssetPack::hashName(const QByteArray &name)
+{
+    quint64 h = 14695981039346656037ULL;   // FNV-1a 64
+    for (char c : name)
+    {
+        h ^= quint8(c);
+        h *= 1099511628211ULL;
+    }
+    return h ? h : 1;   // 0 留给空槽
+}
+
+bool AssetPack::mount(const QString &packFile, const QString &rootDir)
+{
+    unmount();
+
+    QElapsedTimer timer;
+    timer.start();
+    m_file.setFileName(packFile);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Cannot open asset pack" << packFile;
+        return false;
+    }
+    m_fileOpens.fetchAndAddRelaxed(1);
+
+    m_size = m_file.size();
+    m_base = m_size >= qint64(sizeof(PackHeader)) ? m_file.map(0, m_size) : nullptr;
+    m_ioNs.fetchAndAddRelaxed(timer.nsecsElapsed());
+    if (!m_base)
+    {
+        qWarning() << "Cannot map asset pack" << packFile;
+        unmount();
+        return false;
+    }
+
+    // 只检查头和索引是否越界；条目本身在查找时再检查
+    m_header = reinterpret_cast<const PackHeader *>(m_base);
+    const quint64 tableBytes = quint64(m_header->tableSize) * sizeof(PackEntry);
+    if (memcmp(m_header->magic, MAGIC, 4) != 0 || m_header->version != VERSION ||
+        m_header->tableSize == 0 || (m_header->tableSize & (m_header->tableSize - 1)) != 0 ||
+        m_header->tableOffset % alignof(PackEntry) != 0 ||
+        m_header->tableOffset + tableBytes > quint64(m_size) || m_header->namesOffset > quint64(m_size))
+    {
+        qWarning() << "Invalid asset pack" << packFile;
+        unmount();
+        return false;
+    }
+    m_table = reinterpret_cast<const PackEntry *>(m_base + m_header->tableOffset);
+    m_names = reinterpret_cast<const char *>(m_base + m_header->namesOffset);
+    m_root = QDir::cleanPath(QDir::fromNativeSeparators(rootDir));
+
+    qDebug() << "Mounted asset pack" << packFile << "with" << m_header->entryCount << "entries";
+    return true;
+}
+
+void AssetPack::unmount()
+{
+    if (m_base)
+        m_file.unmap(const_cast<uchar *>(m_base));
+    m_file.close();
+    m_base = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_table = nullptr;
+    m_names = nullptr;
+    m_root.clear();
+}
+
+QString AssetPack::entryName(const QString &path) const
+{
+    const QString clean = QDir::cleanPath(QDir::fromNativeSeparators(path));
+    if (m_root.isEmpty() || QDir::isRelativePath(clean))
+        return clean;
+    return QDir(m_root).relativeFilePath(clean);
+}
+
+const PackEntry *AssetPack::find(const QByteArray &name) const
+{
+    if (!m_table)
+        return nullptr;
+
+    const quint64 h = hashName(name);
+    const quint32 mask = m_header->tableSize - 1;
+    for (quint32 i = quint32(h) & mask, n = 0; n < m_header->tableSize; i = (i + 1) & mask, ++n)
+    {
+        const PackEntry &e = m_table[i];
+        if (e.hash == 0)
+            return nullptr;   // 空槽：不存在
+        if (e.hash == h && e.nameLength == quint32(name.size()) &&
+            m_header->namesOffset + e.nameOffset + e.nameLength <= quint64(m_size) &&
+            memcmp(m_names + e.nameOffset, name.constData(), size_t(name.size())) == 0)
+        {
+            if (e.offset + e.size > quint64(m_size))
+                return nullptr;
+            return &e;
+        }
+    }
+    return nullptr;
+}
+
+bool AssetPack::contains(const QString &path) const
+{
+    return find(entryName(path).toUtf8()) != nullptr;
+}
+
+bool AssetPack::exists(const QString &path) const
+{
+    return contains(path) || QFileInfo::exists(path);
+}
+
+QByteArray AssetPack::readLoose(const QString &path)
+{
+    TRACE_SCOPE("AssetPack::readLoose");
+    QElapsedTimer timer;
+    timer.start();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    QByteArray bytes = file.readAll();
+    m_fileOpens.fetchAndAddRelaxed(1);
+    m_looseReads.fetchAndAddRelaxed(1);
+    m_bytes.fetchAndAddRelaxed(bytes.size());
+    m_ioNs.fetchAndAddRelaxed(timer.nsecsElapsed());
+    return bytes;
+}
+
+bool AssetPack::writeLoose(const QString &path, const QByteArray &bytes)
+{
+    TRACE_SCOPE("AssetPack::writeLoose");
+    QElapsedTimer timer;
+    timer.start();
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    const bool ok = file.write(bytes) == bytes.size() && file.commit();
+    m_fileOpens.fetchAndAddRelaxed(1);
+    m_looseWrites.fetchAndAddRelaxed(1);
+    m_bytesWritten.fetchAndAddRelaxed(ok ? bytes.size() : 0);
+    m_ioNs.fetchAndAddRelaxed(timer.nsecsElapsed());
+    return ok;
+}
+
+QByteArray AssetPack::data(const QString &path)
+{
+    if (const PackEntry *e = find(entryName(path).toUtf8()))
+    {
+        m_packReads.fetchAndAddRelaxed(1);
+        m_bytes.fetchAndAddRelaxed(qint64(e->size));
+        // 直接指向映射内存，不拷贝；资源包在 unmount 之前一直有效
+        return QByteArray::fromRawData(reinterpret_cast<const char *>(m_base + e->offset), int(e->size));
+    }
+    return readLoose(path);
+}
+
+QImage AssetPack::image(const QString &path)
+{
+    const QByteArray bytes = data(path);
+    if (bytes.isNull())
+        return QImage();
+
+    TRACE_SCOPE("AssetPack::decodeImage");
+    QElapsedTimer timer;
+    timer.start();
+    QImage img = QImage::fromData(bytes, QFileInfo(path).suffix().toLatin1().constData());
+    m_decodeNs.fetchAndAddRelaxed(timer.nsecsElapsed());
+    return img;
+}
+
+QPixmap AssetPack::pixmap(const QString &path)
+{
+    TRACE_SCOPE("AssetPack::pixmap");
+    return QPixmap::fromImage(image(path));
+}
+
+QSize AssetPack::imageSize(const QString &path)
+{
+    TRACE_SCOPE("AssetPack::imageSize");
+    QByteArray bytes = data(path);
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    return QImageReader(&buffer, QFileInfo(path).suffix().toLatin1()).size();
+}
+
+AssetPack::Stats AssetPack::stats() const
+{
+    Stats s;
+    s.fileOpens = m_fileOpens.loadAcquire();
+    s.packReads = m_packReads.loadAcquire();
+    s.looseReads = m_looseReads.loadAcquire();
+    s.looseWrites = m_looseWrites.loadAcquire();
+    s.bytes = m_bytes.loadAcquire();
+    s.bytesWritten = m_bytesWritten.loadAcquire();
+    s.ioNs = m_ioNs.loadAcquire();
+    s.decodeNs = m_decodeNs.loadAcquire();
+    return s;
+}
+
+void AssetPack::resetStats()
+{
+    m_fileOpens.storeRelease(0);
+    m_packReads.storeRelease(0);
+    m_looseReads.storeRelease(0);
+    m_looseWrites.storeRelease(0);
+    m_bytes.storeRelease(0);
+    m_bytesWritten.storeRelease(0);
+    m_ioNs.storeRelease(0);
+    m_decodeNs.storeRelease(0);
+}
+
+bool AssetPack::write(const QString &packFile, const QString &rootDir, const QStringList &files)
+{
+    QFile out(packFile);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Cannot write asset pack" << packFile;
+        return false;
+    }
+
+    const QDir root(QDir::cleanPath(QDir::fromNativeSeparators(rootDir)));
+    QVector<PackEntry> entries;
+    QByteArray names;
+    QStringList seen;
+
+    // 1. 头先占位，写完数据后再回填
+    PackHeader header;
+    memset(&header, 0, sizeof(header));
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    // 2. 数据区
+    for (const QString &f : files)
+    {
+        const QString clean = QDir::cleanPath(QDir::fromNativeSeparators(f));
+        const QString name = root.relativeFilePath(clean);
+        if (seen.contains(name))
+            continue;
+        seen.append(name);
+
+        QFile in(clean);
+        if (!in.open(QIODevice::ReadOnly))
+        {
+            qWarning() << "Cannot read asset" << clean;
+            return false;
+        }
+        const QByteArray bytes = in.readAll();
+
+        const qint64 pad = (DATA_ALIGN - out.pos() % DATA_ALIGN) % DATA_ALIGN;
+        out.write(QByteArray(int(pad), '\0'));
+
+        const QByteArray utf8 = name.toUtf8();
+        PackEntry e;
+        e.hash = hashName(utf8);
+        e.offset = quint64(out.pos());
+        e.size = quint64(bytes.size());
+        e.nameOffset = quint32(names.size());
+        e.nameLength = quint32(utf8.size());
+        entries.append(e);
+        names.append(utf8);
+        out.write(bytes);
+    }
+
+    // 3. 名字区
+    header.namesOffset = quint64(out.pos());
+    out.write(names);
+
+    // 4. 哈希索引：容量取不小于条目数 2 倍的 2 的幂，线性探测
+    quint32 tableSize = 8;
+    while (tableSize < quint32(entries.size()) * 2)
+        tableSize *= 2;
+    QVector<PackEntry> table(int(tableSize));
+    memset(table.data(), 0, table.size() * sizeof(PackEntry));
+    for (const PackEntry &e : entries)
+    {
+        quint32 i = quint32(e.hash) & (tableSize - 1);
+        while (table[int(i)].hash != 0)
+            i = (i + 1) & (tableSize - 1);
+        table[int(i)] = e;
+    }
+    const qint64 pad = (qint64(alignof(PackEntry)) - out.pos() % alignof(PackEntry)) % alignof(PackEntry);
+    out.write(QByteArray(int(pad), '\0'));
+    header.tableOffset = quint64(out.pos());
+    out.write(reinterpret_cast<const char *>(table.constData()), table.size() * int(sizeof(PackEntry)));
+
+    // 5. 回填头
+    memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    header.entryCount = quint32(entries.size());
+    header.tableSize = tableSize;
+    out.seek(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    qDebug() << "Wrote asset pack" << packFile << "with" << entries.size() << "entries," << out.size() << "bytes";
+    return out.error() == QFileDevice::NoError;
+}
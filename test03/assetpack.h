@@ -0,0 +1,117 @@
+// assetpack.h - 单文件资源包
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QImage>
+#include <QPixmap>
+#include <QAtomicInteger>
+
+/*
+ 资源包格式（小端，所有结构按自然对齐写入，读取时直接映射，不做解析）：
+   PackHeader
+   数据区      每个文件原样存放（PNG 不解压），起始位置按 16 字节对齐
+   名字区      UTF-8 的相对路径，'/' 分隔，无结尾 0
+   索引        tableSize 个 PackEntry 组成的开放寻址哈希表（线性探测，hash 为 0 表示空槽）
+ 名字是相对于资源根目录的路径（可以以 ../ 开头），hash 为名字的 64 位 FNV-1a。
+*/
+struct PackHeader
+{
+    char magic[4];          // "LZPK"
+    quint32 version;
+    quint32 entryCount;
+    quint32 tableSize;      // 2 的幂
+    quint64 tableOffset;
+    quint64 namesOffset;
+};
+
+struct PackEntry
+{
+    quint64 hash;
+    quint64 offset;
+    quint64 size;
+    quint32 nameOffset;     // 相对名字区
+    quint32 nameLength;
+};
+
+/*
+ AssetPack：游戏读取资源的唯一入口
+ - mount() 之后整个资源包只打开一次并映射到内存；查找走哈希索引，不遍历
+ - data() 返回直接指向映射内存的 QByteArray（fromRawData，不拷贝），图片在用到时才解码
+ - 资源包里没有的路径退回到读磁盘上的散文件，没有资源包时行为与以前一样
+ - 统计文件打开次数、读取字节数和耗时，用于报告冷启动 I/O；游戏自己生成的缓存（.mipcache）
+   也经过这里读写，一起计入
+ data() / image() 可以在后台线程调用（预加载地图时），mount() / unmount() 只能在主线程、
+ 没有后台读取时调用。
+*/
+class AssetPack
+{
+public:
+    static const quint32 VERSION = 1;
+
+    struct Stats
+    {
+        int fileOpens = 0;      // 打开的文件数（资源包本身算一次）
+        int packReads = 0;      // 从资源包取到的条目数
+        int looseReads = 0;     // 退回读散文件的次数
+        int looseWrites = 0;    // 写散文件（缓存）的次数
+        qint64 bytes = 0;       // 读取的字节数（资源包按条目大小计）
+        qint64 bytesWritten = 0;
+        qint64 ioNs = 0;        // 打开 / 映射 / 读写文件的耗时
+        qint64 decodeNs = 0;    // 解码图片的耗时（资源包的缺页读盘也算在这里）
+    };
+
+    static AssetPack &instance();
+
+    /* 映射资源包；rootDir 是打包时的资源根目录，游戏里的绝对路径按它换算成包内名字 */
+    bool mount(const QString &packFile, const QString &rootDir);
+    void unmount();
+    bool isMounted() const { return m_base != nullptr; }
+
+    /* 路径 → 包内名字 */
+    QString entryName(const QString &path) const;
+    bool contains(const QString &path) const;
+    bool exists(const QString &path) const;   // 包内或磁盘上存在
+
+    /* 读取资源；失败返回空 QByteArray */
+    QByteArray data(const QString &path);
+    QImage image(const QString &path);
+    QPixmap pixmap(const QString &path);      // 只能在主线程调用
+    QSize imageSize(const QString &path);     // 只读图片头
+    /* 写磁盘上的散文件（游戏生成的缓存）：先写临时文件再替换，几个线程同时写同一个文件也不会写出半个 */
+    bool writeLoose(const QString &path, const QByteArray &bytes);
+
+    Stats stats() const;
+    void resetStats();
+
+    /* 打包：把 files（绝对路径）按相对 rootDir 的名字写进 packFile */
+    static bool write(const QString &packFile, const QString &rootDir, const QStringList &files);
+    static quint64 hashName(const QByteArray &name);
+
+private:
+    AssetPack() = default;
+    const PackEntry *find(const QByteArray &name) const;
+    QByteArray readLoose(const QString &path);
+
+    QFile m_file;
+    const uchar *m_base = nullptr;
+    qint64 m_size = 0;
+    const PackHeader *m_header = nullptr;
+    const PackEntry *m_table = nullptr;
+    const char *m_names = nullptr;
+    QString m_root;
+
+    QAtomicInteger<int> m_fileOpens;
+    QAtomicInteger<int> m_packReads;
+    QAtomicInteger<int> m_looseReads;
+    QAtomicInteger<int> m_looseWrites;
+    QAtomicInteger<qint64> m_bytes;
+    QAtomicInteger<qint64> m_bytesWritten;
+    QAtomicInteger<qint64> m_ioNs;
+    QAtomicInteger<qint64> m_decodeNs;
+};
+
+#endif // ASSETPACK_H
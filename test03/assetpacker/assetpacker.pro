@@ -0,0 +1,24 @@
+# assetpacker.pro - 资源打包工具（构建时使用，与 test02.pro 分开构建）
+# 用法：qmake assetpacker.pro && make
+#       ./assetpacker --root E:/tiled/myexmples --out game.pak --map c.tmx caidao.png guochan.png mushao.png
+QT += core gui xml
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = assetpacker
+TEMPLATE = app
+
+# 打包格式与游戏共用同一份实现
+INCLUDEPATH += ..
+
+# 源文件
+SOURCES += \
+    main.cpp \
+    ../assetpack.cpp
+
+# 头文件
+HEADERS += \
+    ../assetpack.h
+
+# 语言标准
+QMAKE_CXXFLAGS += -std=c++11
@@ -0,0 +1,85 @@
+// main.cpp - 资源打包工具入口
+// 把地图（连同它引用的 TSX 和图块集图片）以及其他散文件打进一个资源包
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+#include "assetpack.h"
+
+namespace {
+/* 收集 XML（TMX / TSX）里引用的文件：<tileset source> 和 <image source>，路径相对于该文件 */
+bool collectDependencies(const QString &file, QStringList &files)
+{
+    QFile f(file);
+    QDomDocument doc;
+    if (!f.open(QIODevice::ReadOnly) || !doc.setContent(&f))
+    {
+        qWarning() << "Cannot parse" << file;
+        return false;
+    }
+
+    const QDir dir = QFileInfo(file).absoluteDir();
+    const QDomNodeList tilesets = doc.elementsByTagName("tileset");
+    for (int i = 0; i < tilesets.size(); ++i)
+    {
+        const QString source = tilesets.at(i).toElement().attribute("source");
+        if (source.isEmpty())
+            continue;
+        const QString tsx = QDir::cleanPath(dir.absoluteFilePath(source));
+        if (files.contains(tsx))
+            continue;
+        files.append(tsx);
+        if (!collectDependencies(tsx, files))
+            return false;
+    }
+
+    const QDomNodeList images = doc.elementsByTagName("image");
+    for (int i = 0; i < images.size(); ++i)
+    {
+        const QString source = images.at(i).toElement().attribute("source");
+        const QString image = QDir::cleanPath(dir.absoluteFilePath(source));
+        if (!source.isEmpty() && !files.contains(image))
+            files.append(image);
+    }
+    return true;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName("assetpacker");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("LZU_GAME asset packer");
+    parser.addHelpOption();
+    QCommandLineOption rootOpt("root", "Asset root directory (the game resolves paths relative to it).", "dir");
+    QCommandLineOption outOpt("out", "Pack file to write.", "file", "game.pak");
+    QCommandLineOption mapOpt("map", "Map to pack together with its tilesets and images (repeatable).", "tmx");
+    parser.addOptions({ rootOpt, outOpt, mapOpt });
+    parser.addPositionalArgument("files", "Other files to pack, relative to --root.");
+    parser.process(app);
+
+    if (!parser.isSet(rootOpt))
+    {
+        qCritical() << "--root is required";
+        return 1;
+    }
+    const QDir root(parser.value(rootOpt));
+
+    QStringList files;
+    for (const QString &map : parser.values(mapOpt))
+    {
+        const QString tmx = QDir::cleanPath(root.absoluteFilePath(map));
+        files.append(tmx);
+        if (!collectDependencies(tmx, files))
+            return 1;
+    }
+    for (const QString &f : parser.positionalArguments())
+        files.append(QDir::cleanPath(root.absoluteFilePath(f)));
+
+    return AssetPack::write(parser.value(outOpt), root.absolutePath(), files) ? 0 : 1;
+}
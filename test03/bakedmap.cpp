@@ -0,0 +1,398 @@
+// bakedmap.cpp - 按区块预先合成的地图图像实现
+#include "bakedmap.h"
+#include "tmxmap.h"
+#include "assetpack.h"
+#include "mipmap.h"
+#include "tracing.h"
+#include <QPainter>
+#include <QDir>
+#include <QSet>
+#include <QDebug>
+
+// bake() 用 LayerData::hasBlock 跳过空区块，要求区块与稀疏块一样大
+static_assert(BakedMap::CHUNK_TILES == LayerData::BLOCK_SIZE, "baked chunks must match sparse layer blocks");
+
+namespace {
+/* 逐像素检查图块的 alpha（图片已转成预乘 ARGB32，alpha 在每个像素的最高字节） */
+BakedMap::TileOpacity classifyTile(const QImage &atlas, const QRect &source)
+{
+    // 裁剪区域超出图片的部分画不出来，盖不住下面
+    const QRect r = source.intersected(atlas.rect());
+    if (r.isEmpty())
+        return BakedMap::Transparent;
+
+    bool anyOpaque = false, anyClear = false;
+    for (int y = r.top(); y <= r.bottom(); ++y)
+    {
+        const QRgb *line = reinterpret_cast<const QRgb *>(atlas.constScanLine(y));
+        for (int x = r.left(); x <= r.right(); ++x)
+        {
+            const int a = qAlpha(line[x]);
+            if (a == 255)
+                anyOpaque = true;
+            else if (a == 0)
+                anyClear = true;
+            else
+                return BakedMap::Translucent;
+            if (anyOpaque && anyClear)
+                return BakedMap::Translucent;
+        }
+    }
+    if (!anyOpaque)
+        return BakedMap::Transparent;
+    return r == source ? BakedMap::Opaque : BakedMap::Translucent;
+}
+}
+
+BakedMap::BakedMap(const TmxMap *map) : m_map(map)
+{
+    // 分组：只有相邻的静态图层才能合并，中间夹着 dynamic 图层时前后分开，保证叠放顺序不变
+    const int entity = map->entityLayerIndex();
+    for (int l = 0; l < map->layerCount(); ++l)
+    {
+        const bool mergeable = l < entity && !map->layer(l).dynamic;
+        if (mergeable && !m_groups.isEmpty() && m_groups.last().merged)
+        {
+            m_groups.last().last = l;
+        }
+        else
+        {
+            Group g;
+            g.first = g.last = l;
+            g.merged = mergeable;
+            g.aboveEntities = l >= entity;
+            m_groups.append(g);
+        }
+        m_groupOfLayer.append(m_groups.size() - 1);
+    }
+    if (m_groups.size() < map->layerCount())
+        qDebug() << "Flattened" << map->layerCount() << "layers into" << m_groups.size() << "draw groups";
+
+    // 缩小后的瓦片边长仍要是整数，图块集里的裁剪区域才能对齐
+    while (m_maxMipLevels < Mipmap::MAX_LEVEL &&
+           map->m_tileWidth % (2 << m_maxMipLevels) == 0 && map->m_tileHeight % (2 << m_maxMipLevels) == 0)
+        ++m_maxMipLevels;
+    m_mipLevels = m_maxMipLevels;
+
+    m_chunksX = (map->m_mapWidth + CHUNK_TILES - 1) / CHUNK_TILES;
+    m_chunksY = (map->m_mapHeight + CHUNK_TILES - 1) / CHUNK_TILES;
+    const int count = (m_maxMipLevels + 1) * m_groups.size() * m_chunksX * m_chunksY;
+    m_chunks.resize(count);
+    m_baked.fill(0, count);
+}
+
+void BakedMap::setMipLevels(int levels)
+{
+    m_mipLevels = qBound(0, levels, m_maxMipLevels);
+}
+
+int BakedMap::levelForScale(qreal scale) const
+{
+    int level = 0;
+    while (level < m_mipLevels && scale * (2 << level) <= 1.0 + 1e-6)
+        ++level;
+    return level;
+}
+
+int BakedMap::chunkPixelWidth() const
+{
+    return CHUNK_TILES * m_map->m_tileWidth;
+}
+
+int BakedMap::chunkPixelHeight() const
+{
+    return CHUNK_TILES * m_map->m_tileHeight;
+}
+
+bool BakedMap::loadTilesets()
+{
+    TRACE_SCOPE("BakedMap::loadTilesets");
+    bool ok = true;
+    m_tileRefs.clear();
+    QVector<QString> gidPaths;
+    QSet<int> unknown;
+    for (int l = 0; l < m_map->layerCount(); ++l)
+    {
+        m_map->layer(l).data.forEachTile([&](int, int, int gid)
+        {
+            if (gid <= 0 || (gid < gidPaths.size() && !gidPaths[gid].isNull()))
+                return;
+            const Tile *t = m_map->findTile(gid);
+            if (!t)
+            {
+                // 不画也不遮挡（opacity 为 Transparent），同一个 GID 只在第一次遇到时警告
+                if (!unknown.contains(gid))
+                    qWarning() << "Tile ID not found:" << gid;
+                unknown.insert(gid);
+                return;
+            }
+            if (gid >= gidPaths.size())
+            {
+                gidPaths.resize(gid + 1);
+                m_tileRefs.resize(gid + 1);
+            }
+            gidPaths[gid] = m_map->resolvePath(t->image);
+            m_tileRefs[gid].source = t->source;
+
+            const QString &path = gidPaths[gid];
+            if (m_tilesets.contains(path))
+                return;
+            QImage img = AssetPack::instance().image(path);
+            if (img.isNull())
+            {
+                qWarning() << "Cannot load image:" << path;
+                ok = false;
+            }
+            Atlas atlas;
+            atlas.levels.append(img.convertToFormat(QImage::Format_ARGB32_Premultiplied));
+            if (!img.isNull())
+            {
+                const QString cacheDir = m_map->basePath().isEmpty()
+                                         ? QString() : QDir(m_map->basePath()).filePath(".mipcache");
+                atlas.levels += Mipmap::levels(path, atlas.levels[0], m_maxMipLevels, cacheDir);
+            }
+            m_tilesets.insert(path, atlas);
+        });
+    }
+
+    // 所有图片都放进哈希表以后再取指针（插入可能导致哈希表重新分配）
+    for (int gid = 0; gid < gidPaths.size(); ++gid)
+    {
+        if (gidPaths[gid].isNull())
+            continue;
+        const Atlas &atlas = m_tilesets[gidPaths[gid]];
+        if (atlas.levels[0].isNull())
+        {
+            m_tileRefs[gid].opacity = Opaque;   // 画占位色块
+            continue;
+        }
+        m_tileRefs[gid].atlas = &atlas;
+        // 缩小版由 2x2 平均得到，瓦片边界对齐，完全不透明 / 完全透明在每一级都保持不变
+        m_tileRefs[gid].opacity = classifyTile(atlas.levels[0], m_tileRefs[gid].source);
+    }
+    m_tilesetsLoaded = true;
+    return ok;
+}
+
+BakedMap::TileOpacity BakedMap::unknownOpacity(int gid) const
+{
+    // 遮挡计算每格都会查，只警告一次；越界的 GID 多半是新放上去还没重新 loadTilesets 的，或者数据坏了
+    if (gid > 0 && !m_warnedUnknownGid)
+    {
+        qWarning() << "BakedMap: GID" << gid << "is outside the loaded tilesets, treating it as transparent";
+        m_warnedUnknownGid = true;
+    }
+    return Transparent;
+}
+
+const QImage *BakedMap::tileImage(int gid, QRect *source, int level) const
+{
+    if (gid <= 0 || gid >= m_tileRefs.size() || !m_tileRefs[gid].atlas)
+        return nullptr;
+    const TileRef &ref = m_tileRefs[gid];
+    const QRect &s = ref.source;
+    *source = QRect(s.x() >> level, s.y() >> level, s.width() >> level, s.height() >> level);
+    return &ref.atlas->levels[level];
+}
+
+void BakedMap::bakeAll(qint64 byteLimit)
+{
+    TRACE_SCOPE("BakedMap::bakeAll");
+    for (int g = 0; g < m_groups.size(); ++g)
+        for (int cy = 0; cy < m_chunksY; ++cy)
+            for (int cx = 0; cx < m_chunksX; ++cx)
+            {
+                if (byteSize() >= byteLimit)
+                    return;   // 剩下的区块等第一次绘制时再烘焙
+                if (!m_baked[chunkIndex(0, g, cx, cy)])
+                    bake(g, cx, cy, 0);
+            }
+}
+
+const QImage &BakedMap::chunk(int group, int cx, int cy, int level)
+{
+    const int index = chunkIndex(level, group, cx, cy);
+    if (!m_baked[index])
+        bake(group, cx, cy, level);
+    return m_chunks[index];
+}
+
+void BakedMap::invalidate(int layerIndex, int tileX, int tileY)
+{
+    if (layerIndex < 0 || layerIndex >= m_map->layerCount() ||
+        tileX < 0 || tileX >= m_map->m_mapWidth || tileY < 0 || tileY >= m_map->m_mapHeight)
+        return;
+
+    // 新出现的 GID 还没有对应的图块集图片，下次烘焙前重新建表
+    const int gid = m_map->tileAt(layerIndex, tileX, tileY);
+    if (gid > 0 && (gid >= m_tileRefs.size() || !m_tileRefs[gid].atlas))
+        m_tilesetsLoaded = false;
+
+    // 这一格的遮挡关系可能变了：下面各绘制组的同一区块也要重新烘焙
+    for (int level = 0; level <= m_maxMipLevels; ++level)
+    {
+        for (int g = 0; g <= groupOf(layerIndex); ++g)
+        {
+            const int index = chunkIndex(level, g, tileX / CHUNK_TILES, tileY / CHUNK_TILES);
+            m_chunkBytes -= m_chunks[index].sizeInBytes();
+            m_chunks[index] = QImage();
+            m_baked[index] = 0;
+        }
+    }
+}
+
+qint64 BakedMap::byteSize() const
+{
+    qint64 bytes = m_chunkBytes;
+    for (const Atlas &atlas : m_tilesets)
+        for (const QImage &img : atlas.levels)
+            bytes += img.sizeInBytes();
+    return bytes;
+}
+
+void BakedMap::collectDraws(int group, int cx, int cy, QVector<Draw> *draws, DrawStats *stats) const
+{
+    const Group &g = m_groups[group];
+    const int tw = m_map->m_tileWidth;
+    const int th = m_map->m_tileHeight;
+    const int x0 = cx * CHUNK_TILES;
+    const int y0 = cy * CHUNK_TILES;
+    const int x1 = qMin(x0 + CHUNK_TILES, m_map->m_mapWidth);
+    const int y1 = qMin(y0 + CHUNK_TILES, m_map->m_mapHeight);
+
+    // 这个区块里有瓦片的图层（稀疏图层没分配的块整块跳过；区块与稀疏块一样大）
+    QVector<const LayerData *> layers(m_map->layerCount(), nullptr);
+    bool any = false;
+    for (int l = g.first; l < m_map->layerCount(); ++l)
+    {
+        const LayerData &data = m_map->layer(l).data;
+        if (data.hasBlock(cx, cy))
+        {
+            layers[l] = &data;
+            any |= l <= g.last;
+        }
+    }
+    if (!any)
+        return;
+
+    /* 每一格从最上面的图层往下找第一块不透明瓦片，它下面的都不用画；
+     组外更高图层的不透明瓦片同样盖住本组（invalidate 会连带作废下面各组的区块） */
+    int cover[CHUNK_TILES * CHUNK_TILES];
+    quint8 started[CHUNK_TILES * CHUNK_TILES];
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int x = x0; x < x1; ++x)
+        {
+            const int c = (y - y0) * CHUNK_TILES + (x - x0);
+            cover[c] = g.first;
+            started[c] = 0;
+            for (int l = m_map->layerCount() - 1; l > g.first; --l)
+            {
+                const int gid = layers[l] ? layers[l]->at(x, y) : 0;
+                if (gid != 0 && opacity(gid) == Opaque)
+                {
+                    cover[c] = l;
+                    break;
+                }
+            }
+        }
+    }
+
+    for (int l = g.first; l <= g.last; ++l)
+    {
+        if (!layers[l])
+            continue;
+        for (int y = y0; y < y1; ++y)
+        {
+            for (int x = x0; x < x1; ++x)
+            {
+                const int gid = layers[l]->at(x, y);
+                if (gid == 0)
+                    continue;
+                const int c = (y - y0) * CHUNK_TILES + (x - x0);
+                if (l < cover[c])
+                {
+                    ++stats->covered;
+                    continue;
+                }
+                if (opacity(gid) == Transparent)
+                {
+                    ++stats->transparent;
+                    continue;
+                }
+                ++stats->drawn;
+                if (draws)
+                    draws->append(Draw{ QPoint((x - x0) * tw, (y - y0) * th), gid, !started[c] });
+                started[c] = 1;
+            }
+        }
+    }
+}
+
+BakedMap::DrawStats BakedMap::analyzeOverdraw() const
+{
+    DrawStats stats;
+    for (int g = 0; g < m_groups.size(); ++g)
+        for (int cy = 0; cy < m_chunksY; ++cy)
+            for (int cx = 0; cx < m_chunksX; ++cx)
+                collectDraws(g, cx, cy, nullptr, &stats);
+    return stats;
+}
+
+void BakedMap::bake(int group, int cx, int cy, int level)
+{
+    TRACE_SCOPE("BakedMap::bake");
+    const int index = chunkIndex(level, group, cx, cy);
+    const int tw = m_map->m_tileWidth >> level;
+    const int th = m_map->m_tileHeight >> level;
+    const int x0 = cx * CHUNK_TILES;
+    const int y0 = cy * CHUNK_TILES;
+    const int x1 = qMin(x0 + CHUNK_TILES, m_map->m_mapWidth);
+    const int y1 = qMin(y0 + CHUNK_TILES, m_map->m_mapHeight);
+
+    if (!m_tilesetsLoaded)
+        loadTilesets();
+
+    m_baked[index] = 1;
+    m_chunkBytes -= m_chunks[index].sizeInBytes();
+    m_chunks[index] = QImage();
+
+    // 没有要画的瓦片（全空、全透明或全被盖住）就不分配图像
+    QVector<Draw> draws;
+    collectDraws(group, cx, cy, &draws, &m_drawStats);
+    if (draws.isEmpty())
+        return;
+
+    QImage img((x1 - x0) * tw, (y1 - y0) * th, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::transparent);
+    QPainter p(&img);
+    // 每格最底下的瓦片直接覆盖（同一图层内的瓦片不重叠），上面的按 alpha 叠加
+    QPainter::CompositionMode mode = QPainter::CompositionMode_Source;
+    p.setCompositionMode(mode);
+    for (const Draw &d : draws)
+    {
+        const QPainter::CompositionMode want = d.firstInCell ? QPainter::CompositionMode_Source
+                                                             : QPainter::CompositionMode_SourceOver;
+        if (want != mode)
+        {
+            mode = want;
+            p.setCompositionMode(mode);
+        }
+        // collectDraws 给的是原尺寸的位置
+        const QPoint pos(d.pos.x() >> level, d.pos.y() >> level);
+        QRect source;
+        const QImage *atlas = tileImage(d.gid, &source, level);
+        if (!atlas)
+        {
+            // 与 TileScene 相同的占位色块
+            p.fillRect(QRect(pos, QSize(tw, th)),
+                       QColor((d.gid * 37) % 255, (d.gid * 61) % 255, (d.gid * 113) % 255));
+            continue;
+        }
+        p.drawImage(pos, *atlas, source);
+    }
+    p.end();
+
+    m_chunkBytes += img.sizeInBytes();
+    m_chunks[index] = img;
+}
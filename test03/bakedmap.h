@@ -0,0 +1,149 @@
+// bakedmap.h - 按区块预先合成的地图图像
+#ifndef BAKEDMAP_H
+#define BAKEDMAP_H
+
+#include <QImage>
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QRect>
+
+class TmxMap;
+
+/*
+ BakedMap：把图层按区块（CHUNK_TILES × CHUNK_TILES 格）预先画成图
+ - 图层先分成绘制组：实体下面连续的静态图层（地面、装饰……）合成一组，烘焙成一套区块；
+   dynamic 图层和实体上面的图层各自单独成组。每帧要贴的区块数和图元数按合并的层数减少
+ - 场景里每个绘制组只需要一个图元，绘制时按区块贴图，不再是每个格子一个图元
+ - 只用 QImage / QPainter，可以在后台线程烘焙（预加载地图时），之后只在主线程使用
+ - 没烘焙的区块在第一次绘制时再烘焙；瓦片变化时只作废所在的区块
+ - 整个区块都是空瓦片时不分配图像
+ - 每个 GID 的图块在加载图块集时分析一次透明度：完全不透明 / 半透明 / 完全透明。
+   烘焙时被更高图层（包括别的绘制组）的不透明瓦片完全盖住的格子不画，完全透明的瓦片当作空格子
+ - 图块集带 1/2、1/4、1/8 的缩小版（Mipmap，缓存在地图目录），区块也可以按这几级烘焙：
+   缩小视图时贴对应一级的区块，像素数和内存都按 4 的级数次方减少
+*/
+class BakedMap
+{
+public:
+    static const int CHUNK_TILES = 16;
+
+    /* 绘制组：图层 first..last 合成在同一套区块里 */
+    struct Group
+    {
+        int first = 0;
+        int last = 0;
+        bool merged = false;        // 实体下面的静态图层，后面的静态图层可以继续并进来
+        bool aboveEntities = false; // 画在玩家和 NPC 上面
+    };
+
+    /* 图块的透明度，loadTilesets 时按像素分析 */
+    enum TileOpacity : quint8
+    {
+        Opaque,       // 每个像素都不透明，能完全盖住下面的图层（图块集图片读不出来时的占位色块也算）
+        Translucent,  // 有透明或半透明像素
+        Transparent   // 全部透明，和空格子一样（图块集里没有的 GID 也算）
+    };
+
+    /* 贴瓦片的次数统计 */
+    struct DrawStats
+    {
+        qint64 drawn = 0;        // 实际贴上去的瓦片
+        qint64 covered = 0;      // 被上面的不透明瓦片盖住而省掉的
+        qint64 transparent = 0;  // 完全透明而省掉的
+        qint64 saved() const { return covered + transparent; }
+    };
+
+    explicit BakedMap(const TmxMap *map);
+
+    int groupCount() const { return m_groups.size(); }
+    const Group &group(int index) const { return m_groups[index]; }
+    int groupOf(int layerIndex) const { return m_groupOfLayer[layerIndex]; }
+
+    /* 解码地图用到的所有图块集图片（后台线程调用；没调用时第一次烘焙会自动调用） */
+    bool loadTilesets();
+    /* 依次烘焙区块，直到已用内存超过 byteLimit（后台线程调用） */
+    void bakeAll(qint64 byteLimit);
+
+    int chunksX() const { return m_chunksX; }
+    int chunksY() const { return m_chunksY; }
+    int chunkPixelWidth() const;
+    int chunkPixelHeight() const;
+
+    /* 可用的缩小级数（0 表示只有原尺寸）；瓦片边长必须能被 2^级数 整除 */
+    int mipLevels() const { return m_mipLevels; }
+    /* 限制使用的级数（基准程序用 0 关掉缩小版做对比），不超过瓦片边长允许的级数 */
+    void setMipLevels(int levels);
+    /* 视图缩放为 scale 时该用的一级：1/2^level 不小于 scale 的最大一级，之后最多再缩小一半 */
+    int levelForScale(qreal scale) const;
+
+    /* 取绘制组的一个区块，没烘焙就先烘焙；空区块返回空图像。
+     level > 0 时是缩小 2^level 倍的区块，大小为 chunkPixelWidth() >> level */
+    const QImage &chunk(int group, int cx, int cy, int level = 0);
+    /* 图层 layerIndex 上的瓦片 (tileX, tileY) 变了：作废它所在绘制组的区块 */
+    void invalidate(int layerIndex, int tileX, int tileY);
+
+    /* 已烘焙区块 + 图块集图片占用的字节数 */
+    qint64 byteSize() const;
+
+    /* 目前为止烘焙时累计的贴图次数 */
+    const DrawStats &drawStats() const { return m_drawStats; }
+    /* 不烘焙，统计把整张地图全部烘焙一遍会贴多少瓦片、省掉多少（需要先 loadTilesets） */
+    DrawStats analyzeOverdraw() const;
+    /* 图块集里找不到的 GID（包括越界的）什么都不画，算完全透明；越界的第一次遇到时警告一次 */
+    TileOpacity opacity(int gid) const
+    { return gid >= 0 && gid < m_tileRefs.size() ? TileOpacity(m_tileRefs[gid].opacity) : unknownOpacity(gid); }
+    /* GID 对应的图块集图片（预乘 ARGB32，level 级缩小版）和图块在图片里的区域；
+     没有图片时返回空指针（画占位色块）。SoftwareRenderer 直接从这里取像素，不再单独加载图块集 */
+    const QImage *tileImage(int gid, QRect *source, int level = 0) const;
+    bool tilesetsLoaded() const { return m_tilesetsLoaded; }
+
+private:
+    int chunkIndex(int level, int group, int cx, int cy) const
+    { return ((level * m_groups.size() + group) * m_chunksY + cy) * m_chunksX + cx; }
+    void bake(int group, int cx, int cy, int level);
+    TileOpacity unknownOpacity(int gid) const;
+
+    /* 区块里要贴的一块瓦片；firstInCell 表示它是这一格最底下要画的瓦片，可以直接覆盖 */
+    struct Draw
+    {
+        QPoint pos;
+        int gid;
+        bool firstInCell;
+    };
+    /* 算出绘制组 group 在区块 (cx, cy) 里要贴的瓦片（draws 可为空，只统计） */
+    void collectDraws(int group, int cx, int cy, QVector<Draw> *draws, DrawStats *stats) const;
+
+    const TmxMap *m_map;
+    QVector<Group> m_groups;
+    QVector<int> m_groupOfLayer;
+    int m_chunksX = 0;
+    int m_chunksY = 0;
+    int m_maxMipLevels = 0; // 瓦片边长允许的级数，区块数组按它分配
+    int m_mipLevels = 0;
+
+    /* 一张图块集：levels[0] 是原图，之后依次缩小一半 */
+    struct Atlas
+    {
+        QVector<QImage> levels;
+    };
+
+    /* GID → 图块集图片和裁剪区域，loadTilesets 时建好，烘焙时不再查 m_tiles 和拼路径 */
+    struct TileRef
+    {
+        const Atlas *atlas = nullptr;
+        QRect source;
+        quint8 opacity = Transparent;   // 没有对应图块的 GID 保持透明
+    };
+
+    QHash<QString, Atlas> m_tilesets;    // 图块集路径 → 解码后的图片（预乘 alpha）及缩小版
+    QVector<TileRef> m_tileRefs;
+    bool m_tilesetsLoaded = false;
+    QVector<QImage> m_chunks;            // 下标 ((级 * 组数 + 绘制组) * chunksY + cy) * chunksX + cx
+    QVector<quint8> m_baked;
+    qint64 m_chunkBytes = 0;
+    DrawStats m_drawStats;
+    mutable bool m_warnedUnknownGid = false;
+};
+
+#endif // BAKEDMAP_H
@@ -0,0 +1,72 @@
+// animationbenchmark.cpp - 精灵动画基准实现
+#include "animationbenchmark.h"
+#include "benchrunner.h"
+#include "spriteanimator.h"
+#include <QGraphicsScene>
+#include <QGraphicsPixmapItem>
+#include <QImage>
+#include <QPainter>
+
+namespace {
+const int SPRITES = 1000;
+const int FRAMES = 600;
+const int FRAME_MS = 16;
+const QSize FRAME_SIZE(32, 37);   // 与 Player.png 的一帧相同
+
+/* 固定种子的线性同余随机数，保证每次跑的结果相同 */
+struct Lcg
+{
+    quint32 state = 12345;
+    int next(int n) { state = state * 1664525u + 1013904223u; return int((state >> 8) % quint32(n)); }
+};
+
+/* 4 × 4 的精灵图，每帧一个不同颜色的方块 */
+QImage makeSheet()
+{
+    QImage image(FRAME_SIZE.width() * 4, FRAME_SIZE.height() * 4, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < 4; ++c)
+            painter.fillRect(QRect(QPoint(c * FRAME_SIZE.width(), r * FRAME_SIZE.height()), FRAME_SIZE).adjusted(4, 4, -4, -4),
+                             QColor::fromHsv((r * 4 + c) * 22, 200, 220));
+    return image;
+}
+}
+
+void AnimationBenchmark::run(BenchRunner &runner)
+{
+    const SpriteSheetPtr sheet = SpriteSheet::fromImage(makeSheet(), 4, 4);
+    const QString dataset = QString("%1-sprites").arg(SPRITES);
+    if (!sheet)
+    {
+        runner.skip("SpriteAnimator::advance", dataset, "cannot build sprite sheet");
+        return;
+    }
+    const SpriteClips clips = SpriteClips::columnsPerDirection(*sheet, 120);
+
+    QGraphicsScene scene(0, 0, 2048, 2048);
+    SpriteAnimator animator;
+    Lcg rng;
+    QVector<int> handles;
+    for (int i = 0; i < SPRITES; ++i)
+    {
+        QGraphicsPixmapItem *item = new QGraphicsPixmapItem;
+        item->setPos(rng.next(2000), rng.next(2000));
+        scene.addItem(item);
+        handles.append(animator.add(item, sheet, &clips));
+        // 错开起步时间，不让所有精灵在同一帧换帧
+        animator.advance(1);
+    }
+
+    const auto reset = [&]() {
+        Lcg r;
+        for (int h : handles)
+            animator.play(h, r.next(2) ? SpriteAnimator::Walk : SpriteAnimator::Idle,
+                          SpriteAnimator::Direction(r.next(4)));
+    };
+    runner.run("SpriteAnimator::advance", dataset, FRAMES, 10, [&]() {
+        for (int f = 0; f < FRAMES; ++f)
+            animator.advance(FRAME_MS);
+    }, reset);
+}
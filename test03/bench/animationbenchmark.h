@@ -0,0 +1,17 @@
+// animationbenchmark.h - 精灵动画基准
+#ifndef ANIMATIONBENCHMARK_H
+#define ANIMATIONBENCHMARK_H
+
+class BenchRunner;
+
+/*
+ 在场景里放 1000 个带精灵动画的图元（一半在走、方向随机、起步时间错开），
+ 测 SpriteAnimator::advance 每帧的耗时（16 ms 一帧），包括换帧时图元的 setPixmap
+*/
+class AnimationBenchmark
+{
+public:
+    static void run(BenchRunner &runner);
+};
+
+#endif // ANIMATIONBENCHMARK_H
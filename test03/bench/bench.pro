@@ -0,0 +1,105 @@
+# bench.pro - 无界面性能基准（与 test02.pro 分开构建）
+# 用法：qmake bench.pro && make && ./bench --out result.json
+QT += core gui widgets xml concurrent
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+TARGET = bench
+TEMPLATE = app
+
+# 被测代码直接引用游戏目录下的源文件
+INCLUDEPATH += ..
+DEFINES += BENCH_SOURCE_DIR=\\\"$$PWD\\\"
+# 与 test02.pro 相同：qmake CONFIG+=trace 时被测代码里的 TRACE_SCOPE 生效（会计入基准耗时）
+trace: DEFINES += LZU_TRACE
+
+# 源文件
+SOURCES += \
+    main.cpp \
+    benchrunner.cpp \
+    syntheticmap.cpp \
+    mapbenchmark.cpp \
+    generatorbenchmark.cpp \
+    fovbenchmark.cpp \
+    renderbenchmark.cpp \
+    scriptbenchmark.cpp \
+    crowdbenchmark.cpp \
+    animationbenchmark.cpp \
+    entitybenchmark.cpp \
+    collisionbenchmark.cpp \
+    netbenchmark.cpp \
+    simulationbenchmark.cpp \
+    ../assetpack.cpp \
+    ../bakedmap.cpp \
+    ../collision.cpp \
+    ../crowd.cpp \
+    ../entitylayer.cpp \
+    ../fieldofview.cpp \
+    ../framebufferitem.cpp \
+    ../frameprofiler.cpp \
+    ../inputlog.cpp \
+    ../itemdatabase.cpp \
+    ../layerdata.cpp \
+    ../maplayeritem.cpp \
+    ../mipmap.cpp \
+    ../netprotocol.cpp \
+    ../scriptcompiler.cpp \
+    ../scriptvm.cpp \
+    ../simulation.cpp \
+    ../softwarerenderer.cpp \
+    ../spriteanimator.cpp \
+    ../spritesheet.cpp \
+    ../tileblitter.cpp \
+    ../tilescene.cpp \
+    ../tmxmap.cpp \
+    ../tracing.cpp \
+    ../world.cpp \
+    ../worldgenerator.cpp
+
+# 头文件
+HEADERS += \
+    benchrunner.h \
+    syntheticmap.h \
+    mapbenchmark.h \
+    generatorbenchmark.h \
+    fovbenchmark.h \
+    renderbenchmark.h \
+    scriptbenchmark.h \
+    crowdbenchmark.h \
+    animationbenchmark.h \
+    entitybenchmark.h \
+    collisionbenchmark.h \
+    netbenchmark.h \
+    simulationbenchmark.h \
+    ../assetpack.h \
+    ../bakedmap.h \
+    ../collision.h \
+    ../crowd.h \
+    ../entitylayer.h \
+    ../fieldofview.h \
+    ../framebufferitem.h \
+    ../frameprofiler.h \
+    ../gamerandom.h \
+    ../inputlog.h \
+    ../Inventory.h \
+    ../Item.h \
+    ../itemdatabase.h \
+    ../layerdata.h \
+    ../maplayeritem.h \
+    ../mipmap.h \
+    ../netprotocol.h \
+    ../scriptcompiler.h \
+    ../scriptvm.h \
+    ../simulation.h \
+    ../softwarerenderer.h \
+    ../spriteanimator.h \
+    ../spritesheet.h \
+    ../tileblitter.h \
+    ../tilescene.h \
+    ../tmxmap.h \
+    ../tracing.h \
+    ../world.h \
+    ../worldgenerator.h
+
+# 语言标准
+QMAKE_CXXFLAGS += -std=c++11
@@ -0,0 +1,182 @@
+// benchrunner.cpp - 基准计时与统计实现
+#include "benchrunner.h"
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QDebug>
+#include <QtMath>
+#include <algorithm>
+
+double BenchResult::mean() const
+{
+    if (samplesMs.isEmpty()) return 0;
+    double sum = 0;
+    for (double v : samplesMs) sum += v;
+    return sum / samplesMs.size();
+}
+
+double BenchResult::variance() const
+{
+    if (samplesMs.size() < 2) return 0;
+    const double m = mean();
+    double sum = 0;
+    for (double v : samplesMs) sum += (v - m) * (v - m);
+    return sum / (samplesMs.size() - 1);
+}
+
+double BenchResult::stddev() const
+{
+    return qSqrt(variance());
+}
+
+double BenchResult::min() const
+{
+    return samplesMs.isEmpty() ? 0 : *std::min_element(samplesMs.begin(), samplesMs.end());
+}
+
+double BenchResult::max() const
+{
+    return samplesMs.isEmpty() ? 0 : *std::max_element(samplesMs.begin(), samplesMs.end());
+}
+
+double BenchResult::median() const
+{
+    if (samplesMs.isEmpty()) return 0;
+    QVector<double> sorted = samplesMs;
+    std::sort(sorted.begin(), sorted.end());
+    int n = sorted.size();
+    return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.0;
+}
+
+QJsonObject BenchResult::toJson() const
+{
+    QJsonObject o;
+    o["name"] = name;
+    o["dataset"] = dataset;
+    o["items"] = double(items);
+    if (isCheck)
+    {
+        o["check"] = passed ? "passed" : "failed";
+        if (!detail.isEmpty())
+            o["detail"] = detail;
+        return o;
+    }
+    if (!skipped.isEmpty())
+    {
+        o["skipped"] = skipped;
+        return o;
+    }
+
+    QJsonArray samples;
+    for (double v : samplesMs) samples.append(v);
+
+    o["unit"] = "ms";
+    o["repeats"] = samplesMs.size();
+    o["mean"] = mean();
+    o["variance"] = variance();
+    o["stddev"] = stddev();
+    o["min"] = min();
+    o["median"] = median();
+    o["max"] = max();
+    o["samples"] = samples;
+    if (items > 0 && mean() > 0)
+    {
+        o["nsPerItem"] = mean() * 1e6 / items;
+        o["itemsPerSecond"] = items / (mean() / 1e3);
+    }
+    return o;
+}
+
+void BenchRunner::run(const QString &name, const QString &dataset, qint64 items, int repeats,
+                      const std::function<void()> &fn, const std::function<void()> &setup)
+{
+    BenchResult r;
+    r.name = name;
+    r.dataset = dataset;
+    r.items = items;
+
+    if (m_repeatOverride > 0)
+        repeats = m_repeatOverride;
+    repeats = qMax(1, repeats);
+
+    // 预热：让文件缓存、内存分配器、图片缓存进入稳定状态
+    if (repeats >= 3)
+    {
+        if (setup) setup();
+        fn();
+    }
+
+    QElapsedTimer timer;
+    for (int i = 0; i < repeats; ++i)
+    {
+        if (setup) setup();
+        timer.start();
+        fn();
+        r.samplesMs.append(timer.nsecsElapsed() / 1e6);
+    }
+
+    qInfo().noquote() << QString("%1 [%2] mean %3 ms, stddev %4 ms (n=%5)")
+                         .arg(name, dataset)
+                         .arg(r.mean(), 0, 'f', 3)
+                         .arg(r.stddev(), 0, 'f', 3)
+                         .arg(repeats);
+    m_results.append(r);
+}
+
+void BenchRunner::skip(const QString &name, const QString &dataset, const QString &reason)
+{
+    BenchResult r;
+    r.name = name;
+    r.dataset = dataset;
+    r.skipped = reason;
+    qInfo().noquote() << QString("%1 [%2] skipped: %3").arg(name, dataset, reason);
+    m_results.append(r);
+}
+
+void BenchRunner::check(const QString &name, const QString &dataset, bool passed, const QString &detail)
+{
+    BenchResult r;
+    r.name = name;
+    r.dataset = dataset;
+    r.isCheck = true;
+    r.passed = passed;
+    r.detail = detail;
+    const QString line = QString("%1 [%2] check %3").arg(name, dataset, passed ? "passed" : "FAILED")
+            + (detail.isEmpty() ? QString() : ": " + detail);
+    if (passed)
+        qInfo().noquote() << line;
+    else
+        qWarning().noquote() << line;
+    m_results.append(r);
+}
+
+int BenchRunner::failures() const
+{
+    int n = 0;
+    for (const BenchResult &r : m_results)
+        n += r.isCheck && !r.passed;
+    return n;
+}
+
+QJsonDocument BenchRunner::toJson() const
+{
+    QJsonArray results;
+    for (const BenchResult &r : m_results)
+        results.append(r.toJson());
+
+    QJsonObject root;
+    root["suite"] = "lzu-game-bench";
+    root["formatVersion"] = 1;
+    root["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    root["qtVersion"] = qVersion();
+    root["cpu"] = QSysInfo::currentCpuArchitecture();
+    root["os"] = QSysInfo::prettyProductName();
+#ifdef QT_DEBUG
+    root["build"] = "debug";
+#else
+    root["build"] = "release";
+#endif
+    root["results"] = results;
+    return QJsonDocument(root);
+}
@@ -0,0 +1,58 @@
+// benchrunner.h - 基准计时与统计
+#ifndef BENCHRUNNER_H
+#define BENCHRUNNER_H
+
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <functional>
+
+/* 一项基准的结果：每次重复的耗时（毫秒）以及统计量 */
+struct BenchResult
+{
+    QString name;       // 被测函数，如 "TmxMap::load"
+    QString dataset;    // 数据集，如 "synthetic-256x256" / "c.tmx"
+    qint64 items = 0;   // 每次执行处理的元素数（格子数、查询次数……），用于换算单次耗时
+    QVector<double> samplesMs;
+    QString skipped;    // 非空表示被跳过，内容为原因
+    bool isCheck = false;  // 正确性检查：不计时，只有通过与否
+    bool passed = false;
+    QString detail;        // 检查的说明，失败时写明哪里不对
+
+    double mean() const;
+    double variance() const;   // 样本方差
+    double stddev() const;
+    double min() const;
+    double median() const;
+    double max() const;
+    QJsonObject toJson() const;
+};
+
+/*
+ BenchRunner 负责重复执行、计时和输出 JSON。
+ 每项基准先跑一次预热（不计入结果，重复次数小于 3 时省略），
+ setup 在每次执行前调用，不计时，用于重置状态。
+ check 记一项正确性检查（确定性、与参考结果一致……），和基准一起输出；有检查失败时 bench 以 1 退出。
+*/
+class BenchRunner
+{
+public:
+    explicit BenchRunner(int repeatOverride = 0) : m_repeatOverride(repeatOverride) {}
+
+    void run(const QString &name, const QString &dataset, qint64 items, int repeats,
+             const std::function<void()> &fn,
+             const std::function<void()> &setup = std::function<void()>());
+    void skip(const QString &name, const QString &dataset, const QString &reason);
+    void check(const QString &name, const QString &dataset, bool passed, const QString &detail = QString());
+    int failures() const;
+
+    const QVector<BenchResult> &results() const { return m_results; }
+    QJsonDocument toJson() const;
+
+private:
+    int m_repeatOverride;
+    QVector<BenchResult> m_results;
+};
+
+#endif // BENCHRUNNER_H
@@ -0,0 +1,76 @@
+// collisionbenchmark.cpp - 像素级碰撞基准实现
+#include "collisionbenchmark.h"
+#include "benchrunner.h"
+#include "collision.h"
+
+namespace {
+const int MAP_SIZE = 256;
+const int TILE = 32;
+const int TICKS = 100;
+const int COUNTS[] = { 1000, 10000 };
+const QSizeF BODY(20, 12);   // 与 Simulation 的玩家碰撞框相同
+
+/* 固定种子的线性同余随机数，保证每次跑的结果相同 */
+struct Lcg
+{
+    quint32 state = 12345;
+    int next(int n) { state = state * 1664525u + 1013904223u; return int((state >> 8) % quint32(n)); }
+};
+
+struct Agent
+{
+    QPointF pos;
+    QPointF velocity;
+};
+}
+
+void CollisionBenchmark::run(BenchRunner &runner)
+{
+    Lcg rng;
+    CollisionGrid grid;
+    grid.reset(MAP_SIZE, MAP_SIZE, TILE, TILE);
+    const QVector<QRectF> table { QRectF(0, TILE / 2, TILE, TILE / 2) };
+    for (int y = 0; y < MAP_SIZE; ++y)
+    {
+        for (int x = 0; x < MAP_SIZE; ++x)
+        {
+            const int r = rng.next(20);
+            if (r < 4)
+                grid.setCell(x, y, CollisionGrid::Full);
+            else if (r == 4)
+                grid.setCell(x, y, CollisionGrid::Shaped, table);
+        }
+    }
+
+    for (int count : COUNTS)
+    {
+        QVector<Agent> start;
+        while (start.size() < count)
+        {
+            Agent a;
+            a.pos = QPointF(rng.next(MAP_SIZE * TILE), rng.next(MAP_SIZE * TILE));
+            if (grid.overlaps(QRectF(a.pos, BODY)))
+                continue;
+            a.velocity = QPointF(rng.next(9) - 4, rng.next(9) - 4);
+            start.append(a);
+        }
+        QVector<Agent> agents;
+        const auto reset = [&]() { agents = start; };
+        runner.run("CollisionGrid::move", QString("%1-agents-%2x%2").arg(count).arg(MAP_SIZE),
+                   qint64(count) * TICKS, 5, [&]() {
+            for (int t = 0; t < TICKS; ++t)
+            {
+                for (Agent &a : agents)
+                {
+                    const QPointF moved = grid.move(QRectF(a.pos, BODY), a.velocity);
+                    a.pos += moved;
+                    // 撞上了就反弹，保持所有人一直在走
+                    if (moved.x() != a.velocity.x())
+                        a.velocity.rx() = -a.velocity.x();
+                    if (moved.y() != a.velocity.y())
+                        a.velocity.ry() = -a.velocity.y();
+                }
+            }
+        }, reset);
+    }
+}
@@ -0,0 +1,17 @@
+// collisionbenchmark.h - 像素级碰撞基准
+#ifndef COLLISIONBENCHMARK_H
+#define COLLISIONBENCHMARK_H
+
+class BenchRunner;
+
+/*
+ 在 256x256 格的随机地图上（约五分之一整格障碍、二十分之一半格的桌子）测 CollisionGrid::move：
+ 1000 / 10000 个角色每个逻辑步各走一次（扫掠 AABB，贴墙滑动），nsPerItem 即一次移动的耗时
+*/
+class CollisionBenchmark
+{
+public:
+    static void run(BenchRunner &runner);
+};
+
+#endif // COLLISIONBENCHMARK_H
@@ -0,0 +1,47 @@
+// crowdbenchmark.cpp - 人群模拟基准实现
+#include "crowdbenchmark.h"
+#include "benchrunner.h"
+#include "crowd.h"
+
+namespace {
+const int MAP_SIZE = 512;
+const int STALLS = 16;
+const int TICKS = 2000;
+const int COUNTS[] = { 1000, 10000, 100000 };
+
+/* 固定种子的线性同余随机数，保证每次跑的地图相同 */
+struct Lcg
+{
+    quint32 state = 12345;
+    int next(int n) { state = state * 1664525u + 1013904223u; return int((state >> 8) % quint32(n)); }
+};
+}
+
+void CrowdBenchmark::run(BenchRunner &runner)
+{
+    Lcg rng;
+    QBitArray blocked(MAP_SIZE * MAP_SIZE);
+    for (int i = 0; i < blocked.size(); ++i)
+        blocked.setBit(i, rng.next(5) == 0);
+    QVector<Crowd::Stall> stalls;
+    for (int i = 0; i < STALLS; ++i)
+    {
+        Crowd::Stall s;
+        s.tile = QPoint(rng.next(MAP_SIZE), rng.next(MAP_SIZE));
+        s.price = 8 + 4 * (i % 4);
+        stalls.append(s);
+    }
+
+    for (int count : COUNTS)
+    {
+        Crowd crowd;
+        // 焦点每 20 步挪一格、在地图中间来回走，和玩家走路差不多快
+        const auto ticks = [&]() {
+            for (int t = 1; t <= TICKS; ++t)
+                crowd.tick(t, QPoint(MAP_SIZE / 4 + (t / 20) % (MAP_SIZE / 2), MAP_SIZE / 2));
+        };
+        const auto reset = [&]() { crowd.populate(MAP_SIZE, MAP_SIZE, blocked, stalls, count, 42, 0); };
+        runner.run("Crowd::tick", QString("%1-customers-%2x%2").arg(count).arg(MAP_SIZE),
+                   TICKS, 5, ticks, reset);
+    }
+}
@@ -0,0 +1,18 @@
+// crowdbenchmark.h - 人群模拟基准
+#ifndef CROWDBENCHMARK_H
+#define CROWDBENCHMARK_H
+
+class BenchRunner;
+
+/*
+ 在随机障碍（五分之一的格子）的街道上测 Crowd::tick：
+ - 1k / 10k / 100k 个顾客，焦点来回走动让顾客不断升降级，nsPerItem 即每个逻辑步的耗时
+ - 分级推进的开销应当基本不随人数增长
+*/
+class CrowdBenchmark
+{
+public:
+    static void run(BenchRunner &runner);
+};
+
+#endif // CROWDBENCHMARK_H
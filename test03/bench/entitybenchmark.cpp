@@ -0,0 +1,162 @@
+// entitybenchmark.cpp - 实体绘制方式的基准实现
+#include "entitybenchmark.h"
+#include "benchrunner.h"
+#include "entitylayer.h"
+#include <QGraphicsScene>
+#include <QGraphicsPixmapItem>
+#include <QImage>
+#include <QPainter>
+
+namespace {
+const QSize VIEWPORT(1000, 800);
+const QRectF WORLD(0, 0, 2048, 2048);
+const int FRAMES = 60;
+const int COUNTS[] = { 1000, 5000 };
+const QSize FRAME_SIZE(32, 37);   // 与 Player.png 的一帧相同
+
+/* 固定种子的线性同余随机数，保证每次跑的结果相同 */
+struct Lcg
+{
+    quint32 state = 12345;
+    int next(int n) { state = state * 1664525u + 1013904223u; return int((state >> 8) % quint32(n)); }
+};
+
+/* 4 × 4 的精灵图，每帧一个不同颜色的方块 */
+QImage makeSheet()
+{
+    QImage image(FRAME_SIZE.width() * 4, FRAME_SIZE.height() * 4, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    for (int r = 0; r < 4; ++r)
+        for (int c = 0; c < 4; ++c)
+            painter.fillRect(QRect(QPoint(c * FRAME_SIZE.width(), r * FRAME_SIZE.height()), FRAME_SIZE).adjusted(4, 4, -4, -4),
+                             QColor::fromHsv((r * 4 + c) * 22, 200, 220));
+    return image;
+}
+
+/* 实体的逻辑状态：两种做法共用同一份，走法完全相同 */
+struct Walker
+{
+    QPointF pos;
+    QPointF velocity;
+    int frame = 0;
+};
+
+QVector<Walker> makeWalkers(int count)
+{
+    Lcg rng;
+    QVector<Walker> walkers(count);
+    for (Walker &w : walkers)
+    {
+        w.pos = QPointF(rng.next(int(WORLD.width())), rng.next(int(WORLD.height())));
+        // 四分之一站着不动，和街上的人差不多
+        if (rng.next(4) != 0)
+            w.velocity = QPointF(rng.next(5) - 2, rng.next(5) - 2);
+        w.frame = rng.next(16);
+    }
+    return walkers;
+}
+
+void stepWalkers(QVector<Walker> &walkers, int frame)
+{
+    for (Walker &w : walkers)
+    {
+        if (w.velocity.isNull())
+            continue;
+        w.pos += w.velocity;
+        if (!WORLD.contains(w.pos))
+        {
+            w.velocity = -w.velocity;
+            w.pos += w.velocity;
+        }
+        if (frame % 8 == 0)
+            w.frame = (w.frame + 4) % 16;
+    }
+}
+
+void renderFrame(QGraphicsScene &scene, QImage &target, int frame)
+{
+    // 视口慢慢平移，和玩家走动时一样
+    const QRectF view(QPointF(frame * 4, frame * 4), QSizeF(VIEWPORT));
+    target.fill(Qt::black);
+    QPainter painter(&target);
+    scene.render(&painter, QRectF(target.rect()), view, Qt::IgnoreAspectRatio);
+}
+}
+
+void EntityBenchmark::run(BenchRunner &runner)
+{
+    const QImage sheetImage = makeSheet();
+    const SpriteSheetPtr sheet = SpriteSheet::fromImage(sheetImage, 4, 4);
+    if (!sheet)
+    {
+        runner.skip("Entities::batchedLayer", "synthetic", "cannot build sprite sheet");
+        return;
+    }
+    QImage target(VIEWPORT, QImage::Format_ARGB32_Premultiplied);
+
+    for (int count : COUNTS)
+    {
+        const QString dataset = QString("%1-entities").arg(count);
+        const QVector<Walker> start = makeWalkers(count);
+        QVector<Walker> walkers;
+
+        // 一个实体一个图元
+        QGraphicsScene itemScene(WORLD);
+        QVector<QGraphicsPixmapItem *> items;
+        for (const Walker &w : start)
+        {
+            QGraphicsPixmapItem *item = itemScene.addPixmap(sheet->frame(w.frame));
+            item->setOffset(-FRAME_SIZE.width() / 2.0, -FRAME_SIZE.height() / 2.0);
+            items.append(item);
+        }
+        const auto updateItems = [&](int frame) {
+            stepWalkers(walkers, frame);
+            for (int i = 0; i < walkers.size(); ++i)
+            {
+                items[i]->setPos(walkers[i].pos);
+                items[i]->setPixmap(sheet->frame(walkers[i].frame));
+            }
+        };
+
+        // 所有实体在一个图元里
+        QGraphicsScene layerScene(WORLD);
+        EntityLayerItem *layer = new EntityLayerItem(WORLD, sheet);
+        layerScene.addItem(layer);
+        QVector<EntitySprite> sprites(count);
+        const auto updateLayer = [&](int frame) {
+            stepWalkers(walkers, frame);
+            for (int i = 0; i < walkers.size(); ++i)
+            {
+                sprites[i].id = i;
+                sprites[i].pos = walkers[i].pos;
+                sprites[i].frame = walkers[i].frame;
+            }
+            layer->setSprites(sprites);
+        };
+
+        const auto reset = [&]() { walkers = start; };
+        runner.run("Entities::pixmapItems", dataset, FRAMES, 5, [&]() {
+            for (int f = 0; f < FRAMES; ++f)
+            {
+                updateItems(f);
+                renderFrame(itemScene, target, f);
+            }
+        }, reset);
+        runner.run("Entities::batchedLayer", dataset, FRAMES, 5, [&]() {
+            for (int f = 0; f < FRAMES; ++f)
+            {
+                updateLayer(f);
+                renderFrame(layerScene, target, f);
+            }
+        }, reset);
+        runner.run("Entities::pixmapItems-update", dataset, FRAMES, 5, [&]() {
+            for (int f = 0; f < FRAMES; ++f)
+                updateItems(f);
+        }, reset);
+        runner.run("Entities::batchedLayer-update", dataset, FRAMES, 5, [&]() {
+            for (int f = 0; f < FRAMES; ++f)
+                updateLayer(f);
+        }, reset);
+    }
+}
@@ -0,0 +1,19 @@
+// entitybenchmark.h - 实体绘制方式的基准
+#ifndef ENTITYBENCHMARK_H
+#define ENTITYBENCHMARK_H
+
+class BenchRunner;
+
+/*
+ 很多走动的实体，每帧挪动位置、换动画帧后画一帧视口（1000x800），对比两种做法：
+ - Entities::pixmapItems：一个实体一个 QGraphicsPixmapItem（setPos + setPixmap，场景维护 BSP 索引）
+ - Entities::batchedLayer：所有实体在一个 EntityLayerItem 里，一次 drawPixmapFragments
+ 两种都包括更新和绘制；另外各测一次只更新不绘制（-update），看场景索引本身的开销
+*/
+class EntityBenchmark
+{
+public:
+    static void run(BenchRunner &runner);
+};
+
+#endif // ENTITYBENCHMARK_H
@@ -0,0 +1,153 @@
+// fovbenchmark.cpp - 视野计算基准实现
+#include "fovbenchmark.h"
+#include "benchrunner.h"
+#include "fieldofview.h"
+#include "worldgenerator.h"
+
+namespace {
+const int RADIUS = 20;
+const int WALK_STEPS = 4000;
+const int EDIT_STEPS = 1000;   // 每步在视野里放下或搬走一个障碍物
+const int LOS_QUERIES = 100000;
+const int LOS_ORIGINS = 500;   // NPC 数：每个 NPC 一批查询，同一视点只投射一次
+const int STUCK_TRIES = 16;    // 连续这么多次走不动就换个地方重新开始
+const int START_TRIES = 1000;  // 找可通行起点的次数，找不到就不走了
+
+/* 固定种子的线性同余随机数，保证每次跑的路线相同 */
+struct Lcg
+{
+    quint32 state = 12345;
+    int next(int n) { state = state * 1664525u + 1013904223u; return int((state >> 8) % quint32(n)); }
+};
+
+/* 随机找一个可通行的格子；试 START_TRIES 次都是障碍时返回 false */
+bool openCell(const FieldOfView &fov, Lcg &rng, QPoint *p)
+{
+    for (int i = 0; i < START_TRIES; ++i)
+    {
+        const QPoint c(rng.next(fov.width()), rng.next(fov.height()));
+        if (!fov.isOpaque(c.x(), c.y()))
+        {
+            *p = c;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* 从地图中心附近出发的随机行走，只走可通行的格子；被围住时换个随机起点接着走，
+ 整张地图几乎都是障碍时路线会短于 WALK_STEPS（可能为空） */
+QVector<QPoint> walkPath(const FieldOfView &fov)
+{
+    static const QPoint dirs[4] = { QPoint(1, 0), QPoint(-1, 0), QPoint(0, 1), QPoint(0, -1) };
+    Lcg rng;
+    QVector<QPoint> path;
+    QPoint p(fov.width() / 2, fov.height() / 2);
+    if (fov.isOpaque(p.x(), p.y()) && !openCell(fov, rng, &p))
+        return path;
+
+    path.reserve(WALK_STEPS);
+    QPoint dir = dirs[0];
+    int stuck = 0;
+    while (path.size() < WALK_STEPS)
+    {
+        // 大多数时候沿原方向走，偶尔转弯，接近玩家的真实走法
+        if (rng.next(8) == 0)
+            dir = dirs[rng.next(4)];
+        const QPoint n = p + dir;
+        if (fov.isOpaque(n.x(), n.y()))
+        {
+            dir = dirs[rng.next(4)];
+            if (++stuck >= STUCK_TRIES)
+            {
+                if (!openCell(fov, rng, &p))
+                    break;
+                stuck = 0;
+            }
+            continue;
+        }
+        stuck = 0;
+        p = n;
+        path.append(p);
+    }
+    return path;
+}
+}
+
+void FovBenchmark::run(BenchRunner &runner)
+{
+    WorldGenerator gen;
+    const GeneratedDistrict district = gen.generateDistrict(QPoint(0, 0), 8, 8);
+    const QString dataset = QString("district-%1x%2-r%3").arg(district.width).arg(district.height).arg(RADIUS);
+
+    FieldOfView fov;
+    fov.reset(district.width, district.height);
+    for (int y = 0; y < district.height; ++y)
+        for (int x = 0; x < district.width; ++x)
+            fov.setOpaque(x, y, district.collision[y * district.width + x]);
+
+    const QVector<QPoint> path = walkPath(fov);
+    if (path.isEmpty())
+    {
+        runner.skip("FieldOfView::update", dataset, "no walkable cell on the generated district");
+        return;
+    }
+
+    // 每步：设置新视点 → 增量更新 → 取出变化的区块（迷雾重绘所需的全部信息）
+    runner.run("FieldOfView::update", dataset, path.size(), 10, [&]() {
+        for (const QPoint &p : path)
+        {
+            fov.setOrigin(p, RADIUS);
+            fov.update();
+            fov.takeDirtyChunks();
+        }
+    }, [&]() {
+        fov.setOrigin(QPoint(-1, -1), RADIUS);
+        fov.update();
+        fov.takeDirtyChunks();
+    });
+
+    // 视点不动、视野不能增量时（换地图、改半径）的整次计算
+    const QPoint center = path[path.size() / 2];
+    runner.run("FieldOfView::recompute", dataset, 1, 200, [&]() {
+        fov.recompute();
+        fov.takeDirtyChunks();
+    }, [&]() {
+        fov.setOrigin(center, RADIUS);
+        fov.update();
+        fov.takeDirtyChunks();
+    });
+
+    // 与 Widget 的 tileChanged 相同：障碍物层的格子变了 → setOpaque → update → 重绘变化的区块
+    Lcg rng;
+    QVector<QPoint> edits;
+    edits.reserve(EDIT_STEPS);
+    while (edits.size() < EDIT_STEPS)
+    {
+        const QPoint p = center + QPoint(rng.next(2 * RADIUS + 1) - RADIUS, rng.next(2 * RADIUS + 1) - RADIUS);
+        if (p != center && p.x() >= 0 && p.x() < fov.width() && p.y() >= 0 && p.y() < fov.height())
+            edits.append(p);
+    }
+    runner.run("FieldOfView::setOpaque", dataset, edits.size(), 10, [&]() {
+        for (const QPoint &p : edits)
+        {
+            fov.setOpaque(p.x(), p.y(), !fov.isOpaque(p.x(), p.y()));
+            fov.update();
+            fov.takeDirtyChunks();
+        }
+    });
+
+    // NPC 视线查询：LOS_ORIGINS 个 NPC 站在路线上，各自看向 20 格以内的随机点；同一 NPC 的查询共用一次投射
+    QVector<LosQuery> queries(LOS_QUERIES);
+    for (int i = 0; i < queries.size(); ++i)
+    {
+        LosQuery &q = queries[i];
+        q.from = path[(i % LOS_ORIGINS) * path.size() / LOS_ORIGINS];
+        q.to = q.from + QPoint(rng.next(2 * RADIUS + 1) - RADIUS, rng.next(2 * RADIUS + 1) - RADIUS);
+        q.maxRange = RADIUS;
+    }
+    QVector<quint8> results;
+    runner.run("FieldOfView::lineOfSight", dataset + "-batch", queries.size(), 10, [&]() {
+        fov.lineOfSight(queries, results);
+    });
+}
@@ -0,0 +1,20 @@
+// fovbenchmark.h - 视野计算基准
+#ifndef FOVBENCHMARK_H
+#define FOVBENCHMARK_H
+
+class BenchRunner;
+
+/*
+ 在程序化生成的街区（碰撞格作为遮挡）上测 FieldOfView：
+ - 玩家沿随机路线行走，每走一格增量更新一次视野（半径 20），nsPerItem 即单步耗时
+ - 视点不动时的整次计算（recompute），即不能增量时的代价
+ - 视野里的障碍物被改（砍掉、热重载）：与游戏里相同的 setOpaque → update，每步改一格
+ - NPC 批量视线查询（500 个视点、距离 20 以内的随机点），走的也是阴影投射
+*/
+class FovBenchmark
+{
+public:
+    static void run(BenchRunner &runner);
+};
+
+#endif // FOVBENCHMARK_H
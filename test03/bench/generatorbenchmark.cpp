@@ -0,0 +1,98 @@
+// generatorbenchmark.cpp - 程序化街区生成吞吐量基准实现
+#include "generatorbenchmark.h"
+#include "benchrunner.h"
+#include "worldgenerator.h"
+#include <QThreadPool>
+#include <QCryptographicHash>
+
+namespace {
+const int SEAM_CHUNKS = 8;   // 接缝检查：8x8 个区块与同样范围的一个大区块比较
+const int SEAM_SEEDS = 8;
+const int GROUND_LAYER = 0;  // GeneratedDistrict::layers：Ground / Decoration / Obstacle
+const int OBSTACLE_LAYER = 2;
+
+QByteArray checksum(const GeneratedDistrict &d)
+{
+    QCryptographicHash h(QCryptographicHash::Sha1);
+    for (const Layer &lay : d.layers)
+    {
+        const QVector<int> gids = lay.data.toVector();
+        h.addData(reinterpret_cast<const char *>(gids.constData()), gids.size() * int(sizeof(int)));
+    }
+    h.addData(reinterpret_cast<const char *>(d.collision.constData()), d.collision.size());
+    return h.result();
+}
+
+/* 地面和建筑（墙、屋顶、摊位）逐格比较，返回不同的格子数
+ 装饰按设计在区块边界外视为空（每个区块单独摆），不参与比较 */
+int mismatches(const GeneratedDistrict &a, const GeneratedDistrict &b, const GeneratorPalette &pal)
+{
+    const auto building = [&](int gid) {
+        const int local = gid - pal.firstGid;
+        return local == pal.wall || local == pal.roof || local == pal.stall ? gid : 0;
+    };
+    const LayerData &groundA = a.layers[GROUND_LAYER].data, &groundB = b.layers[GROUND_LAYER].data;
+    const LayerData &obstacleA = a.layers[OBSTACLE_LAYER].data, &obstacleB = b.layers[OBSTACLE_LAYER].data;
+    int diff = 0;
+    for (int y = 0; y < a.height; ++y)
+        for (int x = 0; x < a.width; ++x)
+            diff += groundA.at(x, y) != groundB.at(x, y)
+                    || building(obstacleA.at(x, y)) != building(obstacleB.at(x, y));
+    return diff;
+}
+}
+
+void GeneratorBenchmark::run(BenchRunner &runner)
+{
+    WorldGenerator gen;
+    const int cs = gen.config().chunkSize;
+    const int defaultThreads = QThreadPool::globalInstance()->maxThreadCount();
+
+    // 8x8 区块 = 256x256 格；32x32 区块 = 1024x1024 格
+    const int sizes[] = { 8, 32 };
+    for (int chunks : sizes)
+    {
+        const qint64 tiles = qint64(chunks) * cs * chunks * cs;
+        const QString dataset = QString("district-%1x%1").arg(chunks * cs);
+
+        // 计时只含生成，校验和在计时之外算最后一次的结果
+        GeneratedDistrict parallel, serial;
+        runner.run("WorldGenerator::generateDistrict", dataset + "-threads" + QString::number(defaultThreads),
+                   tiles, chunks > 8 ? 5 : 10, [&]() {
+            parallel = gen.generateDistrict(QPoint(-chunks / 2, 3), chunks, chunks);
+        });
+
+        QThreadPool::globalInstance()->setMaxThreadCount(1);
+        runner.run("WorldGenerator::generateDistrict", dataset + "-threads1",
+                   tiles, chunks > 8 ? 3 : 5, [&]() {
+            serial = gen.generateDistrict(QPoint(-chunks / 2, 3), chunks, chunks);
+        });
+        QThreadPool::globalInstance()->setMaxThreadCount(defaultThreads);
+
+        runner.check("WorldGenerator::generateDistrict-deterministic", dataset,
+                     checksum(parallel) == checksum(serial),
+                     "all cores vs one thread");
+    }
+
+    // 区块接缝：默认区块大小生成的 8x8 个区块，与把它们当作一个大区块生成的结果比较。
+    // 大区块内部没有接缝，是参考答案；换几个种子，让建筑跨过区块边界的情况都出现
+    int diff = 0;
+    int badSeeds = 0;
+    for (quint64 seed = 1; seed <= SEAM_SEEDS; ++seed)
+    {
+        GeneratorConfig config = gen.config();
+        config.seed = seed;
+        GeneratorConfig single = config;
+        single.chunkSize = SEAM_CHUNKS * cs;
+        // 负坐标也要对齐：大区块 (-1, 1) 正好是小区块 (-8, 8) 开始的 8x8 个
+        const GeneratedDistrict chunked = WorldGenerator(config).generateDistrict(QPoint(-SEAM_CHUNKS, SEAM_CHUNKS),
+                                                                                  SEAM_CHUNKS, SEAM_CHUNKS);
+        const GeneratedDistrict whole = WorldGenerator(single).generateDistrict(QPoint(-1, 1), 1, 1);
+        const int d = mismatches(chunked, whole, config.palette);
+        diff += d;
+        badSeeds += d > 0;
+    }
+    runner.check("WorldGenerator::generateDistrict-seams", QString("district-%1x%1").arg(SEAM_CHUNKS * cs),
+                 diff == 0, QString("%1 ground / building tiles differ from a single chunk (%2 of %3 seeds)")
+                 .arg(diff).arg(badSeeds).arg(SEAM_SEEDS));
+}
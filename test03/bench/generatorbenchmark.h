@@ -0,0 +1,18 @@
+// generatorbenchmark.h - 程序化街区生成吞吐量基准
+#ifndef GENERATORBENCHMARK_H
+#define GENERATORBENCHMARK_H
+
+class BenchRunner;
+
+/*
+ 测 WorldGenerator::generateDistrict 的吞吐量（itemsPerSecond 即每秒生成的格子数），
+ 分别用全部核心和单线程各跑一遍，并检查两者结果完全一致（确定性）；
+ 另外检查区块接缝：8x8 个区块拼起来的地面和建筑，必须与把同样范围当作一个大区块生成的逐格相同。
+*/
+class GeneratorBenchmark
+{
+public:
+    static void run(BenchRunner &runner);
+};
+
+#endif // GENERATORBENCHMARK_H
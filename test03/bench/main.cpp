@@ -0,0 +1,96 @@
+// main.cpp - 基准程序入口
+// 无界面运行（offscreen 平台），结果以 JSON 输出，便于在不同版本之间对比；有正确性检查失败时以 1 退出
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+#include "benchrunner.h"
+#include "mapbenchmark.h"
+#include "generatorbenchmark.h"
+#include "fovbenchmark.h"
+#include "renderbenchmark.h"
+#include "scriptbenchmark.h"
+#include "crowdbenchmark.h"
+#include "animationbenchmark.h"
+#include "entitybenchmark.h"
+#include "collisionbenchmark.h"
+#include "netbenchmark.h"
+#include "simulationbenchmark.h"
+
+int main(int argc, char *argv[])
+{
+    // 没有显示器也能跑：QPixmap / QGraphicsScene 仍然需要 GUI 平台插件
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+    QCoreApplication::setApplicationName("bench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("LZU_GAME headless benchmark suite");
+    parser.addHelpOption();
+    QCommandLineOption outOpt("out", "Write JSON results to <file> (default: stdout).", "file");
+    QCommandLineOption repeatsOpt("repeats", "Override repeat count of every benchmark.", "n", "0");
+    QCommandLineOption sizesOpt("sizes", "Synthetic map sizes, comma separated WxH.", "list",
+                                "30x20,256x256,1024x1024,4096x4096");
+    QCommandLineOption tmxOpt("tmx", "Real map to benchmark (empty to skip).", "file",
+                              QString(BENCH_SOURCE_DIR) + "/../../c.tmx");
+    QCommandLineOption sceneOpt("scene-max-cells", "Largest map (in cells) to build a per-tile scene (TileScene) for.",
+                                "n", "65536");
+    QCommandLineOption workOpt("work-dir", "Directory for generated synthetic maps.", "dir",
+                               QDir::temp().absoluteFilePath("lzu_bench"));
+    parser.addOptions({ outOpt, repeatsOpt, sizesOpt, tmxOpt, sceneOpt, workOpt });
+    parser.process(app);
+
+    BenchOptions options;
+    options.tmxPath = parser.value(tmxOpt);
+    options.workDir = parser.value(workOpt);
+    options.sceneMaxCells = parser.value(sceneOpt).toLongLong();
+    QDir().mkpath(options.workDir);
+
+    for (const QString &s : parser.value(sizesOpt).split(',', QString::SkipEmptyParts))
+    {
+        QStringList wh = s.trimmed().split('x');
+        if (wh.size() == 2 && wh[0].toInt() > 0 && wh[1].toInt() > 0)
+            options.sizes.append(QSize(wh[0].toInt(), wh[1].toInt()));
+        else
+            qWarning() << "Ignoring invalid size" << s;
+    }
+
+    BenchRunner runner(parser.value(repeatsOpt).toInt());
+    MapBenchmark::run(runner, options);
+    GeneratorBenchmark::run(runner);
+    FovBenchmark::run(runner);
+    RenderBenchmark::run(runner, options);
+    ScriptBenchmark::run(runner);
+    CrowdBenchmark::run(runner);
+    AnimationBenchmark::run(runner);
+    EntityBenchmark::run(runner);
+    CollisionBenchmark::run(runner);
+    NetBenchmark::run(runner);
+    SimulationBenchmark::run(runner, options);
+
+    const QByteArray json = runner.toJson().toJson(QJsonDocument::Indented);
+    if (parser.isSet(outOpt))
+    {
+        QFile out(parser.value(outOpt));
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            qCritical() << "Cannot write" << out.fileName();
+            return 1;
+        }
+        out.write(json);
+    }
+    else
+    {
+        QTextStream(stdout) << json;
+    }
+    if (runner.failures() > 0)
+    {
+        qCritical() << runner.failures() << "checks failed";
+        return 1;
+    }
+    return 0;
+}
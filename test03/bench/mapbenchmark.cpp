@@ -0,0 +1,213 @@
+// mapbenchmark.cpp - 地图加载、碰撞查询、物品栏基准实现
+#include "mapbenchmark.h"
+#include "benchrunner.h"
+#include "syntheticmap.h"
+#include "tmxmap.h"
+#include "tilescene.h"
+#include "bakedmap.h"
+#include "Inventory.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDomDocument>
+#include <QGraphicsScene>
+#include <QScopedPointer>
+#include <QDebug>
+#include <limits>
+
+namespace {
+volatile int g_sink = 0; // 防止编译器把被测循环优化掉
+
+/* 重复次数随地图规模递减：小图多跑几次降低噪声，4096x4096 跑 3 次已经要几分钟 */
+int repeatsFor(qint64 cells)
+{
+    if (cells <= 4096) return 20;
+    if (cells <= 300000) return 10;
+    if (cells <= 2000000) return 5;
+    return 3;
+}
+}
+
+void MapBenchmark::run(BenchRunner &runner, const BenchOptions &options)
+{
+    for (const QSize &size : options.sizes)
+    {
+        QString file = SyntheticMap::write(options.workDir, size.width(), size.height());
+        QString dataset = QString("synthetic-%1x%2").arg(size.width()).arg(size.height());
+        if (file.isEmpty())
+        {
+            runner.skip("TmxMap::load", dataset, "cannot generate synthetic map");
+            continue;
+        }
+        benchMap(runner, file, dataset, options.sceneMaxCells);
+    }
+
+    if (!options.tmxPath.isEmpty())
+    {
+        if (QFileInfo::exists(options.tmxPath))
+            benchMap(runner, options.tmxPath, QFileInfo(options.tmxPath).fileName(),
+                     options.sceneMaxCells);
+        else
+            runner.skip("TmxMap::load", options.tmxPath, "file not found");
+    }
+
+    benchInventory(runner);
+}
+
+void MapBenchmark::benchMap(BenchRunner &runner, const QString &fileName, const QString &dataset,
+                            qint64 sceneMaxCells)
+{
+    TmxMap map;
+    if (!map.load(fileName))
+    {
+        runner.skip("TmxMap::load", dataset, "load failed");
+        return;
+    }
+
+    const qint64 cells = qint64(map.m_mapWidth) * map.m_mapHeight;
+    const qint64 layerCells = cells * map.m_layers.size();
+    const int repeats = repeatsFor(cells);
+
+    /* 1. load：整个文件（XML 解析 + 图块集 + 所有图层） */
+    runner.run("TmxMap::load", dataset, cells, repeats, [&]() {
+        TmxMap m;
+        g_sink = g_sink + m.load(fileName);
+    });
+
+    /* 2. parseLayer：XML 只解析一次，计时部分只包含 CSV → GID */
+    QFile file(fileName);
+    QDomDocument doc;
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text) && doc.setContent(&file))
+    {
+        QDomNodeList layerNodes = doc.documentElement().elementsByTagName("layer");
+        TmxMap m;
+        m.m_mapWidth = map.m_mapWidth;
+        m.m_mapHeight = map.m_mapHeight;
+        runner.run("TmxMap::parseLayer", dataset, layerCells, repeats,
+                   [&]() {
+                       for (int i = 0; i < layerNodes.size(); ++i)
+                           g_sink = g_sink + m.parseLayer(layerNodes.at(i).toElement());
+                   },
+                   [&]() {
+                       m.m_layers.clear();
+                       m.m_obstacleLayerIndex = -1;
+                   });
+    }
+    else
+    {
+        runner.skip("TmxMap::parseLayer", dataset, "cannot re-read xml");
+    }
+
+    /* 3. TileScene::build：每个非空格子一个图元，大图会耗尽内存，按上限跳过 */
+    if (cells <= sceneMaxCells)
+    {
+        QGraphicsScene scene;
+        TileScene tileScene(&map);
+        runner.run("TileScene::build", dataset, layerCells, qMin(repeats, 5), [&]() {
+            tileScene.build(&scene);
+            g_sink = g_sink + int(scene.sceneRect().width());
+        });
+    }
+    else
+    {
+        runner.skip("TileScene::build", dataset,
+                    QString("cells > %1 (use --scene-max-cells)").arg(sceneMaxCells));
+    }
+
+    /* 4. isObstacle：100 万次随机查询，约 2% 落在地图外（走边界检测分支） */
+    const int queries = 1000000;
+    QVector<QPoint> points;
+    points.reserve(queries);
+    quint32 s = 12345u;
+    for (int i = 0; i < queries; ++i)
+    {
+        s = s * 1664525u + 1013904223u;
+        int x = int((s >> 8) % quint32(map.m_mapWidth + map.m_mapWidth / 100 + 1)) - map.m_mapWidth / 200;
+        s = s * 1664525u + 1013904223u;
+        int y = int((s >> 8) % quint32(map.m_mapHeight + map.m_mapHeight / 100 + 1)) - map.m_mapHeight / 200;
+        points.append(QPoint(x, y));
+    }
+    runner.run("TmxMap::isObstacle", dataset, queries, 10, [&]() {
+        int hits = 0;
+        for (const QPoint &p : points)
+            hits += map.isObstacle(p.x(), p.y());
+        g_sink = g_sink + hits;
+    });
+
+    /* 5. tileAt：同一批坐标逐层读取，烘焙区块和小地图都走这条路径 */
+    runner.run("TmxMap::tileAt", dataset, qint64(queries) * map.layerCount(), 10, [&]() {
+        int sum = 0;
+        for (int l = 0; l < map.layerCount(); ++l)
+            for (const QPoint &p : points)
+                sum += map.tileAt(l, p.x(), p.y());
+        g_sink = g_sink + sum;
+    });
+
+    // 图层内存：紧凑存储与每格一个 int 的对比
+    qint64 bytes = 0;
+    for (int l = 0; l < map.layerCount(); ++l)
+    {
+        const LayerData &data = map.layer(l).data;
+        bytes += data.memoryBytes();
+        qDebug().nospace() << dataset << " layer " << map.layer(l).name << ": "
+                           << (data.isSparse() ? "sparse" : "dense") << ", " << data.cellBytes()
+                           << " byte cells, " << data.memoryBytes() / 1024 << " KB";
+    }
+    qDebug().nospace() << dataset << " layer storage " << bytes / 1024 << " KB (as QVector<int>: "
+                       << layerCells * qint64(sizeof(int)) / 1024 << " KB)";
+
+    /* 6. 烘焙：先统计整张图的遮挡剔除（不分配区块），小图再测完整烘焙的耗时 */
+    QScopedPointer<BakedMap> baked(new BakedMap(&map));
+    baked->loadTilesets();
+    const BakedMap::DrawStats draws = baked->analyzeOverdraw();
+    const qint64 total = draws.drawn + draws.saved();
+    qDebug().nospace() << dataset << " tile draws: " << draws.drawn << " of " << total << " ("
+                       << draws.covered << " covered, " << draws.transparent << " transparent, "
+                       << (total ? 100.0 * draws.saved() / total : 0.0) << "% saved)";
+    if (cells <= sceneMaxCells)
+    {
+        runner.run("BakedMap::bakeAll", dataset, layerCells, qMin(repeats, 5),
+                   [&]() {
+                       baked->bakeAll(std::numeric_limits<qint64>::max());
+                       g_sink = g_sink + int(baked->byteSize());
+                   },
+                   [&]() {
+                       baked.reset(new BakedMap(&map));
+                       baked->loadTilesets();
+                   });
+    }
+    else
+    {
+        runner.skip("BakedMap::bakeAll", dataset,
+                    QString("cells > %1 (use --scene-max-cells)").arg(sceneMaxCells));
+    }
+}
+
+void MapBenchmark::benchInventory(BenchRunner &runner)
+{
+    QPixmap icon(32, 32);
+    icon.fill(Qt::gray);
+    const Item knife("崭新的菜刀", "菜刀", "可以切菜", icon);
+
+    /* addItem：装满 9 格为一轮（最后一次必然扫描全部槽位） */
+    const int rounds = 100000;
+    runner.run("Inventory::addItem", "9-slot fill", qint64(rounds) * INVENTORY_SIZE, 10, [&]() {
+        for (int r = 0; r < rounds; ++r)
+        {
+            Inventory inv;
+            for (int i = 0; i < INVENTORY_SIZE; ++i)
+                g_sink = g_sink + inv.addItem(knife);
+        }
+    });
+
+    /* getItem：按值返回 Item，包含 QString/QPixmap 的引用计数开销 */
+    Inventory inv;
+    for (int i = 0; i < INVENTORY_SIZE; ++i)
+        inv.addItem(knife);
+    const int lookups = 1000000;
+    runner.run("Inventory::getItem", "9-slot full", lookups, 10, [&]() {
+        int total = 0;
+        for (int i = 0; i < lookups; ++i)
+            total += inv.getItem(i % INVENTORY_SIZE).count();
+        g_sink = g_sink + total;
+    });
+}
@@ -0,0 +1,34 @@
+// mapbenchmark.h - 地图加载、碰撞查询、物品栏基准
+#ifndef MAPBENCHMARK_H
+#define MAPBENCHMARK_H
+
+#include <QString>
+#include <QVector>
+#include <QSize>
+
+class BenchRunner;
+
+struct BenchOptions
+{
+    QString tmxPath;              // 真实地图（c.tmx），为空则跳过
+    QString workDir;              // 合成地图的输出目录
+    QVector<QSize> sizes;         // 合成地图尺寸（格子数）
+    qint64 sceneMaxCells = 0;     // TileScene 只对不超过该格子数的地图测试（每格一个图元）
+};
+
+/*
+ MapBenchmark 是 TmxMap 的友元，可以直接测 parseLayer 这种私有函数。
+ 覆盖：TmxMap::load / parseLayer / isObstacle / tileAt（附带图层内存）/ TileScene::build / BakedMap::bakeAll（附带省掉的贴图次数），Inventory::addItem / getItem
+*/
+class MapBenchmark
+{
+public:
+    static void run(BenchRunner &runner, const BenchOptions &options);
+
+private:
+    static void benchMap(BenchRunner &runner, const QString &fileName, const QString &dataset,
+                         qint64 sceneMaxCells);
+    static void benchInventory(BenchRunner &runner);
+};
+
+#endif // MAPBENCHMARK_H
@@ -0,0 +1,102 @@
+// netbenchmark.cpp - 联机状态差分的编码基准实现
+#include "netbenchmark.h"
+#include "benchrunner.h"
+#include "crowd.h"
+#include "netprotocol.h"
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+const int MAP_SIZE = 256;
+const int STALLS = 16;
+const int STATES = 200;
+const int TICKS_PER_STATE = 3;   // 16ms 一步，约 20 Hz
+const int ACK_LAG = 3;           // 基准落后几份
+const int VIEW_X = 24;           // 与 NetHost 相同
+const int VIEW_Y = 18;
+const int MAX_ENTITIES = 512;
+const int COUNTS[] = { 2000, 20000 };
+
+/* 固定种子的线性同余随机数，保证每次跑的地图相同 */
+struct Lcg
+{
+    quint32 state = 12345;
+    int next(int n) { state = state * 1664525u + 1013904223u; return int((state >> 8) % quint32(n)); }
+};
+
+/* 与 NetHost::buildState 相同：视野里的顾客按 id 排序、量化 */
+NetWorldState makeState(quint32 seq, const Crowd &crowd, const QPoint &center)
+{
+    NetWorldState s;
+    s.seq = seq;
+    s.tick = seq * TICKS_PER_STATE;
+    NetPlayerState p;
+    p.x = NetProtocol::quantizePosition(center.x() * 32 + 16);
+    p.y = NetProtocol::quantizePosition(center.y() * 32 + 16);
+    s.players.append(p);
+
+    QVector<CustomerView> near;
+    crowd.visible(QRect(center.x() - VIEW_X, center.y() - VIEW_Y, 2 * VIEW_X + 1, 2 * VIEW_Y + 1),
+                  MAX_ENTITIES, &near);
+    std::sort(near.begin(), near.end(), [](const CustomerView &a, const CustomerView &b) { return a.id < b.id; });
+    for (const CustomerView &c : near)
+    {
+        NetEntityState e;
+        e.id = c.id;
+        e.x = qRound(c.x * NetProtocol::ENTITY_SCALE);
+        e.y = qRound(c.y * NetProtocol::ENTITY_SCALE);
+        e.mood = c.mood;
+        s.entities.append(e);
+    }
+    return s;
+}
+}
+
+void NetBenchmark::run(BenchRunner &runner)
+{
+    Lcg rng;
+    QBitArray blocked(MAP_SIZE * MAP_SIZE);
+    for (int i = 0; i < blocked.size(); ++i)
+        blocked.setBit(i, rng.next(5) == 0);
+    QVector<Crowd::Stall> stalls;
+    for (int i = 0; i < STALLS; ++i)
+    {
+        Crowd::Stall s;
+        s.tile = QPoint(rng.next(MAP_SIZE), rng.next(MAP_SIZE));
+        s.price = 8 + 4 * (i % 4);
+        stalls.append(s);
+    }
+
+    for (int count : COUNTS)
+    {
+        // 先把状态序列生成好，计时只算编码；客户端玩家站在地图中间，完整模型的顾客都在视野里
+        Crowd crowd;
+        crowd.populate(MAP_SIZE, MAP_SIZE, blocked, stalls, count, 42, 0);
+        const QPoint center(MAP_SIZE / 2, MAP_SIZE / 2);
+        QVector<NetWorldState> states;
+        qint64 entities = 0;
+        for (int i = 0; i < STATES; ++i)
+        {
+            for (int t = 0; t < TICKS_PER_STATE; ++t)
+                crowd.tick(qint64(i) * TICKS_PER_STATE + t + 1, center);
+            states.append(makeState(quint32(i + 1), crowd, center));
+            entities += states.last().entities.size();
+        }
+
+        qint64 deltaBytes = 0;
+        qint64 fullBytes = 0;
+        const QString dataset = QString("%1-customers-%2x%2").arg(count).arg(MAP_SIZE);
+        runner.run("NetProtocol::encodeState", dataset, STATES, 5, [&]() {
+            deltaBytes = 0;
+            for (int i = 0; i < STATES; ++i)
+                deltaBytes += NetProtocol::encodeState(states[i], i >= ACK_LAG ? &states[i - ACK_LAG] : nullptr).size();
+        });
+        for (const NetWorldState &s : states)
+            fullBytes += NetProtocol::encodeState(s, nullptr).size();
+
+        const double perState = double(deltaBytes) / STATES;
+        qInfo().noquote() << QString("NetProtocol::encodeState [%1] %2 customers in view, %3 B/state (full %4 B), %5 KB/s at 20 Hz")
+                             .arg(dataset).arg(entities / STATES).arg(perState, 0, 'f', 0)
+                             .arg(double(fullBytes) / STATES, 0, 'f', 0).arg(perState * 20 / 1024, 0, 'f', 1);
+    }
+}
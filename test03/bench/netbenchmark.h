@@ -0,0 +1,18 @@
+// netbenchmark.h - 联机状态差分的编码基准
+#ifndef NETBENCHMARK_H
+#define NETBENCHMARK_H
+
+class BenchRunner;
+
+/*
+ 256x256 格的街上 2000 / 20000 个顾客（Crowd）走动，每 3 个逻辑步（约 20 Hz）取客户端视野里的顾客
+ 组成一份状态，相对 3 份之前的状态（模拟 150ms 往返才收到确认）编码。
+ 计时的是 NetProtocol::encodeState；另外打印每份状态的平均字节数、整份发送的字节数和折算的带宽
+*/
+class NetBenchmark
+{
+public:
+    static void run(BenchRunner &runner);
+};
+
+#endif // NETBENCHMARK_H
@@ -0,0 +1,147 @@
+// renderbenchmark.cpp - 地图渲染方式的逐帧耗时对比实现
+#include "renderbenchmark.h"
+#include "benchrunner.h"
+#include "mapbenchmark.h"
+#include "syntheticmap.h"
+#include "tmxmap.h"
+#include "tilescene.h"
+#include "bakedmap.h"
+#include "maplayeritem.h"
+#include "framebufferitem.h"
+#include "tileblitter.h"
+#include <QFileInfo>
+#include <QGraphicsScene>
+#include <QPainter>
+#include <QImage>
+#include <limits>
+
+namespace {
+const QSize VIEWPORT(1000, 800);
+const int FRAMES = 60;
+const qreal ZOOMS[] = { 1.0, 0.5, 0.25 };
+const qreal ABOVE_ENTITIES_Z = 1500; // 与 Widget 相同
+
+/* 视口左上角（场景坐标）：从左上角沿对角线平移到右下角，视口比地图大时固定在原点 */
+QVector<QPointF> panPath(const QRectF &bounds, const QSizeF &view)
+{
+    QVector<QPointF> path;
+    const qreal maxX = qMax<qreal>(0, bounds.width() - view.width());
+    const qreal maxY = qMax<qreal>(0, bounds.height() - view.height());
+    for (int i = 0; i < FRAMES; ++i)
+    {
+        const qreal t = FRAMES > 1 ? qreal(i) / (FRAMES - 1) : 0;
+        path.append(QPointF(maxX * t, maxY * t));
+    }
+    return path;
+}
+
+/* 把 scene 在 path 上逐帧画到 target：与 GameView 一样，一帧就是一次整屏重绘 */
+void renderFrames(QGraphicsScene &scene, QImage &target, const QVector<QPointF> &path, const QSizeF &view)
+{
+    for (const QPointF &p : path)
+    {
+        target.fill(Qt::black);
+        QPainter painter(&target);
+        scene.render(&painter, QRectF(target.rect()), QRectF(p, view), Qt::IgnoreAspectRatio);
+    }
+}
+}
+
+void RenderBenchmark::run(BenchRunner &runner, const BenchOptions &options)
+{
+    const QSize sizes[] = { QSize(256, 256), QSize(1024, 1024) };
+    for (const QSize &size : sizes)
+    {
+        const QString file = SyntheticMap::write(options.workDir, size.width(), size.height());
+        const QString dataset = QString("synthetic-%1x%2").arg(size.width()).arg(size.height());
+        if (file.isEmpty())
+        {
+            runner.skip("Render::bakedChunks", dataset, "cannot generate synthetic map");
+            continue;
+        }
+        benchMap(runner, file, dataset, options.sceneMaxCells);
+    }
+
+    if (!options.tmxPath.isEmpty() && QFileInfo::exists(options.tmxPath))
+        benchMap(runner, options.tmxPath, QFileInfo(options.tmxPath).fileName(), options.sceneMaxCells);
+}
+
+void RenderBenchmark::benchMap(BenchRunner &runner, const QString &fileName, const QString &dataset,
+                               qint64 sceneMaxCells)
+{
+    TmxMap map;
+    if (!map.load(fileName))
+    {
+        runner.skip("Render::bakedChunks", dataset, "load failed");
+        return;
+    }
+    const qint64 cells = qint64(map.m_mapWidth) * map.m_mapHeight;
+    const QRectF bounds(0, 0, map.m_mapWidth * map.m_tileWidth, map.m_mapHeight * map.m_tileHeight);
+
+    // 三个场景各自建好，计时只包含逐帧绘制
+    QGraphicsScene tileScene;
+    TileScene tiles(&map);
+    if (cells <= sceneMaxCells)
+        tiles.build(&tileScene);
+
+    BakedMap baked(&map);
+    baked.loadTilesets();
+    baked.bakeAll(std::numeric_limits<qint64>::max());
+    QGraphicsScene bakedScene;
+    bakedScene.setSceneRect(bounds);
+    for (int g = 0; g < baked.groupCount(); ++g)
+    {
+        MapLayerItem *item = new MapLayerItem(&baked, g, bounds);
+        if (baked.group(g).aboveEntities)
+            item->setZValue(ABOVE_ENTITIES_Z + g);
+        bakedScene.addItem(item);
+    }
+
+    QGraphicsScene softScene;
+    softScene.setSceneRect(bounds);
+    int below = 0;
+    while (below < baked.groupCount() && !baked.group(below).aboveEntities)
+        ++below;
+    if (below > 0)
+        softScene.addItem(new FramebufferItem(&map, &baked, 0, below - 1, bounds));
+    if (below < baked.groupCount())
+    {
+        FramebufferItem *above = new FramebufferItem(&map, &baked, below, baked.groupCount() - 1, bounds);
+        above->setZValue(ABOVE_ENTITIES_Z);
+        softScene.addItem(above);
+    }
+
+    QImage target(VIEWPORT, QImage::Format_ARGB32_Premultiplied);
+    const TileBlitter::Kernel best = TileBlitter::bestKernel();
+    for (qreal zoom : ZOOMS)
+    {
+        const QSizeF view(VIEWPORT.width() / zoom, VIEWPORT.height() / zoom);
+        const QVector<QPointF> path = panPath(bounds, view);
+        const QString zoomed = QString("%1@%2x").arg(dataset).arg(zoom);
+
+        if (cells <= sceneMaxCells)
+            runner.run("Render::perTileScene", zoomed, FRAMES, 3, [&]() { renderFrames(tileScene, target, path, view); });
+        else
+            runner.skip("Render::perTileScene", zoomed, QString("cells > %1 (use --scene-max-cells)").arg(sceneMaxCells));
+
+        runner.run("Render::bakedChunks", zoomed, FRAMES, 3, [&]() { renderFrames(bakedScene, target, path, view); });
+        const int mipLevels = baked.mipLevels();
+        baked.setMipLevels(0);
+        runner.run("Render::bakedChunks-noMip", zoomed, FRAMES, 3, [&]() { renderFrames(bakedScene, target, path, view); });
+        baked.setMipLevels(mipLevels);
+
+        for (int k = TileBlitter::Scalar; k <= TileBlitter::Avx2; ++k)
+        {
+            const TileBlitter::Kernel kernel = TileBlitter::Kernel(k);
+            const QString name = QString("Render::software-%1").arg(TileBlitter::kernelName(kernel));
+            if (kernel > best)
+            {
+                runner.skip(name, zoomed, "not supported by this CPU");
+                continue;
+            }
+            TileBlitter::setKernel(kernel);
+            runner.run(name, zoomed, FRAMES, 3, [&]() { renderFrames(softScene, target, path, view); });
+        }
+        TileBlitter::setKernel(best);
+    }
+}
@@ -0,0 +1,29 @@
+// renderbenchmark.h - 地图渲染方式的逐帧耗时对比
+#ifndef RENDERBENCHMARK_H
+#define RENDERBENCHMARK_H
+
+#include <QString>
+
+class BenchRunner;
+struct BenchOptions;
+
+/*
+ 在 1000x800 的视口里沿对角线平移 60 帧，对比三种地图渲染方式的单帧耗时（nsPerItem 即一帧）：
+ - Render::perTileScene：TileScene::build，每格一个图元（大图按 sceneMaxCells 跳过）
+ - Render::bakedChunks：MapLayerItem，每个绘制组一个图元，贴预先烘焙的区块（区块在计时前烘焙好）；
+   缩小时用对应一级的缩小区块，Render::bakedChunks-noMip 关掉缩小版作对比
+ - Render::software-<内核>：FramebufferItem，逐格合成到帧缓冲区后一次呈现，标量 / SSE2 / AVX2 各测一遍
+ 三者都通过 QGraphicsScene::render 画到同一张 QImage 上，缩放 1、0.5、0.25 各测一遍；
+ 合成地图取 256x256 和 1024x1024，再加上真实地图
+*/
+class RenderBenchmark
+{
+public:
+    static void run(BenchRunner &runner, const BenchOptions &options);
+
+private:
+    static void benchMap(BenchRunner &runner, const QString &fileName, const QString &dataset,
+                         qint64 sceneMaxCells);
+};
+
+#endif // RENDERBENCHMARK_H
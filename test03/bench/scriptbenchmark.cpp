@@ -0,0 +1,223 @@
+// scriptbenchmark.cpp - 脚本虚拟机基准实现
+#include "scriptbenchmark.h"
+#include "benchrunner.h"
+#include "scriptcompiler.h"
+#include <QPoint>
+#include <QDebug>
+#include <climits>
+
+namespace {
+const int MAP_SIZE = 128;
+const int NPC_COUNT = 500;
+const int TICKS = 100;
+const int BUDGET = 200;
+const int LOOP_COUNT = 100000;
+
+const char NPC_SCRIPT[] = R"(
+var steps = 0;
+
+// 随机走一步：横竖方向各三分之一的机会，撞墙就原地不动
+fn wander() {
+    var dx = random(3) - 1;
+    var dy = 0;
+    if (dx == 0) {
+        dy = random(3) - 1;
+    }
+    if ((dx != 0 || dy != 0) && !isObstacle(selfX() + dx, selfY() + dy)) {
+        move(dx, dy);
+        steps = steps + 1;
+    }
+    return steps;
+}
+
+// 来回巡逻：每个逻辑步走一格，走满 length 格或撞墙就掉头
+fn patrol(length) {
+    var dir = 1;
+    while (true) {
+        var i = 0;
+        while (i < length) {
+            if (!move(dir, 0)) {
+                break;
+            }
+            i = i + 1;
+            yield;
+        }
+        dir = -dir;
+        yield;
+    }
+}
+)";
+
+const char LOOP_SCRIPT[] = R"(
+fn sum(n) {
+    var s = 0;
+    var i = 0;
+    while (i < n) {
+        s = s + i * 3 % 7;
+        i = i + 1;
+    }
+    return s;
+}
+)";
+
+/* 固定种子的线性同余随机数，保证每次跑的结果相同 */
+struct Lcg
+{
+    quint32 state = 12345;
+    int next(int n) { state = state * 1664525u + 1013904223u; return int((state >> 8) % quint32(n)); }
+};
+
+struct Npc
+{
+    QPoint pos;
+    bool patrol = false;
+    ScriptInstance script;
+};
+
+/* 一群由脚本驱动的 NPC；原生函数通过 ScriptInstance::user 找到自己是哪个 NPC */
+class Crowd
+{
+public:
+    Crowd()
+    {
+        Lcg rng;
+        m_obstacles.resize(MAP_SIZE * MAP_SIZE);
+        for (int i = 0; i < m_obstacles.size(); ++i)
+            m_obstacles[i] = rng.next(5) == 0;
+
+        natives.add("selfX", 0, [](ScriptInstance &self, const qint32 *) {
+            return qint32(static_cast<Npc *>(self.user)->pos.x());
+        });
+        natives.add("selfY", 0, [](ScriptInstance &self, const qint32 *) {
+            return qint32(static_cast<Npc *>(self.user)->pos.y());
+        });
+        natives.add("isObstacle", 2, [this](ScriptInstance &, const qint32 *a) {
+            return qint32(blocked(a[0], a[1]));
+        });
+        natives.add("move", 2, [this](ScriptInstance &self, const qint32 *a) {
+            Npc *npc = static_cast<Npc *>(self.user);
+            const QPoint to = npc->pos + QPoint(a[0], a[1]);
+            if (blocked(to.x(), to.y()))
+                return qint32(0);
+            npc->pos = to;
+            return qint32(1);
+        });
+        natives.add("random", 1, [this](ScriptInstance &, const qint32 *a) {
+            return qint32(a[0] > 0 ? m_rng.next(a[0]) : 0);
+        });
+    }
+
+    bool blocked(int x, int y) const
+    {
+        return x < 0 || y < 0 || x >= MAP_SIZE || y >= MAP_SIZE || m_obstacles[y * MAP_SIZE + x];
+    }
+
+    bool compile(const QByteArray &source, QString *error)
+    {
+        if (!ScriptCompiler::compile(source, &natives, &program, error))
+            return false;
+        m_wander = program.function("wander");
+        m_patrol = program.function("patrol");
+        return true;
+    }
+
+    /* 回到初始状态：NPC 放在固定种子的随机空地上，巡逻的 NPC 开始 patrol */
+    void reset()
+    {
+        m_rng = Lcg();
+        m_npcs.resize(NPC_COUNT);
+        for (int i = 0; i < m_npcs.size(); ++i)
+        {
+            Npc &npc = m_npcs[i];
+            do
+                npc.pos = QPoint(m_rng.next(MAP_SIZE), m_rng.next(MAP_SIZE));
+            while (blocked(npc.pos.x(), npc.pos.y()));
+            npc.patrol = i % 2 == 1;
+            npc.script = ScriptInstance(&program);
+            npc.script.user = &npc;
+            if (npc.patrol)
+            {
+                const qint32 length = 3 + m_rng.next(6);
+                npc.script.start(m_patrol, &length, 1);
+            }
+        }
+    }
+
+    /* 所有 NPC 走一个逻辑步，返回执行的指令数 */
+    qint64 tick()
+    {
+        qint64 executed = 0;
+        for (Npc &npc : m_npcs)
+        {
+            const qint64 before = npc.script.executed;
+            if (!npc.patrol && npc.script.status() == ScriptInstance::Idle)
+                npc.script.start(m_wander);
+            ScriptVM::resume(npc.script, BUDGET);
+            executed += npc.script.executed - before;
+        }
+        return executed;
+    }
+
+    ScriptNatives natives;
+    ScriptProgram program;
+
+private:
+    QVector<quint8> m_obstacles;
+    QVector<Npc> m_npcs;
+    Lcg m_rng;
+    int m_wander = -1;
+    int m_patrol = -1;
+};
+}
+
+void ScriptBenchmark::run(BenchRunner &runner)
+{
+    Crowd crowd;
+    const QByteArray source(NPC_SCRIPT);
+    QString error;
+    runner.run("ScriptCompiler::compile", "npc-script", source.size(), 50, [&]() {
+        ScriptProgram program;
+        ScriptCompiler::compile(source, &crowd.natives, &program, &error);
+    });
+
+    const QString dataset = QString("%1-npcs-%2-ticks").arg(NPC_COUNT).arg(TICKS);
+    if (!crowd.compile(source, &error))
+    {
+        qWarning() << "NPC script does not compile:" << error;
+        runner.skip("ScriptVM::npcTick", dataset, error);
+        return;
+    }
+
+    // 先空跑一遍数出指令数；随机数和初始位置都固定，每次执行的指令数相同
+    crowd.reset();
+    qint64 instructions = 0;
+    for (int t = 0; t < TICKS; ++t)
+        instructions += crowd.tick();
+
+    const auto ticks = [&]() {
+        for (int t = 0; t < TICKS; ++t)
+            crowd.tick();
+    };
+    const auto reset = [&]() { crowd.reset(); };
+    runner.run("ScriptVM::resume", dataset + "-instructions", instructions, 10, ticks, reset);
+    runner.run("ScriptVM::npcTick", dataset, qint64(NPC_COUNT) * TICKS, 10, ticks, reset);
+
+    // 纯算术循环
+    ScriptNatives none;
+    ScriptProgram loop;
+    if (!ScriptCompiler::compile(QByteArray(LOOP_SCRIPT), &none, &loop, &error))
+    {
+        qWarning() << "Loop script does not compile:" << error;
+        return;
+    }
+    ScriptInstance instance(&loop);
+    const int sum = loop.function("sum");
+    const qint32 n = LOOP_COUNT;
+    instance.start(sum, &n, 1);
+    ScriptVM::resume(instance, INT_MAX);
+    const qint64 loopInstructions = instance.executed;
+    runner.run("ScriptVM::resume", QString("arith-loop-%1").arg(LOOP_COUNT), loopInstructions, 10, [&]() {
+        instance.start(sum, &n, 1);
+        ScriptVM::resume(instance, INT_MAX);
+    });
+}
@@ -0,0 +1,21 @@
+// scriptbenchmark.h - 脚本虚拟机基准
+#ifndef SCRIPTBENCHMARK_H
+#define SCRIPTBENCHMARK_H
+
+class BenchRunner;
+
+/*
+ ScriptCompiler / ScriptVM 的基准：
+ - 编译 NPC 脚本，nsPerItem 为每字节源码的耗时
+ - 500 个 NPC 在 128x128 的随机障碍地图上跑 100 个逻辑步：一半每步调用一次 wander()，
+   一半跑不返回、每步 yield 一次的 patrol()；每个 NPC 每步的预算 200 条指令。
+   同一组测量分别按指令数（每条指令的耗时，倒数即每秒指令数）和 NPC·步（每个 NPC 每步的开销）换算
+ - 纯算术循环，不调用原生函数，测解释循环本身的指令吞吐
+*/
+class ScriptBenchmark
+{
+public:
+    static void run(BenchRunner &runner);
+};
+
+#endif // SCRIPTBENCHMARK_H
@@ -0,0 +1,200 @@
+// simulationbenchmark.cpp - 游戏逻辑的逻辑步基准与检查实现
+#include "simulationbenchmark.h"
+#include "benchrunner.h"
+#include "mapbenchmark.h"
+#include "syntheticmap.h"
+#include "simulation.h"
+#include "tmxmap.h"
+#include <QScopedPointer>
+
+namespace {
+const quint32 SEED = 20240601;
+const int TICK_MAP_SIZE = 256;
+const int TICKS = 2000;
+const int HOLD_TICKS = 60;          // 每个方向键按多少步再换
+const int HIT_MAP_WIDTH = 30;       // 2000 个顾客挤在 600 格里，玩家身边一定有人
+const int HIT_MAP_HEIGHT = 20;
+const int HIT_WARMUP_TICKS = 30;    // 先走几步，让身边的顾客升到完整模型
+const int HIT_RADIUS = 2;           // 锅铲打 1 格以内，挨打之后这一步可能又走了一格
+const int REPLAY_HOLD_TICKS = 30;   // 录制：向右走一阵、挥一下锅铲、再向左走一阵
+const int REPLAY_TAIL_TICKS = 30;
+const int REPLAY_EDIT_TICK = 45;    // 回放到这一步之前改一个地面格子
+const int DIRECTION_KEYS[] = { Qt::Key_Right, Qt::Key_Down, Qt::Key_Left, Qt::Key_Up };
+
+/* 与无界面模式相同的顺序：初始物品、进入地图（玩家站在地图中间），然后播种 */
+void start(Simulation &sim, const ItemDatabase &items, const TmxMap &map, const QString &path)
+{
+    QVector<ItemState> inventory;
+    for (const Item &item : items.startingItems())
+        inventory.append(ItemState(item));
+    sim.setInventory(inventory);
+
+    SimCommand command;
+    command.type = SimCommand::EnterMap;
+    command.map = SimMap(map, path, 1);
+    command.tile = QPoint(map.m_mapWidth / 2, map.m_mapHeight / 2);
+    sim.apply(command);
+    sim.reset(SEED);
+}
+
+void input(Simulation &sim, InputEvent::Type type, int code)
+{
+    SimCommand command;
+    command.type = SimCommand::Input;
+    command.input.tick = sim.tickCount();
+    command.input.type = type;
+    command.input.code = code;
+    sim.apply(command);
+}
+
+void tick(Simulation &sim, int count)
+{
+    for (int t = 0; t < count && sim.canTick(); ++t)
+    {
+        sim.tick();
+        sim.takeEvents();
+    }
+}
+
+int slotOf(const ItemDatabase &items, const QString &toolType)
+{
+    for (int i = 0; i < items.startingItems().size(); ++i)
+        if (items.startingItems()[i].toolType() == toolType)
+            return i;
+    return -1;
+}
+
+/* 玩家周围 radius 格以内生气的顾客 */
+int angryNear(const Simulation &sim, int radius)
+{
+    SimSnapshot snapshot;
+    sim.writeSnapshot(&snapshot);
+    int n = 0;
+    for (const CustomerView &c : snapshot.customers)
+        if (c.mood == CustomerView::Angry && qAbs(c.x - snapshot.player.x()) <= radius
+                && qAbs(c.y - snapshot.player.y()) <= radius)
+            ++n;
+    return n;
+}
+
+/* 按录制回放到结束，返回 ReplayFinished 带的校验和；editTick >= 0 时在那一步之前改掉 (0, 0) 的地面瓦片，
+ 像热重载那样通过 SetTile 进来，不在输入里 */
+QByteArray replay(const World &world, const ItemDatabase &items, const TmxMap &map, const QString &path,
+                  const InputLog &log, int editTick)
+{
+    Simulation sim(world, items);
+    start(sim, items, map, path);
+    sim.startReplay(log);
+    const int ground = map.obstacleLayerIndex() == 0 ? 1 : 0;   // 不挡路的图层：只有地图本身的校验和能看出来
+    while (sim.canTick())
+    {
+        if (sim.tickCount() == editTick)
+        {
+            SimCommand command;
+            command.type = SimCommand::SetTile;
+            command.layer = ground;
+            command.tile = QPoint(0, 0);
+            command.gid = map.layer(ground).data.at(0, 0) + 1;
+            command.generation = 1;
+            sim.apply(command);
+        }
+        sim.tick();
+        for (const SimEvent &event : sim.takeEvents())
+            if (event.type == SimEvent::ReplayFinished)
+                return event.text.toLatin1();
+    }
+    return QByteArray();
+}
+
+bool loadMap(const BenchOptions &options, int width, int height, TmxMap *map, QString *path)
+{
+    *path = SyntheticMap::write(options.workDir, width, height);
+    return !path->isEmpty() && map->load(*path);
+}
+}
+
+void SimulationBenchmark::run(BenchRunner &runner, const BenchOptions &options)
+{
+    ItemDatabase items;
+    items.setIconsEnabled(false);
+    items.loadDefaults();
+
+    TmxMap tickMap;
+    QString tickPath;
+    const QString tickDataset = QString("synthetic-%1x%1").arg(TICK_MAP_SIZE);
+    if (loadMap(options, TICK_MAP_SIZE, TICK_MAP_SIZE, &tickMap, &tickPath))
+    {
+        World world;
+        world.setSingleMap(tickPath);
+        QScopedPointer<Simulation> sim;
+        const auto setup = [&]() {
+            sim.reset(new Simulation(world, items));
+            start(*sim, items, tickMap, tickPath);
+        };
+        const auto walk = [&]() {
+            for (int t = 0; t < TICKS; t += HOLD_TICKS)
+            {
+                const int key = DIRECTION_KEYS[(t / HOLD_TICKS) % 4];
+                input(*sim, InputEvent::Key, key);
+                tick(*sim, qMin(HOLD_TICKS, TICKS - t));
+                input(*sim, InputEvent::KeyRelease, key);
+            }
+        };
+        runner.run("Simulation::tick", tickDataset, TICKS, 5, walk, setup);
+    }
+    else
+    {
+        runner.skip("Simulation::tick", tickDataset, "cannot write or load the synthetic map");
+    }
+
+    TmxMap hitMap;
+    QString hitPath;
+    const QString hitDataset = QString("synthetic-%1x%2").arg(HIT_MAP_WIDTH).arg(HIT_MAP_HEIGHT);
+    const int shovel = slotOf(items, "锅铲");
+    const int ladle = slotOf(items, "汤勺");
+    if (!loadMap(options, HIT_MAP_WIDTH, HIT_MAP_HEIGHT, &hitMap, &hitPath) || shovel < 0 || ladle < 0)
+    {
+        runner.check("Simulation::applyItem-hitEntities", hitDataset, false,
+                     "cannot load the synthetic map or the default 锅铲 / 汤勺");
+        return;
+    }
+    World world;
+    world.setSingleMap(hitPath);
+    Simulation hit(world, items);
+    Simulation control(world, items);
+    start(hit, items, hitMap, hitPath);
+    start(control, items, hitMap, hitPath);
+    tick(hit, HIT_WARMUP_TICKS);
+    tick(control, HIT_WARMUP_TICKS);
+    input(hit, InputEvent::SlotClick, shovel);
+    input(control, InputEvent::SlotClick, ladle);
+    tick(hit, 1);
+    tick(control, 1);
+
+    const int angry = angryNear(hit, HIT_RADIUS);
+    const int angryControl = angryNear(control, HIT_RADIUS);
+    runner.check("Simulation::applyItem-hitEntities", hitDataset,
+                 angry > angryControl && hit.checksum() != control.checksum(),
+                 QString("%1 angry customers near the player after 锅铲, %2 after 汤勺")
+                 .arg(angry).arg(angryControl));
+
+    // 录一段，原样回放要得到同一个校验和；回放中途改一个地面格子，校验和就必须对不上
+    Simulation recorded(world, items);
+    start(recorded, items, hitMap, hitPath);
+    recorded.startRecording();
+    input(recorded, InputEvent::Key, Qt::Key_Right);
+    tick(recorded, REPLAY_HOLD_TICKS);
+    input(recorded, InputEvent::KeyRelease, Qt::Key_Right);
+    input(recorded, InputEvent::SlotClick, shovel);
+    input(recorded, InputEvent::Key, Qt::Key_Left);
+    tick(recorded, REPLAY_TAIL_TICKS);
+    input(recorded, InputEvent::KeyRelease, Qt::Key_Left);
+    const InputLog log = recorded.finishRecording();
+
+    const QByteArray same = replay(world, items, hitMap, hitPath, log, -1);
+    const QByteArray edited = replay(world, items, hitMap, hitPath, log, REPLAY_EDIT_TICK);
+    runner.check("Simulation::replay-tileEdit", hitDataset,
+                 same == log.checksum && !edited.isEmpty() && edited != log.checksum,
+                 QString("recorded %1, replayed %2, replayed with a tile edit %3")
+                 .arg(QString::fromLatin1(log.checksum), QString::fromLatin1(same), QString::fromLatin1(edited)));
+}
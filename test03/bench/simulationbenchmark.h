@@ -0,0 +1,22 @@
+// simulationbenchmark.h - 游戏逻辑（Simulation）的逻辑步基准与检查
+#ifndef SIMULATIONBENCHMARK_H
+#define SIMULATIONBENCHMARK_H
+
+class BenchRunner;
+struct BenchOptions;
+
+/*
+ 在合成地图上直接驱动 Simulation（与无界面模式一样，不开模拟线程），物品用内置的默认物品：
+ - Simulation::tick：256x256 的街上 2000 个顾客，玩家按住方向键来回走，nsPerItem 即一个逻辑步
+ - 检查 Simulation::applyItem-hitEntities：30x20 的小街挤满顾客，玩家站在中间用锅铲（hitEntities），
+   身边的顾客要生气；同一种子换成汤勺作对照，两边的校验和也必须不同
+ - 检查 Simulation::replay-tileEdit：同一条街上录一段，原样回放的校验和要与录制一致；
+   回放中途用 SetTile 改一个地面格子（不挡路，顾客和玩家都不受影响），校验和必须对不上
+*/
+class SimulationBenchmark
+{
+public:
+    static void run(BenchRunner &runner, const BenchOptions &options);
+};
+
+#endif // SIMULATIONBENCHMARK_H
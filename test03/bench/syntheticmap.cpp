@@ -0,0 +1,123 @@
+// syntheticmap.cpp - 合成地图生成
+#include "syntheticmap.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QImage>
+#include <QPainter>
+#include <QDebug>
+
+namespace {
+const int TILE = 32;
+const int COLUMNS = 12;
+const int TILE_COUNT = 72;
+
+/* 简单的线性同余生成器，保证跨平台结果一致 */
+struct Lcg
+{
+    quint32 state;
+    explicit Lcg(quint32 seed) : state(seed) {}
+    quint32 next() { state = state * 1664525u + 1013904223u; return state >> 8; }
+};
+
+/* 直接往 QByteArray 里写十进制数字，4096x4096 的图层有上千万个数，不能逐个走 QString */
+void appendInt(QByteArray &out, int v)
+{
+    char buf[12];
+    int n = 0;
+    do { buf[n++] = char('0' + v % 10); v /= 10; } while (v > 0);
+    while (n > 0) out.append(buf[--n]);
+}
+
+/* density 为非空格子的比例（千分比），gidBase/gidRange 决定使用哪些瓦片 */
+QByteArray layerCsv(int width, int height, quint32 seed, int density, int gidBase, int gidRange)
+{
+    QByteArray csv;
+    csv.reserve(qint64(width) * height * 3);
+    Lcg rng(seed);
+    for (int y = 0; y < height; ++y)
+    {
+        csv.append('\n');
+        for (int x = 0; x < width; ++x)
+        {
+            int gid = 0;
+            if (int(rng.next() % 1000) < density)
+                gid = gidBase + int(rng.next() % gidRange);
+            appendInt(csv, gid);
+            if (x != width - 1 || y != height - 1)
+                csv.append(',');
+        }
+    }
+    csv.append('\n');
+    return csv;
+}
+}
+
+bool SyntheticMap::writeTileset(const QString &fileName)
+{
+    if (QFileInfo::exists(fileName))
+        return true;
+
+    // 每个瓦片一种颜色，带一圈半透明边，尽量接近真实图块集的 alpha 分布
+    QImage img(COLUMNS * TILE, (TILE_COUNT / COLUMNS) * TILE, QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::transparent);
+    QPainter p(&img);
+    for (int i = 0; i < TILE_COUNT; ++i)
+    {
+        QRect r((i % COLUMNS) * TILE, (i / COLUMNS) * TILE, TILE, TILE);
+        p.fillRect(r.adjusted(2, 2, -2, -2), QColor::fromHsv((i * 37) % 360, 160, 200));
+        p.fillRect(QRect(r.topLeft(), QSize(TILE, 2)), QColor(0, 0, 0, 80));
+    }
+    p.end();
+    return img.save(fileName);
+}
+
+QString SyntheticMap::write(const QString &dir, int width, int height)
+{
+    QDir d(dir);
+    if (!writeTileset(d.absoluteFilePath("synthetic_tiles.png")))
+    {
+        qWarning() << "Cannot write synthetic tileset in" << dir;
+        return QString();
+    }
+
+    QString fileName = d.absoluteFilePath(QString("synthetic_%1x%2.tmx").arg(width).arg(height));
+    if (QFileInfo::exists(fileName))
+        return fileName;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Cannot write" << fileName;
+        return QString();
+    }
+
+    const QByteArray w = QByteArray::number(width);
+    const QByteArray h = QByteArray::number(height);
+
+    file.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    file.write("<map version=\"1.9\" orientation=\"orthogonal\" renderorder=\"right-down\" width=\""
+               + w + "\" height=\"" + h + "\" tilewidth=\"32\" tileheight=\"32\" infinite=\"0\">\n");
+    file.write(" <tileset firstgid=\"1\" name=\"synthetic\" tilewidth=\"32\" tileheight=\"32\" "
+               "tilecount=\"72\" columns=\"12\">\n"
+               "  <image source=\"synthetic_tiles.png\" width=\"384\" height=\"192\"/>\n"
+               " </tileset>\n");
+
+    struct LayerSpec { const char *name; int density; int gidBase; int gidRange; };
+    const LayerSpec layers[] = {
+        { "Ground",     1000, 13, 12 },
+        { "Decoration",  100, 25, 18 },
+        { "Obstacle",     80, 44,  5 },
+    };
+
+    quint32 seed = 20251122u;
+    for (const LayerSpec &spec : layers)
+    {
+        file.write(QByteArray(" <layer name=\"") + spec.name + "\" width=\"" + w
+                   + "\" height=\"" + h + "\">\n  <data encoding=\"csv\">");
+        file.write(layerCsv(width, height, seed++, spec.density, spec.gidBase, spec.gidRange));
+        file.write("</data>\n </layer>\n");
+    }
+    file.write("</map>\n");
+    return fileName;
+}
@@ -0,0 +1,23 @@
+// syntheticmap.h - 生成基准用的合成地图
+#ifndef SYNTHETICMAP_H
+#define SYNTHETICMAP_H
+
+#include <QString>
+
+/*
+ 生成与 c.tmx 结构相同的 TMX 文件：
+ 一个 384x192、72 个瓦片的图块集（与 buch-outdoor.png 同尺寸），
+ 三个 CSV 图层：地面（全部非空）、装饰（约 10% 非空）、Obstacle（约 8% 非空）。
+ 内容由固定种子的伪随机数决定，同样的尺寸每次生成的文件完全一样。
+*/
+class SyntheticMap
+{
+public:
+    /* 在 dir 下生成 synthetic_<w>x<h>.tmx，返回其路径；失败返回空字符串 */
+    static QString write(const QString &dir, int width, int height);
+
+private:
+    static bool writeTileset(const QString &fileName);
+};
+
+#endif // SYNTHETICMAP_H
@@ -0,0 +1,126 @@
+/* camera.cpp - 摄像机实现
+每帧流程：
+1. 前瞻偏移向“朝向 × 前瞻距离”平滑过渡
+2. 目标点（玩家中心 + 前瞻）离开死区时，拖动死区中心
+3. 死区中心限制在地图范围内，作为期望中心
+4. 当前中心以指数衰减逼近期望中心，最后取整得到视口左上角
+*/
+#include "camera.h"
+#include <QtMath>
+
+Camera::Camera() {}
+
+void Camera::setViewportSize(const QSizeF &size)
+{
+    m_viewport = size;
+}
+
+void Camera::setBounds(const QRectF &bounds)
+{
+    m_bounds = bounds;
+}
+
+void Camera::setDeadZone(const QSizeF &size)
+{
+    m_deadZone = size;
+}
+
+void Camera::setLookahead(qreal distance)
+{
+    m_lookahead = distance;
+}
+
+void Camera::setSmoothTime(qreal ms)
+{
+    m_smoothTime = qMax<qreal>(1.0, ms);
+}
+
+void Camera::follow(const QPointF &target, const QPointF &direction)
+{
+    m_target = target;
+
+    // 朝向归一化，斜向移动时前瞻距离不变
+    qreal len = qSqrt(direction.x() * direction.x() + direction.y() * direction.y());
+    m_direction = len > 0 ? direction / len : QPointF();
+}
+
+void Camera::snapToTarget()
+{
+    m_lookaheadOffset = m_direction * m_lookahead;
+    m_focus = clampCenter(m_target + m_lookaheadOffset);
+    m_center = m_focus;
+    m_topLeft = roundedTopLeft();
+}
+
+bool Camera::update(qreal dtMs)
+{
+    // 指数衰减系数：与帧率无关，dt 越大追得越多
+    const qreal alpha = 1.0 - qExp(-qMax<qreal>(0, dtMs) / m_smoothTime);
+
+    m_lookaheadOffset += (m_direction * m_lookahead - m_lookaheadOffset) * alpha;
+
+    updateFocus();
+    const QPointF desired = m_focus;
+    QPointF delta = desired - m_center;
+    if (qAbs(delta.x()) < 0.25 && qAbs(delta.y()) < 0.25)
+        m_center = desired; // 足够接近，直接吸附，避免无限逼近导致每帧都在动
+    else
+        m_center += delta * alpha;
+
+    QPoint topLeft = roundedTopLeft();
+    if (topLeft == m_topLeft)
+        return false;
+    m_topLeft = topLeft;
+    return true;
+}
+
+bool Camera::isSettled() const
+{
+    return m_center == m_focus;
+}
+
+void Camera::updateFocus()
+{
+    // 死区：目标点只要还在死区内，死区中心就不动
+    QPointF point = m_target + m_lookaheadOffset;
+    QPointF &focus = m_focus;
+    const qreal hw = m_deadZone.width() / 2.0;
+    const qreal hh = m_deadZone.height() / 2.0;
+
+    if (point.x() > focus.x() + hw) focus.setX(point.x() - hw);
+    else if (point.x() < focus.x() - hw) focus.setX(point.x() + hw);
+    if (point.y() > focus.y() + hh) focus.setY(point.y() - hh);
+    else if (point.y() < focus.y() - hh) focus.setY(point.y() + hh);
+
+    // 死区中心本身也要限制在地图内，否则走回来时会有一段“空走”
+    focus = clampCenter(focus);
+}
+
+QPointF Camera::clampCenter(const QPointF &c) const
+{
+    if (m_bounds.isEmpty())
+        return c;
+
+    QPointF r = c;
+    const qreal hw = m_viewport.width() / 2.0;
+    const qreal hh = m_viewport.height() / 2.0;
+
+    // 地图比视口窄/矮：居中显示
+    if (m_bounds.width() <= m_viewport.width())
+        r.setX(m_bounds.center().x());
+    else
+        r.setX(qBound(m_bounds.left() + hw, c.x(), m_bounds.right() - hw));
+
+    if (m_bounds.height() <= m_viewport.height())
+        r.setY(m_bounds.center().y());
+    else
+        r.setY(qBound(m_bounds.top() + hh, c.y(), m_bounds.bottom() - hh));
+
+    return r;
+}
+
+QPoint Camera::roundedTopLeft() const
+{
+    return QPoint(qRound(m_center.x() - m_viewport.width() / 2.0),
+                  qRound(m_center.y() - m_viewport.height() / 2.0));
+}
@@ -0,0 +1,62 @@
+// camera.h - 跟随玩家的摄像机
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <QPointF>
+#include <QSizeF>
+#include <QRectF>
+#include <QPoint>
+
+/*
+ 摄像机只负责计算“视口左上角应该在场景中的哪个位置”，不直接操作 QGraphicsView。
+ 1. 死区（dead zone）：目标在视口中心附近的死区内移动时，摄像机不动
+ 2. 前瞻（lookahead）：沿玩家朝向提前偏移一段距离，看到前方更多内容
+ 3. 平滑：用指数衰减逼近目标，与帧率无关
+ 4. 边界限制：视口不会滚出地图；地图比视口小时居中显示
+ 输出的位置始终是整数像素，这样 QGraphicsView 滚动时可以直接复用已绘制的像素，
+ 只重绘新露出来的条带。
+*/
+class Camera
+{
+public:
+    Camera();
+
+    void setViewportSize(const QSizeF &size);   // 视口大小（场景坐标）
+    void setBounds(const QRectF &bounds);       // 地图范围（场景坐标）
+    void setDeadZone(const QSizeF &size);       // 以视口中心为中心的死区大小
+    void setLookahead(qreal distance);          // 朝向方向上的前瞻距离（像素）
+    void setSmoothTime(qreal ms);               // 约等于追上目标所需时间的 1/3
+
+    /* 设置跟随目标：target 为目标中心点，direction 为朝向（如 (1,0) 表示向右） */
+    void follow(const QPointF &target, const QPointF &direction = QPointF());
+
+    /* 立即跳到目标位置（初始化、切换地图时使用） */
+    void snapToTarget();
+
+    /* 推进 dtMs 毫秒，返回整数位置是否发生变化 */
+    bool update(qreal dtMs);
+
+    QPoint topLeft() const { return m_topLeft; }   // 视口左上角（整数像素）
+    QPointF center() const { return m_center; }    // 当前中心（浮点）
+    bool isSettled() const;                        // 是否已经追上目标
+
+private:
+    void updateFocus();              // 死区 + 前瞻 + 边界限制，得到期望中心 m_focus
+    QPointF clampCenter(const QPointF &c) const;
+    QPoint roundedTopLeft() const;
+
+    QSizeF m_viewport;
+    QRectF m_bounds;
+    QSizeF m_deadZone = QSizeF(64, 48);
+    qreal m_lookahead = 48;
+    qreal m_smoothTime = 90;
+
+    QPointF m_target;          // 跟随目标中心
+    QPointF m_direction;       // 目标朝向（单位向量或 0）
+    QPointF m_lookaheadOffset; // 当前前瞻偏移（平滑过渡，避免转身时镜头跳动）
+    QPointF m_focus;           // 死区中心（即期望中心）
+    QPointF m_center;          // 摄像机当前中心
+    QPoint m_topLeft;
+};
+
+#endif // CAMERA_H
@@ -0,0 +1,149 @@
+// collision.cpp - 瓦片碰撞形状和扫掠 AABB 实现
+#include "collision.h"
+#include "tmxmap.h"
+#include <QtMath>
+
+void TileShapes::build(const QVector<Tile> &tiles)
+{
+    int maxGid = 0;
+    for (const Tile &t : tiles)
+        maxGid = qMax(maxGid, t.id);
+
+    QVector<int> counts(maxGid + 1, 0);
+    for (const Tile &t : tiles)
+        counts[t.id] = t.collision.size();
+
+    m_offsets.resize(maxGid + 2);
+    m_offsets[0] = 0;
+    for (int gid = 0; gid <= maxGid; ++gid)
+        m_offsets[gid + 1] = m_offsets[gid] + counts[gid];
+    m_boxes.resize(m_offsets.last());
+    for (const Tile &t : tiles)
+        for (int i = 0; i < t.collision.size(); ++i)
+            m_boxes[m_offsets[t.id] + i] = t.collision[i];
+    if (m_boxes.isEmpty())
+        m_offsets.clear();
+}
+
+void CollisionGrid::reset(int width, int height, int tileWidth, int tileHeight)
+{
+    m_width = qMax(0, width);
+    m_height = qMax(0, height);
+    m_tileWidth = qMax(1, tileWidth);
+    m_tileHeight = qMax(1, tileHeight);
+    m_kinds.fill(char(Empty), m_width * m_height);
+    m_shapes.clear();
+}
+
+void CollisionGrid::setCell(int x, int y, Kind kind, const QVector<QRectF> &boxes)
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+        return;
+    const int cell = y * m_width + x;
+    if (kind == Shaped && boxes.isEmpty())
+        kind = Empty;
+    m_kinds[cell] = char(kind);
+    if (kind == Shaped)
+        m_shapes.insert(cell, boxes);
+    else
+        m_shapes.remove(cell);
+}
+
+CollisionGrid::Kind CollisionGrid::kind(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= m_width || y >= m_height)
+        return Empty;
+    return Kind(m_kinds.at(y * m_width + x));
+}
+
+bool CollisionGrid::overlaps(const QRectF &box) const
+{
+    const int x0 = qMax(0, qFloor(box.left() / m_tileWidth)), x1 = qMin(m_width - 1, qFloor(box.right() / m_tileWidth));
+    const int y0 = qMax(0, qFloor(box.top() / m_tileHeight)), y1 = qMin(m_height - 1, qFloor(box.bottom() / m_tileHeight));
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            const Kind k = Kind(m_kinds.at(y * m_width + x));
+            if (k == Empty)
+                continue;
+            const QPointF origin(x * m_tileWidth, y * m_tileHeight);
+            if (k == Full)
+            {
+                if (box.intersects(QRectF(origin, QSizeF(m_tileWidth, m_tileHeight))))
+                    return true;
+                continue;
+            }
+            const auto it = m_shapes.constFind(y * m_width + x);
+            if (it == m_shapes.constEnd())
+                continue;
+            for (const QRectF &shape : it.value())
+                if (box.intersects(shape.translated(origin)))
+                    return true;
+        }
+    }
+    return false;
+}
+
+qreal CollisionGrid::sweep(const QRectF &box, qreal delta, bool horizontal) const
+{
+    if (delta == 0)
+        return 0;
+
+    const QRectF swept = box.united(horizontal ? box.translated(delta, 0) : box.translated(0, delta));
+    const int x0 = qMax(0, qFloor(swept.left() / m_tileWidth)), x1 = qMin(m_width - 1, qFloor(swept.right() / m_tileWidth));
+    const int y0 = qMax(0, qFloor(swept.top() / m_tileHeight)), y1 = qMin(m_height - 1, qFloor(swept.bottom() / m_tileHeight));
+
+    // 挡在前面的框把 delta 截短到刚好贴上
+    const auto clip = [&](const QRectF &solid) {
+        if (box.intersects(solid))
+            return;
+        if (horizontal)
+        {
+            if (box.bottom() <= solid.top() || box.top() >= solid.bottom())
+                return;
+            if (delta > 0 && solid.left() >= box.right())
+                delta = qMin(delta, solid.left() - box.right());
+            else if (delta < 0 && solid.right() <= box.left())
+                delta = qMax(delta, solid.right() - box.left());
+        }
+        else
+        {
+            if (box.right() <= solid.left() || box.left() >= solid.right())
+                return;
+            if (delta > 0 && solid.top() >= box.bottom())
+                delta = qMin(delta, solid.top() - box.bottom());
+            else if (delta < 0 && solid.bottom() <= box.top())
+                delta = qMax(delta, solid.bottom() - box.top());
+        }
+    };
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        for (int x = x0; x <= x1; ++x)
+        {
+            const Kind k = Kind(m_kinds.at(y * m_width + x));
+            if (k == Empty)
+                continue;
+            const QPointF origin(x * m_tileWidth, y * m_tileHeight);
+            if (k == Full)
+            {
+                clip(QRectF(origin, QSizeF(m_tileWidth, m_tileHeight)));
+                continue;
+            }
+            const auto it = m_shapes.constFind(y * m_width + x);
+            if (it == m_shapes.constEnd())
+                continue;
+            for (const QRectF &shape : it.value())
+                clip(shape.translated(origin));
+        }
+    }
+    return delta;
+}
+
+QPointF CollisionGrid::move(const QRectF &box, const QPointF &delta) const
+{
+    const qreal dx = sweep(box, delta.x(), true);
+    const qreal dy = sweep(box.translated(dx, 0), delta.y(), false);
+    return QPointF(dx, dy);
+}
@@ -0,0 +1,67 @@
+// collision.h - 瓦片碰撞形状和扫掠 AABB
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <QVector>
+#include <QRectF>
+#include <QByteArray>
+#include <QHash>
+
+struct Tile;
+
+/*
+ TileShapes：每个 GID 的碰撞框（瓦片内的像素坐标），来自图块集里 <tile> 的 <objectgroup>
+ 编译成按 GID 下标的一个连续数组：m_offsets[gid] 到 m_offsets[gid + 1] 是这个 GID 的框
+*/
+class TileShapes
+{
+public:
+    void build(const QVector<Tile> &tiles);
+    bool isEmpty() const { return m_boxes.isEmpty(); }
+    bool hasShape(int gid) const { return count(gid) > 0; }
+    int count(int gid) const
+    {
+        return gid >= 0 && gid + 1 < m_offsets.size() ? m_offsets[gid + 1] - m_offsets[gid] : 0;
+    }
+    const QRectF *boxes(int gid) const { return m_boxes.constData() + m_offsets[gid]; }
+
+private:
+    QVector<int> m_offsets;
+    QVector<QRectF> m_boxes;
+};
+
+/*
+ CollisionGrid：按格子记录哪里挡路，给像素级移动做扫掠 AABB
+ - 每格一个字节：空、整格挡住、按形状挡住；按形状的格子另外存着合并后的碰撞框
+ - move 把移动拆成先横后竖两段，每段只看扫过的范围覆盖的格子，碰到就停在边上，
+   另一个方向照走，所以能贴着桌角滑过去
+ - 一开始就重叠的框不挡（刚在脚下放了障碍物也能走出来）
+ 地图外不算障碍，由调用方自己限制在地图里。
+*/
+class CollisionGrid
+{
+public:
+    enum Kind : quint8 { Empty, Full, Shaped };
+
+    void reset(int width, int height, int tileWidth, int tileHeight);
+    /* boxes 为 Shaped 格子的碰撞框（瓦片内的像素坐标） */
+    void setCell(int x, int y, Kind kind, const QVector<QRectF> &boxes = QVector<QRectF>());
+    Kind kind(int x, int y) const;
+
+    /* box（像素）是否碰到任何碰撞框 */
+    bool overlaps(const QRectF &box) const;
+    /* box 想移动 delta，返回实际能走的位移 */
+    QPointF move(const QRectF &box, const QPointF &delta) const;
+
+private:
+    qreal sweep(const QRectF &box, qreal delta, bool horizontal) const;
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_tileWidth = 1;
+    int m_tileHeight = 1;
+    QByteArray m_kinds;
+    QHash<int, QVector<QRectF>> m_shapes;   // 格子下标 → Shaped 格子的碰撞框
+};
+
+#endif // COLLISION_H
@@ -0,0 +1,512 @@
+// crowd.cpp - 分级推进的人群模拟实现
+#include "crowd.h"
+#include <QDataStream>
+
+namespace {
+const int STEP_TICKS = 10;         // 走一格用几个逻辑步（比玩家慢）
+const int HUNGER_LIMIT = 3600;     // 饿到这个程度就去摊位（约 1 分钟）
+const int SERVE_TICKS = 30;        // 摊位服务一个顾客要几个逻辑步
+const int WANDER_RADIUS = 12;
+const int GIVE_UP_STEPS = 8;       // 连续走不动几步就放弃当前目标
+const int WALKABLE_SEARCH = 8;     // 找最近空地的最大半径
+}
+
+bool Crowd::blocked(int x, int y) const
+{
+    return x < 0 || y < 0 || x >= m_width || y >= m_height || m_blocked.testBit(y * m_width + x);
+}
+
+void Crowd::clear()
+{
+    m_customers.clear();
+    m_full.clear();
+    m_stalls.clear();
+    m_cellHead.clear();
+    m_blocked.clear();
+    m_width = m_height = 0;
+    m_coarseCursor = 0;
+}
+
+void Crowd::populate(int width, int height, const QBitArray &blocked, const QVector<Stall> &stalls,
+                     int count, quint32 seed, qint64 now)
+{
+    clear();
+    if (width <= 0 || height <= 0 || blocked.size() != width * height)
+        return;
+    m_width = width;
+    m_height = height;
+    m_blocked = blocked;
+    m_seed = seed;
+    m_cellsX = (width + CELL_SIZE - 1) / CELL_SIZE;
+    m_cellsY = (height + CELL_SIZE - 1) / CELL_SIZE;
+    m_cellHead.fill(-1, m_cellsX * m_cellsY);
+
+    // 摊位本身常常是障碍（柜台），顾客站到旁边最近的空地上买
+    m_stalls = stalls;
+    for (Stall &s : m_stalls)
+        s.tile = nearestWalkable(s.tile);
+
+    m_customers.resize(count);
+    for (int i = 0; i < count; ++i)
+    {
+        Customer &c = m_customers[i];
+        c.rng.setSeed(seed ^ (0x9E3779B9u * quint32(i + 1)));
+        spawn(c, false);
+        c.lastTick = now;
+        moveToCell(i);
+    }
+}
+
+void Crowd::setBlocked(int x, int y, bool isBlocked)
+{
+    if (x >= 0 && y >= 0 && x < m_width && y < m_height)
+        m_blocked.setBit(y * m_width + x, isBlocked);
+}
+
+QPoint Crowd::randomWalkable(GameRandom &rng, const QPoint &near, int radius) const
+{
+    for (int attempt = 0; attempt < 16; ++attempt)
+    {
+        const QPoint p = near + QPoint(rng.bounded(2 * radius + 1) - radius, rng.bounded(2 * radius + 1) - radius);
+        if (!blocked(p.x(), p.y()))
+            return p;
+    }
+    return near;
+}
+
+QPoint Crowd::nearestWalkable(const QPoint &tile) const
+{
+    if (!blocked(tile.x(), tile.y()))
+        return tile;
+    // 一圈一圈往外找，同一圈里按固定顺序，结果确定
+    for (int r = 1; r <= WALKABLE_SEARCH; ++r)
+    {
+        for (int d = -r; d <= r; ++d)
+        {
+            const QPoint candidates[4] = { tile + QPoint(d, r), tile + QPoint(-r, d),
+                                           tile + QPoint(r, d), tile + QPoint(d, -r) };
+            for (const QPoint &p : candidates)
+                if (!blocked(p.x(), p.y()))
+                    return p;
+        }
+    }
+    return QPoint(qBound(0, tile.x(), m_width - 1), qBound(0, tile.y(), m_height - 1));
+}
+
+/* 新顾客：atEdge 时从地图边缘进来（走掉的顾客由新来的补上，人数不变） */
+void Crowd::spawn(Customer &c, bool atEdge)
+{
+    GameRandom &rng = c.rng;
+    QPoint tile(rng.bounded(m_width), rng.bounded(m_height));
+    for (int attempt = 0; attempt < 32; ++attempt)
+    {
+        if (atEdge)
+        {
+            const int side = rng.bounded(4);
+            const int along = rng.bounded(side < 2 ? m_width : m_height);
+            tile = side == 0 ? QPoint(along, 0) : side == 1 ? QPoint(along, m_height - 1)
+                 : side == 2 ? QPoint(0, along) : QPoint(m_width - 1, along);
+        }
+        else
+        {
+            tile = QPoint(rng.bounded(m_width), rng.bounded(m_height));
+        }
+        if (!blocked(tile.x(), tile.y()))
+            break;
+    }
+
+    c.tile = c.from = tile;
+    c.target = randomWalkable(rng, tile, WANDER_RADIUS);
+    c.money = 20 + rng.bounded(100);
+    c.hunger = rng.bounded(HUNGER_LIMIT);
+    c.patience = 300 + rng.bounded(900);
+    c.stepTicks = 1 + rng.bounded(STEP_TICKS);
+    c.stall = -1;
+    c.stuck = 0;
+    c.angry = false;
+    c.state = Wandering;
+}
+
+/* 需求随时间变化：到了预约的时间就买，饿了就挑一个买得起的最近摊位 */
+void Crowd::advanceNeeds(Customer &c, qint64 elapsed, qint64 now)
+{
+    c.hunger = int(qMin<qint64>(c.hunger + elapsed, 1 << 30));
+
+    if (c.state == Waiting && now >= c.serveTick)
+    {
+        Stall &s = m_stalls[c.stall];
+        c.money -= s.price;
+        s.revenue += s.price;
+        ++s.served;
+        c.hunger = 0;
+        c.angry = false;
+        c.stall = -1;
+        c.state = Wandering;
+        c.target = randomWalkable(c.rng, c.tile, WANDER_RADIUS);
+    }
+
+    if (c.state == Wandering && c.hunger >= HUNGER_LIMIT)
+    {
+        int best = -1;
+        int bestDistance = 0;
+        for (int i = 0; i < m_stalls.size(); ++i)
+        {
+            if (m_stalls[i].price > c.money)
+                continue;
+            const int d = (m_stalls[i].tile - c.tile).manhattanLength();
+            if (best < 0 || d < bestDistance)
+            {
+                best = i;
+                bestDistance = d;
+            }
+        }
+        if (best >= 0)
+        {
+            c.state = Heading;
+            c.stall = qint16(best);
+            c.target = m_stalls[best].tile;
+        }
+        else
+        {
+            // 钱不够了：回家，换一个新顾客来
+            c.state = Leaving;
+            c.target = nearestWalkable(c.tile.x() < m_width / 2 ? QPoint(0, c.tile.y()) : QPoint(m_width - 1, c.tile.y()));
+        }
+    }
+}
+
+/* 到达目标（或者走不过去放弃了） */
+void Crowd::arrive(Customer &c, qint64 now)
+{
+    c.stuck = 0;
+    switch (c.state)
+    {
+    case Wandering:
+        c.target = randomWalkable(c.rng, c.tile, WANDER_RADIUS);
+        break;
+    case Heading:
+    {
+        // 聚合的排队模型：预约摊位下一个空闲时间，等得比耐心还久就生气走掉
+        Stall &s = m_stalls[c.stall];
+        const qint64 serve = qMax(now, s.nextFree);
+        if (serve - now > c.patience)
+        {
+            ++s.turnedAway;
+            c.angry = true;
+            leave(c);
+            break;
+        }
+        s.nextFree = serve + SERVE_TICKS;
+        c.serveTick = serve;
+        c.state = Waiting;
+        break;
+    }
+    case Waiting:
+        break;
+    case Leaving:
+        spawn(c, true);
+        break;
+    }
+}
+
+/* 生气走掉：放弃摊位，往近的上下边缘走，走到了换一个新顾客来 */
+void Crowd::leave(Customer &c)
+{
+    c.stall = -1;
+    c.state = Leaving;
+    c.target = nearestWalkable(QPoint(c.tile.x(), c.tile.y() < m_height / 2 ? 0 : m_height - 1));
+}
+
+/* 完整模型走一格：先走差得多的那个方向，挡住了换另一个方向，都挡住就随便挑一个能走的方向 */
+void Crowd::step(Customer &c)
+{
+    const QPoint d = c.target - c.tile;
+    const QPoint sx(d.x() > 0 ? 1 : -1, 0);
+    const QPoint sy(0, d.y() > 0 ? 1 : -1);
+    QPoint options[2];
+    int n = 0;
+    if (qAbs(d.x()) >= qAbs(d.y()))
+    {
+        if (d.x() != 0) options[n++] = sx;
+        if (d.y() != 0) options[n++] = sy;
+    }
+    else
+    {
+        options[n++] = sy;
+        if (d.x() != 0) options[n++] = sx;
+    }
+    for (int i = 0; i < n; ++i)
+    {
+        const QPoint next = c.tile + options[i];
+        if (!blocked(next.x(), next.y()))
+        {
+            c.tile = next;
+            c.stuck = 0;
+            return;
+        }
+    }
+
+    static const QPoint DIRS[4] = { QPoint(1, 0), QPoint(-1, 0), QPoint(0, 1), QPoint(0, -1) };
+    const QPoint side = DIRS[c.rng.bounded(4)];
+    if (!blocked(c.tile.x() + side.x(), c.tile.y() + side.y()))
+        c.tile += side;
+    ++c.stuck;
+}
+
+void Crowd::tickFull(int index, qint64 now)
+{
+    Customer &c = m_customers[index];
+    advanceNeeds(c, now - c.lastTick, now);
+    c.lastTick = now;
+    if (c.state == Waiting)
+    {
+        c.from = c.tile;
+        return;
+    }
+    if (--c.stepTicks > 0)
+        return;
+
+    c.stepTicks = STEP_TICKS;
+    c.from = c.tile;
+    if (c.tile != c.target)
+    {
+        step(c);
+        moveToCell(index);
+    }
+    if (c.tile == c.target || c.stuck >= GIVE_UP_STEPS)
+    {
+        arrive(c, now);
+        moveToCell(index);   // 离开的顾客换成了边缘的新顾客
+    }
+}
+
+/* 粗略模型：一次补上经过的逻辑步，沿直线走过去，不看障碍 */
+void Crowd::tickCoarse(int index, qint64 now)
+{
+    Customer &c = m_customers[index];
+    const qint64 elapsed = now - c.lastTick;
+    advanceNeeds(c, elapsed, now);
+    c.lastTick = now;
+    if (c.state == Waiting)
+        return;
+
+    const qint64 ticks = c.stepTicks + elapsed;
+    int steps = int(qMin<qint64>(ticks / STEP_TICKS, m_width + m_height));
+    c.stepTicks = int(ticks % STEP_TICKS);
+    while (steps > 0 && c.tile != c.target)
+    {
+        const QPoint d = c.target - c.tile;
+        if (qAbs(d.x()) >= qAbs(d.y()))
+        {
+            const int n = qMin(steps, qAbs(d.x()));
+            c.tile.rx() += d.x() > 0 ? n : -n;
+            steps -= n;
+        }
+        else
+        {
+            const int n = qMin(steps, qAbs(d.y()));
+            c.tile.ry() += d.y() > 0 ? n : -n;
+            steps -= n;
+        }
+    }
+    c.from = c.tile;
+    if (c.tile == c.target)
+        arrive(c, now);
+    moveToCell(index);
+}
+
+void Crowd::promote(const QRect &range, qint64 now)
+{
+    if (m_full.size() >= MAX_FULL)
+        return;
+
+    // 先收集再处理：补步会让顾客换块，边遍历链表边改会漏掉或重复
+    int candidates[SCAN_BUDGET];
+    int found = 0;
+    int visited = 0;
+    const int cx0 = qMax(0, range.left() / CELL_SIZE), cx1 = qMin(m_cellsX - 1, range.right() / CELL_SIZE);
+    const int cy0 = qMax(0, range.top() / CELL_SIZE), cy1 = qMin(m_cellsY - 1, range.bottom() / CELL_SIZE);
+    for (int cy = cy0; cy <= cy1 && visited < SCAN_BUDGET; ++cy)
+    {
+        for (int cx = cx0; cx <= cx1 && visited < SCAN_BUDGET; ++cx)
+        {
+            for (int i = m_cellHead[cy * m_cellsX + cx]; i >= 0 && visited < SCAN_BUDGET; i = m_customers[i].nextInCell)
+            {
+                ++visited;
+                const Customer &c = m_customers[i];
+                if (c.level == Coarse && range.contains(c.tile))
+                    candidates[found++] = i;
+            }
+        }
+    }
+
+    for (int k = 0; k < found && m_full.size() < MAX_FULL; ++k)
+    {
+        const int i = candidates[k];
+        tickCoarse(i, now);   // 先用粗略模型补到现在
+        Customer &c = m_customers[i];
+        c.tile = c.from = nearestWalkable(c.tile);
+        c.stepTicks = STEP_TICKS;
+        c.stuck = 0;
+        c.level = Full;
+        moveToCell(i);
+        m_full.append(i);
+    }
+}
+
+void Crowd::demote(const QRect &range)
+{
+    for (int k = m_full.size() - 1; k >= 0; --k)
+    {
+        Customer &c = m_customers[m_full[k]];
+        if (range.contains(c.tile))
+            continue;
+        c.level = Coarse;
+        c.from = c.tile;
+        c.stepTicks = 0;
+        m_full[k] = m_full.last();
+        m_full.removeLast();
+    }
+}
+
+void Crowd::tick(qint64 now, const QPoint &focus)
+{
+    if (m_customers.isEmpty())
+        return;
+
+    const QRect fullRange(focus - QPoint(FULL_RANGE_X, FULL_RANGE_Y), focus + QPoint(FULL_RANGE_X, FULL_RANGE_Y));
+    demote(fullRange.adjusted(-HYSTERESIS, -HYSTERESIS, HYSTERESIS, HYSTERESIS));
+    promote(fullRange, now);
+
+    for (int i : m_full)
+        tickFull(i, now);
+
+    // 粗略模型轮流推进：最多看 COARSE_PER_TICK + MAX_FULL 个下标，与总人数无关
+    const int count = m_customers.size();
+    for (int visited = 0, updated = 0; visited < count && updated < COARSE_PER_TICK; ++visited)
+    {
+        const int i = m_coarseCursor;
+        m_coarseCursor = m_coarseCursor + 1 < count ? m_coarseCursor + 1 : 0;
+        if (m_customers[i].level == Coarse)
+        {
+            tickCoarse(i, now);
+            ++updated;
+        }
+    }
+}
+
+void Crowd::visible(const QRect &rect, int max, QVector<CustomerView> *out) const
+{
+    out->clear();
+    if (m_customers.isEmpty())
+        return;
+    const int cx0 = qMax(0, rect.left() / CELL_SIZE), cx1 = qMin(m_cellsX - 1, rect.right() / CELL_SIZE);
+    const int cy0 = qMax(0, rect.top() / CELL_SIZE), cy1 = qMin(m_cellsY - 1, rect.bottom() / CELL_SIZE);
+    for (int cy = cy0; cy <= cy1; ++cy)
+    {
+        for (int cx = cx0; cx <= cx1; ++cx)
+        {
+            for (int i = m_cellHead[cy * m_cellsX + cx]; i >= 0; i = m_customers[i].nextInCell)
+            {
+                if (out->size() >= max)
+                    return;
+                const Customer &c = m_customers[i];
+                if (!rect.contains(c.tile))
+                    continue;
+                CustomerView v;
+                v.id = i;
+                // 完整模型在两格之间插值；粗略模型直接画在所在格子
+                const float t = c.level == Full && c.state != Waiting
+                        ? float(STEP_TICKS - c.stepTicks + 1) / STEP_TICKS : 1.0f;
+                v.x = c.from.x() + (c.tile.x() - c.from.x()) * t;
+                v.y = c.from.y() + (c.tile.y() - c.from.y()) * t;
+                v.mood = c.angry ? CustomerView::Angry
+                       : c.state == Waiting ? CustomerView::Waiting
+                       : c.state == Heading ? CustomerView::Hungry : CustomerView::Content;
+                v.fullDetail = c.level == Full;
+                out->append(v);
+            }
+        }
+    }
+}
+
+QVector<int> Crowd::near(const QPoint &center, int radius) const
+{
+    QVector<int> ids;
+    if (m_customers.isEmpty() || radius < 0)
+        return ids;
+    const QRect rect(center - QPoint(radius, radius), center + QPoint(radius, radius));
+    const int cx0 = qMax(0, rect.left() / CELL_SIZE), cx1 = qMin(m_cellsX - 1, rect.right() / CELL_SIZE);
+    const int cy0 = qMax(0, rect.top() / CELL_SIZE), cy1 = qMin(m_cellsY - 1, rect.bottom() / CELL_SIZE);
+    for (int cy = cy0; cy <= cy1; ++cy)
+        for (int cx = cx0; cx <= cx1; ++cx)
+            for (int i = m_cellHead[cy * m_cellsX + cx]; i >= 0; i = m_customers[i].nextInCell)
+                if (rect.contains(m_customers[i].tile))
+                    ids.append(i);
+    return ids;
+}
+
+bool Crowd::hit(int id, int amount)
+{
+    if (id < 0 || id >= m_customers.size())
+        return false;
+    Customer &c = m_customers[id];
+    c.angry = true;
+    c.patience -= qMax(0, amount) * HIT_PATIENCE;
+    if (c.patience <= 0 && c.state != Leaving)
+    {
+        // 排着队的预约作废，但摊位那段时间已经空过去了
+        if (c.stall >= 0)
+            ++m_stalls[c.stall].turnedAway;
+        leave(c);
+    }
+    return true;
+}
+
+void Crowd::writeState(QDataStream &out) const
+{
+    out << qint32(m_customers.size()) << m_seed;
+    for (const Customer &c : m_customers)
+    {
+        out << c.tile << c.target << c.money << c.hunger << c.patience << c.serveTick << c.lastTick
+            << c.stepTicks << c.stall << quint8(c.state) << quint8(c.level) << c.angry << c.rng.state();
+    }
+    for (const Stall &s : m_stalls)
+        out << s.tile << s.nextFree << qint32(s.served) << qint32(s.turnedAway) << s.revenue;
+}
+
+int Crowd::cellOf(const QPoint &tile) const
+{
+    const int cx = qBound(0, tile.x() / CELL_SIZE, m_cellsX - 1);
+    const int cy = qBound(0, tile.y() / CELL_SIZE, m_cellsY - 1);
+    return cy * m_cellsX + cx;
+}
+
+void Crowd::moveToCell(int index)
+{
+    Customer &c = m_customers[index];
+    const int cell = cellOf(c.tile);
+    if (cell == c.cell)
+        return;
+    unlink(index);
+    c.cell = cell;
+    c.prevInCell = -1;
+    c.nextInCell = m_cellHead[cell];
+    if (c.nextInCell >= 0)
+        m_customers[c.nextInCell].prevInCell = index;
+    m_cellHead[cell] = index;
+}
+
+void Crowd::unlink(int index)
+{
+    Customer &c = m_customers[index];
+    if (c.cell < 0)
+        return;
+    if (c.prevInCell >= 0)
+        m_customers[c.prevInCell].nextInCell = c.nextInCell;
+    else
+        m_cellHead[c.cell] = c.nextInCell;
+    if (c.nextInCell >= 0)
+        m_customers[c.nextInCell].prevInCell = c.prevInCell;
+    c.cell = c.prevInCell = c.nextInCell = -1;
+}
@@ -0,0 +1,146 @@
+// crowd.h - 街上的顾客：分级（LOD）推进的人群模拟
+#ifndef CROWD_H
+#define CROWD_H
+
+#include <QVector>
+#include <QPoint>
+#include <QRect>
+#include <QBitArray>
+#include "gamerandom.h"
+
+class QDataStream;
+
+/* 画顾客用的最少信息：位置（格子坐标，可以在两格之间）和心情 */
+struct CustomerView
+{
+    enum Mood : quint8 { Content, Hungry, Waiting, Angry };
+
+    int id = 0;                // 顾客下标，在同一张地图里不变
+    float x = 0;
+    float y = 0;
+    Mood mood = Content;
+    bool fullDetail = false;   // 是否按完整模型推进（调试时可以区分颜色）
+};
+
+/*
+ Crowd：成千上万个有需求（饥饿）、耐心和钱的顾客在街上闲逛、去摊位排队买东西、离开
+ 顾客分两级推进，总开销与人数无关：
+ - 完整模型（Full）：焦点（玩家）周围一屏以内的顾客，每个逻辑步都走：逐格移动、绕开障碍、
+   排队时耐心逐步减少。最多 MAX_FULL 个
+ - 粗略模型（Coarse）：其余顾客轮流推进，每个逻辑步最多 COARSE_PER_TICK 个，一次补上
+   自上次以来经过的所有逻辑步：直线移动、不看障碍，需求按经过的时间一次算完
+ - 排队在两级里是同一个聚合模型：摊位只记“下一个空闲的逻辑步”，顾客到达时预约服务时间，
+   等待超过耐心就生气离开。两级用的是同一套买卖规则，但结果不保证相同：粗略模型的顾客走直线，
+   而且要等轮到自己（最多每 COARSE_PER_TICK 个一轮）才一次补上，到达摊位、预约和离开的逻辑步都更晚、更粗，
+   排队顺序和谁等到生气都可能与一直按完整模型推进时不同
+ 升降级规则只看逻辑状态，录制回放时完全相同：
+ - 顾客在焦点的 FULL_RANGE 范围内、且完整模型没满时升级；升级前先用粗略模型补到当前逻辑步，
+   落在障碍上就挪到最近的空地
+ - 完整模型的顾客离开焦点 FULL_RANGE + HYSTERESIS 以外时降级，边界附近不会来回切换
+ 找焦点附近的顾客用按 CELL_SIZE 分块的链表，每步最多看 SCAN_BUDGET 个
+ 随机数每个顾客一个，推进顺序和级别都不影响各自的随机序列
+*/
+class Crowd
+{
+public:
+    static const int MAX_FULL = 256;
+    static const int COARSE_PER_TICK = 256;
+    static const int SCAN_BUDGET = 1024;
+    static const int FULL_RANGE_X = 16;   // 焦点左右各多少格按完整模型推进（约一屏）
+    static const int FULL_RANGE_Y = 12;
+    static const int HYSTERESIS = 4;
+    static const int CELL_SIZE = 16;
+    static const int HIT_PATIENCE = 300;  // 挨一下少多少步耐心
+
+    struct Stall
+    {
+        QPoint tile;          // 顾客站着买东西的格子
+        int price = 10;
+        qint64 nextFree = 0;  // 下一个空闲的逻辑步
+        int served = 0;
+        int turnedAway = 0;   // 等不及走掉的
+        qint64 revenue = 0;
+    };
+
+    /* 新的街道：blocked 为每格是否可走（行优先），stalls 为摊位，count 个顾客按 seed 生成
+     在两个逻辑步之间调用；之后 tick 的时间从 now 开始算 */
+    void populate(int width, int height, const QBitArray &blocked, const QVector<Stall> &stalls,
+                  int count, quint32 seed, qint64 now);
+    void clear();
+    /* 障碍变化（砍掉、热重载）时同步 */
+    void setBlocked(int x, int y, bool blocked);
+
+    /* 推进到第 now 个逻辑步；focus 为玩家所在格子 */
+    void tick(qint64 now, const QPoint &focus);
+
+    int size() const { return m_customers.size(); }
+    int fullCount() const { return m_full.size(); }
+    const QVector<Stall> &stalls() const { return m_stalls; }
+    /* rect（格子）里的顾客，最多 max 个 */
+    void visible(const QRect &rect, int max, QVector<CustomerView> *out) const;
+    /* center 周围 radius 格以内（横竖都不超过 radius）的顾客编号，物品打人用 */
+    QVector<int> near(const QPoint &center, int radius) const;
+    /* 顾客 id 挨了 amount 下：当场生气，耐心少 amount * HIT_PATIENCE 步，耐心用完就离开（排着的队也不排了）
+     编号无效时返回 false */
+    bool hit(int id, int amount);
+    /* 所有影响以后逻辑的状态，用于校验和 */
+    void writeState(QDataStream &out) const;
+
+private:
+    enum State : quint8 { Wandering, Heading, Waiting, Leaving };
+    enum Level : quint8 { Coarse, Full };
+
+    struct Customer
+    {
+        QPoint tile;
+        QPoint from;            // 完整模型：正在离开的格子，画面在 from 和 tile 之间插值
+        QPoint target;
+        qint32 money = 0;
+        qint32 hunger = 0;      // 每个逻辑步加 1，超过阈值就去买吃的
+        qint32 patience = 0;    // 最多愿意排队的逻辑步
+        qint64 serveTick = 0;   // Waiting：预约到的服务时间
+        qint64 lastTick = 0;    // 上次推进到的逻辑步
+        qint32 stepTicks = 0;   // 完整模型：离下一步还有几个逻辑步；粗略模型：上次没走完的零头
+        qint16 stall = -1;
+        quint8 stuck = 0;
+        bool angry = false;     // 等不及走掉的、挨了打的，画成生气；买到吃的就消气
+        State state = Wandering;
+        Level level = Coarse;
+        GameRandom rng;
+        int cell = -1;          // 分块链表
+        int prevInCell = -1;
+        int nextInCell = -1;
+    };
+
+    bool blocked(int x, int y) const;
+    QPoint randomWalkable(GameRandom &rng, const QPoint &near, int radius) const;
+    QPoint nearestWalkable(const QPoint &tile) const;
+    void spawn(Customer &c, bool atEdge);
+
+    void tickFull(int index, qint64 now);
+    void tickCoarse(int index, qint64 now);
+    void advanceNeeds(Customer &c, qint64 elapsed, qint64 now);
+    void arrive(Customer &c, qint64 now);
+    void leave(Customer &c);
+    void step(Customer &c);
+    void promote(const QRect &range, qint64 now);
+    void demote(const QRect &range);
+
+    int cellOf(const QPoint &tile) const;
+    void moveToCell(int index);
+    void unlink(int index);
+
+    int m_width = 0;
+    int m_height = 0;
+    QBitArray m_blocked;
+    QVector<Stall> m_stalls;
+    QVector<Customer> m_customers;
+    QVector<int> m_full;       // 完整模型的顾客下标
+    int m_coarseCursor = 0;    // 粗略模型轮到哪个下标
+    int m_cellsX = 0;
+    int m_cellsY = 0;
+    QVector<int> m_cellHead;
+    quint32 m_seed = 0;
+};
+
+#endif // CROWD_H
@@ -0,0 +1,100 @@
+// crowditem.cpp - 街上顾客的图元实现
+#include "crowditem.h"
+#include <QPainter>
+#include <QImage>
+
+namespace {
+// 与 CustomerView::Mood 一一对应
+const QColor MOOD_COLORS[4] = {
+    QColor(80, 170, 255),   // Content
+    QColor(255, 200, 60),   // Hungry
+    QColor(160, 220, 110),  // Waiting
+    QColor(230, 60, 50)     // Angry
+};
+const int MOOD_TINT_ALPHA = 110;   // 着色的浓度：看得出心情，也还认得出衣服
+const int PHASE_MS = 37;           // 按 id 错开动画，一群人走路时步子不会一模一样
+}
+
+/* 原图画四遍，每遍只在不透明的像素上（SourceAtop）盖一层心情颜色 */
+SpriteSheetPtr CrowdItem::moodAtlas(const SpriteSheet &sheet)
+{
+    const QImage source = sheet.atlas().toImage();
+    QImage image(source.width(), source.height() * 4, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    for (int m = 0; m < 4; ++m)
+    {
+        const QRect band(0, m * source.height(), source.width(), source.height());
+        painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+        painter.drawImage(band.topLeft(), source);
+        QColor tint = MOOD_COLORS[m];
+        tint.setAlpha(MOOD_TINT_ALPHA);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceAtop);
+        painter.fillRect(band, tint);
+    }
+    painter.end();
+    return SpriteSheet::fromImage(image, sheet.columns(), sheet.rows() * 4);
+}
+
+CrowdItem::CrowdItem(const QRectF &bounds, int tileWidth, int tileHeight, const SpriteSheetPtr &atlas,
+                     const SpriteClips &clips, const SpriteAnimator *animator, QGraphicsItem *parent)
+    : EntityLayerItem(bounds, atlas, parent),
+      m_tileWidth(tileWidth),
+      m_tileHeight(tileHeight),
+      m_clips(clips),
+      m_moodFrames(atlas ? atlas->frameCount() / 4 : 0),
+      m_halfHeight(atlas ? atlas->frameSize().height() / 2.0 : 0),
+      m_animator(animator)
+{
+}
+
+void CrowdItem::setCustomers(const QVector<CustomerView> &customers)
+{
+    ++m_batch;
+    m_customers = customers;
+    for (const CustomerView &c : customers)
+    {
+        if (c.id < 0)
+            continue;
+        if (c.id >= m_motion.size())
+            m_motion.resize(c.id + 1);
+        Motion &m = m_motion[c.id];
+        const QPointF pos(c.x, c.y);
+        // 上一份快照里也有才算得出走的方向；刚进入视野的先站着朝下
+        if (m.seen == m_batch - 1 && pos != m.pos)
+        {
+            const QPointF d = pos - m.pos;
+            m.facing = qAbs(d.x()) >= qAbs(d.y()) ? QPoint(d.x() < 0 ? -1 : 1, 0)
+                                                  : QPoint(0, d.y() < 0 ? -1 : 1);
+            m.movedMs = m_animator->time();
+        }
+        else if (m.seen != m_batch - 1)
+        {
+            m.facing = QPoint(0, 1);
+            m.movedMs = -SpriteAnimator::WALK_LINGER_MS;
+        }
+        m.pos = pos;
+        m.seen = m_batch;
+    }
+}
+
+void CrowdItem::animate()
+{
+    if (m_moodFrames <= 0)
+        return;
+    const qint64 now = m_animator->time();
+    m_sprites.resize(m_customers.size());
+    for (int i = 0; i < m_customers.size(); ++i)
+    {
+        const CustomerView &c = m_customers[i];
+        const Motion m = m_motion.value(c.id);
+        const int d = SpriteAnimator::directionOf(m.facing);
+        const SpriteClip &clip = now - m.movedMs < SpriteAnimator::WALK_LINGER_MS ? m_clips.walk[d] : m_clips.idle[d];
+
+        EntitySprite &s = m_sprites[i];
+        s.id = c.id;
+        s.pos = QPointF((c.x + 0.5) * m_tileWidth, (c.y + 1) * m_tileHeight - m_halfHeight);
+        s.frame = c.mood * m_moodFrames + m_animator->frameAt(clip, -qint64(c.id) * PHASE_MS);
+    }
+    setSprites(m_sprites);
+}
@@ -0,0 +1,53 @@
+// crowditem.h - 街上顾客的图元
+#ifndef CROWDITEM_H
+#define CROWDITEM_H
+
+#include "entitylayer.h"
+#include "spriteanimator.h"
+#include "crowd.h"
+
+/*
+ CrowdItem：把模拟快照里的顾客画成会走路的小人，颜色表示心情
+ - 和别的玩家用同一套站立 / 走路动画；每种心情是一份着色的精灵图，竖着拼成一张图集，
+   所有顾客仍由 EntityLayerItem 一次画完，只重绘动了或换了帧的顾客
+ - 快照里只有位置和心情：朝向和是不是在走，由这次和上次快照的位置差算出来，
+   联机时主机发来的顾客也一样
+ 图元只保存画面用的状态（上次的位置、朝向），不保存任何逻辑状态。
+*/
+class CrowdItem : public EntityLayerItem
+{
+public:
+    /* 每种心情（CustomerView::Mood）一份着色的 sheet，从上到下拼成一张图集；进游戏时做一次 */
+    static SpriteSheetPtr moodAtlas(const SpriteSheet &sheet);
+
+    /* atlas 为 moodAtlas 的结果，clips 里是原精灵图的帧号；帧按 animator 的时钟（与玩家共用）算 */
+    CrowdItem(const QRectF &bounds, int tileWidth, int tileHeight, const SpriteSheetPtr &atlas,
+              const SpriteClips &clips, const SpriteAnimator *animator, QGraphicsItem *parent = nullptr);
+
+    /* 新快照：坐标为格子（可以带小数），脚踩在格子底边的中点 */
+    void setCustomers(const QVector<CustomerView> &customers);
+    /* 每帧在 animator 推进之后调用，按它的时间重新挑帧 */
+    void animate();
+
+private:
+    struct Motion
+    {
+        QPointF pos;
+        QPoint facing = QPoint(0, 1);
+        qint64 movedMs = -SpriteAnimator::WALK_LINGER_MS;   // 最后一次挪动时 animator 的时间
+        quint32 seen = 0;                   // 最后一次出现在快照里的批次
+    };
+
+    int m_tileWidth;
+    int m_tileHeight;
+    SpriteClips m_clips;
+    int m_moodFrames;                  // 图集里一种心情占的帧数
+    qreal m_halfHeight;
+    const SpriteAnimator *m_animator;
+    quint32 m_batch = 0;
+    QVector<CustomerView> m_customers; // 最近一次快照
+    QVector<Motion> m_motion;          // 按 id 下标
+    QVector<EntitySprite> m_sprites;   // 每帧重用
+};
+
+#endif // CROWDITEM_H
@@ -0,0 +1,97 @@
+// entitylayer.cpp - 成批绘制实体精灵的图层实现
+#include "entitylayer.h"
+#include <QStyleOptionGraphicsItem>
+#include <QDebug>
+
+EntityLayerItem::EntityLayerItem(const QRectF &bounds, const SpriteSheetPtr &atlas, QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      m_bounds(bounds),
+      m_atlas(atlas)
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setAcceptedMouseButtons(Qt::NoButton);
+}
+
+QRectF EntityLayerItem::spriteRect(const QPointF &pos, int frame) const
+{
+    const QSizeF size = m_atlas->frameRect(frame).size();
+    return QRectF(pos.x() - size.width() / 2, pos.y() - size.height() / 2, size.width(), size.height());
+}
+
+void EntityLayerItem::setSprites(const QVector<EntitySprite> &sprites)
+{
+    if (!m_atlas)
+        return;
+
+    ++m_batch;
+    QRectF dirty;
+    m_fragments.resize(0);
+    m_fragments.reserve(sprites.size());
+    QVector<int> ids;
+    ids.reserve(sprites.size());
+    for (const EntitySprite &s : sprites)
+    {
+        if (s.id < 0 || s.frame < 0 || s.frame >= m_atlas->frameCount())
+        {
+            qWarning() << "Invalid entity sprite" << s.id << s.frame;
+            continue;
+        }
+        if (s.id >= m_slots.size())
+            m_slots.resize(s.id + 1);
+        Slot &slot = m_slots[s.id];
+        const bool wasShown = slot.seen == m_batch - 1 && slot.frame >= 0;
+        if (!wasShown)
+        {
+            dirty |= spriteRect(s.pos, s.frame);
+        }
+        else if (slot.pos != s.pos || slot.frame != s.frame)
+        {
+            dirty |= spriteRect(slot.pos, slot.frame);
+            dirty |= spriteRect(s.pos, s.frame);
+        }
+        slot.pos = s.pos;
+        slot.frame = s.frame;
+        slot.seen = m_batch;
+        ids.append(s.id);
+        m_fragments.append(QPainter::PixmapFragment::create(s.pos, m_atlas->frameRect(s.frame),
+                                                            1, 1, 0, s.opacity));
+    }
+
+    // 上一批有、这一批没有的：擦掉旧位置
+    for (int id : m_ids)
+    {
+        Slot &slot = m_slots[id];
+        if (slot.seen != m_batch)
+        {
+            dirty |= spriteRect(slot.pos, slot.frame);
+            slot.frame = -1;
+        }
+    }
+    m_ids.swap(ids);
+
+    if (!dirty.isEmpty())
+        update(dirty);
+}
+
+QRectF EntityLayerItem::boundingRect() const
+{
+    return m_bounds;
+}
+
+void EntityLayerItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *)
+{
+    if (!m_atlas || m_fragments.isEmpty())
+        return;
+
+    // 只交给 QPainter 露出区域里的精灵，仍然是一次调用
+    const QRectF exposed = option->exposedRect;
+    m_visible.resize(0);
+    for (const QPainter::PixmapFragment &f : m_fragments)
+    {
+        const QRectF r(f.x - f.width / 2, f.y - f.height / 2, f.width, f.height);
+        if (r.intersects(exposed))
+            m_visible.append(f);
+    }
+    if (!m_visible.isEmpty())
+        painter->drawPixmapFragments(m_visible.constData(), m_visible.size(), m_atlas->atlas());
+}
@@ -0,0 +1,58 @@
+// entitylayer.h - 成批绘制实体精灵的图层
+#ifndef ENTITYLAYER_H
+#define ENTITYLAYER_H
+
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QVector>
+#include "spritesheet.h"
+
+/* 一个要画的实体：id 在图层里唯一（用来判断谁动了），pos 为精灵中心的场景坐标 */
+struct EntitySprite
+{
+    int id = 0;
+    QPointF pos;
+    int frame = 0;      // 图集里的帧号
+    qreal opacity = 1;
+};
+
+/*
+ EntityLayerItem：共用一张图集的所有实体放在一个图元里
+ - 不再是一个实体一个 QGraphicsPixmapItem：场景里只有一个图元，实体移动不用更新 BSP 索引
+ - 位置和源矩形存成一个连续的 QPainter::PixmapFragment 数组，绘制时挑出露出区域里的，
+   一次 drawPixmapFragments 画完
+ - setSprites 按 id 比较上一次的位置和帧，只重绘变了的实体新旧位置的并集；
+   上次有这次没有的实体也算在里面
+*/
+class EntityLayerItem : public QGraphicsItem
+{
+public:
+    EntityLayerItem(const QRectF &bounds, const SpriteSheetPtr &atlas, QGraphicsItem *parent = nullptr);
+
+    /* 这一帧要画的全部实体（整体替换） */
+    void setSprites(const QVector<EntitySprite> &sprites);
+    int spriteCount() const { return m_fragments.size(); }
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    struct Slot
+    {
+        QPointF pos;
+        int frame = -1;
+        quint32 seen = 0;   // 最后一次出现在 setSprites 里的批次
+    };
+
+    QRectF spriteRect(const QPointF &pos, int frame) const;
+
+    QRectF m_bounds;
+    SpriteSheetPtr m_atlas;
+    QVector<QPainter::PixmapFragment> m_fragments;
+    QVector<Slot> m_slots;           // 按 id 下标
+    QVector<int> m_ids;              // 上一批的 id
+    quint32 m_batch = 0;
+    QVector<QPainter::PixmapFragment> m_visible;   // paint 用的临时数组，保留容量
+};
+
+#endif // ENTITYLAYER_H
@@ -0,0 +1,286 @@
+/* fieldofview.cpp - 对称阴影投射实现
+算法来自 Albert Ford 的 "Symmetric Shadowcasting"：
+把视野分成上下左右四个象限，每个象限一行一行向外扫描；
+每一行只扫描 [起始斜率, 结束斜率] 之间的格子，遇到墙就把这一段拆成更窄的下一行。
+斜率全部用整数分数表示（分子/分母），不会有浮点误差。
+*/
+#include "fieldofview.h"
+#include "tmxmap.h"
+#include <QRect>
+#include <algorithm>
+
+namespace {
+// 计算过程中暂时表示“上一次可见”的状态，计算结束后不会留在网格里
+const quint8 WAS_VISIBLE = 3;
+
+/* 向负无穷取整 / 向正无穷取整的整数除法（b > 0） */
+inline int floorDiv(int a, int b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+inline int ceilDiv(int a, int b) { return -floorDiv(-a, b); }
+
+/* 扫描中的一行：depth 为离视点的距离，斜率 = 分子 / 分母 */
+struct Row
+{
+    int depth;
+    int startNum, startDen;
+    int endNum, endDen;
+};
+}
+
+FieldOfView::FieldOfView() {}
+
+void FieldOfView::reset(int width, int height, int chunkSize)
+{
+    m_width = width;
+    m_height = height;
+    m_chunkSize = qMax(1, chunkSize);
+    m_chunksX = (width + m_chunkSize - 1) / m_chunkSize;
+    m_chunksY = (height + m_chunkSize - 1) / m_chunkSize;
+
+    m_opaque.fill(0, width * height);
+    m_state.fill(Unexplored, width * height);
+    m_visible.clear();
+    m_chunkDirty.fill(0, m_chunksX * m_chunksY);
+    m_dirtyChunks.clear();
+
+    // 整张地图都回到未探索状态，所有区块都要重绘
+    for (int i = 0; i < m_chunksX * m_chunksY; ++i)
+        markChunkDirty(i);
+
+    m_origin = QPoint(-1, -1);
+    m_needsUpdate = true;
+}
+
+void FieldOfView::reset(const TmxMap *map, int chunkSize)
+{
+    if (!map)
+        return;
+
+    reset(map->m_mapWidth, map->m_mapHeight, chunkSize);
+    for (int y = 0; y < m_height; ++y)
+        for (int x = 0; x < m_width; ++x)
+            m_opaque[y * m_width + x] = map->isObstacle(x, y);
+}
+
+void FieldOfView::setOpaque(int x, int y, bool opaque)
+{
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height)
+        return;
+
+    quint8 &cell = m_opaque[y * m_width + x];
+    if (cell == quint8(opaque))
+        return;
+    cell = opaque;
+
+    // 只有视野范围内的变化会影响当前视野
+    if (qAbs(x - m_origin.x()) <= m_radius + 1 && qAbs(y - m_origin.y()) <= m_radius + 1)
+        m_needsUpdate = true;
+}
+
+bool FieldOfView::isOpaque(int x, int y) const
+{
+    return blocks(x, y);
+}
+
+void FieldOfView::setOrigin(const QPoint &origin, int radius)
+{
+    if (origin == m_origin && radius == m_radius)
+        return;
+    m_origin = origin;
+    m_radius = radius;
+    m_needsUpdate = true;
+}
+
+bool FieldOfView::update()
+{
+    if (!m_needsUpdate)
+        return false;
+    compute();
+    m_needsUpdate = false;
+    return true;
+}
+
+void FieldOfView::recompute()
+{
+    compute();
+    m_needsUpdate = false;
+}
+
+FieldOfView::Visibility FieldOfView::visibility(int x, int y) const
+{
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height)
+        return Unexplored;
+    return Visibility(m_state[y * m_width + x]);
+}
+
+QVector<int> FieldOfView::takeDirtyChunks()
+{
+    QVector<int> chunks;
+    chunks.swap(m_dirtyChunks);
+    for (int c : chunks)
+        m_chunkDirty[c] = 0;
+    return chunks;
+}
+
+void FieldOfView::markChunkDirty(int index)
+{
+    if (!m_chunkDirty[index])
+    {
+        m_chunkDirty[index] = 1;
+        m_dirtyChunks.append(index);
+    }
+}
+
+bool FieldOfView::blocks(int x, int y) const
+{
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height)
+        return true;
+    return m_opaque[y * m_width + x];
+}
+
+void FieldOfView::markVisible(int x, int y)
+{
+    if (x < 0 || x >= m_width || y < 0 || y >= m_height)
+        return;
+
+    const int idx = y * m_width + x;
+    quint8 &s = m_state[idx];
+    if (s == Visible)
+        return; // 坐标轴上的格子会被相邻两个象限各扫到一次
+
+    // 上一次就可见的格子状态没变，不需要重绘所在区块
+    if (s != WAS_VISIBLE)
+        markChunkDirty((y / m_chunkSize) * m_chunksX + x / m_chunkSize);
+    s = Visible;
+    m_visible.append(idx);
+}
+
+template <typename Fn>
+void FieldOfView::castShadows(const QPoint &origin, int radius, Fn visit) const
+{
+    const int ox = origin.x();
+    const int oy = origin.y();
+    if (ox < 0 || ox >= m_width || oy < 0 || oy >= m_height)
+        return;
+    const int r2 = radius * radius + radius; // 加上 radius 让圆形边缘更饱满
+    visit(ox, oy);
+
+    QVector<Row> stack;
+    for (int quadrant = 0; quadrant < 4; ++quadrant)
+    {
+        // 象限坐标 (depth, col) → 地图坐标
+        auto tx = [&](int depth, int col) {
+            return quadrant == 1 ? ox + depth : (quadrant == 3 ? ox - depth : ox + col);
+        };
+        auto ty = [&](int depth, int col) {
+            return quadrant == 0 ? oy - depth : (quadrant == 2 ? oy + depth : oy + col);
+        };
+
+        stack.append(Row{ 1, -1, 1, 1, 1 });
+        while (!stack.isEmpty())
+        {
+            Row row = stack.last();
+            stack.removeLast();
+            if (row.depth > radius)
+                continue;
+
+            // 本行覆盖的列：起始斜率向上取整（0.5 进位），结束斜率向下取整（0.5 舍去）
+            const int minCol = floorDiv(2 * row.depth * row.startNum + row.startDen, 2 * row.startDen);
+            const int maxCol = ceilDiv(2 * row.depth * row.endNum - row.endDen, 2 * row.endDen);
+
+            int prev = -1; // -1 = 无，0 = 地面，1 = 墙
+            for (int col = minCol; col <= maxCol; ++col)
+            {
+                const int x = tx(row.depth, col);
+                const int y = ty(row.depth, col);
+                const bool wall = blocks(x, y);
+
+                // 对称性：地面格子的中心必须落在扇区内才算可见；墙只要被扫到就可见
+                const bool symmetric = col * row.startDen >= row.depth * row.startNum &&
+                                       col * row.endDen <= row.depth * row.endNum;
+                if ((wall || symmetric) && col * col + row.depth * row.depth <= r2
+                        && x >= 0 && x < m_width && y >= 0 && y < m_height)
+                    visit(x, y);
+
+                if (prev == 1 && !wall)
+                {
+                    // 墙后的第一块地面：收窄起始斜率
+                    row.startNum = 2 * col - 1;
+                    row.startDen = 2 * row.depth;
+                }
+                if (prev == 0 && wall)
+                {
+                    // 地面后遇到墙：墙之前的部分单独作为下一行继续扫描
+                    stack.append(Row{ row.depth + 1, row.startNum, row.startDen,
+                                      2 * col - 1, 2 * row.depth });
+                }
+                prev = wall ? 1 : 0;
+            }
+            if (prev == 0)
+                stack.append(Row{ row.depth + 1, row.startNum, row.startDen, row.endNum, row.endDen });
+        }
+    }
+}
+
+void FieldOfView::compute()
+{
+    // 1. 上一次可见的格子先标成 WAS_VISIBLE，这次仍然可见的会被改回 Visible
+    QVector<int> previous;
+    previous.swap(m_visible);
+    for (int idx : previous)
+        m_state[idx] = WAS_VISIBLE;
+
+    // 2. 四个象限分别扫描
+    castShadows(m_origin, m_radius, [this](int x, int y) { markVisible(x, y); });
+
+    // 3. 这次没有再看到的格子变成“记得”
+    for (int idx : previous)
+    {
+        if (m_state[idx] == WAS_VISIBLE)
+        {
+            m_state[idx] = Remembered;
+            const int x = idx % m_width;
+            const int y = idx / m_width;
+            markChunkDirty((y / m_chunkSize) * m_chunksX + x / m_chunkSize);
+        }
+    }
+}
+
+void FieldOfView::lineOfSight(const QVector<LosQuery> &queries, QVector<quint8> &results) const
+{
+    results.fill(0, queries.size());
+
+    // 同一视点、同一距离的查询排在一起，每组只投射一次
+    QVector<int> order(queries.size());
+    for (int i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&queries](int a, int b) {
+        const LosQuery &qa = queries[a], &qb = queries[b];
+        if (qa.from.y() != qb.from.y()) return qa.from.y() < qb.from.y();
+        if (qa.from.x() != qb.from.x()) return qa.from.x() < qb.from.x();
+        return qa.maxRange < qb.maxRange;
+    });
+
+    // 投射结果只记在视点周围 radius 以内（且在地图内）的窗口里，开销与地图大小无关
+    QVector<quint8> lit;
+    QRect window;
+    for (int i = 0; i < order.size(); )
+    {
+        const LosQuery &group = queries[order[i]];
+        const int radius = group.maxRange > 0 ? group.maxRange : qMax(m_width, m_height);
+        window = QRect(group.from.x() - radius, group.from.y() - radius, 2 * radius + 1, 2 * radius + 1)
+                .intersected(QRect(0, 0, m_width, m_height));
+        lit.fill(0, window.width() * window.height());
+        castShadows(group.from, radius, [&](int x, int y) {
+            lit[(y - window.y()) * window.width() + (x - window.x())] = 1;
+        });
+
+        for (; i < order.size(); ++i)
+        {
+            const LosQuery &q = queries[order[i]];
+            if (q.from != group.from || q.maxRange != group.maxRange)
+                break;
+            results[order[i]] = window.contains(q.to)
+                    && lit[(q.to.y() - window.y()) * window.width() + (q.to.x() - window.x())];
+        }
+    }
+}
@@ -0,0 +1,97 @@
+// fieldofview.h - 视野计算（对称阴影投射）
+#ifndef FIELDOFVIEW_H
+#define FIELDOFVIEW_H
+
+#include <QVector>
+#include <QPoint>
+
+class TmxMap;
+
+/* 一次视线查询：from 能否看到 to */
+struct LosQuery
+{
+    QPoint from;
+    QPoint to;
+    int maxRange = 0;   // 0 表示不限距离（整张地图）
+};
+
+/*
+ FieldOfView：在障碍物网格上做对称阴影投射（symmetric shadowcasting）
+ - 对称：A 能看到 B 当且仅当 B 能看到 A
+ - 增量：只有视点移动、视野半径变化，或视野范围内的障碍物变化时才重新计算；
+   重新计算只遍历上次和这次可见的格子，与地图大小无关
+ - 每个格子有三种状态：未探索 / 记得（看到过但现在看不到）/ 可见
+ - 状态变化的格子所在的区块会被记下来，迷雾只重绘这些区块
+ - NPC 的视线查询用同一套阴影投射：同一视点的查询只投射一次，结果与玩家的视野一致（也是对称的）
+*/
+class FieldOfView
+{
+public:
+    enum Visibility : quint8 { Unexplored = 0, Remembered = 1, Visible = 2 };
+
+    FieldOfView();
+
+    /* 按地图大小重置，并从地图的障碍物层读入遮挡信息 */
+    void reset(const TmxMap *map, int chunkSize = 16);
+    void reset(int width, int height, int chunkSize = 16);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int chunkSize() const { return m_chunkSize; }
+    qint64 memoryBytes() const { return m_opaque.size() + m_state.size() + qint64(m_visible.size()) * sizeof(int); }
+
+    /* 修改一个格子是否遮挡视线；变化在当前视野半径内时标记为需要重新计算 */
+    void setOpaque(int x, int y, bool opaque);
+    bool isOpaque(int x, int y) const;
+
+    /* 设置视点和半径；没有变化时不会触发重新计算 */
+    void setOrigin(const QPoint &origin, int radius);
+    QPoint origin() const { return m_origin; }
+    int radius() const { return m_radius; }
+
+    /* 需要时重新计算视野，返回是否真的计算了 */
+    bool update();
+    /* 强制重新计算（基准测试用） */
+    void recompute();
+
+    Visibility visibility(int x, int y) const;
+    bool isVisible(int x, int y) const { return visibility(x, y) == Visible; }
+    const QVector<int> &visibleCells() const { return m_visible; } // 可见格子的下标（y * width + x）
+
+    /* 取出并清空自上次调用以来状态有变化的区块下标（cy * chunksX + cx） */
+    QVector<int> takeDirtyChunks();
+    int chunksX() const { return m_chunksX; }
+    int chunksY() const { return m_chunksY; }
+
+    /* 批量视线查询（NPC 用），结果与查询一一对应，1 = 看得见；
+     按视点和距离分组，每组从视点投射一次阴影（半径为 maxRange），不影响玩家的视野状态 */
+    void lineOfSight(const QVector<LosQuery> &queries, QVector<quint8> &results) const;
+
+private:
+    /* 从 origin 向四个象限做阴影投射，对半径以内看得见的每个地图内的格子调用 visit(x, y)
+     （坐标轴上的格子可能调用两次） */
+    template <typename Fn>
+    void castShadows(const QPoint &origin, int radius, Fn visit) const;
+    void compute();
+    void markVisible(int x, int y);
+    void markChunkDirty(int index);
+    bool blocks(int x, int y) const; // 地图外视为遮挡
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_chunkSize = 16;
+    int m_chunksX = 0;
+    int m_chunksY = 0;
+
+    QVector<quint8> m_opaque;      // 1 = 遮挡视线
+    QVector<quint8> m_state;       // Visibility
+    QVector<int> m_visible;        // 当前可见格子
+    QVector<quint8> m_chunkDirty;  // 区块是否已记入 m_dirtyChunks
+    QVector<int> m_dirtyChunks;
+
+    QPoint m_origin = QPoint(-1, -1);
+    int m_radius = 0;
+    bool m_needsUpdate = true;
+};
+
+#endif // FIELDOFVIEW_H
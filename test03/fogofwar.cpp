@@ -0,0 +1,121 @@
+// fogofwar.cpp - 战争迷雾图元实现
+#include "fogofwar.h"
+#include "fieldofview.h"
+#include <QPainter>
+#include <QImage>
+#include <QStyleOptionGraphicsItem>
+
+namespace {
+// 每种可见状态对应的迷雾颜色（预乘 alpha 的 ARGB）
+const QRgb FOG_COLORS[3] = {
+    qRgba(0, 0, 0, 255),   // Unexplored
+    qRgba(0, 0, 0, 150),   // Remembered
+    qRgba(0, 0, 0, 0)      // Visible
+};
+}
+
+FogOfWarItem::FogOfWarItem(const FieldOfView *fov, int tileWidth, int tileHeight, QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      m_fov(fov),
+      m_tileWidth(tileWidth),
+      m_tileHeight(tileHeight)
+{
+    // 需要 option->exposedRect 来只画露出来的区块
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption);
+    setAcceptedMouseButtons(Qt::NoButton);
+    refreshAll();
+}
+
+QRectF FogOfWarItem::boundingRect() const
+{
+    return QRectF(0, 0, m_fov->width() * m_tileWidth, m_fov->height() * m_tileHeight);
+}
+
+QRect FogOfWarItem::chunkCells(int index) const
+{
+    const int cs = m_fov->chunkSize();
+    const int cx = index % m_fov->chunksX();
+    const int cy = index / m_fov->chunksX();
+    QRect r(cx * cs, cy * cs, cs, cs);
+    return r.intersected(QRect(0, 0, m_fov->width(), m_fov->height())); // 地图边缘的区块可能不满
+}
+
+QRectF FogOfWarItem::chunkRect(int index) const
+{
+    const QRect c = chunkCells(index);
+    return QRectF(c.x() * m_tileWidth, c.y() * m_tileHeight,
+                  c.width() * m_tileWidth, c.height() * m_tileHeight);
+}
+
+void FogOfWarItem::buildChunk(int index)
+{
+    const QRect cells = chunkCells(index);
+    QImage img(cells.size(), QImage::Format_ARGB32_Premultiplied);
+
+    bool clear = true;
+    for (int y = 0; y < cells.height(); ++y)
+    {
+        QRgb *line = reinterpret_cast<QRgb *>(img.scanLine(y));
+        for (int x = 0; x < cells.width(); ++x)
+        {
+            const int v = m_fov->visibility(cells.x() + x, cells.y() + y);
+            line[x] = FOG_COLORS[v];
+            clear = clear && v == FieldOfView::Visible;
+        }
+    }
+
+    m_chunkClear[index] = clear;
+    m_chunkStale[index] = 0;
+    m_chunks[index] = clear ? QPixmap() : QPixmap::fromImage(img);
+}
+
+/* 只是把区块都标成过期，开销与区块数成正比；图在区块露出来时才生成 */
+void FogOfWarItem::refreshAll()
+{
+    prepareGeometryChange();
+    const int count = m_fov->chunksX() * m_fov->chunksY();
+    m_chunks.fill(QPixmap(), count);
+    m_chunkClear.fill(0, count);
+    m_chunkStale.fill(1, count);
+    update();
+}
+
+void FogOfWarItem::refreshChunks(const QVector<int> &chunks)
+{
+    for (int index : chunks)
+    {
+        if (index < 0 || index >= m_chunks.size())
+            continue;
+        m_chunkStale[index] = 1;
+        update(chunkRect(index));
+    }
+}
+
+void FogOfWarItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+    if (m_chunks.isEmpty())
+        return;
+
+    // 只遍历与重绘区域相交的区块
+    const QRectF exposed = option->exposedRect;
+    const int cs = m_fov->chunkSize();
+    const int cx0 = qMax(0, int(exposed.left()) / (cs * m_tileWidth));
+    const int cy0 = qMax(0, int(exposed.top()) / (cs * m_tileHeight));
+    const int cx1 = qMin(m_fov->chunksX() - 1, int(exposed.right()) / (cs * m_tileWidth));
+    const int cy1 = qMin(m_fov->chunksY() - 1, int(exposed.bottom()) / (cs * m_tileHeight));
+
+    // 过期的区块这时才重新生成；一格一像素的小图按整数倍放大，不插值，保持格子边缘清晰
+    for (int cy = cy0; cy <= cy1; ++cy)
+    {
+        for (int cx = cx0; cx <= cx1; ++cx)
+        {
+            const int index = cy * m_fov->chunksX() + cx;
+            if (m_chunkStale[index])
+                buildChunk(index);
+            if (m_chunkClear[index])
+                continue;
+            painter->drawPixmap(chunkRect(index), m_chunks[index], QRectF(m_chunks[index].rect()));
+        }
+    }
+}
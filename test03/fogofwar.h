@@ -0,0 +1,47 @@
+// fogofwar.h - 战争迷雾图元
+#ifndef FOGOFWAR_H
+#define FOGOFWAR_H
+
+#include <QGraphicsItem>
+#include <QPixmap>
+#include <QVector>
+
+class FieldOfView;
+
+/*
+ FogOfWarItem：覆盖整张地图的迷雾，状态来自 FieldOfView
+ - 未探索：全黑；记得：半透明黑；可见：透明
+ - 按区块（FieldOfView::chunkSize() 格）缓存：每个区块是一张“一格一像素”的小图，
+   绘制时按格子大小放大；只有状态变化的区块会重新生成
+ - 区块图是在它第一次露出来（paint）时才生成的：进入地图时只把区块都标成过期，
+   不在主线程上一次生成整张地图的迷雾
+ - 完全可见的区块直接跳过，不参与绘制
+*/
+class FogOfWarItem : public QGraphicsItem
+{
+public:
+    FogOfWarItem(const FieldOfView *fov, int tileWidth, int tileHeight, QGraphicsItem *parent = nullptr);
+
+    /* 指定区块（FieldOfView::takeDirtyChunks() 的结果）过期，请求重绘，下次绘制时重新生成 */
+    void refreshChunks(const QVector<int> &chunks);
+    /* 全部区块过期（地图重新加载后调用） */
+    void refreshAll();
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    QRect chunkCells(int index) const;   // 区块覆盖的格子范围
+    QRectF chunkRect(int index) const;   // 区块在场景中的矩形
+    void buildChunk(int index);
+
+    const FieldOfView *m_fov;
+    int m_tileWidth;
+    int m_tileHeight;
+
+    QVector<QPixmap> m_chunks;
+    QVector<quint8> m_chunkClear;  // 1 = 区块内全部可见，不用画
+    QVector<quint8> m_chunkStale;  // 1 = 状态变了，绘制前要重新生成
+};
+
+#endif // FOGOFWAR_H
@@ -0,0 +1,39 @@
+// framebufferitem.cpp - 用软件渲染器绘制一段绘制组的图元实现
+#include "framebufferitem.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+FramebufferItem::FramebufferItem(const TmxMap *map, BakedMap *baked, int firstGroup, int lastGroup,
+                                 const QRectF &bounds, QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      m_baked(baked),
+      m_renderer(map, baked),
+      m_firstGroup(firstGroup),
+      m_lastGroup(lastGroup),
+      m_bounds(bounds)
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption); // 需要 exposedRect
+    setAcceptedMouseButtons(Qt::NoButton);
+    setZValue(baked->group(lastGroup).last);
+}
+
+void FramebufferItem::updateTile(int tileX, int tileY, int tileWidth, int tileHeight)
+{
+    update(QRectF(tileX * tileWidth, tileY * tileHeight, tileWidth, tileHeight));
+}
+
+void FramebufferItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+    const QRect exposed = option->exposedRect.toAlignedRect().intersected(m_bounds.toAlignedRect());
+    if (exposed.isEmpty())
+        return;
+    const int level = m_baked->levelForScale(
+        QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform()));
+    QRect covered;
+    const QImage frame = m_renderer.render(exposed, m_firstGroup, m_lastGroup, level, &covered);
+    if (level == 0)
+        painter->drawImage(covered.topLeft(), frame);
+    else
+        painter->drawImage(QRectF(covered), frame);
+}
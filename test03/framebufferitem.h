@@ -0,0 +1,35 @@
+// framebufferitem.h - 用软件渲染器绘制一段绘制组的图元
+#ifndef FRAMEBUFFERITEM_H
+#define FRAMEBUFFERITEM_H
+
+#include <QGraphicsItem>
+#include "softwarerenderer.h"
+
+/*
+ FramebufferItem：MapLayerItem 的替代品（F6 切换）。
+ 一个图元负责连续的几个绘制组（实体下面的一段或上面的一段），绘制时把重绘区域内的瓦片
+ 用 SoftwareRenderer 合成到帧缓冲区，再用一次 drawImage 呈现。视图缩小时按缩放比例
+ 选 BakedMap 的缩小版合成，剩下不到一半的缩放只发生在这一次呈现上
+*/
+class FramebufferItem : public QGraphicsItem
+{
+public:
+    FramebufferItem(const TmxMap *map, BakedMap *baked, int firstGroup, int lastGroup,
+                    const QRectF &bounds, QGraphicsItem *parent = nullptr);
+
+    bool containsGroup(int group) const { return group >= m_firstGroup && group <= m_lastGroup; }
+    /* 瓦片变化后请求重绘这一格 */
+    void updateTile(int tileX, int tileY, int tileWidth, int tileHeight);
+
+    QRectF boundingRect() const override { return m_bounds; }
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    BakedMap *m_baked;
+    SoftwareRenderer m_renderer;
+    int m_firstGroup;
+    int m_lastGroup;
+    QRectF m_bounds;
+};
+
+#endif // FRAMEBUFFERITEM_H
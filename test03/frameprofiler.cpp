@@ -0,0 +1,178 @@
+/* frameprofiler.cpp - 帧采样实现
+采样流程：
+1. 各处用 PROFILE_SCOPE / addPaint / countInventoryRepaint 往“当前帧”累加
+2. 下一帧开始时 nextFrame() 把累加值取出（同时清零），写进环形缓冲区
+3. HUD 只读环形缓冲区；开着 CSV 记录时，封存的那条采样同时追加到文件
+*/
+#include "frameprofiler.h"
+#include <QDebug>
+#include <algorithm>
+
+FrameProfiler &FrameProfiler::instance()
+{
+    static FrameProfiler profiler;
+    return profiler;
+}
+
+FrameProfiler::FrameProfiler()
+{
+    m_samples.resize(HISTORY);
+    m_clock.start();
+    m_frameStart = now();
+}
+
+void FrameProfiler::nextFrame()
+{
+    const qint64 t = now();
+
+    Sample &s = m_samples[m_next];
+    s.frameNs = t - m_frameStart;
+    // fetchAndStore：取出累加值并清零，计时器在其他地方累加也不会丢数据
+    s.paintNs = m_paintNs.fetchAndStoreRelaxed(0);
+    s.paintPixels = m_paintPixels.fetchAndStoreRelaxed(0);
+    for (int i = 0; i < SubsystemCount; ++i)
+        s.subsystemNs[i] = m_subsystemNs[i].fetchAndStoreRelaxed(0);
+    s.sceneItems = m_sceneItems;
+    s.inventoryRepaints = m_inventoryRepaints.fetchAndStoreRelaxed(0);
+
+    if (m_csv.isOpen())
+        writeCsvRow(m_csvOut, m_csvRows++, s);
+
+    m_next = (m_next + 1) % HISTORY;
+    if (m_count < HISTORY)
+        ++m_count;
+    m_frameStart = t;
+}
+
+void FrameProfiler::addPaint(qint64 ns, qint64 pixels)
+{
+    m_paintNs.fetchAndAddRelaxed(ns);
+    m_paintPixels.fetchAndAddRelaxed(pixels);
+}
+
+const FrameProfiler::Sample &FrameProfiler::sample(int i) const
+{
+    // 缓冲区未满时最老的一帧在下标 0，满了以后在 m_next
+    int start = m_count < HISTORY ? 0 : m_next;
+    return m_samples[(start + i) % HISTORY];
+}
+
+qint64 FrameProfiler::framePercentile(double p) const
+{
+    if (m_count == 0)
+        return 0;
+
+    QVector<qint64> times;
+    times.reserve(m_count);
+    for (int i = 0; i < m_count; ++i)
+        times.append(sample(i).frameNs);
+
+    // nth_element 只做部分排序，比完整排序快
+    int k = qBound(0, int(p * (m_count - 1) + 0.5), m_count - 1);
+    std::nth_element(times.begin(), times.begin() + k, times.end());
+    return times[k];
+}
+
+FrameProfiler::Sample FrameProfiler::average() const
+{
+    Sample avg;
+    if (m_count == 0)
+        return avg;
+
+    for (int i = 0; i < m_count; ++i)
+    {
+        const Sample &s = sample(i);
+        avg.frameNs += s.frameNs;
+        avg.paintNs += s.paintNs;
+        avg.paintPixels += s.paintPixels;
+        for (int j = 0; j < SubsystemCount; ++j)
+            avg.subsystemNs[j] += s.subsystemNs[j];
+        avg.inventoryRepaints += s.inventoryRepaints;
+    }
+    avg.frameNs /= m_count;
+    avg.paintNs /= m_count;
+    avg.paintPixels /= m_count;
+    for (int j = 0; j < SubsystemCount; ++j)
+        avg.subsystemNs[j] /= m_count;
+    avg.inventoryRepaints /= m_count;
+    avg.sceneItems = sample(m_count - 1).sceneItems; // 图元数量取最新值
+    return avg;
+}
+
+QVector<int> FrameProfiler::frameHistogram(int buckets, qint64 bucketNs) const
+{
+    QVector<int> hist(buckets, 0);
+    if (buckets <= 0 || bucketNs <= 0)
+        return hist;
+
+    for (int i = 0; i < m_count; ++i)
+    {
+        int b = int(sample(i).frameNs / bucketNs);
+        hist[qMin(b, buckets - 1)]++;
+    }
+    return hist;
+}
+
+bool FrameProfiler::startCsv(const QString &fileName)
+{
+    stopCsv();
+    m_csv.setFileName(fileName);
+    if (!m_csv.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qWarning() << "Cannot write profile csv:" << fileName;
+        return false;
+    }
+    m_csvOut.setDevice(&m_csv);
+    writeCsvHeader(m_csvOut);
+    for (m_csvRows = 0; m_csvRows < m_count; ++m_csvRows)
+        writeCsvRow(m_csvOut, m_csvRows, sample(m_csvRows));
+    return true;
+}
+
+int FrameProfiler::stopCsv()
+{
+    if (!m_csv.isOpen())
+        return 0;
+    m_csvOut.flush();
+    m_csvOut.setDevice(nullptr);
+    m_csv.close();
+    qDebug() << "Wrote" << m_csvRows << "frame samples to" << m_csv.fileName();
+    return m_csvRows;
+}
+
+void FrameProfiler::writeCsvHeader(QTextStream &out)
+{
+    out << "frame,frame_us,paint_us,paint_pixels,simulation_us,pathfinding_us,rendering_us,"
+           "scene_items,inventory_repaints\n";
+}
+
+void FrameProfiler::writeCsvRow(QTextStream &out, int frame, const Sample &s)
+{
+    out << frame << ','
+        << s.frameNs / 1000 << ','
+        << s.paintNs / 1000 << ','
+        << s.paintPixels << ','
+        << s.subsystemNs[Simulation] / 1000 << ','
+        << s.subsystemNs[Pathfinding] / 1000 << ','
+        << s.subsystemNs[Rendering] / 1000 << ','
+        << s.sceneItems << ','
+        << s.inventoryRepaints << '\n';
+}
+
+bool FrameProfiler::writeCsv(const QString &fileName, const QVector<Sample> &samples)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        qWarning() << "Cannot write profile csv:" << fileName;
+        return false;
+    }
+
+    QTextStream out(&file);
+    writeCsvHeader(out);
+    for (int i = 0; i < samples.size(); ++i)
+        writeCsvRow(out, i, samples[i]);
+
+    qDebug() << "Wrote" << samples.size() << "frame samples to" << fileName;
+    return true;
+}
@@ -0,0 +1,125 @@
+// frameprofiler.h - 帧耗时与子系统计时
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <QVector>
+#include <QString>
+#include <QElapsedTimer>
+#include <QAtomicInteger>
+#include <QFile>
+#include <QTextStream>
+
+/*
+ FrameProfiler 记录最近若干帧的采样（环形缓冲区），供 HUD 显示和导出 CSV。
+ 每帧开始时 Widget::onFrame 调用 nextFrame()，把上一帧累计的数据封存成一条采样；
+ 开着 CSV 记录时同时追加一行，记录多长不受环形缓冲区大小限制。
+ 计时全部用 QElapsedTimer::nsecsElapsed（单调时钟，一次调用几十纳秒），
+ 累加器是原子整数，发布版也可以一直开着。
+*/
+class FrameProfiler
+{
+public:
+    enum Subsystem
+    {
+        Simulation,   // 游戏逻辑（移动、物品栏……）
+        Pathfinding,  // 寻路 / 碰撞查询（嵌套在模拟内，模拟的耗时包含它）
+        Rendering,    // 渲染相关（摄像机、场景更新）
+        SubsystemCount
+    };
+
+    struct Sample
+    {
+        qint64 frameNs = 0;                       // 与上一帧的间隔
+        qint64 paintNs = 0;                       // 视图 paintEvent 总耗时
+        qint64 paintPixels = 0;                   // 视图本帧重绘的像素面积
+        qint64 subsystemNs[SubsystemCount] = {};  // 各子系统耗时
+        int sceneItems = 0;                       // 场景图元数量
+        int inventoryRepaints = 0;                // 物品栏槽位重绘次数
+    };
+
+    static FrameProfiler &instance();
+
+    /* 当前时间（纳秒，单调递增） */
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+
+    /* 封存上一帧并开始新的一帧 */
+    void nextFrame();
+
+    void addSubsystemTime(Subsystem s, qint64 ns) { m_subsystemNs[s].fetchAndAddRelaxed(ns); }
+    void addPaint(qint64 ns, qint64 pixels);
+    void countInventoryRepaint() { m_inventoryRepaints.fetchAndAddRelaxed(1); }
+    void setSceneItemCount(int count) { m_sceneItems = count; }
+
+    /* 最近的采样（i = 0 为最老的一帧） */
+    int sampleCount() const { return m_count; }
+    const Sample &sample(int i) const;
+
+    /* 帧耗时百分位（p 取 0~1），单位纳秒 */
+    qint64 framePercentile(double p) const;
+    /* 各字段在窗口内的平均值 */
+    Sample average() const;
+    /* 帧耗时直方图：bucketNs 为每格宽度，最后一格收集所有更大的值 */
+    QVector<int> frameHistogram(int buckets, qint64 bucketNs) const;
+
+    /* 开始持续记录 CSV：先写入窗口内已有的采样，之后每封存一帧追加一行，直到 stopCsv() */
+    bool startCsv(const QString &fileName);
+    /* 停止记录并关闭文件，返回写入的帧数 */
+    int stopCsv();
+    bool isCapturing() const { return m_csv.isOpen(); }
+    QString csvFileName() const { return m_csv.fileName(); }
+    /* 把任意一组采样写成同样格式的 CSV（回放会记下整局的采样，超出环形缓冲区） */
+    static bool writeCsv(const QString &fileName, const QVector<Sample> &samples);
+
+    static const int HISTORY = 3600; // 约 60 秒 @60FPS
+
+private:
+    FrameProfiler();
+
+    static void writeCsvHeader(QTextStream &out);
+    static void writeCsvRow(QTextStream &out, int frame, const Sample &s);
+
+    QElapsedTimer m_clock;
+    qint64 m_frameStart = 0;
+
+    // 当前帧的累加器
+    QAtomicInteger<qint64> m_subsystemNs[SubsystemCount];
+    QAtomicInteger<qint64> m_paintNs;
+    QAtomicInteger<qint64> m_paintPixels;
+    QAtomicInteger<int> m_inventoryRepaints;
+    int m_sceneItems = 0;
+
+    // 环形缓冲区
+    QVector<Sample> m_samples;
+    int m_next = 0;
+    int m_count = 0;
+
+    // 持续记录的 CSV（QTextStream 自带缓冲，每帧追加一行不会每帧都写盘）
+    QFile m_csv;
+    QTextStream m_csvOut;
+    int m_csvRows = 0;
+};
+
+/* 作用域计时器：构造时记下时间，析构时把耗时加到对应子系统 */
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(FrameProfiler::Subsystem subsystem)
+        : m_subsystem(subsystem), m_start(FrameProfiler::instance().now()) {}
+    ~ScopedTimer()
+    {
+        FrameProfiler &p = FrameProfiler::instance();
+        p.addSubsystemTime(m_subsystem, p.now() - m_start);
+    }
+
+private:
+    FrameProfiler::Subsystem m_subsystem;
+    qint64 m_start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+/* 用法：PROFILE_SCOPE(Simulation); 计时到当前作用域结束 */
+#define PROFILE_SCOPE(subsystem) \
+    ScopedTimer PROFILE_CONCAT(profileScope_, __LINE__)(FrameProfiler::subsystem)
+
+#endif // FRAMEPROFILER_H
@@ -0,0 +1,43 @@
+// gamerandom.h - 可复现的随机数
+#ifndef GAMERANDOM_H
+#define GAMERANDOM_H
+
+#include <QtGlobal>
+
+/*
+ GameRandom：游戏逻辑专用的随机数发生器（xorshift32）
+ 逻辑里所有的随机都从这里取，种子写进输入录制文件，回放时得到完全相同的序列。
+ 不要在逻辑里用 qrand / QRandomGenerator::global()，那样回放就对不上了。
+*/
+class GameRandom
+{
+public:
+    explicit GameRandom(quint32 seed = 1) { setSeed(seed); }
+
+    void setSeed(quint32 seed)
+    {
+        m_seed = seed;
+        m_state = seed ? seed : 0x9E3779B9u; // xorshift 的状态不能是 0
+    }
+    quint32 seed() const { return m_seed; }
+    quint32 state() const { return m_state; }
+
+    quint32 next()
+    {
+        quint32 x = m_state;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        m_state = x;
+        return x;
+    }
+
+    /* [0, bound) 内的整数（bound > 0） */
+    int bounded(int bound) { return int((quint64(next()) * quint64(bound)) >> 32); }
+
+private:
+    quint32 m_seed = 1;
+    quint32 m_state = 1;
+};
+
+#endif // GAMERANDOM_H
@@ -0,0 +1,28 @@
+// gameview.cpp - 游戏地图视图实现
+#include "gameview.h"
+#include "frameprofiler.h"
+#include "tracing.h"
+#include <QPaintEvent>
+
+GameView::GameView(QGraphicsScene *scene, QWidget *parent)
+    : QGraphicsView(scene, parent)
+{
+}
+
+void GameView::paintEvent(QPaintEvent *event)
+{
+    TRACE_SCOPE("GameView::paint");
+    FrameProfiler &profiler = FrameProfiler::instance();
+    const qint64 start = profiler.now();
+
+    QGraphicsView::paintEvent(event);
+
+    // 重绘面积：滚动时应该只有新露出的条带，可以用来验证摄像机的滚动是否生效
+    qint64 pixels = 0;
+    for (const QRect &r : event->region())
+        pixels += qint64(r.width()) * r.height();
+
+    const qint64 elapsed = profiler.now() - start;
+    profiler.addPaint(elapsed, pixels);
+    profiler.addSubsystemTime(FrameProfiler::Rendering, elapsed);
+}
@@ -0,0 +1,21 @@
+// gameview.h - 游戏地图视图
+#ifndef GAMEVIEW_H
+#define GAMEVIEW_H
+
+#include <QGraphicsView>
+
+/*
+ 在 QGraphicsView 的基础上统计每次重绘的耗时和面积，交给 FrameProfiler。
+ 其余行为与 QGraphicsView 完全一致。
+*/
+class GameView : public QGraphicsView
+{
+    Q_OBJECT
+public:
+    explicit GameView(QGraphicsScene *scene, QWidget *parent = nullptr);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+};
+
+#endif // GAMEVIEW_H
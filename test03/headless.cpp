@@ -0,0 +1,270 @@
+// headless.cpp - 无界面模式的实现
+#include "headless.h"
+#include "simulation.h"
+#include "tmxmap.h"
+#include "assetpack.h"
+#include <QFileInfo>
+#include <QThread>
+#include <QDebug>
+
+namespace {
+// 与 Widget::loadMap 相同的数据文件
+const char *const WORLD_PATH = "E:\\tiled\\myexmples\\lzu.world";
+const char *const TMX_PATH = "E:\\tiled\\myexmples\\c.tmx";
+const char *const ITEMS_PATH = "E:\\tiled\\myexmples\\items.json";
+const QPoint SPAWN_TILE(5, 5);   // 与 GUI 相同的出生点
+
+const int BOT_KEYS[] = { Qt::Key_Left, Qt::Key_Right, Qt::Key_Up, Qt::Key_Down };
+}
+
+HeadlessGame::HeadlessGame()
+{
+}
+
+HeadlessGame::~HeadlessGame()
+{
+}
+
+void HeadlessGame::loadData()
+{
+    const QString itemsPath = QString::fromLatin1(ITEMS_PATH);
+    const QString worldPath = QString::fromLatin1(WORLD_PATH);
+    m_items.setIconsEnabled(false);
+    if (!AssetPack::instance().exists(itemsPath) || !m_items.load(itemsPath))
+        m_items.loadDefaults();
+    if (!AssetPack::instance().exists(worldPath) || !m_world.load(worldPath))
+        m_world.setSingleMap(QString::fromLatin1(TMX_PATH));
+}
+
+int HeadlessGame::run(const Options &options)
+{
+    InputLog log;
+    const bool replaying = !options.replay.isEmpty();
+    if (replaying && !log.load(options.replay))
+        return 2;
+
+    QString start = m_world.startMap();
+    if (!replaying && !options.map.isEmpty())
+        start = QFileInfo(options.map).absoluteFilePath();
+    // 从别的地图开始回放，结果一定对不上，与日志本身有问题一样当作加载失败
+    if (replaying && log.map != start)
+    {
+        qWarning() << "Input log starts on" << log.map << "but the world starts on" << start;
+        return 2;
+    }
+
+    // 与 GUI 相同的顺序：初始物品、进入第一张地图，然后播种（录制也是在这之后开始的）
+    m_sim.reset(new Simulation(m_world, m_items));
+    QVector<ItemState> items;
+    for (const Item &item : m_items.startingItems())
+        items.append(ItemState(item));
+    m_sim->setInventory(items);
+    if (!enterMap(start, SPAWN_TILE))
+        return 2;
+    const quint32 seed = replaying ? log.seed : options.seed;
+    m_sim->reset(seed);
+    if (replaying)
+        m_sim->startReplay(log);
+    m_botRng.setSeed(seed);
+
+    qDebug().nospace() << "Headless: " << start << ", seed " << seed << ", "
+                       << (options.unthrottled ? "unthrottled" : "fixed step")
+                       << (options.bot && !replaying ? ", bot input" : "")
+                       << (replaying ? ", replaying " + options.replay : QString());
+
+    const qint64 tickNs = qint64(Simulation::TICK_MS) * 1000000;
+    qint64 nextTickNs = tickNs;
+    m_clock.start();
+    while (!m_replayFinished)
+    {
+        if (options.ticks > 0 && m_sim->tickCount() >= options.ticks)
+            break;
+        if (options.seconds > 0 && m_clock.elapsed() >= options.seconds * 1000)
+            break;
+        if (!m_sim->canTick())
+        {
+            // 地图切换在 handleEvents 里同步做完，这里还停着说明没有地图可走了
+            qWarning() << "Headless: the simulation stopped at tick" << m_sim->tickCount();
+            break;
+        }
+
+        if (options.bot && !replaying)
+            driveBot();
+        m_sim->tick();
+        handleEvents();
+
+        if (!options.unthrottled)
+        {
+            nextTickNs += tickNs;
+            const qint64 waitNs = nextTickNs - m_clock.nsecsElapsed();
+            if (waitNs > 0)
+                QThread::usleep(quint64(waitNs / 1000));
+            else if (-waitNs > MAX_LAG_TICKS * tickNs)
+                nextTickNs = m_clock.nsecsElapsed();   // 跟不上时丢掉欠下的步，不越补越慢
+        }
+        if (m_clock.elapsed() - m_reportMs >= REPORT_INTERVAL_MS)
+            report(false);
+    }
+    report(true);
+
+    if (!replaying)
+        return 0;
+    const bool matched = log.checksum.isEmpty() || m_replayChecksum == log.checksum;
+    if (!m_replayFinished)
+        qWarning() << "Headless: stopped at tick" << m_sim->tickCount() << "before the end of the recording at" << log.ticks;
+    else if (!matched)
+        qWarning().noquote() << "Replay checksum" << m_replayChecksum << "DIFFERS from the recording" << log.checksum;
+    else
+        qDebug().noquote() << "Replay checksum" << m_replayChecksum
+                           << (log.checksum.isEmpty() ? "(no recorded checksum)" : "matches the recording");
+    return m_replayFinished && matched ? 0 : 1;
+}
+
+/* 只解析数据：TmxMap::load 不解码图块集图片，只读图片头拿尺寸 */
+TmxMap *HeadlessGame::acquireMap(const QString &path)
+{
+    QSharedPointer<TmxMap> &map = m_maps[path];
+    if (!map)
+    {
+        QSharedPointer<TmxMap> loaded(new TmxMap);
+        if (!loaded->load(path))
+        {
+            m_maps.remove(path);
+            return nullptr;
+        }
+        map = loaded;
+    }
+    return map.data();
+}
+
+bool HeadlessGame::enterMap(const QString &path, const QPoint &tile)
+{
+    TmxMap *map = acquireMap(path);
+    if (!map)
+    {
+        qWarning() << "Headless: cannot load map" << path;
+        return false;
+    }
+    m_mapPath = path;
+    m_world.setMapSize(path, QSize(map->m_mapWidth * map->m_tileWidth, map->m_mapHeight * map->m_tileHeight));
+
+    SimCommand command;
+    command.type = SimCommand::EnterMap;
+    command.map = SimMap(*map, path, ++m_generation);
+    command.tile = QPoint(qBound(0, tile.x(), map->m_mapWidth - 1), qBound(0, tile.y(), map->m_mapHeight - 1));
+    m_sim->apply(command);
+    return true;
+}
+
+/* 与 Widget::enterTransition 相同，只是同步加载 */
+void HeadlessGame::enterTransition(const WorldTransition &t)
+{
+    TmxMap *next = acquireMap(t.map);
+    if (!next)
+    {
+        qWarning() << "Headless: cannot load map" << t.map << ", staying on" << m_mapPath;
+        SimCommand command;
+        command.type = SimCommand::TransitionFailed;
+        m_sim->apply(command);
+        return;
+    }
+    const QPoint target = t.fromEdge
+            ? m_world.tileIn(t.map, t.worldPos, QSize(next->m_tileWidth, next->m_tileHeight))
+            : t.tile;
+    ++m_transitions;
+    enterMap(t.map, target);
+}
+
+void HeadlessGame::handleEvents()
+{
+    for (const SimEvent &event : m_sim->takeEvents())
+    {
+        switch (event.type)
+        {
+        case SimEvent::TileChanged:
+            // 记到加载过的地图上，之后回到这张地图时修改还在
+            if (event.generation == m_generation)
+            {
+                if (TmxMap *map = m_maps.value(m_mapPath).data())
+                    map->setTile(event.layer, event.tile.x(), event.tile.y(), event.gid);
+                ++m_tileEdits;
+            }
+            break;
+        case SimEvent::Transition:
+            enterTransition(event.transition);
+            break;
+        case SimEvent::ReplayFinished:
+            m_replayFinished = true;
+            m_replayChecksum = event.text.toLatin1();
+            break;
+        case SimEvent::Status:
+        case SimEvent::NetInput:
+            break;
+        }
+    }
+}
+
+/* 按着一个方向键走一阵，再随机换一个（或者停下）；换的时候偶尔用一个物品 */
+void HeadlessGame::driveBot()
+{
+    if (--m_botHoldTicks > 0)
+        return;
+    m_botHoldTicks = BOT_MIN_HOLD_TICKS + m_botRng.bounded(BOT_MAX_HOLD_TICKS - BOT_MIN_HOLD_TICKS + 1);
+
+    SimCommand command;
+    command.type = SimCommand::Input;
+    command.input.tick = m_sim->tickCount();
+    command.input.timeMs = m_clock.elapsed();
+    if (m_botKey)
+    {
+        command.input.type = InputEvent::KeyRelease;
+        command.input.code = m_botKey;
+        m_sim->apply(command);
+    }
+
+    const int choice = m_botRng.bounded(5);   // 四个方向或者停下
+    m_botKey = choice < 4 ? BOT_KEYS[choice] : 0;
+    if (m_botKey)
+    {
+        command.input.type = InputEvent::Key;
+        command.input.code = m_botKey;
+        m_sim->apply(command);
+    }
+
+    const int slots = m_items.startingItems().size();
+    if (slots > 0 && m_botRng.bounded(100) < BOT_USE_PERCENT)
+    {
+        command.input.type = InputEvent::SlotClick;
+        command.input.code = m_botRng.bounded(slots);
+        m_sim->apply(command);
+    }
+}
+
+void HeadlessGame::report(bool final)
+{
+    const qint64 nowMs = m_clock.elapsed();
+    const qint64 ticks = m_sim->tickCount();
+    const qint64 spanMs = final ? nowMs : nowMs - m_reportMs;
+    const qint64 spanTicks = final ? ticks : ticks - m_reportTicks;
+    const double ticksPerSecond = spanMs > 0 ? spanTicks * 1000.0 / spanMs : 0.0;
+    m_reportMs = nowMs;
+    m_reportTicks = ticks;
+
+    if (!final)
+    {
+        qDebug().nospace() << "Headless: tick " << ticks << ", " << ticksPerSecond << " ticks/s ("
+                           << ticksPerSecond * Simulation::TICK_MS / 1000.0 << "x real time)";
+        return;
+    }
+
+    // 内存里的地图只有图层数据
+    qint64 layerBytes = 0;
+    for (const QSharedPointer<TmxMap> &map : m_maps)
+        for (int l = 0; l < map->layerCount(); ++l)
+            layerBytes += map->layer(l).data.memoryBytes();
+    qDebug().nospace() << "Headless: " << ticks << " ticks in " << nowMs << " ms, " << ticksPerSecond
+                       << " ticks/s (" << ticksPerSecond * Simulation::TICK_MS / 1000.0 << "x real time), "
+                       << m_transitions << " map transitions, " << m_tileEdits << " tile edits, "
+                       << m_maps.size() << " maps loaded (" << layerBytes / 1024 << " KB layer data)";
+    qDebug().noquote() << "Headless: final checksum" << m_sim->checksum();
+}
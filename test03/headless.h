@@ -0,0 +1,84 @@
+// headless.h - 无界面模式：只跑游戏逻辑
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <QString>
+#include <QHash>
+#include <QSharedPointer>
+#include <QScopedPointer>
+#include <QElapsedTimer>
+#include "world.h"
+#include "itemdatabase.h"
+#include "gamerandom.h"
+
+class TmxMap;
+class Simulation;
+
+/*
+ HeadlessGame：没有窗口、场景和 QPixmap 的游戏（--headless），给机器人、长时间的稳定性测试和服务器用
+ - 地图只加载 TmxMap 的数据，复制成 SimMap 建碰撞；不烘焙区块、不读图块集图片，物品不带图标，
+   内存里只有图层数据和模拟本身
+ - Simulation 在调用线程里直接驱动，不开模拟线程：按 Simulation::TICK_MS 的固定步长，或者不限速
+ - 门和地图边缘当场同步加载目标地图（失败时回 TransitionFailed），模拟改过的瓦片记在加载过的地图上，
+   回到同一张地图时还在，与 GUI 的地图缓存一样
+ - 机器人（bot）：隔一阵随机换个方向键、偶尔用一个物品；随机数来自自己的 GameRandom，同一种子每次一样
+ - 回放（replay）：按录制文件喂输入，走完比对最终状态的校验和
+ - 每 REPORT_INTERVAL_MS 打印一次逻辑步/秒，结束时打印总数和最终状态校验和
+*/
+class HeadlessGame
+{
+public:
+    static const int REPORT_INTERVAL_MS = 5000;
+    static const int MAX_LAG_TICKS = 5;        // 固定步长时落后超过这么多步就不再补
+    static const int BOT_MIN_HOLD_TICKS = 15;  // 机器人一个方向至少按多少步
+    static const int BOT_MAX_HOLD_TICKS = 120;
+    static const int BOT_USE_PERCENT = 10;     // 换方向时顺手用一个物品的概率（%）
+
+    struct Options
+    {
+        QString map;               // 出生地图；空为世界的起始地图
+        quint32 seed = 0;
+        qint64 ticks = 0;          // 走到这么多步就结束，0 为不限
+        qint64 seconds = 0;        // 跑这么多秒（真实时间）就结束，0 为不限
+        bool unthrottled = false;  // 不按真实时间限速，能走多快走多快
+        bool bot = false;
+        QString replay;            // 录制文件：按它喂输入（不用 seed、map 和 bot），走完就结束
+    };
+
+    HeadlessGame();
+    ~HeadlessGame();
+
+    /* 读物品定义（不带图标）和世界；都没有时退回到内置物品和只有一张地图的世界 */
+    void loadData();
+    /* 跑到结束，返回进程退出码：0 正常（回放时校验和一致），1 回放的校验和不一致，2 加载失败（包括输入日志的起始地图与世界不符） */
+    int run(const Options &options);
+
+private:
+    TmxMap *acquireMap(const QString &path);
+    bool enterMap(const QString &path, const QPoint &tile);
+    void enterTransition(const WorldTransition &t);
+    void handleEvents();
+    void driveBot();
+    void report(bool final);
+
+    World m_world;
+    ItemDatabase m_items;
+    QScopedPointer<Simulation> m_sim;
+    QHash<QString, QSharedPointer<TmxMap>> m_maps;   // 加载过的地图，模拟的瓦片修改也记在这里
+    QString m_mapPath;
+    int m_generation = 0;
+
+    GameRandom m_botRng;
+    int m_botKey = 0;        // 机器人按着的方向键，0 为没按
+    int m_botHoldTicks = 0;  // 还要按多少步再换
+
+    QElapsedTimer m_clock;
+    qint64 m_reportMs = 0;
+    qint64 m_reportTicks = 0;
+    int m_tileEdits = 0;
+    int m_transitions = 0;
+    bool m_replayFinished = false;
+    QByteArray m_replayChecksum;
+};
+
+#endif // HEADLESS_H
@@ -0,0 +1,278 @@
+// hotreload.cpp - 开发模式下的地图热重载实现
+#include "hotreload.h"
+#include "tmxmap.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+QByteArray readFile(const QString &path)
+{
+    QFile f(path);
+    return f.open(QIODevice::ReadOnly) ? f.readAll() : QByteArray();
+}
+
+/* 每个 <data encoding="csv"> 的文本范围，顺序与 TmxMap::load 解析图层的顺序相同 */
+QVector<QPair<int, int>> findCsvSpans(const QByteArray &bytes)
+{
+    QVector<QPair<int, int>> spans;
+    int pos = 0;
+    while ((pos = bytes.indexOf("<data", pos)) >= 0)
+    {
+        const int open = bytes.indexOf('>', pos);
+        const int close = bytes.indexOf("</data>", pos);
+        if (open < 0 || close < 0 || open > close)
+            break;
+        spans.append(qMakePair(open + 1, close));
+        pos = close;
+    }
+    return spans;
+}
+
+/* 解析一段 CSV（逗号分隔，允许空白和换行）；有非法内容时返回 false */
+bool parseCells(const char *begin, const char *end, QVector<int> &cells)
+{
+    cells.clear();
+    int value = 0;
+    bool digits = false;
+    for (const char *p = begin; ; ++p)
+    {
+        if (p == end || *p == ',')
+        {
+            if (!digits)
+                return false;
+            cells.append(value);
+            value = 0;
+            digits = false;
+            if (p == end)
+                return true;
+        }
+        else if (*p >= '0' && *p <= '9')
+        {
+            value = value * 10 + (*p - '0');
+            digits = true;
+        }
+        else if (*p != ' ' && *p != '\n' && *p != '\r' && *p != '\t')
+        {
+            return false;
+        }
+    }
+}
+
+/* 两段内容相同的前缀长度：先按块 memcmp，再逐字节 */
+int commonPrefix(const QByteArray &a, const QByteArray &b)
+{
+    const int n = qMin(a.size(), b.size());
+    const int block = 4096;
+    int p = 0;
+    while (p + block <= n && memcmp(a.constData() + p, b.constData() + p, block) == 0)
+        p += block;
+    while (p < n && a[p] == b[p])
+        ++p;
+    return p;
+}
+}
+
+HotReloader::HotReloader(QObject *parent) : QObject(parent)
+{
+    m_debounce.setSingleShot(true);
+    m_debounce.setInterval(100);
+    connect(&m_debounce, &QTimer::timeout, this, &HotReloader::processChanges);
+    connect(&m_watcher, &QFileSystemWatcher::fileChanged, this, &HotReloader::onFileChanged);
+}
+
+void HotReloader::watch(TmxMap *map, const QString &tmxPath)
+{
+    stop();
+    m_map = map;
+    m_tmxPath = QFileInfo(tmxPath).absoluteFilePath();
+    m_lastBytes = readFile(m_tmxPath);
+    m_csvSpans = findCsvSpans(m_lastBytes);
+
+    QStringList files = map->sourceFiles();
+    if (!files.contains(m_tmxPath))
+        files.append(m_tmxPath);
+    m_watcher.addPaths(files);
+}
+
+void HotReloader::stop()
+{
+    if (!m_watcher.files().isEmpty())
+        m_watcher.removePaths(m_watcher.files());
+    m_debounce.stop();
+    m_changed.clear();
+    m_map = nullptr;
+    m_lastBytes.clear();
+    m_csvSpans.clear();
+}
+
+void HotReloader::onFileChanged(const QString &path)
+{
+    // 有些编辑器先删除再写新文件，监视会丢失，重新加上
+    if (!m_watcher.files().contains(path) && QFileInfo::exists(path))
+        m_watcher.addPath(path);
+    m_changed.insert(QFileInfo(path).absoluteFilePath());
+    m_debounce.start();
+}
+
+void HotReloader::processChanges()
+{
+    if (!m_map)
+        return;
+
+    const QSet<QString> changed = m_changed;
+    m_changed.clear();
+    for (const QString &path : changed)
+    {
+        if (path != m_tmxPath)
+        {
+            // TSX / 图片变了：瓦片定义或外观都可能变，只能整张重新加载
+            qDebug() << "Hot reload:" << path << "changed, reloading" << m_tmxPath;
+            emit reloadRequired(m_tmxPath);
+            return;
+        }
+    }
+    reloadTmx();
+}
+
+void HotReloader::reloadTmx()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const QByteArray bytes = readFile(m_tmxPath);
+    if (bytes.isEmpty())
+        return;   // 编辑器还没写完，等下一次通知
+    if (bytes == m_lastBytes)
+        return;
+
+    int changed = applyTextDiff(bytes);
+    const bool fast = changed >= 0;
+    if (!fast)
+        changed = applyFullDiff();
+    m_lastBytes = bytes;
+    m_csvSpans = findCsvSpans(m_lastBytes);
+
+    if (changed < 0)
+    {
+        emit reloadRequired(m_tmxPath);
+        return;
+    }
+    qDebug() << "Hot reload:" << changed << "tiles changed in" << timer.elapsed() << "ms"
+             << (fast ? "(incremental)" : "(full parse)");
+}
+
+int HotReloader::applyTextDiff(const QByteArray &bytes)
+{
+    const QByteArray &a = m_lastBytes;
+    const QByteArray &b = bytes;
+    if (a.isEmpty() || m_csvSpans.size() != m_map->layerCount())
+        return -1;
+
+    // 1. 去掉相同的前缀和后缀，剩下的就是改动的范围：旧 [p, oldEnd)，新 [p, newEnd)
+    const int p = commonPrefix(a, b);
+    int s = 0;
+    const int maxSuffix = qMin(a.size(), b.size()) - p;
+    while (s < maxSuffix && a[a.size() - 1 - s] == b[b.size() - 1 - s])
+        ++s;
+    const int oldEnd = a.size() - s;
+    const int newEnd = b.size() - s;
+    const int delta = b.size() - a.size();
+
+    // 2. 改动必须落在某一个图层的 CSV 文本里
+    int layer = -1;
+    for (int i = 0; i < m_csvSpans.size(); ++i)
+        if (m_csvSpans[i].first <= p && oldEnd <= m_csvSpans[i].second)
+            layer = i;
+    if (layer < 0)
+        return -1;
+    const int spanStart = m_csvSpans[layer].first;
+    const int oldSpanEnd = m_csvSpans[layer].second;
+    const int newSpanEnd = oldSpanEnd + delta;
+
+    // 3. 扩展到完整的格子（逗号之间）
+    int start = p;
+    while (start > spanStart && a[start - 1] != ',')
+        --start;
+    int oldStop = oldEnd;
+    while (oldStop < oldSpanEnd && a[oldStop] != ',')
+        ++oldStop;
+    int newStop = newEnd;
+    while (newStop < newSpanEnd && b[newStop] != ',')
+        ++newStop;
+
+    QVector<int> oldCells, newCells;
+    if (!parseCells(a.constData() + start, a.constData() + oldStop, oldCells) ||
+        !parseCells(b.constData() + start, b.constData() + newStop, newCells) ||
+        oldCells.size() != newCells.size())
+        return -1;   // 格子数变了（插入 / 删除），不能按位置对应
+
+    // 4. 第一个格子的序号 = 前面的逗号数
+    const int first = int(std::count(a.constData() + spanStart, a.constData() + start, ','));
+    const int w = m_map->m_mapWidth;
+    if (first + newCells.size() > w * m_map->m_mapHeight)
+        return -1;
+
+    int changed = 0;
+    for (int k = 0; k < newCells.size(); ++k)
+    {
+        const int cell = first + k;
+        if (m_map->tileAt(layer, cell % w, cell / w) == newCells[k])
+            continue;
+        m_map->setTile(layer, cell % w, cell / w, newCells[k]);
+        ++changed;
+    }
+    return changed;
+}
+
+int HotReloader::applyFullDiff()
+{
+    TmxMap fresh;
+    if (!fresh.load(m_tmxPath))
+    {
+        qWarning() << "Hot reload: parse failed, keeping the current map";
+        return 0;
+    }
+
+    // 结构必须一致：尺寸、图层、图块集定义
+    if (fresh.m_mapWidth != m_map->m_mapWidth || fresh.m_mapHeight != m_map->m_mapHeight ||
+        fresh.m_tileWidth != m_map->m_tileWidth || fresh.m_tileHeight != m_map->m_tileHeight ||
+        fresh.layerCount() != m_map->layerCount() || fresh.tiles().size() != m_map->tiles().size() ||
+        fresh.entityLayerIndex() != m_map->entityLayerIndex())
+        return -1;
+    // 图层的 dynamic 属性决定烘焙时怎么合并，变了也要整张重载
+    for (int l = 0; l < fresh.layerCount(); ++l)
+        if (fresh.layer(l).name != m_map->layer(l).name || fresh.layer(l).dynamic != m_map->layer(l).dynamic)
+            return -1;
+    for (int i = 0; i < fresh.tiles().size(); ++i)
+    {
+        const Tile &t1 = fresh.tiles()[i];
+        const Tile &t2 = m_map->tiles()[i];
+        if (t1.id != t2.id || t1.source != t2.source || t1.image != t2.image || t1.collision != t2.collision)
+            return -1;
+    }
+
+    int changed = 0;
+    const int w = m_map->m_mapWidth;
+    for (int l = 0; l < fresh.layerCount(); ++l)
+    {
+        const LayerData &next = fresh.layer(l).data;
+        const LayerData &cur = m_map->layer(l).data;
+        for (int y = 0; y < m_map->m_mapHeight; ++y)
+        {
+            for (int x = 0; x < w; ++x)
+            {
+                const int gid = next.at(x, y);
+                if (gid != cur.at(x, y))
+                {
+                    m_map->setTile(l, x, y, gid);
+                    ++changed;
+                }
+            }
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,55 @@
+// hotreload.h - 开发模式下的地图热重载
+#ifndef HOTRELOAD_H
+#define HOTRELOAD_H
+
+#include <QObject>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QSet>
+#include <QVector>
+#include <QPair>
+
+class TmxMap;
+
+/*
+ HotReloader：监视当前地图的 .tmx / .tsx / 图块集图片，保存后自动重新载入
+ - 只改了 TMX 里的瓦片时，把新旧两份文件逐字节比较，找到变化所在的 CSV 片段，
+   只解析这一小段，对变化的格子调用 TmxMap::setTile。后面的区块作废、碰撞、视野、
+   小地图都跟着 tileChanged 信号增量更新，玩家的位置和状态保持不变
+ - 改动不在某个图层的 CSV 里（或格子数变了）时，完整解析一遍再逐格比较
+ - 地图尺寸、图层、图块集变了，或者 TSX / 图片变了，发出 reloadRequired，由调用方整张重新加载
+ 编辑器保存时往往连续写好几次，变化通知会合并 100ms 再处理。
+ 热重载直接读磁盘上的文件，开发模式下不要挂载资源包。
+*/
+class HotReloader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit HotReloader(QObject *parent = nullptr);
+
+    /* 开始监视 map（它的 sourceFiles()），tmxPath 为地图文件 */
+    void watch(TmxMap *map, const QString &tmxPath);
+    void stop();
+
+signals:
+    void reloadRequired(const QString &tmxPath);
+
+private:
+    void onFileChanged(const QString &path);
+    void processChanges();
+    void reloadTmx();
+
+    int applyTextDiff(const QByteArray &bytes);   // 返回改动的格子数，-1 表示无法走快速路径
+    int applyFullDiff();                          // 返回改动的格子数，-1 表示结构变了
+
+    QFileSystemWatcher m_watcher;
+    QTimer m_debounce;
+    QSet<QString> m_changed;
+
+    TmxMap *m_map = nullptr;
+    QString m_tmxPath;
+    QByteArray m_lastBytes;                 // 上一次的 TMX 内容
+    QVector<QPair<int, int>> m_csvSpans;    // 每个图层 CSV 文本在 m_lastBytes 中的 [起, 止)
+};
+
+#endif // HOTRELOAD_H
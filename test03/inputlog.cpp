@@ -0,0 +1,89 @@
+// inputlog.cpp - 输入录制文件的读写
+#include "inputlog.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+namespace {
+const int VERSION = 1;
+}
+
+bool InputLog::save(const QString &fileName) const
+{
+    QJsonArray list;
+    for (const InputEvent &e : events)
+        list.append(QJsonArray{ double(e.tick), double(e.timeMs), int(e.type), e.code });
+
+    QJsonObject root;
+    root.insert("version", VERSION);
+    root.insert("seed", double(seed));
+    root.insert("map", map);
+    root.insert("tickMs", tickMs);
+    root.insert("ticks", double(ticks));
+    root.insert("checksum", QString::fromLatin1(checksum));
+    root.insert("events", list);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Cannot write input log" << fileName;
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    qDebug() << "Wrote" << events.size() << "input events," << ticks << "ticks to" << fileName;
+    return true;
+}
+
+bool InputLog::load(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Cannot open input log" << fileName;
+        return false;
+    }
+
+    QJsonParseError err;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &err);
+    if (doc.isNull() || !doc.isObject())
+    {
+        qWarning() << "Invalid input log" << fileName << err.errorString();
+        return false;
+    }
+
+    const QJsonObject root = doc.object();
+    if (root.value("version").toInt() != VERSION)
+    {
+        qWarning() << "Unsupported input log version" << root.value("version").toInt() << fileName;
+        return false;
+    }
+
+    // 种子是 32 位无符号数，JSON 里存成 double 不会丢精度
+    seed = quint32(root.value("seed").toDouble());
+    map = root.value("map").toString();
+    tickMs = root.value("tickMs").toInt(16);
+    ticks = qint64(root.value("ticks").toDouble());
+    checksum = root.value("checksum").toString().toLatin1();
+
+    events.clear();
+    qint64 lastTick = 0;
+    for (const QJsonValue &v : root.value("events").toArray())
+    {
+        const QJsonArray a = v.toArray();
+        InputEvent e;
+        e.tick = qint64(a.at(0).toDouble());
+        e.timeMs = qint64(a.at(1).toDouble());
+        e.type = InputEvent::Type(a.at(2).toInt());
+        e.code = a.at(3).toInt();
+        if (a.size() != 4 || e.tick < lastTick || e.type > InputEvent::KeyRelease)
+        {
+            qWarning() << "Corrupt input log event" << events.size() << "in" << fileName;
+            return false;
+        }
+        lastTick = e.tick;
+        events.append(e);
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+// inputlog.h - 输入录制文件
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+
+/* 一条玩家输入，在第 tick 个逻辑步开始时生效 */
+struct InputEvent
+{
+    enum Type : quint8 { Key = 0, SlotClick = 1, KeyRelease = 2 };
+
+    qint64 tick = 0;    // 逻辑步序号，回放按它对齐
+    qint64 timeMs = 0;  // 录制时距开局的真实时间，只用于报告
+    Type type = Key;
+    int code = 0;       // Key / KeyRelease：Qt::Key；SlotClick：槽位下标
+};
+
+/*
+ InputLog：一局游戏的全部输入，加上随机种子和出生地图
+ 逻辑按固定步长推进，输入记在它被处理的那个逻辑步上，所以回放与帧率无关，
+ 最终状态逐位相同；录制结束时的状态校验和也存在文件里，回放完拿来比对。
+ 文件格式（JSON）：
+ {"version":1, "seed":..., "map":"...", "tickMs":16, "ticks":..., "checksum":"...",
+  "events":[[tick, timeMs, type, code], ...]}
+*/
+struct InputLog
+{
+    quint32 seed = 0;
+    QString map;          // 出生地图
+    int tickMs = 16;      // 逻辑步长
+    qint64 ticks = 0;     // 录制结束时走过的逻辑步数
+    QByteArray checksum;  // 录制结束时的状态校验和（十六进制）
+    QVector<InputEvent> events;
+
+    bool save(const QString &fileName) const;
+    bool load(const QString &fileName);
+};
+
+#endif // INPUTLOG_H
@@ -1,6 +1,7 @@
 #include "inventoryslot.h"
 #include <QPainter>
 #include <QRadialGradient>
+#include "frameprofiler.h"
 
 InventorySlot::InventorySlot(QWidget *parent) : QFrame(parent)
 {
@@ -21,6 +22,8 @@ InventorySlot::InventorySlot(QWidget *parent) : QFrame(parent)
 
 void InventorySlot::paintEvent(QPaintEvent *)
 {
+    FrameProfiler::instance().countInventoryRepaint();
+
     QPainter p(this);
     p.setRenderHint(QPainter::Antialiasing);
 
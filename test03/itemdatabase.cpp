@@ -0,0 +1,417 @@
+// itemdatabase.cpp - 数据驱动的物品类型与使用效果实现
+#include "itemdatabase.h"
+#include "simulation.h"
+#include "assetpack.h"
+#include "gamerandom.h"
+#include "scriptcompiler.h"
+#include "tracing.h"
+#include <QDir>
+#include <QHash>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+namespace {
+const int VERSION = 1;
+
+/* 数据文件不存在时的内置定义：与原来写死在 Widget 里的三种厨具相同，
+ 菜刀能砍掉面前的障碍物，锅铲拍打身边的实体 */
+const char DEFAULT_ITEMS[] = R"({
+  "version": 1,
+  "types": [
+    { "name": "菜刀", "verb": "切了菜",
+      "actions": [ { "do": "message" },
+                   { "do": "setTile", "target": "facingTile", "layer": "Obstacle", "to": 0,
+                     "failText": "面前没有可以砍的东西" } ] },
+    { "name": "锅铲", "verb": "抄了菜",
+      "actions": [ { "do": "message" },
+                   { "do": "hitEntities", "target": "nearbyEntities", "radius": 1, "amount": 1 } ] },
+    { "name": "汤勺", "verb": "舀取了汤",
+      "actions": [ { "do": "message" } ] }
+  ],
+  "inventory": [
+    { "name": "崭新的菜刀", "type": "菜刀", "description": "可以切菜", "icon": "caidao.png" },
+    { "name": "铁制锅铲", "type": "锅铲", "description": "烹饪必备", "icon": "guochan.png" },
+    { "name": "木汤勺", "type": "汤勺", "description": "可以舀取汤", "icon": "mushao.png" }
+  ]
+})";
+const char DEFAULT_ICON_DIR[] = "E:\\tiled\\myexmples";
+/* 一次使用最多执行的脚本指令数：物品脚本必须在这之内跑完，写错的死循环只会让这次使用失败 */
+const int ITEM_SCRIPT_BUDGET = 10000;
+
+/* 动作目标格子；越界返回 false */
+bool targetTile(const ItemDatabase::Action &action, const ItemContext &ctx, QPoint *tile)
+{
+    *tile = action.target == ItemDatabase::FacingTile ? ctx.player + ctx.facing : ctx.player;
+    return ctx.map && ctx.map->contains(tile->x(), tile->y());
+}
+
+// ---- 物品脚本的原生函数：ScriptInstance::user 指向本次使用的 ItemContext ----
+ItemContext &contextOf(ScriptInstance &self)
+{
+    return *static_cast<ItemContext *>(self.user);
+}
+
+bool inMap(const ItemContext &ctx, int x, int y)
+{
+    return ctx.map && ctx.map->contains(x, y);
+}
+
+/* 字符串参数（编译时是字符串表下标）；不是合法下标时报错并返回 nullptr */
+const QString *stringArg(ScriptInstance &self, qint32 index)
+{
+    if (index < 0 || index >= self.program()->strings.size())
+    {
+        self.raiseError("argument is not a string");
+        return nullptr;
+    }
+    return &self.program()->string(index);
+}
+
+/*
+ playerX() playerY() facingX() facingY()   玩家所在格子和朝向
+ layer("Obstacle")                         图层下标，当前地图没有这个图层时为 -1
+ tileAt(layer, x, y) setTile(layer, x, y, gid)   读写瓦片（越界读到 0，写入失败返回 0）
+ isObstacle(x, y)                          地图外也算障碍
+ say("……")                                 在提示文字后面追加一句
+ hasItem("菜刀")                           物品栏里有没有这种类型的工具
+ random(n)                                 [0, n) 的随机数，来自逻辑步的随机数发生器
+ hitNearby(radius, amount)                 对周围的实体造成效果，返回命中的个数
+*/
+const ScriptNatives &itemNatives()
+{
+    static const ScriptNatives natives = [] {
+        ScriptNatives n;
+        n.add("playerX", 0, [](ScriptInstance &self, const qint32 *) { return qint32(contextOf(self).player.x()); });
+        n.add("playerY", 0, [](ScriptInstance &self, const qint32 *) { return qint32(contextOf(self).player.y()); });
+        n.add("facingX", 0, [](ScriptInstance &self, const qint32 *) { return qint32(contextOf(self).facing.x()); });
+        n.add("facingY", 0, [](ScriptInstance &self, const qint32 *) { return qint32(contextOf(self).facing.y()); });
+        n.add("layer", 1, [](ScriptInstance &self, const qint32 *a) {
+            const ItemContext &ctx = contextOf(self);
+            const QString *name = stringArg(self, a[0]);
+            for (int l = 0; name && ctx.map && l < ctx.map->layerCount(); ++l)
+                if (ctx.map->layerName(l) == *name)
+                    return qint32(l);
+            return qint32(-1);
+        });
+        n.add("tileAt", 3, [](ScriptInstance &self, const qint32 *a) {
+            const ItemContext &ctx = contextOf(self);
+            return qint32(ctx.map ? ctx.map->tileAt(a[0], a[1], a[2]) : 0);
+        });
+        n.add("setTile", 4, [](ScriptInstance &self, const qint32 *a) {
+            ItemContext &ctx = contextOf(self);
+            if (!inMap(ctx, a[1], a[2]) || a[0] < 0 || a[0] >= ctx.map->layerCount())
+                return qint32(0);
+            return qint32(ctx.map->setTile(a[0], a[1], a[2], a[3]));
+        });
+        n.add("isObstacle", 2, [](ScriptInstance &self, const qint32 *a) {
+            const ItemContext &ctx = contextOf(self);
+            return qint32(!inMap(ctx, a[0], a[1]) || ctx.map->isObstacle(a[0], a[1]));
+        });
+        n.add("say", 1, [](ScriptInstance &self, const qint32 *a) {
+            if (const QString *text = stringArg(self, a[0]))
+                contextOf(self).status += *text;
+            return qint32(0);
+        });
+        n.add("hasItem", 1, [](ScriptInstance &self, const qint32 *a) {
+            const ItemContext &ctx = contextOf(self);
+            const QString *type = stringArg(self, a[0]);
+            if (!type || !ctx.inventory)
+                return qint32(0);
+            for (const ItemState &item : *ctx.inventory)
+                if (item.valid && item.toolType == *type)
+                    return qint32(1);
+            return qint32(0);
+        });
+        n.add("random", 1, [](ScriptInstance &self, const qint32 *a) {
+            GameRandom *rng = contextOf(self).rng;
+            return qint32(rng && a[0] > 0 ? rng->bounded(a[0]) : 0);
+        });
+        n.add("hitNearby", 2, [](ScriptInstance &self, const qint32 *a) {
+            const ItemContext &ctx = contextOf(self);
+            const QVector<int> ids = ctx.entitiesNear ? ctx.entitiesNear(ctx.player, a[0]) : QVector<int>();
+            qint32 hits = 0;
+            for (int id : ids)
+                hits += ctx.hitEntity && ctx.hitEntity(id, a[1]);
+            return hits;
+        });
+        return n;
+    }();
+    return natives;
+}
+
+/* 编译 script 动作引用的脚本；同一个文件在一次加载里只编译一次，也只建一个运行实例 */
+bool loadScript(const QJsonObject &ao, const QString &baseDir, const QString &source,
+                QHash<QString, QSharedPointer<const ScriptProgram>> *cache, QVector<ScriptInstance> *instances,
+                ItemDatabase::Action *action)
+{
+    const bool embedded = ao.contains("source");
+    const QString file = embedded ? QString() : QDir(baseDir).filePath(ao.value("script").toString());
+    QSharedPointer<const ScriptProgram> program = embedded ? QSharedPointer<const ScriptProgram>() : cache->value(file);
+    if (!program)
+    {
+        const QByteArray code = embedded ? ao.value("source").toString().toUtf8() : AssetPack::instance().data(file);
+        if (code.isEmpty())
+        {
+            qWarning() << "Cannot open item script" << file << "in" << source;
+            return false;
+        }
+        QSharedPointer<ScriptProgram> compiled(new ScriptProgram);
+        QString error;
+        if (!ScriptCompiler::compile(code, &itemNatives(), compiled.data(), &error))
+        {
+            qWarning() << "Item script" << (embedded ? source : file) << error;
+            return false;
+        }
+        program = compiled;
+        if (!embedded)
+            cache->insert(file, program);
+    }
+
+    const QString function = ao.value("function").toString("use");
+    action->program = program;
+    action->function = program->function(function);
+    if (action->function < 0 || program->functions[action->function].params != 0)
+    {
+        qWarning() << "Item script has no function" << function << "without parameters in" << source;
+        return false;
+    }
+    for (int i = 0; i < instances->size() && action->script < 0; ++i)
+        if (instances->at(i).program() == program.data())
+            action->script = i;
+    if (action->script < 0)
+    {
+        action->script = instances->size();
+        instances->append(ScriptInstance(program.data()));
+    }
+    return true;
+}
+
+// ---- 动作处理函数：下标与 ItemDatabase::ActionKind 一一对应 ----
+// script 是动作的运行实例（只有 script 动作有，其他为 nullptr）
+typedef bool (*ActionHandler)(const ItemDatabase::Action &action, const ItemState &item, ItemContext &ctx,
+                              ScriptInstance *script);
+
+bool doMessage(const ItemDatabase::Action &action, const ItemState &item, ItemContext &ctx, ScriptInstance *)
+{
+    ctx.status = action.text.isEmpty() ? item.useText : item.useText + action.text;
+    return true;
+}
+
+bool doSetTile(const ItemDatabase::Action &action, const ItemState &, ItemContext &ctx, ScriptInstance *)
+{
+    QPoint tile;
+    if (action.layer < 0 || !targetTile(action, ctx, &tile))
+        return false;
+    const int gid = ctx.map->tileAt(action.layer, tile.x(), tile.y());
+    const bool matches = action.from.isEmpty() ? gid != 0 : action.from.contains(gid);
+    if (!matches || gid == action.to)
+    {
+        if (!action.failText.isEmpty())
+            ctx.status = action.failText;
+        return false;
+    }
+    return ctx.map->setTile(action.layer, tile.x(), tile.y(), action.to);
+}
+
+bool doHitEntities(const ItemDatabase::Action &action, const ItemState &, ItemContext &ctx, ScriptInstance *)
+{
+    const QVector<int> ids = ctx.entitiesNear ? ctx.entitiesNear(ctx.player, action.radius) : QVector<int>();
+    int hits = 0;
+    for (int id : ids)
+        hits += ctx.hitEntity && ctx.hitEntity(id, action.amount);
+    if (hits == 0)
+    {
+        if (!action.failText.isEmpty())
+            ctx.status = action.failText;
+        return false;
+    }
+    return true;
+}
+
+/* 物品脚本一次跑完：用完预算或 yield 都算失败（yield 留给 NPC 这类跨逻辑步的脚本）
+ 实例是重用的，先恢复初始状态：上次留下的全局变量和没跑完的调用都不带到这次 */
+bool doScript(const ItemDatabase::Action &action, const ItemState &, ItemContext &ctx, ScriptInstance *script)
+{
+    ScriptInstance &instance = *script;
+    instance.restart();
+    instance.user = &ctx;
+    if (!instance.start(action.function))
+        return false;
+    const ScriptVM::Result result = ScriptVM::resume(instance, ITEM_SCRIPT_BUDGET);
+    if (result != ScriptVM::Finished)
+    {
+        qWarning() << "Item script" << action.program->functions[action.function].name
+                   << (result == ScriptVM::Failed ? instance.error() : QString("did not finish within budget"));
+        return false;
+    }
+    return instance.result() != 0;
+}
+
+const ActionHandler HANDLERS[ItemDatabase::ActionKindCount] = { doMessage, doSetTile, doHitEntities, doScript };
+
+bool parseKind(const QString &name, ItemDatabase::ActionKind *kind)
+{
+    if (name == "message")          *kind = ItemDatabase::Message;
+    else if (name == "setTile")     *kind = ItemDatabase::SetTile;
+    else if (name == "hitEntities") *kind = ItemDatabase::HitEntities;
+    else if (name == "script")      *kind = ItemDatabase::RunScript;
+    else return false;
+    return true;
+}
+
+bool parseTarget(const QString &name, ItemDatabase::Target *target)
+{
+    if (name.isEmpty() || name == "self")  *target = ItemDatabase::Self;
+    else if (name == "facingTile")         *target = ItemDatabase::FacingTile;
+    else if (name == "nearbyEntities")     *target = ItemDatabase::NearbyEntities;
+    else return false;
+    return true;
+}
+}
+
+bool ItemDatabase::load(const QString &fileName)
+{
+    const QByteArray bytes = AssetPack::instance().data(fileName);
+    if (bytes.isEmpty())
+    {
+        qWarning() << "Cannot open item data" << fileName;
+        return false;
+    }
+    return parse(bytes, QFileInfo(fileName).absolutePath(), fileName);
+}
+
+void ItemDatabase::loadDefaults()
+{
+    parse(QByteArray(DEFAULT_ITEMS), QString::fromLatin1(DEFAULT_ICON_DIR), "built-in items");
+}
+
+bool ItemDatabase::parse(const QByteArray &json, const QString &baseDir, const QString &source)
+{
+    TRACE_SCOPE("ItemDatabase::parse");
+    QJsonParseError err;
+    const QJsonDocument doc = QJsonDocument::fromJson(json, &err);
+    if (doc.isNull() || !doc.isObject())
+    {
+        qWarning() << "Invalid item data" << source << err.errorString();
+        return false;
+    }
+    const QJsonObject root = doc.object();
+    if (root.value("version").toInt() != VERSION)
+    {
+        qWarning() << "Unsupported item data version" << root.value("version").toInt() << source;
+        return false;
+    }
+
+    // 先全部解析到临时表，出错时不破坏已加载的内容
+    ItemDatabase parsed;
+    QHash<QString, QSharedPointer<const ScriptProgram>> scripts;
+    for (const QJsonValue &tv : root.value("types").toArray())
+    {
+        const QJsonObject to = tv.toObject();
+        Type type;
+        type.name = to.value("name").toString();
+        type.verb = to.value("verb").toString();
+        if (type.name.isEmpty() || parsed.typeId(type.name) >= 0)
+        {
+            qWarning() << "Missing or duplicate item type" << type.name << "in" << source;
+            return false;
+        }
+        for (const QJsonValue &av : to.value("actions").toArray())
+        {
+            const QJsonObject ao = av.toObject();
+            Action a;
+            if (!parseKind(ao.value("do").toString(), &a.kind) ||
+                !parseTarget(ao.value("target").toString(), &a.target))
+            {
+                qWarning() << "Unknown action or target" << ao.value("do").toString()
+                           << ao.value("target").toString() << "for" << type.name << "in" << source;
+                return false;
+            }
+            a.layerName = ao.value("layer").toString();
+            for (const QJsonValue &g : ao.value("from").toArray())
+                a.from.append(g.toInt());
+            a.to = ao.value("to").toInt();
+            a.radius = ao.value("radius").toInt(1);
+            a.amount = ao.value("amount").toInt(1);
+            a.text = ao.value("text").toString();
+            a.failText = ao.value("failText").toString();
+            if (a.kind == RunScript && !loadScript(ao, baseDir, source, &scripts, &parsed.m_scripts, &a))
+                return false;
+            type.actions.append(a);
+        }
+        parsed.m_types.append(type);
+    }
+
+    for (const QJsonValue &iv : root.value("inventory").toArray())
+    {
+        const QJsonObject io = iv.toObject();
+        const QString icon = QDir(baseDir).filePath(io.value("icon").toString());
+        const Item item = parsed.createItem(io.value("name").toString(), io.value("type").toString(),
+                                            io.value("description").toString(),
+                                            m_iconsEnabled ? AssetPack::instance().pixmap(icon) : QPixmap());
+        if (item.typeId() < 0)
+        {
+            qWarning() << "Unknown item type" << io.value("type").toString() << "in" << source;
+            return false;
+        }
+        parsed.m_startingItems.append(item);
+    }
+
+    m_types = parsed.m_types;
+    m_startingItems = parsed.m_startingItems;
+    m_scripts = parsed.m_scripts;
+    qDebug() << "Loaded" << m_types.size() << "item types," << m_startingItems.size() << "starting items from" << source;
+    return true;
+}
+
+int ItemDatabase::typeId(const QString &name) const
+{
+    for (int i = 0; i < m_types.size(); ++i)
+        if (m_types[i].name == name)
+            return i;
+    return -1;
+}
+
+Item ItemDatabase::createItem(const QString &name, const QString &type, const QString &description,
+                              const QPixmap &icon) const
+{
+    const int id = typeId(type);
+    if (id < 0)
+        return Item();
+    const QString useText = "使用【" + name + "】→ " + description + "（" + m_types[id].verb + "）";
+    return Item(name, type, description, icon, id, useText);
+}
+
+void ItemDatabase::bindMap(const SimMap *map)
+{
+    for (Type &type : m_types)
+    {
+        for (Action &a : type.actions)
+        {
+            a.layer = -1;
+            if (a.layerName.isEmpty() || !map)
+                continue;
+            for (int l = 0; l < map->layerCount(); ++l)
+            {
+                if (map->layerName(l) == a.layerName)
+                {
+                    a.layer = l;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+bool ItemDatabase::use(const ItemState &item, ItemContext &context) const
+{
+    if (item.typeId < 0 || item.typeId >= m_types.size())
+        return false;
+    bool any = false;
+    for (const Action &a : m_types[item.typeId].actions)
+        any |= HANDLERS[a.kind](a, item, context, a.script >= 0 ? &m_scripts[a.script] : nullptr);
+    return any;
+}
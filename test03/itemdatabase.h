@@ -0,0 +1,149 @@
+// itemdatabase.h - 数据驱动的物品类型与使用效果
+#ifndef ITEMDATABASE_H
+#define ITEMDATABASE_H
+
+#include <QString>
+#include <QVector>
+#include <QPoint>
+#include <QSharedPointer>
+#include <functional>
+#include "Item.h"
+#include "scriptvm.h"
+
+class SimMap;
+class GameRandom;
+
+/* 物品的逻辑部分：模拟线程只持有它，带图标（QPixmap）的 Item 只能在 GUI 线程里用
+ 有没有图标不影响逻辑：无界面模式的物品不带图标，照样有效 */
+struct ItemState
+{
+    ItemState() {}
+    explicit ItemState(const Item &item)
+        : name(item.name()), toolType(item.toolType()), useText(item.useText()),
+          typeId(item.typeId()), valid(!item.name().isEmpty() && !item.toolType().isEmpty()) {}
+
+    QString name;
+    QString toolType;
+    QString useText;
+    int typeId = -1;
+    bool valid = false;
+};
+
+/* 使用物品时的上下文：由调用方（Simulation）填好，动作处理函数只通过它改动游戏 */
+struct ItemContext
+{
+    SimMap *map = nullptr;
+    QPoint player;        // 玩家所在格子
+    QPoint facing;        // 朝向（单位向量）
+    const QVector<ItemState> *inventory = nullptr;
+    GameRandom *rng = nullptr;   // 脚本的 random() 用逻辑步的随机数，回放时结果相同
+    /* 以 center 为中心、radius 格以内的实体编号（Simulation 里是顾客的下标）；为空函数时打不到任何东西 */
+    std::function<QVector<int>(const QPoint &center, int radius)> entitiesNear;
+    /* 对实体 id 造成 amount 点效果；返回 false 表示目标已经不在了 */
+    std::function<bool(int id, int amount)> hitEntity;
+
+    QString status;       // 处理函数写入的提示文字
+};
+
+/*
+ ItemDatabase：物品类型和它们的动作都写在 JSON 数据文件里，启动时编译成
+ - 整数类型编号：Item 创建时就带上，使用时不再比较 toolType 字符串
+ - 每个类型一串动作，动作种类是处理函数表的下标，使用物品就是依次按下标调用
+ - 动作引用的图层名在进入地图时（bindMap）换算成图层下标
+ - 提示文字在创建物品时拼好，使用时直接取
+ 新增工具只需要改数据文件；新增动作种类才需要在 itemdatabase.cpp 的处理函数表里加一项
+
+ 数据文件格式：
+ {
+   "version": 1,
+   "types": [ { "name": "菜刀", "verb": "切了菜",
+                "actions": [ { "do": "message" },
+                             { "do": "setTile", "target": "facingTile", "layer": "Obstacle",
+                               "from": [], "to": 0, "failText": "……" } ] } ],
+   "inventory": [ { "name": "崭新的菜刀", "type": "菜刀", "description": "可以切菜", "icon": "caidao.png" } ]
+ }
+ 动作：message（显示使用提示，可带 text）、setTile（把目标格子的瓦片换成 to，from 非空时只换其中的 GID）、
+ hitEntities（对 radius 格内的实体造成 amount 点效果）、
+ script（运行脚本里的函数 function，脚本写在 script 指向的文件或 source 里，加载时编译，见 scriptcompiler.h；
+ 函数返回非 0 表示生效。脚本能调用的原生函数见 itemdatabase.cpp 的 itemNatives）。
+ target：self（玩家所在格）、facingTile（面前一格）、nearbyEntities（周围的实体，只对 hitEntities 有意义）
+*/
+class ItemDatabase
+{
+public:
+    enum ActionKind : quint8
+    {
+        Message,
+        SetTile,
+        HitEntities,
+        RunScript,
+        ActionKindCount
+    };
+
+    enum Target : quint8
+    {
+        Self,
+        FacingTile,
+        NearbyEntities
+    };
+
+    struct Action
+    {
+        ActionKind kind = Message;
+        Target target = Self;
+        QString layerName;
+        int layer = -1;        // bindMap 时由 layerName 换算，当前地图没有这个图层时为 -1
+        QVector<int> from;     // setTile：只替换这些 GID（空表示任何非空瓦片）
+        int to = 0;
+        int radius = 1;
+        int amount = 1;
+        QString text;          // message 附加的文字
+        QString failText;      // 没有作用对象时的提示
+        QSharedPointer<const ScriptProgram> program;   // script：编译好的脚本（同一文件的动作共用）
+        int function = -1;
+        int script = -1;       // script：运行实例在 m_scripts 里的下标（同一个编译好的脚本共用一个）
+    };
+
+    struct Type
+    {
+        QString name;          // 即 Item::toolType()
+        QString verb;          // 使用提示里括号中的动作描述
+        QVector<Action> actions;
+    };
+
+    /* 读取数据文件（相对路径的图标相对于数据文件所在目录）；失败时保留原内容并返回 false */
+    bool load(const QString &fileName);
+    /* 内置的三种厨具，数据文件不存在时使用 */
+    void loadDefaults();
+    /* 无界面模式（QCoreApplication）不能创建 QPixmap：在 load 之前关掉，初始物品就不读图标 */
+    void setIconsEnabled(bool enabled) { m_iconsEnabled = enabled; }
+
+    int typeCount() const { return m_types.size(); }
+    const Type &type(int typeId) const { return m_types[typeId]; }
+    /* 按名字查类型编号，只在加载和创建物品时用；找不到返回 -1 */
+    int typeId(const QString &name) const;
+
+    /* 数据文件里的初始物品（已带类型编号和拼好的提示文字） */
+    const QVector<Item> &startingItems() const { return m_startingItems; }
+    /* 创建一个物品；类型不存在时返回无效物品 */
+    Item createItem(const QString &name, const QString &type, const QString &description,
+                    const QPixmap &icon) const;
+
+    /* 进入新地图时调用：把动作里的图层名换算成下标 */
+    void bindMap(const SimMap *map);
+
+    /* 依次执行物品类型的所有动作；任何一个动作生效就返回 true */
+    bool use(const ItemState &item, ItemContext &context) const;
+
+private:
+    bool parse(const QByteArray &json, const QString &baseDir, const QString &source);
+
+    QVector<Type> m_types;        // 下标就是类型编号
+    /* 每个编译好的脚本一个运行实例，使用物品时重用，寄存器栈只分配一次
+     复制 ItemDatabase（交给模拟线程）时是隐式共享的，各自第一次使用时分离，不会两个线程用同一个实例 */
+    mutable QVector<ScriptInstance> m_scripts;
+    QVector<Item> m_startingItems;
+    bool m_iconsEnabled = true;
+};
+
+#endif // ITEMDATABASE_H
@@ -0,0 +1,145 @@
+// layerdata.cpp - 图层格子的紧凑存储实现
+#include "layerdata.h"
+
+namespace {
+/* 放得下 gid 的最窄格子宽度（字节） */
+int bytesFor(int gid)
+{
+    if (gid >= 0 && gid <= 0xFF)
+        return 1;
+    if (gid >= 0 && gid <= 0xFFFF)
+        return 2;
+    return 4;
+}
+}
+
+LayerData::LayerData(int width, int height)
+    : m_width(width),
+      m_height(height),
+      m_sparse(true),
+      m_blocksX((width + BLOCK_MASK) >> BLOCK_SHIFT)
+{
+    // 全空的图层：一个块都不分配
+    m_blockOffset.fill(-1, m_blocksX * ((height + BLOCK_MASK) >> BLOCK_SHIFT));
+}
+
+LayerData::LayerData(int width, int height, const QVector<int> &gids)
+    : m_width(width),
+      m_height(height),
+      m_blocksX((width + BLOCK_MASK) >> BLOCK_SHIFT)
+{
+    const int blocksY = (height + BLOCK_MASK) >> BLOCK_SHIFT;
+    const int blockCount = m_blocksX * blocksY;
+
+    // 1. 统计格子宽度和有瓦片的块
+    QVector<quint8> used(blockCount, 0);
+    int usedBlocks = 0;
+    for (int y = 0; y < height; ++y)
+    {
+        const int *row = gids.constData() + y * width;
+        for (int x = 0; x < width; ++x)
+        {
+            if (row[x] == 0)
+                continue;
+            m_cellBytes = qMax(m_cellBytes, bytesFor(row[x]));
+            quint8 &u = used[(y >> BLOCK_SHIFT) * m_blocksX + (x >> BLOCK_SHIFT)];
+            if (!u)
+            {
+                u = 1;
+                ++usedBlocks;
+            }
+        }
+    }
+
+    // 2. 稀疏存储至少省一半内存才用：否则多一次查表不划算
+    const qint64 denseBytes = qint64(width) * height * m_cellBytes;
+    const qint64 sparseBytes = qint64(usedBlocks) * BLOCK_SIZE * BLOCK_SIZE * m_cellBytes +
+                               qint64(blockCount) * sizeof(qint32);
+    m_sparse = sparseBytes * 2 <= denseBytes;
+
+    if (!m_sparse)
+    {
+        m_cells.resize(int(denseBytes));
+        for (int i = 0; i < width * height; ++i)
+            setCell(i, gids[i]);
+        return;
+    }
+
+    m_blockOffset.fill(-1, blockCount);
+    m_cells.fill(0, usedBlocks * BLOCK_SIZE * BLOCK_SIZE * m_cellBytes);
+    int next = 0;
+    for (int b = 0; b < blockCount; ++b)
+    {
+        if (used[b])
+        {
+            m_blockOffset[b] = next;
+            next += BLOCK_SIZE * BLOCK_SIZE;
+        }
+    }
+    for (int y = 0; y < height; ++y)
+        for (int x = 0; x < width; ++x)
+            if (gids[y * width + x] != 0)
+                setCell(cellIndex(x, y), gids[y * width + x]);
+}
+
+int LayerData::cellIndex(int x, int y) const
+{
+    if (!m_sparse)
+        return y * m_width + x;
+    const qint32 base = m_blockOffset[(y >> BLOCK_SHIFT) * m_blocksX + (x >> BLOCK_SHIFT)];
+    return base < 0 ? -1 : base + ((y & BLOCK_MASK) << BLOCK_SHIFT) + (x & BLOCK_MASK);
+}
+
+void LayerData::setCell(int index, int gid)
+{
+    char *p = m_cells.data();
+    switch (m_cellBytes)
+    {
+    case 1:  reinterpret_cast<quint8 *>(p)[index] = quint8(gid); break;
+    case 2:  reinterpret_cast<quint16 *>(p)[index] = quint16(gid); break;
+    default: reinterpret_cast<qint32 *>(p)[index] = gid; break;
+    }
+}
+
+void LayerData::set(int x, int y, int gid)
+{
+    const int need = bytesFor(gid);
+    if (need > m_cellBytes)
+        widen(need);
+
+    int index = cellIndex(x, y);
+    if (index < 0)
+    {
+        if (gid == 0)
+            return; // 空块里写空格子，什么都不用做
+        // 在末尾分配一个新块；清空格子时不回收块，需要时调用 compact()
+        m_blockOffset[(y >> BLOCK_SHIFT) * m_blocksX + (x >> BLOCK_SHIFT)] = m_cells.size() / m_cellBytes;
+        m_cells.append(QByteArray(BLOCK_SIZE * BLOCK_SIZE * m_cellBytes, 0));
+        index = cellIndex(x, y);
+    }
+    setCell(index, gid);
+}
+
+void LayerData::widen(int cellBytes)
+{
+    const int count = m_cells.size() / m_cellBytes;
+    LayerData wide;
+    wide.m_cellBytes = cellBytes;
+    wide.m_cells.resize(count * cellBytes);
+    for (int i = 0; i < count; ++i)
+        wide.setCell(i, cell(i));
+    m_cells.swap(wide.m_cells);
+    m_cellBytes = cellBytes;
+}
+
+QVector<int> LayerData::toVector() const
+{
+    QVector<int> gids(m_width * m_height, 0);
+    forEachTile([&gids, this](int x, int y, int gid) { gids[y * m_width + x] = gid; });
+    return gids;
+}
+
+void LayerData::compact()
+{
+    *this = LayerData(m_width, m_height, toVector());
+}
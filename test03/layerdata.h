@@ -0,0 +1,131 @@
+// layerdata.h - 图层格子的紧凑存储
+#ifndef LAYERDATA_H
+#define LAYERDATA_H
+
+#include <QByteArray>
+#include <QVector>
+
+/*
+ LayerData：一个图层所有格子的 GID
+ - 每格按图层里最大的 GID 选 1 / 2 / 4 字节（c.tmx 的 GID 都在 65535 以内，只要 2 字节）；
+   之后写入更大的 GID 时自动加宽
+ - 大部分为空的图层（例如 Obstacle）自动改用稀疏存储：地图切成 16x16 的块，
+   只给有瓦片的块分配格子，外加一张块索引表；随机访问仍然是 O(1)
+ - 只读接口都是 const，不存在 QVector::operator[] 那样一读就触发写时复制的问题；
+   修改只能走 set()
+ 坐标不做边界检查，调用方（TmxMap）负责
+*/
+class LayerData
+{
+public:
+    static const int BLOCK_SHIFT = 4;
+    static const int BLOCK_SIZE = 1 << BLOCK_SHIFT; // 稀疏块边长（格），与烘焙区块一致
+    static const int BLOCK_MASK = BLOCK_SIZE - 1;
+
+    LayerData() {}
+    /* 全空的图层 */
+    LayerData(int width, int height);
+    /* 从行优先的 GID 数组建立，自动选择格子宽度和存储方式 */
+    LayerData(int width, int height, const QVector<int> &gids);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int size() const { return m_width * m_height; }
+
+    inline int at(int x, int y) const;
+    /* 写入一格；gid 超出当前格子宽度时整层加宽，稀疏存储写入空块时分配这个块 */
+    void set(int x, int y, int gid);
+
+    /* 块 (bx, by) 里是否可能有瓦片：稀疏存储没分配的块一定是空的，稠密存储总是返回 true */
+    bool hasBlock(int bx, int by) const
+    {
+        return !m_sparse || m_blockOffset[by * m_blocksX + bx] >= 0;
+    }
+
+    /* 对每个非空格子调用 fn(x, y, gid)；稀疏存储只遍历已分配的块 */
+    template <typename Fn>
+    void forEachTile(Fn fn) const;
+
+    QVector<int> toVector() const;
+    /* 按当前内容重新选择格子宽度和存储方式（大批修改之后调用） */
+    void compact();
+
+    bool isSparse() const { return m_sparse; }
+    int cellBytes() const { return m_cellBytes; }
+    qint64 memoryBytes() const { return m_cells.size() + qint64(m_blockOffset.size()) * sizeof(qint32); }
+
+private:
+    inline int cell(int index) const;
+    void setCell(int index, int gid);
+    int cellIndex(int x, int y) const; // 稀疏存储中未分配的块返回 -1
+    void widen(int cellBytes);
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_cellBytes = 1;
+    bool m_sparse = false;
+
+    /* 稠密：行优先的全部格子；稀疏：已分配的块依次排列，每块 BLOCK_SIZE * BLOCK_SIZE 格 */
+    QByteArray m_cells;
+    /* 稀疏存储的块索引：块内第一格在 m_cells 中的格子下标，-1 表示整块为空 */
+    QVector<qint32> m_blockOffset;
+    int m_blocksX = 0;
+};
+
+inline int LayerData::cell(int index) const
+{
+    const char *p = m_cells.constData();
+    switch (m_cellBytes)
+    {
+    case 1:  return reinterpret_cast<const quint8 *>(p)[index];
+    case 2:  return reinterpret_cast<const quint16 *>(p)[index];
+    default: return reinterpret_cast<const qint32 *>(p)[index];
+    }
+}
+
+inline int LayerData::at(int x, int y) const
+{
+    if (!m_sparse)
+        return cell(y * m_width + x);
+
+    const qint32 base = m_blockOffset.constData()[(y >> BLOCK_SHIFT) * m_blocksX + (x >> BLOCK_SHIFT)];
+    if (base < 0)
+        return 0;
+    return cell(base + ((y & BLOCK_MASK) << BLOCK_SHIFT) + (x & BLOCK_MASK));
+}
+
+template <typename Fn>
+void LayerData::forEachTile(Fn fn) const
+{
+    if (!m_sparse)
+    {
+        for (int y = 0; y < m_height; ++y)
+            for (int x = 0; x < m_width; ++x)
+            {
+                const int gid = cell(y * m_width + x);
+                if (gid != 0)
+                    fn(x, y, gid);
+            }
+        return;
+    }
+
+    for (int b = 0; b < m_blockOffset.size(); ++b)
+    {
+        const qint32 base = m_blockOffset[b];
+        if (base < 0)
+            continue;
+        const int x0 = (b % m_blocksX) * BLOCK_SIZE;
+        const int y0 = (b / m_blocksX) * BLOCK_SIZE;
+        const int w = qMin(BLOCK_SIZE, m_width - x0);
+        const int h = qMin(BLOCK_SIZE, m_height - y0);
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+            {
+                const int gid = cell(base + y * BLOCK_SIZE + x);
+                if (gid != 0)
+                    fn(x0 + x, y0 + y, gid);
+            }
+    }
+}
+
+#endif // LAYERDATA_H
@@ -0,0 +1,93 @@
+// lockfree.h - 线程之间传递数据用的无锁容器
+#ifndef LOCKFREE_H
+#define LOCKFREE_H
+
+#include <QAtomicInteger>
+#include <QVector>
+
+/*
+ SpscQueue：单生产者、单消费者的环形队列
+ push 只能在一个线程里调用，pop 只能在另一个线程里调用；两边各自只写自己的下标，
+ 不需要锁。容量固定（2 的幂），满了 push 返回 false，由调用方决定丢弃还是稍后再试。
+ 元素出队时原位置被重置为 T()，元素持有的共享数据在消费者线程里释放
+*/
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(int capacity)
+        : m_slots(capacity),
+          m_mask(quint32(capacity - 1))
+    {
+        Q_ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0);
+    }
+
+    /* 生产者线程 */
+    bool push(const T &value)
+    {
+        const quint32 head = m_head.loadAcquire();
+        if (head - m_tail.loadAcquire() > m_mask)
+            return false;
+        m_slots[int(head & m_mask)] = value;
+        m_head.storeRelease(head + 1);
+        return true;
+    }
+
+    /* 消费者线程 */
+    bool pop(T *value)
+    {
+        const quint32 tail = m_tail.loadAcquire();
+        if (tail == m_head.loadAcquire())
+            return false;
+        T &slot = m_slots[int(tail & m_mask)];
+        *value = slot;
+        slot = T();
+        m_tail.storeRelease(tail + 1);
+        return true;
+    }
+
+private:
+    QVector<T> m_slots;
+    const quint32 m_mask;
+    QAtomicInteger<quint32> m_head;   // 下一个写入位置，只有生产者写
+    QAtomicInteger<quint32> m_tail;   // 下一个读取位置，只有消费者写
+};
+
+/*
+ TripleBuffer：一个线程不停地发布最新状态，另一个线程随时取最新的一份
+ 三个槽位分别归写端（back）、读端（front）和中间交换位所有；发布和读取都只是一次
+ 原子交换，谁也不等谁。读端没来得及取的旧版本直接被覆盖，适合每帧只关心最新状态的快照；
+ 不能丢的消息走 SpscQueue
+*/
+template <typename T>
+class TripleBuffer
+{
+public:
+    /* 写端：在 back() 里写好一份完整的状态，然后 publish() */
+    T &back() { return m_slots[m_back]; }
+    void publish()
+    {
+        m_back = m_middle.fetchAndStoreAcqRel(m_back | FRESH) & INDEX;
+    }
+
+    /* 读端：有新发布的状态时换到 front() 并返回 true；front() 在下次 update() 之前不会变 */
+    bool update()
+    {
+        if (!(m_middle.loadAcquire() & FRESH))
+            return false;
+        m_front = m_middle.fetchAndStoreAcqRel(m_front) & INDEX;
+        return true;
+    }
+    const T &front() const { return m_slots[m_front]; }
+
+private:
+    static const int INDEX = 3;
+    static const int FRESH = 4;   // 中间位上是写端刚发布、读端还没取走的状态
+
+    T m_slots[3];
+    int m_back = 0;
+    QAtomicInteger<int> m_middle {1};
+    int m_front = 2;
+};
+
+#endif // LOCKFREE_H
@@ -1,16 +1,144 @@
 // main.cpp - 应用程序入口
 #include <QApplication>
+#include <QCoreApplication>
 #include "widget.h"
 #include "StartWidget.h"
+#include "assetpack.h"
+#include "inputlog.h"
+#include "netprotocol.h"
+#include "headless.h"
+#include "tracing.h"
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <cstring>
+
+/* 命令行参数 name 后面的值，没有则返回空 */
+static QString argumentValue(const QStringList &args, const QString &name)
+{
+    const int i = args.indexOf(name);
+    return i >= 0 && i + 1 < args.size() ? args.at(i + 1) : QString();
+}
+
+/* 所有资源从一个资源包读取（用 assetpacker 生成）；开发模式和没有资源包时读散文件 */
+static void mountAssets(bool devMode)
+{
+    const QString packPath = "E:\\tiled\\myexmples\\game.pak";
+    if (!devMode && QFile::exists(packPath))
+        AssetPack::instance().mount(packPath, "E:\\tiled\\myexmples");
+}
+
+/* 无界面模式：--headless [--ticks 步数] [--seconds 秒数] [--unthrottled] [--bot] [--seed 种子] [--map 地图]
+ 或 --headless --replay 录制文件。只有 QCoreApplication，不建窗口、场景和 QPixmap；
+ 步数和秒数都没给时一直跑下去（回放走完录制就结束）。--trace 与窗口模式相同 */
+static int runHeadless(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    const QStringList args = a.arguments();
+    mountAssets(args.contains("--dev") || qEnvironmentVariableIsSet("LZU_DEV"));
+
+    HeadlessGame::Options options;
+    options.map = argumentValue(args, "--map");
+    bool seeded = false;
+    options.seed = argumentValue(args, "--seed").toUInt(&seeded);
+    if (!seeded)
+        options.seed = QRandomGenerator::global()->generate();
+    options.ticks = argumentValue(args, "--ticks").toLongLong();
+    options.seconds = argumentValue(args, "--seconds").toLongLong();
+    options.unthrottled = args.contains("--unthrottled");
+    options.bot = args.contains("--bot");
+    options.replay = argumentValue(args, "--replay");
+
+    const QString tracePath = argumentValue(args, "--trace");
+    const bool tracing = !tracePath.isEmpty() && Tracer::instance().start();
+
+    HeadlessGame game;
+    game.loadData();
+    const int result = game.run(options);
+    if (tracing)
+        Tracer::instance().writeJson(tracePath);
+    return result;
+}
 
 int main(int argc, char *argv[])
 {
+    // 无界面模式要在创建 QApplication 之前分出去
+    for (int i = 1; i < argc; ++i)
+        if (std::strcmp(argv[i], "--headless") == 0)
+            return runHeadless(argc, argv);
+
+    /* 回放（--replay 录制文件 [--fast] [--frames 逐帧耗时.csv]）不需要窗口：
+     必须在创建 QApplication 之前选 offscreen 平台，画面照样绘制（计入帧耗时），只是不显示 */
+    for (int i = 1; i < argc; ++i)
+        if (std::strcmp(argv[i], "--replay") == 0 && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+
     QApplication a(argc, argv);
+    QElapsedTimer startup;
+    startup.start();
+
+    // 开发模式（--dev 或环境变量 LZU_DEV）：直接读散文件，地图保存后热重载
+    const bool devMode = a.arguments().contains("--dev") || qEnvironmentVariableIsSet("LZU_DEV");
+
+    mountAssets(devMode);
+
+    const QStringList args = a.arguments();
+    const QString replayPath = argumentValue(args, "--replay");
+    const QString recordPath = argumentValue(args, "--record");
+
+    // 时间线追踪（--trace 文件.json，要用 qmake CONFIG+=trace 编译）：从加载地图之前开始记，退出时写出，
+    // 用 Perfetto 或 chrome://tracing 打开
+    const QString tracePath = argumentValue(args, "--trace");
+    if (!tracePath.isEmpty() && Tracer::instance().start())
+        QObject::connect(&a, &QApplication::aboutToQuit, [tracePath]() { Tracer::instance().writeJson(tracePath); });
+
+    Widget w;
+
+    // 回放：跳过开始界面，跑完退出；退出码 0 = 最终状态与录制时一致
+    if (!replayPath.isEmpty())
+    {
+        InputLog log;
+        if (!log.load(replayPath))
+            return 2;
+        QObject::connect(&w, &Widget::replayFinished, &a, [&a](bool matched) { a.exit(matched ? 0 : 1); });
+        w.show();
+        w.startReplay(log, args.contains("--fast"), argumentValue(args, "--frames"));
+        return a.exec();
+    }
+
+    w.setHotReloadEnabled(devMode);
+
+    // 录制（--record 文件）：退出时写出这一局的输入、种子和最终状态校验和
+    if (!recordPath.isEmpty())
+    {
+        w.startRecording(QRandomGenerator::global()->generate());
+        QObject::connect(&a, &QApplication::aboutToQuit, [&w, recordPath]() { w.saveRecording(recordPath); });
+    }
+
+    // 局域网联机：--host [端口] 开一局等别人加入，--connect 主机[:端口] 加入别人的一局
+    if (args.contains("--host"))
+    {
+        const quint16 port = argumentValue(args, "--host").toUShort();
+        w.startHost(port ? port : NetProtocol::DEFAULT_PORT);
+    }
+    const QString connectTo = argumentValue(args, "--connect");
+    if (!connectTo.isEmpty())
+    {
+        const int colon = connectTo.lastIndexOf(':');
+        const quint16 port = colon > 0 ? connectTo.mid(colon + 1).toUShort() : 0;
+        w.connectToHost(colon > 0 ? connectTo.left(colon) : connectTo, port ? port : NetProtocol::DEFAULT_PORT);
+    }
 
     StartWidget startWidget;
     startWidget.show();
 
-    Widget w;
+    // 冷启动 I/O 报告：打开了几个文件、读写了多少、花了多久
+    const AssetPack::Stats io = AssetPack::instance().stats();
+    qDebug().nospace() << "Startup: " << startup.elapsed() << " ms, "
+                       << io.fileOpens << " file opens (" << io.packReads << " from pack, "
+                       << io.looseReads << " loose, " << io.looseWrites << " cache writes), "
+                       << io.bytes / 1024 << " KB read, " << io.bytesWritten / 1024 << " KB written, I/O "
+                       << io.ioNs / 1000000.0 << " ms, decode " << io.decodeNs / 1000000.0 << " ms";
 
     QObject::connect(&startWidget, &StartWidget::startGame, [&]()
     {
@@ -0,0 +1,182 @@
+// mapcache.cpp - 地图缓存实现
+#include "mapcache.h"
+#include "tmxmap.h"
+#include "bakedmap.h"
+#include "fieldofview.h"
+#include "minimap.h"
+#include "simulation.h"
+#include "tracing.h"
+#include <QtConcurrent>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+LoadedMap::~LoadedMap()
+{
+    delete sim;
+    delete minimap;
+    delete fov;
+    delete baked;
+    delete map;
+}
+
+qint64 LoadedMap::byteSize() const
+{
+    qint64 bytes = 0;
+    for (int l = 0; l < map->layerCount(); ++l)
+        bytes += map->layer(l).data.memoryBytes();
+    return bytes + baked->byteSize() + fov->memoryBytes() + minimap->byteSize();
+}
+
+MapCache::MapCache(qint64 budgetBytes, QObject *parent)
+    : QObject(parent),
+      m_budget(budgetBytes)
+{
+}
+
+MapCache::~MapCache()
+{
+    // 等后台加载结束（包括 invalidate 丢下不管的），避免线程池里的任务在缓存销毁后还在运行
+    for (QFutureWatcherBase *w : findChildren<QFutureWatcherBase *>())
+        w->waitForFinished();
+    qDeleteAll(m_pending);
+}
+
+LoadedMapPtr MapCache::loadMap(const QString &path, qint64 bakeLimit)
+{
+    TRACE_SCOPE("MapCache::loadMap");
+    QElapsedTimer timer;
+    timer.start();
+
+    LoadedMapPtr loaded(new LoadedMap);
+    loaded->path = path;
+    loaded->map = new TmxMap;
+    if (!loaded->map->load(path))
+        return LoadedMapPtr();
+
+    // 先解码图块集、烘焙一部分区块，切换地图时就不用再做
+    loaded->baked = new BakedMap(loaded->map);
+    loaded->baked->loadTilesets();
+    loaded->baked->bakeAll(bakeLimit);
+
+    // 视野从障碍物层读入遮挡信息，小地图底图用刚解码的图块集取颜色，模拟的副本要把图块集里的碰撞形状编好；
+    // 都要遍历整张地图或全部图块
+    loaded->fov = new FieldOfView;
+    loaded->fov->reset(loaded->map);
+    loaded->minimap = new MinimapImage(loaded->map, loaded->baked);
+    loaded->sim = new SimMap(*loaded->map, path, 0);
+
+    // 在工作线程创建的 QObject 要交给主线程，之后才能在主线程里收发信号
+    loaded->map->moveToThread(QCoreApplication::instance()->thread());
+
+    const BakedMap::DrawStats &draws = loaded->baked->drawStats();
+    qDebug() << "Map ready:" << path << timer.elapsed() << "ms," << loaded->byteSize() / 1024 << "KB,"
+             << draws.drawn << "tile draws," << draws.covered << "covered and"
+             << draws.transparent << "transparent skipped";
+    return loaded;
+}
+
+void MapCache::preload(const QString &path)
+{
+    if (path.isEmpty() || m_maps.contains(path) || m_pending.contains(path))
+        return;
+
+    QFutureWatcher<LoadedMapPtr> *watcher = new QFutureWatcher<LoadedMapPtr>(this);
+    connect(watcher, &QFutureWatcher<LoadedMapPtr>::finished, this, [this, path]()
+    {
+        LoadedMapPtr loaded = takePending(path);
+        if (!loaded)
+        {
+            qWarning() << "Preloading map failed:" << path;
+            return;
+        }
+        insert(loaded);
+        emit preloaded(path);
+    });
+    m_pending.insert(path, watcher);
+    // 单张地图的烘焙量不超过预算的 1/4，剩下的区块第一次绘制时再烘焙
+    watcher->setFuture(QtConcurrent::run(&MapCache::loadMap, path, m_budget / 4));
+}
+
+LoadedMapPtr MapCache::takePending(const QString &path)
+{
+    QFutureWatcher<LoadedMapPtr> *watcher = m_pending.take(path);
+    if (!watcher)
+        return LoadedMapPtr();
+    watcher->waitForFinished();
+    LoadedMapPtr loaded = watcher->result();
+    watcher->disconnect(this);
+    watcher->deleteLater();
+    return loaded;
+}
+
+LoadedMapPtr MapCache::acquire(const QString &path)
+{
+    TRACE_SCOPE("MapCache::acquire");
+    LoadedMapPtr loaded = m_maps.value(path);
+    if (!loaded && m_pending.contains(path))
+    {
+        // 预加载还没完成：等它，比重新加载一遍快
+        loaded = takePending(path);
+        if (loaded)
+            insert(loaded);
+    }
+    if (!loaded)
+    {
+        loaded = loadMap(path, m_budget / 4);
+        if (!loaded)
+            return LoadedMapPtr();
+        insert(loaded);
+    }
+    touch(path);
+    evict();
+    return loaded;
+}
+
+void MapCache::invalidate(const QString &path)
+{
+    // 正在加载的是旧文件：线程池里的任务停不下来，也不等它，做完以后连同结果一起丢掉
+    if (QFutureWatcher<LoadedMapPtr> *watcher = m_pending.take(path))
+    {
+        watcher->disconnect(this);
+        connect(watcher, &QFutureWatcher<LoadedMapPtr>::finished, watcher, &QObject::deleteLater);
+    }
+    m_maps.remove(path);
+    m_lru.removeOne(path);
+}
+
+void MapCache::insert(const LoadedMapPtr &loaded)
+{
+    m_maps.insert(loaded->path, loaded);
+    touch(loaded->path);
+    evict();
+}
+
+void MapCache::touch(const QString &path)
+{
+    m_lru.removeOne(path);
+    m_lru.prepend(path);
+}
+
+qint64 MapCache::usedBytes() const
+{
+    qint64 bytes = 0;
+    for (const LoadedMapPtr &m : m_maps)
+        bytes += m->byteSize();
+    return bytes;
+}
+
+void MapCache::evict()
+{
+    // 区块是按需烘焙的，占用会增长，所以每次都重新统计
+    qint64 used = usedBytes();
+    for (int i = m_lru.size() - 1; i >= 0 && used > m_budget; --i)
+    {
+        const QString path = m_lru[i];
+        if (path == m_pinned || i == 0)
+            continue;   // 当前地图和刚用到的地图保留
+        used -= m_maps.value(path)->byteSize();
+        m_maps.remove(path);
+        m_lru.removeAt(i);
+        qDebug() << "Evicted map from cache:" << path;
+    }
+}
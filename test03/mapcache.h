@@ -0,0 +1,80 @@
+// mapcache.h - 地图缓存（后台预加载 + LRU）
+#ifndef MAPCACHE_H
+#define MAPCACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <QSharedPointer>
+#include <QFutureWatcher>
+
+class TmxMap;
+class BakedMap;
+class FieldOfView;
+class MinimapImage;
+class SimMap;
+
+/*
+ 一张已加载的地图：解析结果 + 烘焙好的区块，以及进入地图时要用、和地图一样大的东西：
+ 视野的遮挡网格、小地图底图和交给模拟线程的地图副本（带碰撞形状）。它们都在工作线程里准备好，切换地图时主线程只是换上
+ 视野跟着缓存走：回到还在缓存里的地图时，探索过的区域还记得
+*/
+struct LoadedMap
+{
+    QString path;
+    TmxMap *map = nullptr;
+    BakedMap *baked = nullptr;
+    FieldOfView *fov = nullptr;
+    MinimapImage *minimap = nullptr;
+    SimMap *sim = nullptr;     // generation 为 0，进入地图时按它复制一份
+
+    ~LoadedMap();
+    qint64 byteSize() const;   // 图层数据 + 区块图像 + 图块集图片 + 视野网格 + 小地图底图
+};
+typedef QSharedPointer<LoadedMap> LoadedMapPtr;
+
+/*
+ MapCache：按绝对路径缓存地图，总内存不超过预算
+ - preload()：在线程池里解析 TMX 并烘焙区块，完成后放进缓存，不阻塞主线程
+ - acquire()：缓存命中直接返回；正在预加载就等它完成；都不是才同步加载
+ - 超出预算时按最近最少使用（LRU）淘汰；当前地图（pin）不会被淘汰，
+   已被取走的地图由 QSharedPointer 保证在用完之前不会被释放
+*/
+class MapCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MapCache(qint64 budgetBytes = 256 * 1024 * 1024, QObject *parent = nullptr);
+    ~MapCache();
+
+    LoadedMapPtr acquire(const QString &path);
+    void preload(const QString &path);
+    /* 丢弃缓存的地图（文件改了以后），下次 acquire 时重新加载
+     正在预加载的旧文件不等它：让它在后台做完，结果丢掉 */
+    void invalidate(const QString &path);
+
+    bool contains(const QString &path) const { return m_maps.contains(path); }
+    bool isPending(const QString &path) const { return m_pending.contains(path); }
+    void setPinned(const QString &path) { m_pinned = path; }
+
+    qint64 budget() const { return m_budget; }
+    qint64 usedBytes() const;
+
+signals:
+    void preloaded(const QString &path);
+
+private:
+    static LoadedMapPtr loadMap(const QString &path, qint64 bakeLimit); // 在工作线程中执行
+    LoadedMapPtr takePending(const QString &path);
+    void insert(const LoadedMapPtr &loaded);
+    void touch(const QString &path);
+    void evict();
+
+    qint64 m_budget;
+    QString m_pinned;
+    QHash<QString, LoadedMapPtr> m_maps;
+    QStringList m_lru;   // 最近使用的在前
+    QHash<QString, QFutureWatcher<LoadedMapPtr> *> m_pending;
+};
+
+#endif // MAPCACHE_H
@@ -0,0 +1,77 @@
+// maplayeritem.cpp - 按区块绘制一个绘制组的图元实现
+#include "maplayeritem.h"
+#include "bakedmap.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+MapLayerItem::MapLayerItem(BakedMap *baked, int group, const QRectF &bounds, QGraphicsItem *parent)
+    : QGraphicsItem(parent),
+      m_baked(baked),
+      m_group(group),
+      m_bounds(bounds)
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption); // 需要 exposedRect
+    setAcceptedMouseButtons(Qt::NoButton);
+    setZValue(baked->group(group).last);
+}
+
+void MapLayerItem::updateTile(int tileX, int tileY, int tileWidth, int tileHeight)
+{
+    const int cw = m_baked->chunkPixelWidth();
+    const int ch = m_baked->chunkPixelHeight();
+    const int cx = tileX * tileWidth / cw;
+    const int cy = tileY * tileHeight / ch;
+    update(QRectF(cx * cw, cy * ch, cw, ch));
+}
+
+void MapLayerItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+    // 取整到像素，保证贴图时源矩形和目标矩形一样大，不会触发缩放
+    const QRect exposed = option->exposedRect.toAlignedRect().intersected(m_bounds.toAlignedRect());
+    if (exposed.isEmpty())
+        return;
+
+    const int cw = m_baked->chunkPixelWidth();
+    const int ch = m_baked->chunkPixelHeight();
+    const int cx0 = qMax(0, exposed.left() / cw);
+    const int cy0 = qMax(0, exposed.top() / ch);
+    const int cx1 = qMin(m_baked->chunksX() - 1, exposed.right() / cw);
+    const int cy1 = qMin(m_baked->chunksY() - 1, exposed.bottom() / ch);
+
+    const int level = m_baked->levelForScale(
+        QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform()));
+    if (level > 0)
+    {
+        // 缩小的区块：场景坐标下的目标矩形换算到区块图像里要除以 2^level
+        const qreal s = qreal(1 << level);
+        for (int cy = cy0; cy <= cy1; ++cy)
+        {
+            for (int cx = cx0; cx <= cx1; ++cx)
+            {
+                const QImage &img = m_baked->chunk(m_group, cx, cy, level);
+                if (img.isNull())
+                    continue;
+                const QRect target = QRect(cx * cw, cy * ch, img.width() << level, img.height() << level)
+                                         .intersected(exposed);
+                const QRectF source(QPointF(target.x() - cx * cw, target.y() - cy * ch) / s,
+                                    QSizeF(target.size()) / s);
+                painter->drawImage(QRectF(target), img, source);
+            }
+        }
+        return;
+    }
+
+    for (int cy = cy0; cy <= cy1; ++cy)
+    {
+        for (int cx = cx0; cx <= cx1; ++cx)
+        {
+            const QImage &img = m_baked->chunk(m_group, cx, cy);
+            if (img.isNull())
+                continue;   // 空区块
+            // 只贴与重绘区域相交的部分
+            const QRect target = QRect(cx * cw, cy * ch, img.width(), img.height()).intersected(exposed);
+            painter->drawImage(target.topLeft(), img, target.translated(-cx * cw, -cy * ch));
+        }
+    }
+}
@@ -0,0 +1,33 @@
+// maplayeritem.h - 按区块绘制一个绘制组的图元
+#ifndef MAPLAYERITEM_H
+#define MAPLAYERITEM_H
+
+#include <QGraphicsItem>
+
+class BakedMap;
+
+/*
+ MapLayerItem：一个绘制组（合并后的静态图层，或单独的一个图层）只用一个图元，
+ 绘制时从 BakedMap 取出与重绘区域相交的区块贴上去。
+ 默认 z 值为组内最上面图层的序号，与 TileScene 的约定一致；实体上面的组由调用方另设 z 值。
+ 视图缩小时按缩放比例取 BakedMap 对应一级的缩小区块，贴图的像素数与原尺寸视图差不多。
+*/
+class MapLayerItem : public QGraphicsItem
+{
+public:
+    MapLayerItem(BakedMap *baked, int group, const QRectF &bounds, QGraphicsItem *parent = nullptr);
+
+    int group() const { return m_group; }
+    /* 瓦片变化后请求重绘它所在的区块 */
+    void updateTile(int tileX, int tileY, int tileWidth, int tileHeight);
+
+    QRectF boundingRect() const override { return m_bounds; }
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
+
+private:
+    BakedMap *m_baked;
+    int m_group;
+    QRectF m_bounds;
+};
+
+#endif // MAPLAYERITEM_H
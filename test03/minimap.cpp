@@ -0,0 +1,229 @@
+// minimap.cpp - 小地图实现
+#include "minimap.h"
+#include "tmxmap.h"
+#include "bakedmap.h"
+#include <QPainter>
+
+namespace {
+const QColor BACKGROUND(20, 20, 20, 200);
+const QColor PLAYER_COLOR(255, 60, 60);
+const QColor NPC_COLOR(255, 220, 60);
+const int MAX_GID = 1 << 20;   // 超出的 GID（如 Tiled 的翻转标志位）按透明处理
+
+/* 把 src 按各自的 alpha 叠加到 dst 上（非预乘颜色） */
+QRgb blendOver(QRgb dst, QRgb src)
+{
+    const int sa = qAlpha(src);
+    if (sa == 255) return src;
+    if (sa == 0) return dst;
+    const int da = qAlpha(dst) * (255 - sa) / 255;
+    const int a = sa + da;
+    return qRgba((qRed(src) * sa + qRed(dst) * da) / a,
+                 (qGreen(src) * sa + qGreen(dst) * da) / a,
+                 (qBlue(src) * sa + qBlue(dst) * da) / a,
+                 a);
+}
+}
+
+MinimapImage::MinimapImage(const TmxMap *map, const BakedMap *baked)
+    : m_map(map),
+      m_baked(baked)
+{
+    if (m_map->m_mapWidth <= 0 || m_map->m_mapHeight <= 0)
+        return;
+
+    const int longest = qMax(m_map->m_mapWidth, m_map->m_mapHeight);
+    m_scale = (longest + MAX_SIZE - 1) / MAX_SIZE;
+    const int w = (m_map->m_mapWidth + m_scale - 1) / m_scale;
+    const int h = (m_map->m_mapHeight + m_scale - 1) / m_scale;
+    m_image = QImage(w, h, QImage::Format_ARGB32);
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            updatePixel(x, y);
+}
+
+/* GID 的平均颜色，第一次用到时从 BakedMap 最小的一级缩小版里算（一块瓦片只有几个像素） */
+QRgb MinimapImage::gidColor(int gid)
+{
+    if (gid <= 0 || gid > MAX_GID)
+        return qRgba(0, 0, 0, 0);
+    if (gid >= m_gidColors.size())
+        m_gidColors.resize(gid + 1);
+    if (m_gidColors[gid] != 0)
+        return m_gidColors[gid];
+
+    QRgb color = qRgba(0, 0, 0, 1);   // 找不到或完全透明的瓦片；非 0，表示已算过
+    QRect src;
+    const QImage *img = m_baked->tileImage(gid, &src, m_baked->mipLevels());
+    if (img)
+    {
+        // 图块集是预乘 alpha 的：颜色通道之和除以 alpha 之和就是按 alpha 加权的平均，透明像素不影响颜色
+        src = src.intersected(img->rect());
+        qint64 r = 0, g = 0, b = 0, a = 0;
+        for (int y = src.top(); y <= src.bottom(); ++y)
+        {
+            const QRgb *line = reinterpret_cast<const QRgb *>(img->constScanLine(y));
+            for (int x = src.left(); x <= src.right(); ++x)
+            {
+                r += qRed(line[x]);
+                g += qGreen(line[x]);
+                b += qBlue(line[x]);
+                a += qAlpha(line[x]);
+            }
+        }
+        const qint64 n = qint64(src.width()) * src.height();
+        if (a > 0)
+            color = qRgba(int(r * 255 / a), int(g * 255 / a), int(b * 255 / a), qMax(1, int(a / n)));
+    }
+    else if (!m_baked->tilesetsLoaded())
+    {
+        return qRgba(0, 0, 0, 0);   // 刚放上去的新 GID，BakedMap 下次烘焙时才重新建表，先不缓存
+    }
+    else if (m_baked->opacity(gid) == BakedMap::Opaque)
+    {
+        color = qRgba((gid * 37) % 255, (gid * 61) % 255, (gid * 113) % 255, 255); // 图片读不出来：与场景中的占位色一致
+    }
+    m_gidColors[gid] = color;
+    return color;
+}
+
+void MinimapImage::updatePixel(int px, int py)
+{
+    const int x0 = px * m_scale;
+    const int y0 = py * m_scale;
+    const int x1 = qMin(x0 + m_scale, m_map->m_mapWidth);
+    const int y1 = qMin(y0 + m_scale, m_map->m_mapHeight);
+
+    // 颜色按 alpha 加权：透明和半透明的格子不会把颜色拉向黑色，只让整个像素更透明
+    qint64 r = 0, g = 0, b = 0, a = 0, n = 0;
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int x = x0; x < x1; ++x)
+        {
+            // 图层从下往上叠加
+            QRgb c = qRgba(0, 0, 0, 0);
+            for (int l = 0; l < m_map->layerCount(); ++l)
+            {
+                c = blendOver(c, gidColor(m_map->layer(l).data.at(x, y)));
+            }
+            const int alpha = qAlpha(c);
+            r += qRed(c) * alpha; g += qGreen(c) * alpha; b += qBlue(c) * alpha; a += alpha;
+            ++n;
+        }
+    }
+    if (a == 0)
+        m_image.setPixel(px, py, qRgba(0, 0, 0, 0));
+    else
+        m_image.setPixel(px, py, qRgba(int(r / a), int(g / a), int(b / a), int(a / n)));
+}
+
+QPoint MinimapImage::updateTile(int tileX, int tileY)
+{
+    if (m_image.isNull() || tileX < 0 || tileX >= m_map->m_mapWidth || tileY < 0 || tileY >= m_map->m_mapHeight)
+        return QPoint(-1, -1);
+    const QPoint pixel(tileX / m_scale, tileY / m_scale);
+    updatePixel(pixel.x(), pixel.y());
+    return pixel;
+}
+
+Minimap::Minimap(QWidget *parent) : QWidget(parent)
+{
+    setFixedSize(200, 150);
+    setAttribute(Qt::WA_TransparentForMouseEvents);
+    setFocusPolicy(Qt::NoFocus);
+}
+
+void Minimap::setMap(const TmxMap *map, MinimapImage *base)
+{
+    m_map = map;
+    m_base = map ? base : nullptr;
+    m_npcs.clear();   // 上一张地图的顾客，等新地图的第一份快照
+    update();
+}
+
+void Minimap::onTileChanged(int layerIndex, int tileX, int tileY)
+{
+    Q_UNUSED(layerIndex);   // 一个像素要叠加全部图层，不区分是哪一层变了
+    if (!hasImage())
+        return;
+    const QPoint pixel = m_base->updateTile(tileX, tileY);
+    if (pixel.x() < 0)
+        return;
+
+    const QImage &image = m_base->image();
+    const QRectF r = imageRect();
+    const qreal sx = r.width() / image.width();
+    const qreal sy = r.height() / image.height();
+    update(QRectF(r.x() + pixel.x() * sx, r.y() + pixel.y() * sy, sx, sy).toAlignedRect().adjusted(-1, -1, 1, 1));
+}
+
+QRectF Minimap::imageRect() const
+{
+    if (!hasImage())
+        return QRectF();
+    const QSizeF s = QSizeF(m_base->image().size()).scaled(QSizeF(size()) - QSizeF(8, 8), Qt::KeepAspectRatio);
+    return QRectF((width() - s.width()) / 2, (height() - s.height()) / 2, s.width(), s.height());
+}
+
+QPointF Minimap::toWidget(const QPointF &tilePos) const
+{
+    const QRectF r = imageRect();
+    return QPointF(r.x() + tilePos.x() * r.width() / m_map->m_mapWidth,
+                   r.y() + tilePos.y() * r.height() / m_map->m_mapHeight);
+}
+
+void Minimap::setPlayerPosition(const QPointF &tilePos)
+{
+    if (tilePos == m_player)
+        return;
+    // 标记在屏幕上没有挪动一个像素时不必重绘
+    const bool moved = !hasImage() ||
+            toWidget(tilePos).toPoint() != toWidget(m_player).toPoint();
+    m_player = tilePos;
+    if (moved)
+        update();
+}
+
+void Minimap::setNpcPositions(const QVector<QPointF> &tilePositions)
+{
+    m_npcs = tilePositions;
+    update();
+}
+
+void Minimap::setViewRect(const QRectF &tileRect)
+{
+    if (tileRect == m_viewRect)
+        return;
+    m_viewRect = tileRect;
+    update();
+}
+
+void Minimap::paintEvent(QPaintEvent *)
+{
+    QPainter p(this);
+    p.fillRect(rect(), BACKGROUND);
+    if (!hasImage())
+        return;
+
+    // 底图缩放绘制；开销只与控件大小有关
+    const QRectF r = imageRect();
+    p.drawImage(r, m_base->image());
+
+    if (!m_viewRect.isEmpty())
+    {
+        p.setPen(QColor(255, 255, 255, 160));
+        p.setBrush(Qt::NoBrush);
+        p.drawRect(QRectF(toWidget(m_viewRect.topLeft()), toWidget(m_viewRect.bottomRight())));
+    }
+
+    p.setPen(Qt::NoPen);
+    p.setBrush(NPC_COLOR);
+    for (const QPointF &npc : m_npcs)
+        p.drawEllipse(toWidget(npc), 2, 2);
+
+    if (m_player.x() >= 0)
+    {
+        p.setBrush(PLAYER_COLOR);
+        p.drawEllipse(toWidget(m_player), 3, 3);
+    }
+}
@@ -0,0 +1,85 @@
+// minimap.h - 小地图
+#ifndef MINIMAP_H
+#define MINIMAP_H
+
+#include <QWidget>
+#include <QImage>
+#include <QVector>
+#include <QPoint>
+#include <QPointF>
+#include <QRectF>
+
+class TmxMap;
+class BakedMap;
+
+/*
+ 小地图底图：不重新渲染场景，而是直接由图层数据生成一张缩小的图
+ - 生成时为每个用到的 GID 算好一个平均颜色：取 BakedMap 已经解码好的图块集里最小的一级缩小版，
+   对该瓦片的像素求平均，不再自己解码图块集
+ - 每个像素对应 scale × scale 个格子，各图层的平均颜色按顺序叠加后再取平均；
+   最长边不超过 MAX_SIZE，所以再大的地图底图也不会太大
+ - 不是 QObject，也不碰控件：MapCache 在工作线程里预加载地图时就生成好，切换地图时主线程只是换上它
+ - 瓦片变化时只重算它所在的那一个像素
+*/
+class MinimapImage
+{
+public:
+    static const int MAX_SIZE = 512;
+
+    /* baked 要已经 loadTilesets；两者都要比 MinimapImage 活得长 */
+    MinimapImage(const TmxMap *map, const BakedMap *baked);
+
+    /* 某个格子的瓦片变化了：重算对应像素，返回它在底图上的坐标（格子在地图外时返回 (-1, -1)） */
+    QPoint updateTile(int tileX, int tileY);
+
+    const QImage &image() const { return m_image; }
+    qint64 byteSize() const { return m_image.sizeInBytes() + qint64(m_gidColors.size()) * sizeof(QRgb); }
+
+private:
+    QRgb gidColor(int gid);             // GID → 平均颜色（按需计算并缓存）
+    void updatePixel(int px, int py);   // 重算底图上的一个像素
+
+    const TmxMap *m_map;
+    const BakedMap *m_baked;
+    QVector<QRgb> m_gidColors;   // GID → 平均颜色（非预乘 ARGB），0 表示还没算
+    QImage m_image;
+    int m_scale = 1;             // 一个像素覆盖的格子数（每个方向）
+};
+
+/*
+ 小地图：画 MinimapImage 底图，玩家、NPC 标记和视口框在绘制时叠加上去，移动它们不会改动底图
+ 每帧开销只与小地图控件的大小有关，与地图大小无关。
+*/
+class Minimap : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit Minimap(QWidget *parent = nullptr);
+
+    /* 换上预加载时生成好的底图（属于 LoadedMap，离开地图时传 nullptr） */
+    void setMap(const TmxMap *map, MinimapImage *base);
+    /* 某个格子的瓦片变化了（连接 TmxMap::tileChanged） */
+    void onTileChanged(int layerIndex, int tileX, int tileY);
+
+    /* 标记位置都以格子为单位，可以是小数（移动动画中） */
+    void setPlayerPosition(const QPointF &tilePos);
+    void setNpcPositions(const QVector<QPointF> &tilePositions);   // 顾客，每帧由模拟的快照给出
+    void setViewRect(const QRectF &tileRect);   // 当前视口覆盖的格子范围
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    bool hasImage() const { return m_base && !m_base->image().isNull(); }
+    QPointF toWidget(const QPointF &tilePos) const;
+    QRectF imageRect() const;           // 底图在控件中的绘制区域（保持长宽比）
+
+    const TmxMap *m_map = nullptr;
+    MinimapImage *m_base = nullptr;
+
+    QPointF m_player = QPointF(-1, -1);
+    QVector<QPointF> m_npcs;
+    QRectF m_viewRect;
+};
+
+#endif // MINIMAP_H
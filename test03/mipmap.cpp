@@ -0,0 +1,133 @@
+// mipmap.cpp - 图块集的多级缩小图实现
+#include "mipmap.h"
+#include "assetpack.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QBuffer>
+#include <QDebug>
+
+namespace {
+const quint32 MAGIC = 0x504d5a4c; // "LZMP"
+const quint32 VERSION = 1;
+
+/* 缓存文件名：图块集文件名 + 路径的哈希（不同目录下的同名图块集不会冲突） */
+QString cacheFile(const QString &path, const QString &cacheDir)
+{
+    const QByteArray id = QCryptographicHash::hash(QFileInfo(path).absoluteFilePath().toUtf8(),
+                                                   QCryptographicHash::Sha1).toHex().left(12);
+    return QDir(cacheDir).filePath(QString("%1-%2.mip").arg(QFileInfo(path).completeBaseName(),
+                                                            QString::fromLatin1(id)));
+}
+
+/* 读缓存（经过 AssetPack，计入 I/O 统计）：格式不对、内容哈希或级数对不上都当作没有缓存 */
+QVector<QImage> readCache(const QString &fileName, const QByteArray &key, int levels)
+{
+    QByteArray bytes = AssetPack::instance().data(fileName);
+    if (bytes.isEmpty())
+        return QVector<QImage>();
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    QDataStream in(&buffer);
+    quint32 magic = 0, version = 0, count = 0;
+    QByteArray storedKey;
+    in >> magic >> version >> storedKey >> count;
+    if (magic != MAGIC || version != VERSION || storedKey != key || int(count) != levels)
+        return QVector<QImage>();
+
+    QVector<QImage> result;
+    for (int l = 0; l < levels; ++l)
+    {
+        qint32 w = 0, h = 0;
+        in >> w >> h;
+        if (in.status() != QDataStream::Ok || w <= 0 || h <= 0)
+            return QVector<QImage>();
+        QImage img(w, h, QImage::Format_ARGB32_Premultiplied);
+        for (int y = 0; y < h; ++y)
+        {
+            const int bytes = w * 4;
+            if (in.readRawData(reinterpret_cast<char *>(img.scanLine(y)), bytes) != bytes)
+                return QVector<QImage>();
+        }
+        result.append(img);
+    }
+    return result;
+}
+
+/* 在内存里拼好整个文件，交给 AssetPack::writeLoose（先写临时文件再替换，计入 I/O 统计） */
+bool writeCache(const QString &fileName, const QByteArray &key, const QVector<QImage> &levels)
+{
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out << MAGIC << VERSION << key << quint32(levels.size());
+    for (const QImage &img : levels)
+    {
+        out << qint32(img.width()) << qint32(img.height());
+        for (int y = 0; y < img.height(); ++y)
+            out.writeRawData(reinterpret_cast<const char *>(img.constScanLine(y)), img.width() * 4);
+    }
+    return out.status() == QDataStream::Ok && AssetPack::instance().writeLoose(fileName, bytes);
+}
+}
+
+namespace Mipmap
+{
+QImage halve(const QImage &image)
+{
+    const int w = qMax(1, image.width() / 2);
+    const int h = qMax(1, image.height() / 2);
+    QImage out(w, h, QImage::Format_ARGB32_Premultiplied);
+    // 1 像素宽 / 高的图没有第二行 / 列可取，重复同一个像素
+    const int dx = image.width() > 1 ? 1 : 0;
+    const int dy = image.height() > 1 ? 1 : 0;
+    for (int y = 0; y < h; ++y)
+    {
+        const quint32 *r0 = reinterpret_cast<const quint32 *>(image.constScanLine(2 * y));
+        const quint32 *r1 = reinterpret_cast<const quint32 *>(image.constScanLine(2 * y + dy));
+        quint32 *dst = reinterpret_cast<quint32 *>(out.scanLine(y));
+        for (int x = 0; x < w; ++x)
+        {
+            const quint32 p[4] = { r0[2 * x], r0[2 * x + dx], r1[2 * x], r1[2 * x + dx] };
+            // 两个通道一组相加（每个通道 8 位，4 个相加不超过 10 位，不会溢出到相邻通道），四舍五入
+            quint32 rb = 0x00020002, ag = 0x00020002;
+            for (quint32 v : p)
+            {
+                rb += v & 0x00ff00ff;
+                ag += (v >> 8) & 0x00ff00ff;
+            }
+            dst[x] = ((rb >> 2) & 0x00ff00ff) | (((ag >> 2) & 0x00ff00ff) << 8);
+        }
+    }
+    return out;
+}
+
+QVector<QImage> levels(const QString &path, const QImage &atlas, int levels, const QString &cacheDir)
+{
+    if (levels <= 0 || atlas.isNull())
+        return QVector<QImage>();
+
+    QByteArray key;
+    QString fileName;
+    QVector<QImage> result;
+    if (!cacheDir.isEmpty())
+    {
+        // 图块集可能在资源包里，直接对编码后的文件内容求哈希
+        key = QCryptographicHash::hash(AssetPack::instance().data(path), QCryptographicHash::Sha1);
+        fileName = cacheFile(path, cacheDir);
+        result = readCache(fileName, key, levels);
+        if (!result.isEmpty())
+            return result;
+    }
+
+    QImage level = atlas;
+    for (int l = 0; l < levels; ++l)
+    {
+        level = halve(level);
+        result.append(level);
+    }
+    if (!cacheDir.isEmpty() && (!QDir().mkpath(cacheDir) || !writeCache(fileName, key, result)))
+        qDebug() << "Mipmap cache not writable, keeping levels in memory:" << fileName;
+    return result;
+}
+}
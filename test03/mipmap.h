@@ -0,0 +1,31 @@
+// mipmap.h - 图块集的多级缩小图
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <QImage>
+#include <QVector>
+#include <QString>
+
+/*
+ Mipmap：图块集图片的 1/2、1/4、1/8 缩小版，缩小视图时直接取对应的一级，
+ 不必每帧把原尺寸的瓦片缩小绘制
+ - 每一级由上一级 2x2 取平均得到（预乘 alpha 下取平均就是正确的过滤）
+ - 生成一次后缓存到地图目录下的 .mipcache：一张图块集一个文件，存预乘 ARGB32 原始像素，
+   读取时不用解码；文件头记录图块集内容的 SHA-1，图块集改过以后自动重新生成。
+   读写都经过 AssetPack，算在它的 I/O 统计里
+ - 缓存目录不可写（例如地图在只读的安装目录）时只在内存里生成，不报错
+ 可以在后台线程调用（MapCache 预加载时 BakedMap::loadTilesets 会用到）
+*/
+namespace Mipmap
+{
+const int MAX_LEVEL = 3; // 最小到 1/8
+
+/* 2x2 取平均缩小一半（输入必须是 Format_ARGB32_Premultiplied，奇数边长舍去最后一行 / 列） */
+QImage halve(const QImage &image);
+
+/* 图块集 path（已解码为预乘 ARGB32 的 atlas）的第 1..levels 级；
+ 先查 cacheDir 里的缓存，没有或过期时生成并写回（cacheDir 为空则不用缓存）。返回 levels 张图，下标 0 是 1/2 */
+QVector<QImage> levels(const QString &path, const QImage &atlas, int levels, const QString &cacheDir);
+}
+
+#endif // MIPMAP_H
@@ -0,0 +1,484 @@
+// netprotocol.cpp - 联机报文的编码和解码
+#include "netprotocol.h"
+#include <QtMath>
+#include <limits>
+
+namespace {
+const int MAX_STRING = 1024;     // 地图路径、物品名的最大字节数
+const int MAX_LIST = 65536;      // 列表最多多少项，乱发的报文不会让解码分配大块内存
+
+enum PlayerFlag : quint8 { PlayerNew = 1, PlayerInventory = 2, PlayerMoving = 4 };
+enum EntityFlag : quint8 { EntityX = 1, EntityY = 2, EntityMood = 4 };
+
+quint32 zigzag(qint32 v) { return (quint32(v) << 1) ^ quint32(v >> 31); }
+qint32 unzigzag(quint32 v) { return qint32(v >> 1) ^ -qint32(v & 1); }
+
+class NetWriter
+{
+public:
+    explicit NetWriter(NetProtocol::PacketType type)
+    {
+        m_bytes.reserve(64);
+        u8('L');
+        u8('Z');
+        u8(NetProtocol::VERSION);
+        u8(type);
+    }
+
+    void u8(quint8 v) { m_bytes.append(char(v)); }
+    void varint(quint64 v)
+    {
+        while (v >= 0x80)
+        {
+            u8(quint8(v) | 0x80);
+            v >>= 7;
+        }
+        u8(quint8(v));
+    }
+    void sint(qint32 v) { varint(zigzag(v)); }
+    void string(const QString &s)
+    {
+        QByteArray utf8 = s.toUtf8();
+        if (utf8.size() > MAX_STRING)
+        {
+            // 截断点往前退到字符边界（不是 10xxxxxx 的续字节），不把一个汉字切成两半
+            int n = MAX_STRING;
+            while (n > 0 && (quint8(utf8[n]) & 0xC0) == 0x80)
+                --n;
+            utf8.truncate(n);
+        }
+        varint(quint64(utf8.size()));
+        m_bytes.append(utf8);
+    }
+
+    const QByteArray &bytes() const { return m_bytes; }
+
+private:
+    QByteArray m_bytes;
+};
+
+/* 读到报文末尾之后的每次读取都返回 0 并把 ok 置为 false，调用方最后检查一次就够了 */
+class NetReader
+{
+public:
+    NetReader(const QByteArray &bytes, NetProtocol::PacketType type) : m_bytes(bytes)
+    {
+        if (NetProtocol::packetType(bytes) != type)
+            m_ok = false;
+        m_pos = 4;
+    }
+
+    bool ok() const { return m_ok; }
+    bool atEnd() const { return m_pos == m_bytes.size(); }
+
+    quint8 u8()
+    {
+        if (!m_ok || m_pos >= m_bytes.size())
+        {
+            m_ok = false;
+            return 0;
+        }
+        return quint8(m_bytes[m_pos++]);
+    }
+    quint64 varint()
+    {
+        quint64 v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            const quint8 b = u8();
+            v |= quint64(b & 0x7f) << shift;
+            if (!(b & 0x80))
+                return v;
+        }
+        m_ok = false;
+        return 0;
+    }
+    quint32 u32()
+    {
+        const quint64 v = varint();
+        if (v > 0xffffffffu)
+            m_ok = false;
+        return quint32(v);
+    }
+    qint32 sint() { return unzigzag(u32()); }
+    /* 列表长度：超过上限或比剩下的字节还多（每项至少一个字节）都算坏报文 */
+    int count()
+    {
+        const quint32 n = u32();
+        if (n > quint32(MAX_LIST) || int(n) > m_bytes.size() - m_pos)
+        {
+            m_ok = false;
+            return 0;
+        }
+        return int(n);
+    }
+    QString string()
+    {
+        const quint32 n = u32();
+        if (!m_ok || n > quint32(MAX_STRING) || int(n) > m_bytes.size() - m_pos)
+        {
+            m_ok = false;
+            return QString();
+        }
+        const QString s = QString::fromUtf8(m_bytes.constData() + m_pos, int(n));
+        m_pos += int(n);
+        return s;
+    }
+
+private:
+    const QByteArray &m_bytes;
+    int m_pos = 0;
+    bool m_ok = true;
+};
+
+const NetPlayerState *findPlayer(const NetWorldState *state, quint8 id)
+{
+    if (!state)
+        return nullptr;
+    for (const NetPlayerState &p : state->players)
+        if (p.id == id)
+            return &p;
+    return nullptr;
+}
+}
+
+namespace NetProtocol
+{
+quint8 facingCode(const QPoint &facing)
+{
+    if (facing.x() < 0) return 1;
+    if (facing.x() > 0) return 2;
+    if (facing.y() < 0) return 3;
+    return 0;
+}
+
+QPoint facingOf(quint8 code)
+{
+    static const QPoint dirs[] = { QPoint(0, 1), QPoint(-1, 0), QPoint(1, 0), QPoint(0, -1) };
+    return dirs[code & 3];
+}
+
+qint32 quantizePosition(qreal pixels)
+{
+    return qint32(qRound(pixels * POSITION_SCALE));
+}
+
+qreal positionOf(qint32 quantized)
+{
+    return qreal(quantized) / POSITION_SCALE;
+}
+
+PacketType packetType(const QByteArray &packet)
+{
+    if (packet.size() < 4 || packet[0] != 'L' || packet[1] != 'Z' || quint8(packet[2]) != VERSION)
+        return Invalid;
+    const quint8 type = quint8(packet[3]);
+    return type >= Hello && type <= Bye ? PacketType(type) : Invalid;
+}
+
+QByteArray encodeHello(const QString &map)
+{
+    NetWriter w(Hello);
+    w.string(map);
+    return w.bytes();
+}
+
+bool decodeHello(const QByteArray &packet, QString *map)
+{
+    NetReader r(packet, Hello);
+    *map = r.string();
+    return r.ok() && r.atEnd();
+}
+
+QByteArray encodeWelcome(quint8 playerId, const QString &map)
+{
+    NetWriter w(Welcome);
+    w.u8(playerId);
+    w.string(map);
+    return w.bytes();
+}
+
+bool decodeWelcome(const QByteArray &packet, quint8 *playerId, QString *map)
+{
+    NetReader r(packet, Welcome);
+    *playerId = r.u8();
+    *map = r.string();
+    return r.ok() && r.atEnd();
+}
+
+QByteArray encodeBye(quint8 playerId)
+{
+    NetWriter w(Bye);
+    w.u8(playerId);
+    return w.bytes();
+}
+
+bool decodeBye(const QByteArray &packet, quint8 *playerId)
+{
+    NetReader r(packet, Bye);
+    *playerId = r.u8();
+    return r.ok() && r.atEnd();
+}
+
+QByteArray encodeInput(quint8 playerId, quint32 stateAck, const QVector<NetInputFrame> &frames)
+{
+    const int first = qMax(0, frames.size() - MAX_INPUT_FRAMES);
+    NetWriter w(Input);
+    w.u8(playerId);
+    w.varint(stateAck);
+    w.u8(quint8(frames.size() - first));
+    if (first < frames.size())
+        w.sint(frames[first].tick);
+    for (int i = first; i < frames.size(); ++i)
+    {
+        // 方向键 4 位、朝向 2 位合成一个字节；物品格 +1，0 为没有
+        w.u8(quint8((frames[i].keys & 0x0f) | (frames[i].facing & 3) << 4));
+        w.u8(quint8(frames[i].slot + 1));
+    }
+    return w.bytes();
+}
+
+bool decodeInput(const QByteArray &packet, quint8 *playerId, quint32 *stateAck, QVector<NetInputFrame> *frames)
+{
+    NetReader r(packet, Input);
+    *playerId = r.u8();
+    *stateAck = r.u32();
+    const int n = r.u8();
+    frames->clear();
+    const qint32 tick = n > 0 ? r.sint() : 0;
+    for (int i = 0; i < n && r.ok(); ++i)
+    {
+        NetInputFrame f;
+        f.tick = tick + i;
+        const quint8 bits = r.u8();
+        f.keys = bits & 0x0f;
+        f.facing = (bits >> 4) & 3;
+        f.slot = qint8(r.u8() - 1);
+        frames->append(f);
+    }
+    return r.ok() && r.atEnd();
+}
+
+QByteArray encodeState(const NetWorldState &state, const NetWorldState *baseline)
+{
+    NetWriter w(State);
+    w.varint(state.seq);
+    w.varint(baseline ? baseline->seq : 0);
+    w.varint(quint64(state.tick));
+    w.sint(state.inputAck);
+    w.varint(state.editSeq);
+
+    // 玩家：人数少，每个都写，位置按与基准的差值
+    w.varint(quint64(state.players.size()));
+    for (const NetPlayerState &p : state.players)
+    {
+        const NetPlayerState *base = findPlayer(baseline, p.id);
+        quint8 flags = p.moving ? PlayerMoving : 0;
+        if (!base)
+            flags |= PlayerNew;
+        if (!base || base->inventory != p.inventory)
+            flags |= PlayerInventory;
+        w.u8(p.id);
+        w.u8(quint8(flags | (p.facing & 3) << 4));
+        w.sint(p.x - (base ? base->x : 0));
+        w.sint(p.y - (base ? base->y : 0));
+        if (flags & PlayerInventory)
+        {
+            w.varint(quint64(p.inventory.size()));
+            for (const QString &name : p.inventory)
+                w.string(name);
+        }
+    }
+
+    // 顾客：两边都按 id 排序，一起往下走，只写变了的和新出现的
+    static const QVector<NetEntityState> none;
+    const QVector<NetEntityState> &before = baseline ? baseline->entities : none;
+    QVector<int> changed;
+    QVector<qint32> removed;
+    int b = 0;
+    for (int i = 0; i < state.entities.size(); ++i)
+    {
+        const NetEntityState &e = state.entities[i];
+        while (b < before.size() && before[b].id < e.id)
+            removed.append(before[b++].id);
+        if (b < before.size() && before[b].id == e.id)
+        {
+            const NetEntityState &o = before[b++];
+            if (o.x == e.x && o.y == e.y && o.mood == e.mood)
+                continue;
+        }
+        changed.append(i);
+    }
+    while (b < before.size())
+        removed.append(before[b++].id);
+
+    w.varint(quint64(changed.size()));
+    qint32 prevId = -1;
+    b = 0;
+    for (int i : changed)
+    {
+        const NetEntityState &e = state.entities[i];
+        while (b < before.size() && before[b].id < e.id)
+            ++b;
+        const NetEntityState *o = b < before.size() && before[b].id == e.id ? &before[b] : nullptr;
+        quint8 flags = 0;
+        if (!o || o->x != e.x) flags |= EntityX;
+        if (!o || o->y != e.y) flags |= EntityY;
+        if (!o || o->mood != e.mood) flags |= EntityMood;
+        w.varint(quint32(e.id - prevId - 1));
+        w.u8(flags);
+        if (flags & EntityX)
+            w.sint(e.x - (o ? o->x : 0));
+        if (flags & EntityY)
+            w.sint(e.y - (o ? o->y : 0));
+        if (flags & EntityMood)
+            w.u8(e.mood);
+        prevId = e.id;
+    }
+    w.varint(quint64(removed.size()));
+    prevId = -1;
+    for (qint32 id : removed)
+    {
+        w.varint(quint32(id - prevId - 1));
+        prevId = id;
+    }
+
+    w.varint(quint64(state.edits.size()));
+    for (const NetTileEdit &e : state.edits)
+    {
+        w.u8(e.layer);
+        w.varint(e.x);
+        w.varint(e.y);
+        w.varint(quint32(e.gid));
+    }
+    return w.bytes();
+}
+
+bool stateBaseline(const QByteArray &packet, quint32 *baselineSeq)
+{
+    NetReader r(packet, State);
+    r.u32();
+    *baselineSeq = r.u32();
+    return r.ok();
+}
+
+bool decodeState(const QByteArray &packet, const NetWorldState *baseline, NetWorldState *state)
+{
+    NetReader r(packet, State);
+    NetWorldState s;
+    s.seq = r.u32();
+    const quint32 baselineSeq = r.u32();
+    if (baselineSeq != (baseline ? baseline->seq : 0))
+        return false;
+    s.tick = qint64(r.varint());
+    s.inputAck = r.sint();
+    s.editSeq = r.u32();
+
+    const int playerCount = r.count();
+    for (int i = 0; i < playerCount && r.ok(); ++i)
+    {
+        NetPlayerState p;
+        p.id = r.u8();
+        const quint8 bits = r.u8();
+        p.facing = (bits >> 4) & 3;
+        p.moving = bits & PlayerMoving;
+        const NetPlayerState *base = bits & PlayerNew ? nullptr : findPlayer(baseline, p.id);
+        if (!(bits & PlayerNew) && !base)
+            return false;
+        p.x = r.sint() + (base ? base->x : 0);
+        p.y = r.sint() + (base ? base->y : 0);
+        if (bits & PlayerInventory)
+        {
+            const int n = r.count();
+            for (int k = 0; k < n && r.ok(); ++k)
+                p.inventory.append(r.string());
+        }
+        else if (base)
+        {
+            p.inventory = base->inventory;
+        }
+        s.players.append(p);
+    }
+
+    // 先读出变了的和去掉的，再与基准合并成完整的列表
+    QVector<NetEntityState> changed;
+    QVector<quint8> changedFlags;
+    const int changedCount = r.count();
+    changed.reserve(changedCount);
+    qint32 id = -1;
+    for (int i = 0; i < changedCount && r.ok(); ++i)
+    {
+        NetEntityState e;
+        id += qint32(r.u32()) + 1;
+        e.id = id;
+        const quint8 flags = r.u8();
+        if (flags & EntityX) e.x = r.sint();
+        if (flags & EntityY) e.y = r.sint();
+        if (flags & EntityMood) e.mood = r.u8();
+        changed.append(e);
+        changedFlags.append(flags);
+    }
+    QVector<qint32> removed;
+    const int removedCount = r.count();
+    id = -1;
+    for (int i = 0; i < removedCount && r.ok(); ++i)
+    {
+        id += qint32(r.u32()) + 1;
+        removed.append(id);
+    }
+    if (!r.ok())
+        return false;
+
+    static const QVector<NetEntityState> none;
+    const QVector<NetEntityState> &before = baseline ? baseline->entities : none;
+    s.entities.reserve(before.size() + changed.size());
+    int b = 0;
+    int rm = 0;
+    for (int c = 0; c <= changed.size(); ++c)
+    {
+        const qint32 limit = c < changed.size() ? changed[c].id : std::numeric_limits<qint32>::max();
+        // 基准里 id 小于下一个变化的顾客：没去掉的原样留下
+        while (b < before.size() && before[b].id < limit)
+        {
+            while (rm < removed.size() && removed[rm] < before[b].id)
+                ++rm;
+            if (rm >= removed.size() || removed[rm] != before[b].id)
+                s.entities.append(before[b]);
+            ++b;
+        }
+        if (c == changed.size())
+            break;
+        NetEntityState e = changed[c];
+        const bool inBase = b < before.size() && before[b].id == e.id;
+        const quint8 flags = changedFlags[c];
+        if (inBase)
+        {
+            const NetEntityState &o = before[b++];
+            e.x = flags & EntityX ? o.x + e.x : o.x;
+            e.y = flags & EntityY ? o.y + e.y : o.y;
+            if (!(flags & EntityMood))
+                e.mood = o.mood;
+        }
+        else if (flags != (EntityX | EntityY | EntityMood))
+        {
+            return false;   // 基准里没有的顾客必须整个带上
+        }
+        s.entities.append(e);
+    }
+
+    const int editCount = r.count();
+    for (int i = 0; i < editCount && r.ok(); ++i)
+    {
+        NetTileEdit e;
+        e.layer = r.u8();
+        e.x = quint16(r.u32());
+        e.y = quint16(r.u32());
+        e.gid = qint32(r.u32());
+        s.edits.append(e);
+    }
+    if (!r.ok() || !r.atEnd() || quint32(s.edits.size()) > s.editSeq)
+        return false;
+    *state = s;
+    return true;
+}
+}
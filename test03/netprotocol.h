@@ -0,0 +1,121 @@
+// netprotocol.h - 联机报文：量化的世界状态，按对方确认过的基准做差分
+#ifndef NETPROTOCOL_H
+#define NETPROTOCOL_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPoint>
+#include <QPointF>
+
+/* 客户端一个逻辑步的输入：按住的方向键、朝向和这一步使用的物品格 */
+struct NetInputFrame
+{
+    enum Key : quint8 { Left = 1, Right = 2, Up = 4, Down = 8 };
+
+    qint32 tick = 0;     // 客户端的逻辑步
+    quint8 keys = 0;     // Key 的组合
+    quint8 facing = 0;   // NetProtocol::facingCode
+    qint8 slot = -1;     // 使用的物品格，-1 为没有
+};
+
+/* 一个玩家：位置量化到 1/4 像素 */
+struct NetPlayerState
+{
+    quint8 id = 0;
+    qint32 x = 0;
+    qint32 y = 0;
+    quint8 facing = 0;
+    bool moving = false;
+    QStringList inventory;   // 每格物品的名字，空格为空字符串；只在变化时发送
+};
+
+/* 一个顾客：位置量化到 1/16 格 */
+struct NetEntityState
+{
+    qint32 id = 0;
+    qint32 x = 0;
+    qint32 y = 0;
+    quint8 mood = 0;
+};
+
+/* 一次瓦片修改；序号由主机连续编号 */
+struct NetTileEdit
+{
+    quint8 layer = 0;
+    quint16 x = 0;
+    quint16 y = 0;
+    qint32 gid = 0;
+};
+
+/* 主机发给某个客户端的一份世界状态 */
+struct NetWorldState
+{
+    quint32 seq = 0;        // 主机发给这个客户端的第几份（从 1 开始）
+    qint64 tick = 0;        // 主机的逻辑步
+    qint32 inputAck = -1;   // 收件人的输入处理到了哪个逻辑步，客户端从这里重放预测
+    quint32 editSeq = 0;    // 收件人有了这一份后拥有的最后一条瓦片修改的序号
+    QVector<NetPlayerState> players;   // 按 id 排序
+    QVector<NetEntityState> entities;  // 按 id 排序
+    QVector<NetTileEdit> edits;        // 序号 editSeq - edits.size() + 1 .. editSeq 的修改（基准之后的）
+};
+
+/*
+ NetProtocol：UDP 报文的编码和解码，不碰套接字，两边线程都能用
+ - 每个报文以 'L' 'Z'、版本号和类型开头；整数用变长编码（小的值一个字节），有符号数先 zigzag
+ - State 相对基准编码：基准是客户端在 Input 里确认收到的某一份 State（没有时为 0，整份发送）
+   - 玩家：位置、朝向按差值写，物品栏只有和基准不同时才带
+   - 顾客：按 id 排序，只写和基准不同的那些（id 写与上一个的间隔、一个标志字节、差值），
+     再写基准里有、这一份没有的 id；站着不动的顾客不占字节
+   - 瓦片修改：只带基准之后的那些，客户端按序号去重；没确认之前每一份都会重带，丢包也不会漏
+   基准两边都存着量化后的整数，解码结果与主机编码时的状态逐位相同
+ - 所有读取都检查长度，截断或乱发的报文解码失败，不会越界
+*/
+namespace NetProtocol
+{
+const quint16 DEFAULT_PORT = 47800;
+const quint8 VERSION = 1;
+const int POSITION_SCALE = 4;   // 玩家位置：1/4 像素
+const int ENTITY_SCALE = 16;    // 顾客位置：1/16 格
+const int MAX_INPUT_FRAMES = 32;  // 一个 Input 报文最多重带几个没确认的输入
+
+enum PacketType : quint8
+{
+    Invalid = 0,
+    Hello,     // 客户端 → 主机：请求加入，带自己的地图
+    Welcome,   // 主机 → 客户端：分到的玩家编号和主机的地图
+    Input,     // 客户端 → 主机：确认收到的 State 序号，加上还没被处理的输入
+    State,     // 主机 → 客户端：世界状态（相对基准）
+    Bye        // 任一方：离开
+};
+
+/* 朝向和编号互换：下、左、右、上（与 SpriteAnimator::Direction 相同） */
+quint8 facingCode(const QPoint &facing);
+QPoint facingOf(quint8 code);
+
+qint32 quantizePosition(qreal pixels);
+qreal positionOf(qint32 quantized);
+
+/* 报文类型；不是本协议或版本不对时为 Invalid */
+PacketType packetType(const QByteArray &packet);
+
+QByteArray encodeHello(const QString &map);
+bool decodeHello(const QByteArray &packet, QString *map);
+QByteArray encodeWelcome(quint8 playerId, const QString &map);
+bool decodeWelcome(const QByteArray &packet, quint8 *playerId, QString *map);
+QByteArray encodeBye(quint8 playerId);
+bool decodeBye(const QByteArray &packet, quint8 *playerId);
+
+/* frames 是连续的逻辑步，多于 MAX_INPUT_FRAMES 时只带最后那些 */
+QByteArray encodeInput(quint8 playerId, quint32 stateAck, const QVector<NetInputFrame> &frames);
+bool decodeInput(const QByteArray &packet, quint8 *playerId, quint32 *stateAck, QVector<NetInputFrame> *frames);
+
+/* baseline 为 nullptr 时整份编码；baseline 的 seq 写进报文，解码时必须拿同一份作基准 */
+QByteArray encodeState(const NetWorldState &state, const NetWorldState *baseline);
+/* State 报文引用的基准序号（0 为整份）；报文不对时返回 false */
+bool stateBaseline(const QByteArray &packet, quint32 *baselineSeq);
+bool decodeState(const QByteArray &packet, const NetWorldState *baseline, NetWorldState *state);
+}
+
+#endif // NETPROTOCOL_H
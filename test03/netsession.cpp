@@ -0,0 +1,364 @@
+// netsession.cpp - 局域网联机会话的实现
+#include "netsession.h"
+#include <QDebug>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+const int MAX_UNSENT_INPUT = 4 * NetProtocol::MAX_INPUT_FRAMES; // 主机一直不处理时客户端最多留多少输入
+
+QByteArray readDatagram(QUdpSocket &socket, QHostAddress *address, quint16 *port)
+{
+    QByteArray packet;
+    packet.resize(int(socket.pendingDatagramSize()));
+    const qint64 n = socket.readDatagram(packet.data(), packet.size(), address, port);
+    packet.resize(n < 0 ? 0 : int(n));
+    return packet;
+}
+}
+
+NetHost::NetHost(QObject *parent) : QObject(parent)
+{
+    connect(&m_socket, &QUdpSocket::readyRead, this, &NetHost::onReadyRead);
+    connect(&m_sendTimer, &QTimer::timeout, this, &NetHost::sendStates);
+}
+
+NetHost::~NetHost()
+{
+    const QByteArray bye = NetProtocol::encodeBye(0);
+    for (const Client &c : m_clients)
+        m_socket.writeDatagram(bye, c.address, c.port);
+}
+
+bool NetHost::listen(quint16 port, const QString &map)
+{
+    if (!m_socket.bind(QHostAddress::Any, port))
+    {
+        qWarning() << "Net: cannot listen on port" << port << ":" << m_socket.errorString();
+        return false;
+    }
+    m_map = map;
+    m_sendTimer.start(SEND_INTERVAL_MS);
+    m_statsClock.start();
+    qDebug() << "Net: hosting on port" << port;
+    return true;
+}
+
+void NetHost::setSnapshot(const SimSnapshot &snapshot)
+{
+    m_snapshot = snapshot;
+}
+
+void NetHost::addTileEdit(int layer, int x, int y, int gid)
+{
+    NetTileEdit e;
+    e.layer = quint8(layer);
+    e.x = quint16(x);
+    e.y = quint16(y);
+    e.gid = gid;
+    m_edits.append(e);
+}
+
+NetHost::Client *NetHost::findClient(const QHostAddress &address, quint16 port)
+{
+    for (Client &c : m_clients)
+        if (c.port == port && c.address.isEqual(address))
+            return &c;
+    return nullptr;
+}
+
+void NetHost::onReadyRead()
+{
+    while (m_socket.hasPendingDatagrams())
+    {
+        QHostAddress address;
+        quint16 port = 0;
+        const QByteArray packet = readDatagram(m_socket, &address, &port);
+
+        switch (NetProtocol::packetType(packet))
+        {
+        case NetProtocol::Hello:
+        {
+            QString map;
+            if (!NetProtocol::decodeHello(packet, &map))
+                break;
+            Client *c = findClient(address, port);
+            if (!c)
+            {
+                if (m_nextId > 255)
+                {
+                    qWarning() << "Net: no more player ids, ignoring" << address.toString();
+                    break;
+                }
+                if (map != m_map)
+                    qWarning() << "Net: client" << address.toString() << "is on" << map << "but the host is on" << m_map;
+                Client client;
+                client.address = address;
+                client.port = port;
+                client.id = quint8(m_nextId++);
+                m_clients.append(client);
+                c = &m_clients.last();
+                qDebug() << "Net: player" << c->id << "joined from" << address.toString() << port;
+                emit clientJoined(c->id);
+            }
+            c->heard.restart();
+            // 重复的 Hello（Welcome 丢了）再答复一次
+            m_socket.writeDatagram(NetProtocol::encodeWelcome(c->id, m_map), address, port);
+            break;
+        }
+        case NetProtocol::Input:
+        {
+            quint8 id = 0;
+            quint32 ack = 0;
+            QVector<NetInputFrame> frames;
+            Client *c = findClient(address, port);
+            if (!c || !NetProtocol::decodeInput(packet, &id, &ack, &frames) || id != c->id)
+                break;
+            c->heard.restart();
+            c->ackSeq = qMax(c->ackSeq, ack);
+            // 每个报文都重带没处理的输入，只交出新的
+            for (const NetInputFrame &f : frames)
+            {
+                if (f.tick <= c->lastInput)
+                    continue;
+                c->lastInput = f.tick;
+                emit inputReceived(c->id, f);
+            }
+            break;
+        }
+        case NetProtocol::Bye:
+        {
+            quint8 id = 0;
+            Client *c = findClient(address, port);
+            if (c && NetProtocol::decodeBye(packet, &id) && id == c->id)
+                dropClient(int(c - m_clients.constData()));
+            break;
+        }
+        default:
+            break;
+        }
+    }
+}
+
+void NetHost::dropClient(int index)
+{
+    const int id = m_clients[index].id;
+    qDebug() << "Net: player" << id << "left";
+    m_clients.remove(index);
+    emit clientLeft(id);
+}
+
+NetWorldState NetHost::buildState(Client &client, const NetWorldState *baseline) const
+{
+    NetWorldState s;
+    s.seq = client.nextSeq++;
+    s.tick = m_snapshot.tick;
+
+    QPoint center = m_snapshot.player;
+    for (const PlayerView &p : m_snapshot.players)
+    {
+        NetPlayerState n;
+        n.id = quint8(p.id);
+        n.x = NetProtocol::quantizePosition(p.position.x());
+        n.y = NetProtocol::quantizePosition(p.position.y());
+        n.facing = NetProtocol::facingCode(p.facing);
+        n.moving = p.moving;
+        n.inventory = p.inventory;
+        s.players.append(n);
+        if (p.id == client.id)
+        {
+            s.inputAck = p.inputTick;
+            center = p.tile;
+        }
+    }
+
+    // 只发这个客户端附近的顾客；太多时留下最近的那些，再按 id 排好做差分
+    const QRect view(center.x() - VIEW_X, center.y() - VIEW_Y, 2 * VIEW_X + 1, 2 * VIEW_Y + 1);
+    QVector<CustomerView> near;
+    for (const CustomerView &c : m_snapshot.customers)
+        if (view.contains(qFloor(c.x), qFloor(c.y)))
+            near.append(c);
+    if (near.size() > MAX_ENTITIES)
+    {
+        auto distance = [&center](const CustomerView &c) { return qAbs(c.x - center.x()) + qAbs(c.y - center.y()); };
+        std::nth_element(near.begin(), near.begin() + MAX_ENTITIES, near.end(),
+                         [&distance](const CustomerView &a, const CustomerView &b) { return distance(a) < distance(b); });
+        near.resize(MAX_ENTITIES);
+    }
+    std::sort(near.begin(), near.end(), [](const CustomerView &a, const CustomerView &b) { return a.id < b.id; });
+    s.entities.reserve(near.size());
+    for (const CustomerView &c : near)
+    {
+        NetEntityState e;
+        e.id = c.id;
+        e.x = qRound(c.x * NetProtocol::ENTITY_SCALE);
+        e.y = qRound(c.y * NetProtocol::ENTITY_SCALE);
+        e.mood = c.mood;
+        s.entities.append(e);
+    }
+
+    // 瓦片修改：基准之后的，一次最多 MAX_EDITS 条
+    const int first = baseline ? int(baseline->editSeq) : 0;
+    const int count = qMin(m_edits.size() - first, MAX_EDITS);
+    s.edits = m_edits.mid(first, count);
+    s.editSeq = quint32(first + count);
+    return s;
+}
+
+void NetHost::sendStates()
+{
+    for (int i = m_clients.size() - 1; i >= 0; --i)
+        if (m_clients[i].heard.elapsed() > TIMEOUT_MS)
+            dropClient(i);
+
+    for (Client &c : m_clients)
+    {
+        const NetWorldState *baseline = nullptr;
+        for (const NetWorldState &s : c.sent)
+            if (s.seq == c.ackSeq)
+                baseline = &s;
+
+        NetWorldState state = buildState(c, baseline);
+        const QByteArray packet = NetProtocol::encodeState(state, baseline);
+        m_socket.writeDatagram(packet, c.address, c.port);
+        c.bytes += packet.size();
+        ++c.states;
+        if (!baseline)
+            ++c.fullStates;
+
+        // 留作以后的基准；修改本身不用留，基准只看 editSeq
+        state.edits.clear();
+        if (c.sent.size() >= HISTORY)
+            c.sent.remove(0);
+        c.sent.append(state);
+    }
+
+    if (m_statsClock.elapsed() >= STATS_INTERVAL_MS)
+        reportStats();
+}
+
+void NetHost::reportStats()
+{
+    const qreal seconds = m_statsClock.restart() / 1000.0;
+    for (Client &c : m_clients)
+    {
+        qDebug().nospace() << "Net: player " << c.id << " " << c.bytes / 1024.0 / seconds << " KB/s, "
+                           << c.states << " states (" << c.fullStates << " full), avg "
+                           << (c.states > 0 ? c.bytes / c.states : 0) << " B, "
+                           << (c.sent.isEmpty() ? 0 : c.sent.last().entities.size()) << " customers in view";
+        c.bytes = 0;
+        c.states = 0;
+        c.fullStates = 0;
+    }
+}
+
+NetClient::NetClient(QObject *parent) : QObject(parent)
+{
+    connect(&m_socket, &QUdpSocket::readyRead, this, &NetClient::onReadyRead);
+    connect(&m_helloTimer, &QTimer::timeout, this, &NetClient::sendHello);
+}
+
+NetClient::~NetClient()
+{
+    if (m_playerId >= 0)
+        m_socket.writeDatagram(NetProtocol::encodeBye(quint8(m_playerId)), m_host, m_port);
+}
+
+bool NetClient::connectToHost(const QHostAddress &address, quint16 port, const QString &map)
+{
+    if (!m_socket.bind(QHostAddress::Any, 0))
+    {
+        qWarning() << "Net: cannot open a UDP socket:" << m_socket.errorString();
+        return false;
+    }
+    m_host = address;
+    m_port = port;
+    m_map = map;
+    sendHello();
+    m_helloTimer.start(HELLO_RETRY_MS);
+    qDebug() << "Net: connecting to" << address.toString() << port;
+    return true;
+}
+
+void NetClient::sendHello()
+{
+    m_socket.writeDatagram(NetProtocol::encodeHello(m_map), m_host, m_port);
+}
+
+void NetClient::addInput(const NetInputFrame &frame)
+{
+    if (m_unacked.size() >= MAX_UNSENT_INPUT)
+        m_unacked.remove(0);
+    m_unacked.append(frame);
+}
+
+void NetClient::flushInput()
+{
+    if (m_playerId < 0 || m_unacked.isEmpty())
+        return;
+    m_socket.writeDatagram(NetProtocol::encodeInput(quint8(m_playerId), m_latestSeq, m_unacked), m_host, m_port);
+}
+
+const NetWorldState *NetClient::findReceived(quint32 seq) const
+{
+    for (const NetWorldState &s : m_received)
+        if (s.seq == seq)
+            return &s;
+    return nullptr;
+}
+
+void NetClient::onReadyRead()
+{
+    while (m_socket.hasPendingDatagrams())
+    {
+        QHostAddress address;
+        quint16 port = 0;
+        const QByteArray packet = readDatagram(m_socket, &address, &port);
+        if (port != m_port || !address.isEqual(m_host))
+            continue;
+
+        switch (NetProtocol::packetType(packet))
+        {
+        case NetProtocol::Welcome:
+        {
+            quint8 id = 0;
+            QString hostMap;
+            if (m_playerId >= 0 || !NetProtocol::decodeWelcome(packet, &id, &hostMap))
+                break;
+            m_playerId = id;
+            m_helloTimer.stop();
+            qDebug() << "Net: joined as player" << id;
+            emit welcomed(id, hostMap);
+            break;
+        }
+        case NetProtocol::State:
+        {
+            quint32 baselineSeq = 0;
+            if (m_playerId < 0 || !NetProtocol::stateBaseline(packet, &baselineSeq))
+                break;
+            const NetWorldState *baseline = baselineSeq ? findReceived(baselineSeq) : nullptr;
+            NetWorldState state;
+            if ((baselineSeq && !baseline) || !NetProtocol::decodeState(packet, baseline, &state))
+                break;   // 基准已经丢掉了（太旧），等下一份
+            if (state.seq <= m_latestSeq)
+                break;   // 乱序到达的旧状态
+            m_latestSeq = state.seq;
+
+            while (!m_unacked.isEmpty() && m_unacked.first().tick <= state.inputAck)
+                m_unacked.remove(0);
+            emit stateReceived(state);
+
+            state.edits.clear();
+            if (m_received.size() >= NetHost::HISTORY)
+                m_received.remove(0);
+            m_received.append(state);
+            break;
+        }
+        case NetProtocol::Bye:
+            qWarning() << "Net: the host closed the session";
+            break;
+        default:
+            break;
+        }
+    }
+}
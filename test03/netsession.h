@@ -0,0 +1,128 @@
+// netsession.h - 局域网联机：主机和客户端的 UDP 会话
+#ifndef NETSESSION_H
+#define NETSESSION_H
+
+#include <QObject>
+#include <QUdpSocket>
+#include <QHostAddress>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include "netprotocol.h"
+#include "simulation.h"
+
+/*
+ NetHost：主机这边的会话，在 GUI 线程里收发报文，逻辑都在模拟线程
+ - 客户端的 Hello 分到一个玩家编号（1 起），收到的输入按逻辑步去重后交给模拟
+ - 每 SEND_INTERVAL_MS 给每个客户端发一份状态：它附近的顾客（最多 MAX_ENTITIES 个）、
+   所有玩家、它还没确认的瓦片修改。每个客户端留着最近 HISTORY 份发出去的状态，
+   以客户端确认收到的那一份为基准做差分；确认的那份已经不在了就整份发
+ - 每个客户端发了多少字节按 STATS_INTERVAL_MS 打印一次；TIMEOUT_MS 没有消息算离开
+*/
+class NetHost : public QObject
+{
+    Q_OBJECT
+public:
+    static const int SEND_INTERVAL_MS = 50;
+    static const int HISTORY = 32;
+    static const int MAX_ENTITIES = 512;
+    static const int VIEW_X = 24;   // 客户端玩家左右多少格内的顾客
+    static const int VIEW_Y = 18;
+    static const int MAX_EDITS = 256;   // 一份状态最多带几条瓦片修改，多的下一份再带
+    static const int TIMEOUT_MS = 5000;
+    static const int STATS_INTERVAL_MS = 5000;
+
+    explicit NetHost(QObject *parent = nullptr);
+    ~NetHost();
+
+    /* 在 port 上等客户端；map 为主机的地图，客户端的地图不同时只警告 */
+    bool listen(quint16 port, const QString &map);
+    int clientCount() const { return m_clients.size(); }
+
+    /* 主机模拟最新发布的状态；下一次发送时用 */
+    void setSnapshot(const SimSnapshot &snapshot);
+    /* 主机这边生效的瓦片修改，按顺序编号，发给所有客户端直到确认 */
+    void addTileEdit(int layer, int x, int y, int gid);
+
+signals:
+    void clientJoined(int playerId);
+    void clientLeft(int playerId);
+    /* 客户端的一个新的逻辑步输入（已去重、按顺序） */
+    void inputReceived(int playerId, const NetInputFrame &frame);
+
+private:
+    struct Client
+    {
+        QHostAddress address;
+        quint16 port = 0;
+        quint8 id = 0;
+        qint32 lastInput = -1;            // 已经交给模拟的最后一个输入
+        quint32 ackSeq = 0;               // 客户端确认收到的最后一份状态
+        quint32 nextSeq = 1;
+        QVector<NetWorldState> sent;      // 最近发出的状态，基准从这里找
+        QElapsedTimer heard;
+        qint64 bytes = 0;                 // 这一统计周期发出的字节
+        int states = 0;
+        int fullStates = 0;
+    };
+
+    void onReadyRead();
+    void sendStates();
+    void reportStats();
+    Client *findClient(const QHostAddress &address, quint16 port);
+    NetWorldState buildState(Client &client, const NetWorldState *baseline) const;
+    void dropClient(int index);
+
+    QUdpSocket m_socket;
+    QTimer m_sendTimer;
+    QElapsedTimer m_statsClock;
+    QString m_map;
+    QVector<Client> m_clients;
+    int m_nextId = 1;
+    SimSnapshot m_snapshot;
+    QVector<NetTileEdit> m_edits;   // 下标 i 的修改序号为 i + 1
+};
+
+/*
+ NetClient：客户端这边的会话
+ - 连上之前每 HELLO_RETRY_MS 发一次 Hello，直到主机答复 Welcome
+ - 本机每个逻辑步的输入先存着，每帧 flushInput 一次把主机还没处理的全部发出去，
+   丢一两个包也不要紧；同一个报文里带上收到的最新一份状态的序号作确认
+ - 收到的状态留着最近 NetHost::HISTORY 份作基准；比已有的旧的（乱序）直接丢掉
+*/
+class NetClient : public QObject
+{
+    Q_OBJECT
+public:
+    static const int HELLO_RETRY_MS = 500;
+
+    explicit NetClient(QObject *parent = nullptr);
+    ~NetClient();
+
+    bool connectToHost(const QHostAddress &address, quint16 port, const QString &map);
+    int playerId() const { return m_playerId; }
+
+    void addInput(const NetInputFrame &frame);
+    void flushInput();
+
+signals:
+    void welcomed(int playerId, const QString &hostMap);
+    void stateReceived(const NetWorldState &state);
+
+private:
+    void onReadyRead();
+    void sendHello();
+    const NetWorldState *findReceived(quint32 seq) const;
+
+    QUdpSocket m_socket;
+    QHostAddress m_host;
+    quint16 m_port = 0;
+    QString m_map;
+    QTimer m_helloTimer;
+    int m_playerId = -1;
+    QVector<NetInputFrame> m_unacked;   // 主机还没处理的输入
+    QVector<NetWorldState> m_received;  // 最近收到的状态
+    quint32 m_latestSeq = 0;
+};
+
+#endif // NETSESSION_H
@@ -0,0 +1,113 @@
+// profileroverlay.cpp - 性能 HUD 实现
+#include "profileroverlay.h"
+#include "frameprofiler.h"
+#include <QPainter>
+#include <QGraphicsScene>
+#include <QDateTime>
+#include <QStringList>
+#include <QFontDatabase>
+
+namespace {
+const int HIST_BUCKETS = 25;            // 直方图格数
+const qint64 HIST_BUCKET_NS = 2000000;  // 每格 2ms，最后一格为 ≥48ms
+
+QString ms(qint64 ns)
+{
+    return QString::number(ns / 1e6, 'f', 2);
+}
+}
+
+ProfilerOverlay::ProfilerOverlay(QWidget *parent) : QWidget(parent)
+{
+    setFixedSize(340, 230);
+    setAttribute(Qt::WA_TransparentForMouseEvents); // 不挡住下面的视图
+    setFocusPolicy(Qt::NoFocus);
+
+    m_refreshTimer.setInterval(250);
+    connect(&m_refreshTimer, &QTimer::timeout, this, &ProfilerOverlay::refresh);
+}
+
+QString ProfilerOverlay::startCsv()
+{
+    QString fileName = QString("frame_profile_%1.csv")
+            .arg(QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+    return FrameProfiler::instance().startCsv(fileName) ? fileName : QString();
+}
+
+void ProfilerOverlay::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    refresh();
+    m_refreshTimer.start();
+}
+
+void ProfilerOverlay::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    m_refreshTimer.stop();
+}
+
+void ProfilerOverlay::refresh()
+{
+    if (m_scene)
+        FrameProfiler::instance().setSceneItemCount(m_scene->items().size());
+    update();
+}
+
+void ProfilerOverlay::paintEvent(QPaintEvent *)
+{
+    const FrameProfiler &prof = FrameProfiler::instance();
+    const FrameProfiler::Sample avg = prof.average();
+
+    QPainter p(this);
+    p.fillRect(rect(), QColor(0, 0, 0, 180));
+    p.setPen(Qt::white);
+    QFont f = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    f.setPointSize(9);
+    p.setFont(f);
+
+    const qint64 p50 = prof.framePercentile(0.50);
+    const qint64 p90 = prof.framePercentile(0.90);
+    const qint64 p99 = prof.framePercentile(0.99);
+    const qint64 pmax = prof.framePercentile(1.0);
+    const double fps = avg.frameNs > 0 ? 1e9 / avg.frameNs : 0.0;
+
+    QStringList lines;
+    lines << QString("FPS %1   帧 %2 ms").arg(fps, 0, 'f', 1).arg(ms(avg.frameNs));
+    lines << QString("p50 %1  p90 %2  p99 %3  max %4").arg(ms(p50), ms(p90), ms(p99), ms(pmax));
+    lines << QString("绘制 %1 ms   面积 %2 px/帧").arg(ms(avg.paintNs)).arg(avg.paintPixels);
+    lines << QString("场景图元 %1   物品栏重绘 %2/帧")
+             .arg(avg.sceneItems).arg(avg.inventoryRepaints);
+    lines << QString("模拟 %1  寻路 %2  渲染 %3 ms")
+             .arg(ms(avg.subsystemNs[FrameProfiler::Simulation]),
+                  ms(avg.subsystemNs[FrameProfiler::Pathfinding]),
+                  ms(avg.subsystemNs[FrameProfiler::Rendering]));
+    lines << (prof.isCapturing() ? QString("F3 关闭面板   F4 停止记录 CSV（%1）").arg(prof.csvFileName())
+                                 : QString("F3 关闭面板   F4 开始记录 CSV（含最近 %1 帧）").arg(prof.sampleCount()));
+
+    const int lineH = p.fontMetrics().height();
+    int y = 6 + p.fontMetrics().ascent();
+    for (const QString &line : lines)
+    {
+        p.drawText(8, y, line);
+        y += lineH;
+    }
+
+    // 帧耗时直方图：横轴 0~50ms，每格 2ms；16.7ms 处画一条参考线
+    const QRect histRect(8, y, width() - 16, height() - y - 8);
+    const QVector<int> hist = prof.frameHistogram(HIST_BUCKETS, HIST_BUCKET_NS);
+    int peak = 1;
+    for (int c : hist)
+        peak = qMax(peak, c);
+
+    const qreal barW = histRect.width() / qreal(HIST_BUCKETS);
+    for (int i = 0; i < HIST_BUCKETS; ++i)
+    {
+        int h = hist[i] * histRect.height() / peak;
+        QColor c = i * HIST_BUCKET_NS < 16700000 ? QColor("#4ecca3") : QColor("#e84545");
+        p.fillRect(QRectF(histRect.left() + i * barW, histRect.bottom() - h, barW - 1, h), c);
+    }
+    const qreal budgetX = histRect.left() + 16.7e6 / HIST_BUCKET_NS * barW;
+    p.setPen(QPen(Qt::yellow, 1, Qt::DashLine));
+    p.drawLine(QPointF(budgetX, histRect.top()), QPointF(budgetX, histRect.bottom()));
+}
@@ -0,0 +1,40 @@
+// profileroverlay.h - 性能 HUD
+#ifndef PROFILEROVERLAY_H
+#define PROFILEROVERLAY_H
+
+#include <QWidget>
+#include <QTimer>
+
+class QGraphicsScene;
+
+/*
+ 半透明的性能面板，叠在地图视图左上角（F3 开关）。
+ 显示：帧耗时与百分位、帧耗时直方图、视图重绘耗时/面积、场景图元数、
+ 物品栏重绘次数，以及模拟/寻路/渲染三个子系统的平均耗时。
+ 面板本身每 250ms 刷新一次，避免自己成为性能负担。
+*/
+class ProfilerOverlay : public QWidget
+{
+    Q_OBJECT
+public:
+    explicit ProfilerOverlay(QWidget *parent = nullptr);
+
+    /* 用于统计场景图元数量（只在面板可见时统计，items() 需要遍历整个场景） */
+    void setScene(QGraphicsScene *scene) { m_scene = scene; }
+
+    /* 开始把帧采样持续写进 CSV（最近的采样先写进去），返回文件名（失败返回空） */
+    QString startCsv();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    void refresh();
+
+    QGraphicsScene *m_scene = nullptr;
+    QTimer m_refreshTimer;
+};
+
+#endif // PROFILEROVERLAY_H
@@ -0,0 +1,864 @@
+// scriptcompiler.cpp - 脚本编译器实现：词法分析 + 单遍递归下降，边解析边生成寄存器字节码
+#include "scriptcompiler.h"
+
+using namespace Script;
+
+namespace {
+
+enum TokenType : quint8
+{
+    Ident,
+    Number,
+    String,
+    Punct,
+    End
+};
+
+struct Token
+{
+    TokenType type = End;
+    QByteArray text;     // 标识符、符号的原文；字符串的内容（已处理转义）
+    qint64 value = 0;    // 数字
+    int line = 0;
+};
+
+const char *const KEYWORDS[] = {
+    "var", "fn", "if", "else", "while", "return", "yield", "break", "continue", "true", "false"
+};
+const char *const PUNCTS2[] = { "==", "!=", "<=", ">=", "&&", "||" };
+const char PUNCTS1[] = "(){},;=+-*/%<>!";
+
+bool isIdentStart(char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool isKeyword(const QByteArray &word)
+{
+    for (const char *kw : KEYWORDS)
+        if (word == kw)
+            return true;
+    return false;
+}
+
+/* 结果可以直接改写到别的寄存器的指令：A 只是目标，不参与运算 */
+bool writesOnlyA(Op op)
+{
+    switch (op)
+    {
+    case LoadI: case LoadK: case Move: case GetG:
+    case Add: case Sub: case Mul: case Div: case Mod:
+    case Lt: case Le: case Eq: case Ne:
+    case AddI: case Neg: case Not: case Bool:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/*
+ Compiler：表达式的结果总在寄存器里。局部变量（含参数）占据前面的寄存器，临时值像栈一样
+ 分配在它们上面，语句结束时全部释放。函数调用把参数依次放进栈顶的连续寄存器，
+ 被调用函数的寄存器窗口就从这里开始，参数不需要再复制
+ 出错时记录第一个错误并直接跳到输入末尾，之后的解析都会很快结束
+*/
+class Compiler
+{
+public:
+    explicit Compiler(const ScriptNatives *natives) : m_natives(natives) {}
+    bool run(const QByteArray &source, ScriptProgram *program, QString *message);
+
+private:
+    struct Local
+    {
+        QByteArray name;
+        int reg;
+    };
+    struct Loop
+    {
+        int start;
+        QVector<int> breaks;
+    };
+
+    bool tokenize(const QByteArray &source);
+    void declareFunctions();
+    void globalVar();
+    void function();
+    void block();
+    void statement();
+    void varStatement();
+    void ifStatement();
+    void whileStatement();
+    void assignment();
+    int expr() { return binary(0); }
+    int binary(int level);
+    int unary();
+    int primary();
+    int call(const QByteArray &name);
+
+    const Token &peek(int ahead = 0) const
+    { return m_tokens[qMin(m_pos + ahead, m_tokens.size() - 1)]; }
+    bool check(const char *punct) const
+    { return peek().type == Punct && peek().text == punct; }
+    bool checkKeyword(const char *keyword) const
+    { return peek().type == Ident && peek().text == keyword; }
+    bool accept(const char *punct);
+    bool acceptKeyword(const char *keyword);
+    void expect(const char *punct);
+    QByteArray identifier();
+    void error(const QString &message);
+
+    void append(quint32 instruction) { m_program.code.append(instruction); }
+    int emitJump(Op op, int a);
+    void patchJump(int at);
+    void emitJumpBack(int target);
+    int alloc();
+    void freeTo(int mark) { m_nextReg = mark; }
+    void storeTo(int dest, int src);
+    void loadConstant(int reg, qint64 value);
+    int stringIndex(const QByteArray &utf8);
+    int findLocal(const QByteArray &name) const;
+    int findGlobal(const QByteArray &name) const;
+    int findFunction(const QByteArray &name) const;
+
+    const ScriptNatives *m_natives;
+    ScriptProgram m_program;
+    QVector<Token> m_tokens;
+    int m_pos = 0;
+    QString m_error;
+    int m_label = -1;          // 最近一个前跳目标；等于 code.size() 时最后一条指令后面有跳转落点，不能改写它
+
+    // 当前函数
+    QVector<Local> m_locals;
+    int m_nextReg = 0;
+    int m_maxReg = 0;
+    QVector<Loop> m_loops;
+};
+
+bool Compiler::run(const QByteArray &source, ScriptProgram *program, QString *message)
+{
+    m_program.natives = m_natives;
+    if (tokenize(source))
+    {
+        declareFunctions();
+        while (m_error.isEmpty() && peek().type != End)
+        {
+            if (acceptKeyword("var"))
+                globalVar();
+            else if (acceptKeyword("fn"))
+                function();
+            else
+                error("expected 'var' or 'fn' at top level");
+        }
+    }
+    if (!m_error.isEmpty())
+    {
+        if (message)
+            *message = m_error;
+        return false;
+    }
+    *program = m_program;
+    return true;
+}
+
+bool Compiler::tokenize(const QByteArray &source)
+{
+    const char *p = source.constData();
+    const char *const end = p + source.size();
+    int line = 1;
+    auto fail = [&](const QString &message) {
+        m_error = QString("line %1: %2").arg(line).arg(message);
+        return false;
+    };
+
+    while (p < end)
+    {
+        const char c = *p;
+        if (c == '\n')
+        {
+            ++line;
+            ++p;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r')
+        {
+            ++p;
+            continue;
+        }
+        if (c == '/' && p + 1 < end && p[1] == '/')
+        {
+            while (p < end && *p != '\n')
+                ++p;
+            continue;
+        }
+        if (c == '/' && p + 1 < end && p[1] == '*')
+        {
+            p += 2;
+            while (p + 1 < end && !(p[0] == '*' && p[1] == '/'))
+                line += *p++ == '\n';
+            if (p + 1 >= end)
+                return fail("unterminated comment");
+            p += 2;
+            continue;
+        }
+
+        Token t;
+        t.line = line;
+        if (isIdentStart(c))
+        {
+            const char *start = p;
+            while (p < end && (isIdentStart(*p) || isDigit(*p)))
+                ++p;
+            t.type = Ident;
+            t.text = QByteArray(start, int(p - start));
+        }
+        else if (isDigit(c))
+        {
+            // 允许到 2^31，-2147483648 由一元负号折叠
+            while (p < end && isDigit(*p))
+            {
+                t.value = t.value * 10 + (*p++ - '0');
+                if (t.value > 0x80000000LL)
+                    return fail("number too large");
+            }
+            if (p < end && isIdentStart(*p))
+                return fail("invalid number");
+            t.type = Number;
+        }
+        else if (c == '"')
+        {
+            ++p;
+            while (p < end && *p != '"' && *p != '\n')
+            {
+                if (*p == '\\' && p + 1 < end)
+                {
+                    ++p;
+                    t.text += *p == 'n' ? '\n' : *p == 't' ? '\t' : *p;
+                }
+                else
+                {
+                    t.text += *p;
+                }
+                ++p;
+            }
+            if (p >= end || *p != '"')
+                return fail("unterminated string");
+            ++p;
+            t.type = String;
+        }
+        else
+        {
+            t.type = Punct;
+            for (const char *op : PUNCTS2)
+            {
+                if (p + 1 < end && p[0] == op[0] && p[1] == op[1])
+                {
+                    t.text = QByteArray(op, 2);
+                    break;
+                }
+            }
+            if (t.text.isEmpty())
+            {
+                bool known = false;
+                for (const char *q = PUNCTS1; *q; ++q)
+                    known |= *q == c;
+                if (!known)
+                    return fail(QString("unexpected character '%1'").arg(QString::fromLatin1(&c, 1)));
+                t.text = QByteArray(1, c);
+            }
+            p += t.text.size();
+        }
+        m_tokens.append(t);
+    }
+
+    Token eof;
+    eof.line = line;
+    m_tokens.append(eof);
+    return true;
+}
+
+/* 预先扫描所有顶层函数的名字和参数个数，函数体里就可以调用后面定义的函数 */
+void Compiler::declareFunctions()
+{
+    int depth = 0;
+    for (int i = 0; i + 1 < m_tokens.size(); ++i)
+    {
+        const Token &t = m_tokens[i];
+        if (t.type == Punct)
+            depth += t.text == "{" ? 1 : t.text == "}" ? -1 : 0;
+        if (depth != 0 || t.type != Ident || t.text != "fn" || m_tokens[i + 1].type != Ident)
+            continue;
+
+        const QByteArray name = m_tokens[i + 1].text;
+        m_pos = i + 1;
+        if (findFunction(name) >= 0 || (m_natives && m_natives->find(QString::fromLatin1(name)) >= 0))
+            return error(QString("function '%1' is already defined").arg(QString::fromLatin1(name)));
+        if (m_program.functions.size() == MAX_FUNCTIONS)
+            return error("too many functions");
+
+        ScriptProgram::Function f;
+        f.name = QString::fromLatin1(name);
+        for (int j = i + 3; j < m_tokens.size() && m_tokens[j].type == Ident; j += 2)
+        {
+            ++f.params;
+            if (m_tokens[j + 1].type != Punct || m_tokens[j + 1].text != ",")
+                break;
+        }
+        m_program.functions.append(f);
+    }
+    m_pos = 0;
+}
+
+void Compiler::globalVar()
+{
+    const QByteArray name = identifier();
+    if (findGlobal(name) >= 0)
+        return error(QString("global '%1' is already defined").arg(QString::fromLatin1(name)));
+    qint64 value = 0;
+    if (accept("="))
+    {
+        const bool negative = accept("-");
+        const Token &t = peek();
+        if (t.type == Number)
+            value = negative ? -t.value : t.value;
+        else if (!negative && t.type == String)
+            value = stringIndex(t.text);
+        else if (!negative && t.type == Ident && (t.text == "true" || t.text == "false"))
+            value = t.text == "true";
+        else
+            return error("global initializer must be a constant");
+        if (value > 0x7fffffffLL)
+            return error("number too large");
+        ++m_pos;
+    }
+    expect(";");
+    m_program.globals.append(QString::fromLatin1(name));
+    m_program.globalInit.append(qint32(value));
+}
+
+void Compiler::function()
+{
+    const QByteArray name = identifier();
+    const int index = findFunction(name);
+    if (index < 0)
+        return;
+    m_program.functions[index].entry = m_program.code.size();
+    m_locals.clear();
+    m_loops.clear();
+    m_nextReg = 0;
+    m_maxReg = 0;
+
+    expect("(");
+    if (!check(")"))
+    {
+        do
+        {
+            const QByteArray param = identifier();
+            if (findLocal(param) >= 0)
+                return error(QString("duplicate parameter '%1'").arg(QString::fromLatin1(param)));
+            m_locals.append(Local{param, alloc()});
+        } while (accept(","));
+    }
+    expect(")");
+    block();
+    append(encode(Ret0, 0, 0, 0));
+    // 至少一个寄存器：调用方把返回值放在被调用者的 R0
+    m_program.functions[index].registers = qMax(m_maxReg, 1);
+}
+
+void Compiler::block()
+{
+    expect("{");
+    const int locals = m_locals.size();
+    const int mark = m_nextReg;
+    while (!check("}") && peek().type != End)
+        statement();
+    expect("}");
+    m_locals.resize(locals);
+    freeTo(mark);
+}
+
+void Compiler::statement()
+{
+    if (check("{"))
+    {
+        block();
+    }
+    else if (acceptKeyword("var"))
+    {
+        varStatement();
+    }
+    else if (acceptKeyword("if"))
+    {
+        ifStatement();
+    }
+    else if (acceptKeyword("while"))
+    {
+        whileStatement();
+    }
+    else if (acceptKeyword("return"))
+    {
+        if (accept(";"))
+        {
+            append(encode(Ret0, 0, 0, 0));
+            return;
+        }
+        const int mark = m_nextReg;
+        append(encode(Ret, expr(), 0, 0));
+        expect(";");
+        freeTo(mark);
+    }
+    else if (acceptKeyword("yield"))
+    {
+        expect(";");
+        append(encode(Yield, 0, 0, 0));
+    }
+    else if (acceptKeyword("break"))
+    {
+        expect(";");
+        if (m_loops.isEmpty())
+            return error("'break' outside of a loop");
+        m_loops.last().breaks.append(emitJump(Jmp, 0));
+    }
+    else if (acceptKeyword("continue"))
+    {
+        expect(";");
+        if (m_loops.isEmpty())
+            return error("'continue' outside of a loop");
+        emitJumpBack(m_loops.last().start);
+    }
+    else if (peek().type == Ident && peek(1).type == Punct && peek(1).text == "=")
+    {
+        assignment();
+    }
+    else
+    {
+        const int mark = m_nextReg;
+        expr();
+        expect(";");
+        freeTo(mark);
+    }
+}
+
+void Compiler::varStatement()
+{
+    const QByteArray name = identifier();
+    // 新变量的寄存器先占住，初值表达式的临时值在它上面；初值里还看不到这个变量
+    const int reg = alloc();
+    if (accept("="))
+        storeTo(reg, expr());
+    else
+        loadConstant(reg, 0);
+    expect(";");
+    m_locals.append(Local{name, reg});
+    freeTo(reg + 1);
+}
+
+void Compiler::ifStatement()
+{
+    expect("(");
+    const int mark = m_nextReg;
+    const int skip = emitJump(JmpF, expr());
+    freeTo(mark);
+    expect(")");
+    statement();
+    if (acceptKeyword("else"))
+    {
+        const int over = emitJump(Jmp, 0);
+        patchJump(skip);
+        statement();
+        patchJump(over);
+    }
+    else
+    {
+        patchJump(skip);
+    }
+}
+
+void Compiler::whileStatement()
+{
+    const int start = m_program.code.size();
+    expect("(");
+    const int mark = m_nextReg;
+    const int exit = emitJump(JmpF, expr());
+    freeTo(mark);
+    expect(")");
+    m_loops.append(Loop{start, QVector<int>()});
+    statement();
+    emitJumpBack(start);
+    patchJump(exit);
+    if (m_loops.isEmpty())
+        return;
+    for (int at : m_loops.last().breaks)
+        patchJump(at);
+    m_loops.removeLast();
+}
+
+void Compiler::assignment()
+{
+    const QByteArray name = identifier();
+    expect("=");
+    const int mark = m_nextReg;
+    const int local = findLocal(name);
+    const int global = local < 0 ? findGlobal(name) : -1;
+    if (local < 0 && global < 0)
+        return error(QString("unknown variable '%1'").arg(QString::fromLatin1(name)));
+    const int value = expr();
+    if (local >= 0)
+        storeTo(m_locals[local].reg, value);
+    else
+        append(encodeBx(SetG, value, global));
+    expect(";");
+    freeTo(mark);
+}
+
+/*
+ 二元运算按优先级分 6 层：|| && (== !=) (< <= > >=) (+ -) (* / %)
+ 结果放在进入这一层时栈顶的临时寄存器里，左右操作数的临时值用完就释放
+*/
+int Compiler::binary(int level)
+{
+    static const char *const OPS[6][4] = {
+        { "||" }, { "&&" }, { "==", "!=" }, { "<", "<=", ">", ">=" }, { "+", "-" }, { "*", "/", "%" }
+    };
+    if (level == 6)
+        return unary();
+
+    const int mark = m_nextReg;
+    int left = binary(level + 1);
+
+    if (level <= 1)
+    {
+        // 短路：dest = 左边；为假（||：为真）就跳到末尾，否则 dest = 右边；最后规整成 0/1
+        if (!check(OPS[level][0]))
+            return left;
+        freeTo(mark);
+        const int dest = alloc();
+        storeTo(dest, left);
+        QVector<int> jumps;
+        while (accept(OPS[level][0]))
+        {
+            jumps.append(emitJump(level == 0 ? JmpT : JmpF, dest));
+            storeTo(dest, binary(level + 1));
+            freeTo(dest + 1);
+        }
+        for (int at : jumps)
+            patchJump(at);
+        append(encode(Bool, dest, dest, 0));
+        return dest;
+    }
+
+    for (;;)
+    {
+        int op = -1;
+        for (int i = 0; i < 4 && OPS[level][i]; ++i)
+            if (check(OPS[level][i]))
+                op = i;
+        if (op < 0)
+            return left;
+        ++m_pos;
+
+        const int right = binary(level + 1);
+        freeTo(mark);
+        const int dest = alloc();
+
+        // x + 常量、x - 常量：把刚生成的 LOADI 换成一条 ADDI
+        QVector<quint32> &code = m_program.code;
+        if (level == 4 && right >= m_locals.size() && !code.isEmpty() && m_label < code.size() &&
+            opOf(code.last()) == LoadI && argA(code.last()) == right)
+        {
+            const int k = op == 0 ? argSBx(code.last()) : -argSBx(code.last());
+            if (k >= -128 && k <= 127)
+            {
+                code.removeLast();
+                append(encode(AddI, dest, left, k + 128));
+                left = dest;
+                continue;
+            }
+        }
+
+        static const Op CODES[6][4] = {
+            {}, {}, { Eq, Ne }, { Lt, Le, Lt, Le }, { Add, Sub }, { Mul, Div, Mod }
+        };
+        // a > b 即 b < a
+        const bool swap = level == 3 && op >= 2;
+        append(encode(CODES[level][op], dest, swap ? right : left, swap ? left : right));
+        left = dest;
+    }
+}
+
+int Compiler::unary()
+{
+    const int mark = m_nextReg;
+    if (accept("-"))
+    {
+        if (peek().type == Number)
+        {
+            const qint64 value = -peek().value;
+            ++m_pos;
+            const int dest = alloc();
+            loadConstant(dest, value);
+            return dest;
+        }
+        const int operand = unary();
+        freeTo(mark);
+        const int dest = alloc();
+        append(encode(Neg, dest, operand, 0));
+        return dest;
+    }
+    if (accept("!"))
+    {
+        const int operand = unary();
+        freeTo(mark);
+        const int dest = alloc();
+        append(encode(Not, dest, operand, 0));
+        return dest;
+    }
+    return primary();
+}
+
+int Compiler::primary()
+{
+    const Token t = peek();
+    if (t.type == Number)
+    {
+        ++m_pos;
+        if (t.value > 0x7fffffffLL)
+            error("number too large");
+        const int dest = alloc();
+        loadConstant(dest, t.value);
+        return dest;
+    }
+    if (t.type == String)
+    {
+        ++m_pos;
+        const int dest = alloc();
+        loadConstant(dest, stringIndex(t.text));
+        return dest;
+    }
+    if (accept("("))
+    {
+        const int value = expr();
+        expect(")");
+        return value;
+    }
+    if (t.type == Ident && (t.text == "true" || t.text == "false"))
+    {
+        ++m_pos;
+        const int dest = alloc();
+        loadConstant(dest, t.text == "true");
+        return dest;
+    }
+
+    const QByteArray name = identifier();
+    if (name.isEmpty())
+        return 0;
+    if (check("("))
+        return call(name);
+    const int local = findLocal(name);
+    if (local >= 0)
+        return m_locals[local].reg;
+    const int global = findGlobal(name);
+    if (global < 0)
+    {
+        error(QString("unknown variable '%1'").arg(QString::fromLatin1(name)));
+        return 0;
+    }
+    const int dest = alloc();
+    append(encodeBx(GetG, dest, global));
+    return dest;
+}
+
+int Compiler::call(const QByteArray &name)
+{
+    expect("(");
+    const int base = m_nextReg;
+    int argc = 0;
+    if (!check(")"))
+    {
+        do
+        {
+            if (argc == MAX_ARGS)
+            {
+                error("too many arguments");
+                return base;
+            }
+            const int value = expr();
+            freeTo(base + argc);
+            storeTo(alloc(), value);
+            ++argc;
+        } while (accept(","));
+    }
+    expect(")");
+    if (argc == 0)
+        alloc();   // 返回值的位置
+
+    const QString qname = QString::fromLatin1(name);
+    const int function = findFunction(name);
+    const int native = function < 0 && m_natives ? m_natives->find(qname) : -1;
+    if (function < 0 && native < 0)
+    {
+        error(QString("unknown function '%1'").arg(qname));
+        return base;
+    }
+    const int arity = function >= 0 ? m_program.functions[function].params : m_natives->arity(native);
+    if (argc != arity)
+    {
+        error(QString("'%1' takes %2 arguments, %3 given").arg(qname).arg(arity).arg(argc));
+        return base;
+    }
+    if (function >= 0)
+        append(encode(Call, base, function, argc));
+    else if (native < MAX_NATIVES)
+        append(encode(NCall, base, native & 0xff, ((native >> 8) << 4) | argc));
+    else
+        error("too many natives");
+    freeTo(base + 1);
+    return base;
+}
+
+bool Compiler::accept(const char *punct)
+{
+    if (!check(punct))
+        return false;
+    ++m_pos;
+    return true;
+}
+
+bool Compiler::acceptKeyword(const char *keyword)
+{
+    if (!checkKeyword(keyword))
+        return false;
+    ++m_pos;
+    return true;
+}
+
+void Compiler::expect(const char *punct)
+{
+    if (!accept(punct))
+        error(QString("expected '%1'").arg(QString::fromLatin1(punct)));
+}
+
+QByteArray Compiler::identifier()
+{
+    if (peek().type != Ident || isKeyword(peek().text))
+    {
+        error("expected identifier");
+        return QByteArray();
+    }
+    return m_tokens[m_pos++].text;
+}
+
+void Compiler::error(const QString &message)
+{
+    if (m_error.isEmpty())
+        m_error = QString("line %1: %2").arg(peek().line).arg(message);
+    m_pos = m_tokens.size() - 1;
+}
+
+int Compiler::emitJump(Op op, int a)
+{
+    append(encodeBx(op, a, 32768));
+    return m_program.code.size() - 1;
+}
+
+/* 把 at 处的跳转指向当前位置 */
+void Compiler::patchJump(int at)
+{
+    QVector<quint32> &code = m_program.code;
+    const int offset = code.size() - (at + 1);
+    if (offset > 32767)
+        return error("function too large");
+    code[at] = encodeBx(opOf(code[at]), argA(code[at]), offset + 32768);
+    m_label = code.size();
+}
+
+void Compiler::emitJumpBack(int target)
+{
+    const int offset = target - (m_program.code.size() + 1);
+    if (offset < -32768)
+        return error("function too large");
+    append(encodeBx(Jmp, 0, offset + 32768));
+}
+
+int Compiler::alloc()
+{
+    if (m_nextReg == MAX_REGISTERS)
+    {
+        error("expression too complex");
+        return 0;
+    }
+    m_maxReg = qMax(m_maxReg, m_nextReg + 1);
+    return m_nextReg++;
+}
+
+/* dest = src；src 是刚算出来的临时值时直接改写算它的那条指令，省掉一条 MOVE */
+void Compiler::storeTo(int dest, int src)
+{
+    if (dest == src)
+        return;
+    QVector<quint32> &code = m_program.code;
+    if (src >= m_locals.size() && !code.isEmpty() && m_label < code.size() &&
+        writesOnlyA(opOf(code.last())) && argA(code.last()) == src)
+    {
+        code.last() = (code.last() & ~0xff00u) | (quint32(dest) << 8);
+        return;
+    }
+    append(encode(Move, dest, src, 0));
+}
+
+void Compiler::loadConstant(int reg, qint64 value)
+{
+    if (value < -0x80000000LL || value > 0x7fffffffLL)
+        return error("number too large");
+    if (value >= -32768 && value <= 32767)
+    {
+        append(encodeBx(LoadI, reg, int(value) + 32768));
+        return;
+    }
+    int k = m_program.constants.indexOf(qint32(value));
+    if (k < 0)
+    {
+        k = m_program.constants.size();
+        m_program.constants.append(qint32(value));
+    }
+    append(encodeBx(LoadK, reg, k));
+}
+
+int Compiler::stringIndex(const QByteArray &utf8)
+{
+    const QString s = QString::fromUtf8(utf8);
+    int index = m_program.strings.indexOf(s);
+    if (index < 0)
+    {
+        index = m_program.strings.size();
+        m_program.strings.append(s);
+    }
+    if (index > 32767)
+        error("too many strings");
+    return index;
+}
+
+int Compiler::findLocal(const QByteArray &name) const
+{
+    for (int i = m_locals.size() - 1; i >= 0; --i)
+        if (m_locals[i].name == name)
+            return i;
+    return -1;
+}
+
+int Compiler::findGlobal(const QByteArray &name) const
+{
+    return m_program.globals.indexOf(QString::fromLatin1(name));
+}
+
+int Compiler::findFunction(const QByteArray &name) const
+{
+    return m_program.function(QString::fromLatin1(name));
+}
+}
+
+bool ScriptCompiler::compile(const QByteArray &source, const ScriptNatives *natives,
+                             ScriptProgram *program, QString *error)
+{
+    Compiler compiler(natives);
+    return compiler.run(source, program, error);
+}
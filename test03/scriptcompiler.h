@@ -0,0 +1,34 @@
+// scriptcompiler.h - 把脚本源码编译成 ScriptVM 字节码
+#ifndef SCRIPTCOMPILER_H
+#define SCRIPTCOMPILER_H
+
+#include <QByteArray>
+#include <QString>
+#include "scriptvm.h"
+
+/*
+ ScriptCompiler：加载时把脚本源码一次编译成字节码，运行时不再解析
+ 语言（所有值都是 32 位整数）：
+
+   var counter = 0;                  // 顶层 var：每个实例一份的全局变量，初值只能是常量
+   fn tick(x, y) {                   // 函数；可以调用后面才定义的函数
+       var dx = random(3) - 1;       // 局部变量，作用域到所在的 { } 结束
+       if (dx != 0 && !isObstacle(x + dx, y)) { move(dx, 0); }
+       else { say("走不动"); }       // 字符串常量是字符串表下标，由原生函数解释
+       while (counter < 10) { counter = counter + 1; if (counter == 5) { break; } }
+       yield;                        // 让出本次执行，下次 resume 从这里继续
+       return counter;
+   }
+
+ 运算符：|| && == != < <= > >= + - * / % 一元 - !，&& 和 || 短路并得到 0/1；true/false 即 1/0
+ 函数和原生函数的名字、参数个数都在编译时检查；原生函数由 natives 提供，program 会记住这张表
+*/
+class ScriptCompiler
+{
+public:
+    /* 编译 source（UTF-8）；失败时 error 为“第几行：原因”，program 不变 */
+    static bool compile(const QByteArray &source, const ScriptNatives *natives,
+                        ScriptProgram *program, QString *error);
+};
+
+#endif // SCRIPTCOMPILER_H
@@ -0,0 +1,229 @@
+// scriptvm.cpp - 脚本虚拟机实现
+#include "scriptvm.h"
+#include <algorithm>
+
+using namespace Script;
+
+int ScriptNatives::add(const QString &name, int arity, const ScriptNativeFn &fn)
+{
+    const int existing = find(name);
+    if (existing >= 0)
+    {
+        m_entries[existing].arity = arity;
+        m_entries[existing].fn = fn;
+        return existing;
+    }
+    m_entries.append(Entry{name, arity, fn});
+    return m_entries.size() - 1;
+}
+
+int ScriptNatives::find(const QString &name) const
+{
+    for (int i = 0; i < m_entries.size(); ++i)
+        if (m_entries[i].name == name)
+            return i;
+    return -1;
+}
+
+int ScriptProgram::function(const QString &name) const
+{
+    for (int i = 0; i < functions.size(); ++i)
+        if (functions[i].name == name)
+            return i;
+    return -1;
+}
+
+QString ScriptProgram::disassemble() const
+{
+    static const char *const NAMES[OpCount] = {
+        "LOADI", "LOADK", "MOVE", "GETG", "SETG", "ADD", "SUB", "MUL", "DIV", "MOD",
+        "LT", "LE", "EQ", "NE", "ADDI", "NEG", "NOT", "BOOL", "JMP", "JMPF", "JMPT",
+        "CALL", "NCALL", "RET", "RET0", "YIELD"
+    };
+    QString out;
+    for (int pc = 0; pc < code.size(); ++pc)
+    {
+        for (const Function &f : functions)
+            if (f.entry == pc)
+                out += QString("%1(%2 params, %3 registers):\n").arg(f.name).arg(f.params).arg(f.registers);
+        const quint32 i = code[pc];
+        const Op op = opOf(i);
+        QString line = QString("%1  %2").arg(pc, 5).arg(QString::fromLatin1(op < OpCount ? NAMES[op] : "?"), -6);
+        switch (op)
+        {
+        case LoadI: case Jmp: case JmpF: case JmpT:
+            line += QString(" %1 %2").arg(argA(i)).arg(argSBx(i));
+            break;
+        case LoadK: case GetG: case SetG:
+            line += QString(" %1 %2").arg(argA(i)).arg(argBx(i));
+            break;
+        default:
+            line += QString(" %1 %2 %3").arg(argA(i)).arg(argB(i)).arg(argC(i));
+            break;
+        }
+        out += line + "\n";
+    }
+    return out;
+}
+
+ScriptInstance::ScriptInstance(const ScriptProgram *program)
+    : m_program(program),
+      m_globals(program->globalInit),
+      m_registers(STACK_REGISTERS, 0)
+{
+}
+
+bool ScriptInstance::start(int function, const qint32 *args, int argc)
+{
+    if (!m_program || m_status != Idle || function < 0 || function >= m_program->functions.size())
+        return false;
+    const ScriptProgram::Function &f = m_program->functions[function];
+    if (argc != f.params || f.registers > STACK_REGISTERS)
+        return false;
+    for (int i = 0; i < argc; ++i)
+        m_registers[i] = args[i];
+    m_frames[0] = Frame{function, f.entry, 0};
+    m_depth = 1;
+    m_status = Running;
+    return true;
+}
+
+void ScriptInstance::raiseError(const QString &message)
+{
+    m_status = Error;
+    m_error = message;
+}
+
+void ScriptInstance::reset()
+{
+    m_status = Idle;
+    m_depth = 0;
+    m_error.clear();
+}
+
+void ScriptInstance::restart()
+{
+    reset();
+    if (m_program)
+        std::copy(m_program->globalInit.constBegin(), m_program->globalInit.constEnd(), m_globals.begin());
+}
+
+/*
+ 解释循环：当前帧的 pc 和寄存器窗口放在局部变量里，只在调用、返回和退出时写回帧；
+ 每条指令只有一次预算计数和一次 switch 分派，不分配内存
+*/
+ScriptVM::Result ScriptVM::resume(ScriptInstance &in, int budget)
+{
+    if (in.m_status != ScriptInstance::Running)
+        return in.m_status == ScriptInstance::Error ? Failed : Finished;
+
+    const ScriptProgram &prog = *in.m_program;
+    const quint32 *const code = prog.code.constData();
+    const qint32 *const constants = prog.constants.constData();
+    qint32 *const stack = in.m_registers.data();
+    qint32 *const globals = in.m_globals.data();
+
+    ScriptInstance::Frame *frame = &in.m_frames[in.m_depth - 1];
+    int pc = frame->pc;
+    qint32 *r = stack + frame->base;
+    int left = budget;
+
+    auto fail = [&](const QString &message) {
+        in.m_status = ScriptInstance::Error;
+        in.m_error = QString("%1 (in %2, pc %3)").arg(message).arg(prog.functions[frame->function].name).arg(pc - 1);
+        in.m_depth = 0;
+        in.executed += budget - left;
+        return Failed;
+    };
+
+    while (left > 0)
+    {
+        --left;
+        const quint32 i = code[pc++];
+        const int a = argA(i);
+        switch (opOf(i))
+        {
+        case LoadI: r[a] = argSBx(i); break;
+        case LoadK: r[a] = constants[argBx(i)]; break;
+        case Move:  r[a] = r[argB(i)]; break;
+        case GetG:  r[a] = globals[argBx(i)]; break;
+        case SetG:  globals[argBx(i)] = r[a]; break;
+        // 用无符号运算避免有符号溢出的未定义行为，结果按补码回绕
+        case Add: r[a] = qint32(quint32(r[argB(i)]) + quint32(r[argC(i)])); break;
+        case Sub: r[a] = qint32(quint32(r[argB(i)]) - quint32(r[argC(i)])); break;
+        case Mul: r[a] = qint32(quint32(r[argB(i)]) * quint32(r[argC(i)])); break;
+        case Div:
+        case Mod:
+        {
+            const qint32 x = r[argB(i)];
+            const qint32 y = r[argC(i)];
+            if (y == 0)
+                return fail("division by zero");
+            if (y == -1)   // INT_MIN / -1 会溢出
+                r[a] = opOf(i) == Div ? qint32(0u - quint32(x)) : 0;
+            else
+                r[a] = opOf(i) == Div ? x / y : x % y;
+            break;
+        }
+        case Lt:   r[a] = r[argB(i)] < r[argC(i)]; break;
+        case Le:   r[a] = r[argB(i)] <= r[argC(i)]; break;
+        case Eq:   r[a] = r[argB(i)] == r[argC(i)]; break;
+        case Ne:   r[a] = r[argB(i)] != r[argC(i)]; break;
+        case AddI: r[a] = qint32(quint32(r[argB(i)]) + quint32(argC(i) - 128)); break;
+        case Neg:  r[a] = qint32(0u - quint32(r[argB(i)])); break;
+        case Not:  r[a] = !r[argB(i)]; break;
+        case Bool: r[a] = r[argB(i)] != 0; break;
+        case Jmp:  pc += argSBx(i); break;
+        case JmpF: if (!r[a]) pc += argSBx(i); break;
+        case JmpT: if (r[a]) pc += argSBx(i); break;
+        case Call:
+        {
+            const ScriptProgram::Function &callee = prog.functions[argB(i)];
+            const int base = int(r - stack) + a;
+            if (in.m_depth == ScriptInstance::MAX_FRAMES || base + callee.registers > ScriptInstance::STACK_REGISTERS)
+                return fail("call stack overflow");
+            frame->pc = pc;
+            frame = &in.m_frames[in.m_depth++];
+            *frame = ScriptInstance::Frame{argB(i), callee.entry, base};
+            pc = callee.entry;
+            r = stack + base;
+            break;
+        }
+        case NCall:
+        {
+            const int native = argB(i) | ((argC(i) >> 4) << 8);
+            r[a] = prog.natives->fn(native)(in, r + a);
+            if (in.m_status == ScriptInstance::Error)
+                return fail(in.m_error);
+            break;
+        }
+        case Ret:
+        case Ret0:
+        {
+            const qint32 value = opOf(i) == Ret ? r[a] : 0;
+            if (--in.m_depth == 0)
+            {
+                in.m_result = value;
+                in.m_status = ScriptInstance::Idle;
+                in.executed += budget - left;
+                return Finished;
+            }
+            // 返回值写到被调用者的 R0，也就是调用者的 R[A]
+            r[0] = value;
+            frame = &in.m_frames[in.m_depth - 1];
+            pc = frame->pc;
+            r = stack + frame->base;
+            break;
+        }
+        case Yield:
+            frame->pc = pc;
+            in.executed += budget - left;
+            return Yielded;
+        default:
+            return fail("invalid instruction");
+        }
+    }
+    frame->pc = pc;
+    in.executed += budget;
+    return OutOfBudget;
+}
@@ -0,0 +1,194 @@
+// scriptvm.h - 嵌入式脚本的字节码和寄存器虚拟机
+#ifndef SCRIPTVM_H
+#define SCRIPTVM_H
+
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+#include <functional>
+
+class ScriptInstance;
+
+/*
+ 脚本系统分三部分：
+ - ScriptNatives：宿主提供的原生函数表（名字、参数个数、处理函数）。编译时按名字查到下标，
+   运行时按下标直接调用，不再查名字
+ - ScriptProgram：ScriptCompiler 编译出的字节码，只读，可以被任意多个实例共享
+ - ScriptInstance：一个 NPC / 一次物品使用的运行状态（全局变量、寄存器栈、调用栈），
+   创建时一次分配好，执行指令时不再分配内存；可以按指令预算分多次执行（见 ScriptVM）
+
+ 指令是 32 位：op(8) | A(8) | B(8) | C(8)，或 op(8) | A(8) | Bx(16)（sBx = Bx - 32768）。
+ 所有值都是 32 位整数；字符串常量编译成字符串表的下标，原生函数用 ScriptProgram::string 取回
+*/
+namespace Script
+{
+enum Op : quint8
+{
+    LoadI,      // R[A] = sBx
+    LoadK,      // R[A] = K[Bx]
+    Move,       // R[A] = R[B]
+    GetG,       // R[A] = G[Bx]
+    SetG,       // G[Bx] = R[A]
+    Add, Sub, Mul, Div, Mod,   // R[A] = R[B] op R[C]
+    Lt, Le, Eq, Ne,            // R[A] = (R[B] op R[C]) ? 1 : 0
+    AddI,       // R[A] = R[B] + (C - 128)
+    Neg,        // R[A] = -R[B]
+    Not,        // R[A] = !R[B]
+    Bool,       // R[A] = R[B] != 0
+    Jmp,        // pc += sBx
+    JmpF,       // if (!R[A]) pc += sBx
+    JmpT,       // if (R[A]) pc += sBx
+    Call,       // R[A] = 函数 B(R[A] .. R[A+C-1])，被调用函数的寄存器窗口从 R[A] 开始
+    NCall,      // R[A] = 原生函数 (B | (C >> 4) << 8)(R[A] .. R[A+(C & 15)-1])
+    Ret,        // 返回 R[A]
+    Ret0,       // 返回 0
+    Yield,      // 本次执行到此为止，下次从下一条指令继续
+    OpCount
+};
+
+inline quint32 encode(Op op, int a, int b, int c)
+{ return quint32(op) | (quint32(a & 0xff) << 8) | (quint32(b & 0xff) << 16) | (quint32(c & 0xff) << 24); }
+inline quint32 encodeBx(Op op, int a, int bx)
+{ return quint32(op) | (quint32(a & 0xff) << 8) | (quint32(bx & 0xffff) << 16); }
+inline Op opOf(quint32 i) { return Op(i & 0xff); }
+inline int argA(quint32 i) { return int((i >> 8) & 0xff); }
+inline int argB(quint32 i) { return int((i >> 16) & 0xff); }
+inline int argC(quint32 i) { return int(i >> 24); }
+inline int argBx(quint32 i) { return int(i >> 16); }
+inline int argSBx(quint32 i) { return int(i >> 16) - 32768; }
+
+const int MAX_REGISTERS = 250;  // 一个函数最多用的寄存器
+const int MAX_FUNCTIONS = 256;  // Call 的函数下标 8 位
+const int MAX_NATIVES = 4096;   // NCall 的下标 12 位
+const int MAX_ARGS = 15;
+}
+
+/* 原生函数：args 指向 arity 个参数，返回值写回调用处的寄存器 */
+typedef std::function<qint32(ScriptInstance &self, const qint32 *args)> ScriptNativeFn;
+
+class ScriptNatives
+{
+public:
+    /* 注册一个原生函数，返回下标；同名的后注册覆盖先注册的 */
+    int add(const QString &name, int arity, const ScriptNativeFn &fn);
+    int find(const QString &name) const;   // 编译时用，找不到返回 -1
+    int count() const { return m_entries.size(); }
+    const QString &name(int index) const { return m_entries[index].name; }
+    int arity(int index) const { return m_entries[index].arity; }
+    const ScriptNativeFn &fn(int index) const { return m_entries[index].fn; }
+
+private:
+    struct Entry
+    {
+        QString name;
+        int arity;
+        ScriptNativeFn fn;
+    };
+    QVector<Entry> m_entries;
+};
+
+class ScriptProgram
+{
+public:
+    struct Function
+    {
+        QString name;
+        int entry = 0;       // 第一条指令的下标
+        int params = 0;
+        int registers = 0;   // 参数 + 局部变量 + 临时值
+    };
+
+    /* 按名字找函数（宿主在加载后查一次，之后只用下标）；找不到返回 -1 */
+    int function(const QString &name) const;
+    int functionCount() const { return functions.size(); }
+    const QString &string(int index) const { return strings[index]; }
+    int globalCount() const { return globals.size(); }
+    bool isNull() const { return code.isEmpty(); }
+    /* 反汇编，调试用 */
+    QString disassemble() const;
+
+    QVector<quint32> code;
+    QVector<qint32> constants;
+    QVector<QString> strings;
+    QVector<Function> functions;
+    QVector<QString> globals;       // 全局变量名（每个实例一份）
+    QVector<qint32> globalInit;     // 全局变量初值
+    const ScriptNatives *natives = nullptr;
+};
+
+/* 一个运行中的脚本 */
+class ScriptInstance
+{
+public:
+    enum Status : quint8
+    {
+        Idle,         // 没有在执行的调用，可以 start
+        Running,      // 调用还没结束（预算用完或 yield），下次 resume 继续
+        Error
+    };
+
+    static const int STACK_REGISTERS = 1024;
+    static const int MAX_FRAMES = 32;
+
+    ScriptInstance() {}
+    explicit ScriptInstance(const ScriptProgram *program);
+
+    const ScriptProgram *program() const { return m_program; }
+    Status status() const { return m_status; }
+    /* 出错原因（status 为 Error 时） */
+    const QString &error() const { return m_error; }
+    qint32 result() const { return m_result; }   // 最近一次执行完的调用的返回值
+    qint32 global(int index) const { return m_globals[index]; }
+    void setGlobal(int index, qint32 value) { m_globals[index] = value; }
+
+    /* 开始调用函数 function（参数个数必须与定义一致）；正在执行别的调用时返回 false */
+    bool start(int function, const qint32 *args = nullptr, int argc = 0);
+    /* 出错后清除错误状态，全局变量保留 */
+    void reset();
+    /* 回到刚创建时的状态：清除错误和没执行完的调用，全局变量恢复初值；不重新分配寄存器栈 */
+    void restart();
+    /* 供原生函数报告错误：原生函数返回后当前调用中止，resume 返回 Failed */
+    void raiseError(const QString &message);
+
+    void *user = nullptr;     // 宿主数据（NPC 指针等），原生函数通过它找到调用者
+    qint64 executed = 0;      // 累计执行的指令数
+
+private:
+    friend class ScriptVM;
+    struct Frame
+    {
+        int function;
+        int pc;
+        int base;        // 寄存器窗口在 m_registers 中的起点
+    };
+
+    const ScriptProgram *m_program = nullptr;
+    Status m_status = Idle;
+    QString m_error;
+    qint32 m_result = 0;
+    QVector<qint32> m_globals;
+    QVector<qint32> m_registers;
+    Frame m_frames[MAX_FRAMES];
+    int m_depth = 0;
+};
+
+/*
+ ScriptVM：执行 ScriptInstance，直到调用返回、yield、出错或用完 budget 条指令
+ 预算用完时停在下一条指令上，下次 resume 接着执行：每个 NPC 每个逻辑步给一个预算，
+ 写成死循环的脚本也只会拖慢它自己，不会卡住整帧
+*/
+class ScriptVM
+{
+public:
+    enum Result : quint8
+    {
+        Finished,        // 调用返回了（instance.result() 为返回值）
+        Yielded,         // 执行了 yield
+        OutOfBudget,     // 预算用完
+        Failed           // 运行时错误（除以 0、调用栈溢出……），见 instance.error()
+    };
+
+    static Result resume(ScriptInstance &instance, int budget);
+};
+
+#endif // SCRIPTVM_H
@@ -0,0 +1,127 @@
+// simthread.cpp - 驱动 Simulation 的后台线程实现
+#include "simthread.h"
+#include <QElapsedTimer>
+
+namespace {
+const int COMMAND_QUEUE_SIZE = 256;
+const int EVENT_QUEUE_SIZE = 1024;
+const int MAX_TICKS_PER_FRAME = 5;  // 卡顿后最多补几步，防止越补越慢
+const int UNTHROTTLED_BATCH = 64;   // 不限速时每轮走几步再发布一次状态、看一眼命令
+const qint64 IDLE_WAIT_US = 1000;   // 等地图 / 回放结束后多久看一次命令
+}
+
+SimulationThread::SimulationThread(const World &world, const ItemDatabase &items, QObject *parent)
+    : QThread(parent),
+      m_sim(world, items),
+      m_commands(COMMAND_QUEUE_SIZE),
+      m_events(EVENT_QUEUE_SIZE)
+{
+    setObjectName("simulation");   // 调试器和时间线追踪里的线程名
+}
+
+SimulationThread::~SimulationThread()
+{
+    stop();
+}
+
+void SimulationThread::stop()
+{
+    m_stopRequested.storeRelease(1);
+    wait();
+    m_stopRequested.storeRelease(0);
+
+    // 线程已经结束：还没处理的命令直接交给模拟，之后 simulation() 反映 GUI 发过的全部命令
+    SimCommand command;
+    while (m_commands.pop(&command))
+        m_sim.apply(command);
+    for (const SimCommand &c : m_unsentCommands)
+        m_sim.apply(c);
+    m_unsentCommands.clear();
+}
+
+void SimulationThread::post(const SimCommand &command)
+{
+    // 先送积压的，保证命令的顺序
+    m_unsentCommands.append(command);
+    int sent = 0;
+    while (sent < m_unsentCommands.size() && m_commands.push(m_unsentCommands[sent]))
+        ++sent;
+    m_unsentCommands.remove(0, sent);
+}
+
+bool SimulationThread::pollEvent(SimEvent *event)
+{
+    return m_events.pop(event);
+}
+
+void SimulationThread::flushEvents()
+{
+    m_unsentEvents += m_sim.takeEvents();
+    int sent = 0;
+    while (sent < m_unsentEvents.size() && m_events.push(m_unsentEvents[sent]))
+        ++sent;
+    m_unsentEvents.remove(0, sent);
+}
+
+void SimulationThread::run()
+{
+    const qint64 tickNs = qint64(Simulation::TICK_MS) * 1000000;
+    QElapsedTimer clock;
+    clock.start();
+    qint64 nextTickNs = tickNs;
+
+    while (!m_stopRequested.loadAcquire())
+    {
+        bool changed = false;
+        SimCommand command;
+        while (m_commands.pop(&command))
+        {
+            m_sim.apply(command);
+            changed = true;
+        }
+
+        const qint64 now = clock.nsecsElapsed();
+        int steps = 0;
+        if (!m_sim.canTick())
+        {
+            nextTickNs = now + tickNs;   // 等地图的时间不算欠下的逻辑步
+        }
+        else if (!m_throttled)
+        {
+            while (steps < UNTHROTTLED_BATCH && m_sim.canTick())
+            {
+                m_sim.tick();
+                ++steps;
+            }
+        }
+        else
+        {
+            while (now >= nextTickNs && steps < MAX_TICKS_PER_FRAME && m_sim.canTick())
+            {
+                m_sim.tick();
+                nextTickNs += tickNs;
+                ++steps;
+            }
+            // 补不完的时间直接丢掉：逻辑变慢，但不会因为补步而卡得更久
+            if (steps == MAX_TICKS_PER_FRAME && now >= nextTickNs)
+                nextTickNs = now + tickNs;
+        }
+
+        if (steps > 0 || changed)
+        {
+            m_sim.writeSnapshot(&m_snapshots.back());
+            m_snapshots.publish();
+        }
+        flushEvents();
+
+        if (!m_sim.canTick())
+            QThread::usleep(IDLE_WAIT_US);
+        else if (m_throttled)
+        {
+            const qint64 waitUs = (nextTickNs - clock.nsecsElapsed()) / 1000;
+            if (waitUs > 0)
+                QThread::usleep(waitUs);
+        }
+    }
+    flushEvents();
+}
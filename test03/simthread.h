@@ -0,0 +1,57 @@
+// simthread.h - 驱动 Simulation 的后台线程
+#ifndef SIMTHREAD_H
+#define SIMTHREAD_H
+
+#include <QThread>
+#include <QVector>
+#include <QAtomicInteger>
+#include "simulation.h"
+#include "lockfree.h"
+
+/*
+ SimulationThread：在自己的线程里按固定步长推进 Simulation
+ - GUI → 模拟：post() 把命令放进无锁队列，模拟线程每一轮开头全部取走
+ - 模拟 → GUI：每走完几步把状态写进三缓冲并发布，GUI 每帧 updateSnapshot() 取最新的一份，
+   两边谁也不等谁；不能丢的消息（瓦片修改、提示、地图切换）走另一个无锁队列，GUI 用 pollEvent() 取
+ - 队列满了不会丢：多出来的先放在发送方自己的列表里，下次再送
+ 模拟线程没有运行时（stop() 之后、start() 之前）GUI 可以直接用 simulation() 做设置。
+*/
+class SimulationThread : public QThread
+{
+    Q_OBJECT
+public:
+    SimulationThread(const World &world, const ItemDatabase &items, QObject *parent = nullptr);
+    ~SimulationThread() override;
+
+    /* 只能在线程没有运行时使用 */
+    Simulation &simulation() { return m_sim; }
+    /* false：不按真实时间限速，能走多快走多快（快速回放）；在 start() 之前设置 */
+    void setThrottled(bool throttled) { m_throttled = throttled; }
+    /* 请求线程退出并等它结束，然后把排队的命令交给模拟 */
+    void stop();
+
+    // ---- 以下只在 GUI 线程调用 ----
+    void post(const SimCommand &command);
+    bool pollEvent(SimEvent *event);
+    /* 模拟发布了新状态时换上它并返回 true；snapshot() 在下次 updateSnapshot() 之前不变 */
+    bool updateSnapshot() { return m_snapshots.update(); }
+    const SimSnapshot &snapshot() const { return m_snapshots.front(); }
+
+protected:
+    void run() override;
+
+private:
+    void flushEvents();
+
+    Simulation m_sim;
+    bool m_throttled = true;
+    QAtomicInteger<int> m_stopRequested;
+
+    SpscQueue<SimCommand> m_commands;
+    QVector<SimCommand> m_unsentCommands;   // GUI 线程的：队列满时暂存
+    SpscQueue<SimEvent> m_events;
+    QVector<SimEvent> m_unsentEvents;       // 模拟线程的：队列满时暂存
+    TripleBuffer<SimSnapshot> m_snapshots;
+};
+
+#endif // SIMTHREAD_H
@@ -0,0 +1,819 @@
+// simulation.cpp - 与画面无关的游戏逻辑实现
+#include "simulation.h"
+#include "tmxmap.h"
+#include "Inventory.h"
+#include "frameprofiler.h"
+#include "tracing.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QtEndian>
+#include <QtMath>
+#include <QDebug>
+
+namespace {
+const int CROWD_SIZE = 2000;
+const int STALL_FALLBACK = 6;         // 地图没有 Stalls 层时随机摆几个摊位
+const int CUSTOMER_VIEW_X = 128;      // 快照里带上玩家周围多大范围的顾客（格子）
+const int CUSTOMER_VIEW_Y = 96;
+const int CUSTOMER_VIEW_MAX = 4096;
+const int NET_HISTORY_MAX = 256;      // 客户端最多留多少步没被主机处理的输入
+const int REMOTE_BACKLOG = 2;         // 主机：客户端的输入积压超过这么多步时一步多处理几个
+const int REMOTE_MAX_PER_TICK = 4;
+
+QStringList inventoryNames(const QVector<ItemState> &items)
+{
+    QStringList names;
+    for (const ItemState &item : items)
+        names.append(item.valid ? item.name : QString());
+    return names;
+}
+}
+
+SimMap::SimMap(const TmxMap &map, const QString &path, int generation)
+    : m_path(path),
+      m_generation(generation),
+      m_width(map.m_mapWidth),
+      m_height(map.m_mapHeight),
+      m_tileWidth(map.m_tileWidth),
+      m_tileHeight(map.m_tileHeight),
+      m_obstacleLayer(map.obstacleLayerIndex())
+{
+    m_layers.reserve(map.layerCount());
+    for (int l = 0; l < map.layerCount(); ++l)
+    {
+        m_layerNames.append(map.layer(l).name);
+        m_layers.append(map.layer(l).data);
+    }
+    m_shapes.build(map.tiles());
+}
+
+SimMap::SimMap(const SimMap &prepared, const TmxMap &map, int generation)
+    : m_path(prepared.m_path),
+      m_generation(generation),
+      m_width(prepared.m_width),
+      m_height(prepared.m_height),
+      m_tileWidth(prepared.m_tileWidth),
+      m_tileHeight(prepared.m_tileHeight),
+      m_layerNames(prepared.m_layerNames),
+      m_obstacleLayer(prepared.m_obstacleLayer),
+      m_shapes(prepared.m_shapes)
+{
+    m_layers.reserve(map.layerCount());
+    for (int l = 0; l < map.layerCount(); ++l)
+        m_layers.append(map.layer(l).data);
+}
+
+int SimMap::tileAt(int layer, int x, int y) const
+{
+    if (layer < 0 || layer >= m_layers.size() || !contains(x, y))
+        return 0;
+    return m_layers[layer].at(x, y);
+}
+
+bool SimMap::setTile(int layer, int x, int y, int gid)
+{
+    if (layer < 0 || layer >= m_layers.size() || !contains(x, y))
+    {
+        qWarning() << "setTile out of range:" << layer << x << y;
+        return false;
+    }
+    LayerData &data = m_layers[layer];
+    if (data.at(x, y) == gid)
+        return true;
+    data.set(x, y, gid);
+    if (m_collisionBuilt)
+        updateCollision(x, y);
+    TileChange change = { layer, x, y, gid };
+    m_changes.append(change);
+    return true;
+}
+
+bool SimMap::isObstacle(int x, int y) const
+{
+    if (m_obstacleLayer < 0 || !contains(x, y))
+        return false;
+    return m_layers[m_obstacleLayer].at(x, y) != 0;
+}
+
+void SimMap::buildCollision()
+{
+    TRACE_SCOPE("SimMap::buildCollision");
+    m_collision.reset(m_width, m_height, m_tileWidth, m_tileHeight);
+    m_collisionBuilt = true;
+    if (m_shapes.isEmpty())
+    {
+        // 没有碰撞形状（常见情况）：只看障碍物层
+        for (int y = 0; y < m_height; ++y)
+            for (int x = 0; x < m_width; ++x)
+                if (isObstacle(x, y))
+                    m_collision.setCell(x, y, CollisionGrid::Full);
+        return;
+    }
+    for (int y = 0; y < m_height; ++y)
+        for (int x = 0; x < m_width; ++x)
+            updateCollision(x, y);
+}
+
+void SimMap::updateCollision(int x, int y)
+{
+    CollisionGrid::Kind kind = CollisionGrid::Empty;
+    QVector<QRectF> boxes;
+    for (int l = 0; l < m_layers.size() && kind != CollisionGrid::Full; ++l)
+    {
+        const int gid = m_layers[l].at(x, y);
+        if (gid == 0)
+            continue;
+        const int n = m_shapes.count(gid);
+        if (n > 0)
+        {
+            const QRectF *b = m_shapes.boxes(gid);
+            for (int i = 0; i < n; ++i)
+                boxes.append(b[i]);
+            kind = CollisionGrid::Shaped;
+        }
+        else if (l == m_obstacleLayer)
+        {
+            kind = CollisionGrid::Full;
+        }
+    }
+    m_collision.setCell(x, y, kind, boxes);
+}
+
+QVector<SimMap::TileChange> SimMap::takeChanges()
+{
+    QVector<TileChange> changes;
+    changes.swap(m_changes);
+    return changes;
+}
+
+void SimMap::hashTiles(QCryptographicHash *hash) const
+{
+    // 固定用小端，录制和回放不在同一种机器上也能比
+    QVector<qint32> row(m_width);
+    for (const LayerData &data : m_layers)
+    {
+        for (int y = 0; y < m_height; ++y)
+        {
+            for (int x = 0; x < m_width; ++x)
+                row[x] = qToLittleEndian<qint32>(data.at(x, y));
+            hash->addData(reinterpret_cast<const char *>(row.constData()), m_width * int(sizeof(qint32)));
+        }
+    }
+}
+
+Simulation::Simulation(const World &world, const ItemDatabase &items)
+    : m_world(world),
+      m_items(items),
+      m_inventory(INVENTORY_SIZE)
+{
+}
+
+void Simulation::reset(quint32 seed)
+{
+    m_rng.setSeed(seed);
+    m_tick = 0;
+    m_pendingInput.clear();
+    m_heldKeys.clear();  // 录制和回放都从什么键都没按着开始
+    m_moving = false;
+    m_edgeTried = false;
+    if (!m_map.isNull())
+        populateCrowd(m_rng.next());
+}
+
+void Simulation::setInventory(const QVector<ItemState> &items)
+{
+    m_inventory = items;
+    m_inventory.resize(INVENTORY_SIZE);
+}
+
+void Simulation::setNetRole(NetRole role)
+{
+    const bool crowdChanged = (role == Client) != (m_netRole == Client);
+    m_netRole = role;
+    m_netId = role == Host ? 0 : -1;
+    m_remotes.clear();
+    m_netHistory.clear();
+    m_netSlot = -1;
+    m_netEditSeq = 0;
+    m_netPlayers.clear();
+    m_netCustomers.clear();
+    if (crowdChanged && !m_map.isNull())
+        populateCrowd(m_rng.next());   // 客户端不推进顾客，主机和单机按自己的地图生成
+}
+
+void Simulation::apply(const SimCommand &command)
+{
+    switch (command.type)
+    {
+    case SimCommand::Input:
+        // 回放时输入全部来自录制文件
+        if (!m_replaying)
+            m_pendingInput.append(command.input);
+        break;
+    case SimCommand::EnterMap:
+        m_map = command.map;
+        m_world.setMapSize(m_map.path(), QSize(m_map.width() * m_map.tileWidth(),
+                                               m_map.height() * m_map.tileHeight()));
+        m_map.buildCollision();
+        m_items.bindMap(&m_map);
+        m_moving = false;  // 走到一半换了地图（门、热重载）：直接落在新位置，还按着的方向键接着走
+        m_edgeTried = false;
+        m_player = QPoint(qBound(0, command.tile.x(), m_map.width() - 1),
+                          qBound(0, command.tile.y(), m_map.height() - 1));
+        m_position = QPointF((m_player.x() + 0.5) * m_map.tileWidth(), (m_player.y() + 0.5) * m_map.tileHeight());
+        m_waitingForMap = false;
+        populateCrowd(m_rng.next());
+        break;
+    case SimCommand::TransitionFailed:
+        m_waitingForMap = false;
+        break;
+    case SimCommand::SetTile:
+        // 只是同步 GUI 已经做过的修改，不再发回去
+        if (command.generation == m_map.generation())
+        {
+            m_map.setTile(command.layer, command.tile.x(), command.tile.y(), command.gid);
+            syncObstacles(m_map.takeChanges());
+        }
+        break;
+    case SimCommand::RemoteJoin:
+        if (m_netRole == Host && !m_map.isNull())
+        {
+            // 新来的玩家站在主机玩家的位置，带一份初始物品
+            RemotePlayer r;
+            r.id = command.player;
+            r.position = m_position;
+            r.tile = m_player;
+            r.inventory = m_inventory;
+            m_remotes.append(r);
+        }
+        break;
+    case SimCommand::RemoteLeave:
+        for (int i = 0; i < m_remotes.size(); ++i)
+            if (m_remotes[i].id == command.player)
+                m_remotes.remove(i--);
+        break;
+    case SimCommand::RemoteInput:
+        for (RemotePlayer &r : m_remotes)
+            if (r.id == command.player)
+                r.input.append(command.frame);
+        break;
+    case SimCommand::NetJoined:
+        m_netId = command.player;
+        m_netHistory.clear();
+        break;
+    case SimCommand::NetState:
+        if (m_netRole == Client && !m_map.isNull())
+            applyNetState(command.state);
+        break;
+    }
+}
+
+bool Simulation::canTick() const
+{
+    return !m_waitingForMap && !(m_replaying && m_tick >= m_replay.ticks);
+}
+
+void Simulation::tick()
+{
+    PROFILE_SCOPE(Simulation);
+    TRACE_SCOPE("Simulation::tick");
+
+    // 回放：把录在这个逻辑步上的输入放进队列
+    if (m_replaying)
+    {
+        while (m_replayIndex < m_replay.events.size() && m_replay.events[m_replayIndex].tick <= m_tick)
+            m_pendingInput.append(m_replay.events[m_replayIndex++]);
+    }
+
+    // 先取走队列；某条输入引起地图切换时，剩下的放回去，等切换完成后的下一个逻辑步再处理
+    QVector<InputEvent> input;
+    input.swap(m_pendingInput);
+    for (int i = 0; i < input.size(); ++i)
+    {
+        if (m_waitingForMap)
+        {
+            m_pendingInput = input.mid(i) + m_pendingInput;
+            break;
+        }
+        InputEvent &e = input[i];
+        e.tick = m_tick;
+        if (m_recording)
+        {
+            e.timeMs = m_recordClock.elapsed();
+            m_record.events.append(e);
+        }
+        handleInput(e);
+    }
+
+    if (!m_waitingForMap)
+    {
+        advanceMove();
+        if (m_netRole == Client)
+        {
+            recordNetInput();
+        }
+        else
+        {
+            advanceRemotes();
+            // 完整模型跟着玩家走（逻辑状态），不看摄像机，回放时升降级完全相同
+            TRACE_SCOPE("Crowd::tick");
+            m_crowd.tick(m_tick, m_player);
+        }
+    }
+    ++m_tick;
+
+    if (m_replaying && m_tick == m_replay.ticks)
+        post(SimEvent::ReplayFinished, QString::fromLatin1(checksum()));
+}
+
+namespace {
+QPoint directionOf(int key)
+{
+    switch (key)
+    {
+    case Qt::Key_Left:  return QPoint(-1, 0);
+    case Qt::Key_Right: return QPoint(1, 0);
+    case Qt::Key_Up:    return QPoint(0, -1);
+    case Qt::Key_Down:  return QPoint(0, 1);
+    default:            return QPoint();
+    }
+}
+}
+
+void Simulation::handleInput(const InputEvent &event)
+{
+    if (event.type == InputEvent::SlotClick)
+    {
+        useItem(event.code);
+        return;
+    }
+
+    const QPoint dir = directionOf(event.code);
+    if (event.type == InputEvent::KeyRelease)
+    {
+        m_heldKeys.removeAll(event.code);
+        // 松开后面按下的键时，朝向回到还按着的那个方向
+        if (!dir.isNull() && !m_heldKeys.isEmpty())
+            m_facing = directionOf(m_heldKeys.last());
+        return;
+    }
+
+    if (dir.isNull())
+    {
+        // 工具使用逻辑（数字键1-9）
+        if (event.code >= Qt::Key_1 && event.code <= Qt::Key_9)
+            useItem(event.code - Qt::Key_1);
+        return;
+    }
+
+    // 按住期间的移动由逻辑步推进；即使被挡住也要转向，摄像机前瞻跟着朝向走
+    if (!m_heldKeys.contains(event.code))
+        m_heldKeys.append(event.code);
+    m_facing = dir;
+    m_edgeTried = false;
+}
+
+void Simulation::useItem(int slotIndex)
+{
+    // 客户端：物品由主机使用，瓦片修改随主机的状态回来
+    if (m_netRole == Client)
+    {
+        m_netSlot = qint8(slotIndex);
+        return;
+    }
+
+    const ItemState item = m_inventory.value(slotIndex);
+    if (!item.valid)
+    {
+        post(SimEvent::Status, "槽位 " + QString::number(slotIndex + 1) + " 无工具！");
+        return;
+    }
+
+    const QString status = applyItem(item, m_player, m_facing, m_inventory);
+    if (!status.isEmpty())
+        post(SimEvent::Status, status);
+}
+
+QString Simulation::applyItem(const ItemState &item, const QPoint &tile, const QPoint &facing,
+                              const QVector<ItemState> &inventory)
+{
+    // 作用对象（面前的格子、周围的实体）由数据文件里的动作决定；实体就是街上的顾客
+    ItemContext ctx;
+    ctx.map = &m_map;
+    ctx.player = tile;
+    ctx.facing = facing;
+    ctx.inventory = &inventory;
+    ctx.rng = &m_rng;
+    ctx.entitiesNear = [this](const QPoint &center, int radius) { return m_crowd.near(center, radius); };
+    ctx.hitEntity = [this](int id, int amount) { return m_crowd.hit(id, amount); };
+    m_items.use(item, ctx);
+    publishChanges();
+    return ctx.status;
+}
+
+void Simulation::publishChanges()
+{
+    const QVector<SimMap::TileChange> changes = m_map.takeChanges();
+    syncObstacles(changes);
+    for (const SimMap::TileChange &c : changes)
+    {
+        SimEvent e;
+        e.type = SimEvent::TileChanged;
+        e.generation = m_map.generation();
+        e.layer = c.layer;
+        e.tile = QPoint(c.x, c.y);
+        e.gid = c.gid;
+        m_events.append(e);
+    }
+}
+
+QRectF Simulation::bodyBox(const QPointF &position) const
+{
+    return QRectF(position.x() - BODY_WIDTH / 2.0, position.y() - BODY_HEIGHT / 2.0, BODY_WIDTH, BODY_HEIGHT);
+}
+
+void Simulation::advanceMove()
+{
+    m_moving = false;
+    if (m_heldKeys.isEmpty())
+        return;
+
+    // 按住的方向合在一起，斜着走时速度不变
+    QPoint dir;
+    for (int key : m_heldKeys)
+        dir += directionOf(key);
+    dir = QPoint(qBound(-1, dir.x(), 1), qBound(-1, dir.y(), 1));
+    if (dir.isNull())
+        return;
+
+    QPoint edge;
+    m_moving = !walk(&m_position, dir, &edge).isNull();
+    const QPoint tile = tileOf(m_position);
+    if (tile != m_player)
+    {
+        m_player = tile;
+        m_edgeTried = false;
+        if (tryTransition(m_player)) // 踩到门
+            return;
+    }
+    if (!edge.isNull() && !m_edgeTried)
+    {
+        m_edgeTried = true;
+        tryTransition(m_player + edge);
+    }
+}
+
+QPointF Simulation::walk(QPointF *position, const QPoint &dir, QPoint *edge) const
+{
+    const qreal speed = dir.x() != 0 && dir.y() != 0 ? WALK_SPEED * M_SQRT1_2 : WALK_SPEED;
+    const QPointF delta(dir.x() * speed, dir.y() * speed);
+
+    const QRectF box = bodyBox(*position);
+    QPointF moved;
+    {
+        PROFILE_SCOPE(Pathfinding);
+        moved = m_map.collision().move(box, delta);
+    }
+
+    // 地图边缘：碰撞框不出地图；顶着边缘走时看世界里有没有相邻的地图
+    const QRectF bounds(0, 0, m_map.width() * m_map.tileWidth(), m_map.height() * m_map.tileHeight());
+    const QRectF next = box.translated(moved);
+    *edge = QPoint();
+    if (next.left() < bounds.left())        { moved.rx() += bounds.left() - next.left(); edge->rx() = -1; }
+    else if (next.right() > bounds.right()) { moved.rx() -= next.right() - bounds.right(); edge->rx() = 1; }
+    if (next.top() < bounds.top())          { moved.ry() += bounds.top() - next.top(); edge->ry() = -1; }
+    else if (next.bottom() > bounds.bottom()) { moved.ry() -= next.bottom() - bounds.bottom(); edge->ry() = 1; }
+
+    *position += moved;
+    return moved;
+}
+
+QPoint Simulation::tileOf(const QPointF &position) const
+{
+    return QPoint(qBound(0, qFloor(position.x() / m_map.tileWidth()), m_map.width() - 1),
+                  qBound(0, qFloor(position.y() / m_map.tileHeight()), m_map.height() - 1));
+}
+
+namespace {
+quint8 keyBits(const QVector<int> &heldKeys)
+{
+    quint8 bits = 0;
+    for (int key : heldKeys)
+    {
+        switch (key)
+        {
+        case Qt::Key_Left:  bits |= NetInputFrame::Left; break;
+        case Qt::Key_Right: bits |= NetInputFrame::Right; break;
+        case Qt::Key_Up:    bits |= NetInputFrame::Up; break;
+        case Qt::Key_Down:  bits |= NetInputFrame::Down; break;
+        default: break;
+        }
+    }
+    return bits;
+}
+
+/* 与 advanceMove 合并按住的方向键的结果相同 */
+QPoint directionOfBits(quint8 bits)
+{
+    return QPoint((bits & NetInputFrame::Right ? 1 : 0) - (bits & NetInputFrame::Left ? 1 : 0),
+                  (bits & NetInputFrame::Down ? 1 : 0) - (bits & NetInputFrame::Up ? 1 : 0));
+}
+}
+
+/* 主机：客户端的玩家按收到的输入走，一个输入走一步 */
+void Simulation::advanceRemotes()
+{
+    for (RemotePlayer &r : m_remotes)
+    {
+        r.moving = false;
+        const int count = r.input.size() > REMOTE_BACKLOG ? qMin(r.input.size(), REMOTE_MAX_PER_TICK)
+                                                          : qMin(r.input.size(), 1);
+        for (int i = 0; i < count; ++i)
+        {
+            const NetInputFrame &f = r.input[i];
+            r.facing = NetProtocol::facingOf(f.facing);
+            const QPoint dir = directionOfBits(f.keys);
+            QPoint edge;
+            if (!dir.isNull() && !walk(&r.position, dir, &edge).isNull())
+                r.moving = true;
+            r.tile = tileOf(r.position);
+            if (f.slot >= 0)
+            {
+                const ItemState item = r.inventory.value(f.slot);
+                if (item.valid)
+                    applyItem(item, r.tile, r.facing, r.inventory);
+            }
+            r.inputTick = f.tick;
+        }
+        r.input.remove(0, count);
+    }
+}
+
+/* 客户端：这一步的输入留底（预测已经按它走过了），发给主机 */
+void Simulation::recordNetInput()
+{
+    if (m_netId < 0)
+        return;   // 主机还没答复，输入发不出去
+    NetInputFrame f;
+    f.tick = qint32(m_tick);
+    f.keys = keyBits(m_heldKeys);
+    f.facing = NetProtocol::facingCode(m_facing);
+    f.slot = m_netSlot;
+    m_netSlot = -1;
+    if (m_netHistory.size() >= NET_HISTORY_MAX)
+        m_netHistory.remove(0);
+    m_netHistory.append(f);
+
+    SimEvent e;
+    e.type = SimEvent::NetInput;
+    e.frame = f;
+    m_events.append(e);
+}
+
+void Simulation::applyNetState(const NetWorldState &state)
+{
+    // 瓦片修改按序号去重：没确认之前主机每一份都会重带
+    const quint32 first = state.editSeq - quint32(state.edits.size()) + 1;
+    for (int i = 0; i < state.edits.size(); ++i)
+    {
+        if (first + quint32(i) <= m_netEditSeq)
+            continue;
+        const NetTileEdit &e = state.edits[i];
+        m_map.setTile(e.layer, e.x, e.y, e.gid);
+    }
+    m_netEditSeq = qMax(m_netEditSeq, state.editSeq);
+    publishChanges();
+
+    m_netPlayers.clear();
+    for (const NetPlayerState &p : state.players)
+    {
+        PlayerView v;
+        v.id = p.id;
+        v.position = QPointF(NetProtocol::positionOf(p.x), NetProtocol::positionOf(p.y));
+        v.tile = tileOf(v.position);
+        v.facing = NetProtocol::facingOf(p.facing);
+        v.moving = p.moving;
+        v.inventory = p.inventory;
+        if (p.id == m_netId)
+        {
+            // 校正：回到主机处理完 inputAck 那一步的位置，把主机还没处理的输入重新走一遍
+            while (!m_netHistory.isEmpty() && m_netHistory.first().tick <= state.inputAck)
+                m_netHistory.remove(0);
+            QPointF position = v.position;
+            for (const NetInputFrame &f : m_netHistory)
+            {
+                const QPoint dir = directionOfBits(f.keys);
+                QPoint edge;
+                if (!dir.isNull())
+                    walk(&position, dir, &edge);
+            }
+            m_position = position;
+            m_player = tileOf(m_position);
+            v.tile = m_player;
+            v.position = m_position;
+            v.facing = m_facing;
+            v.moving = m_moving;
+        }
+        m_netPlayers.append(v);
+    }
+
+    m_netCustomers.clear();
+    m_netCustomers.reserve(state.entities.size());
+    for (const NetEntityState &e : state.entities)
+    {
+        CustomerView c;
+        c.id = e.id;
+        c.x = float(e.x) / NetProtocol::ENTITY_SCALE;
+        c.y = float(e.y) / NetProtocol::ENTITY_SCALE;
+        c.mood = CustomerView::Mood(e.mood & 3);
+        m_netCustomers.append(c);
+    }
+}
+
+bool Simulation::tryTransition(const QPoint &tile)
+{
+    // 联机时大家必须在同一张地图上
+    if (m_netRole != Standalone)
+        return false;
+
+    WorldTransition t;
+    if (!m_world.transitionAt(m_map.path(), tile, QSize(m_map.tileWidth(), m_map.tileHeight()), &t))
+        return false;
+
+    SimEvent e;
+    e.type = SimEvent::Transition;
+    e.transition = t;
+    m_events.append(e);
+    m_waitingForMap = true;
+    return true;
+}
+
+/* 障碍物来自地图的障碍物层；摊位来自名为 Stalls 的图层（非空格子），没有就用 seed 随机摆几个 */
+void Simulation::populateCrowd(quint32 seed)
+{
+    TRACE_SCOPE("Simulation::populateCrowd");
+    // 客户端的顾客来自主机
+    if (m_netRole == Client)
+    {
+        m_crowd.clear();
+        return;
+    }
+
+    const int w = m_map.width();
+    const int h = m_map.height();
+    QBitArray blocked(w * h);
+    for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+            if (m_map.isObstacle(x, y))
+                blocked.setBit(y * w + x);
+
+    QVector<Crowd::Stall> stalls;
+    for (int l = 0; l < m_map.layerCount(); ++l)
+    {
+        if (m_map.layerName(l) != "Stalls")
+            continue;
+        for (int y = 0; y < h; ++y)
+            for (int x = 0; x < w; ++x)
+                if (m_map.tileAt(l, x, y) != 0)
+                {
+                    Crowd::Stall s;
+                    s.tile = QPoint(x, y);
+                    s.price = 8 + 4 * (stalls.size() % 4);
+                    stalls.append(s);
+                }
+    }
+    GameRandom rng(seed);
+    if (stalls.isEmpty() && w > 0 && h > 0)
+    {
+        for (int i = 0; i < STALL_FALLBACK; ++i)
+        {
+            Crowd::Stall s;
+            s.tile = QPoint(rng.bounded(w), rng.bounded(h));
+            s.price = 8 + 4 * (i % 4);
+            stalls.append(s);
+        }
+    }
+
+    m_crowd.populate(w, h, blocked, stalls, CROWD_SIZE, rng.next(), m_tick);
+}
+
+void Simulation::syncObstacles(const QVector<SimMap::TileChange> &changes)
+{
+    for (const SimMap::TileChange &c : changes)
+        if (c.layer == m_map.obstacleLayerIndex())
+            m_crowd.setBlocked(c.x, c.y, c.gid != 0);
+}
+
+void Simulation::post(SimEvent::Type type, const QString &text)
+{
+    SimEvent e;
+    e.type = type;
+    e.text = text;
+    m_events.append(e);
+}
+
+void Simulation::writeSnapshot(SimSnapshot *snapshot) const
+{
+    TRACE_SCOPE("Simulation::writeSnapshot");
+    snapshot->tick = m_tick;
+    snapshot->mapGeneration = m_map.generation();
+    snapshot->player = m_player;
+    snapshot->position = m_position;
+    snapshot->facing = m_facing;
+    snapshot->moving = m_moving;
+    snapshot->players.clear();
+    if (m_netRole == Client)
+    {
+        snapshot->customers = m_netCustomers;
+        snapshot->players = m_netPlayers;
+        return;
+    }
+
+    // 主机：每个客户端要的是它自己附近的顾客，范围包住所有玩家
+    const QPoint range(CUSTOMER_VIEW_X, CUSTOMER_VIEW_Y);
+    QRect view(m_player - range, m_player + range);
+    for (const RemotePlayer &r : m_remotes)
+        view = view.united(QRect(r.tile - range, r.tile + range));
+    m_crowd.visible(view, CUSTOMER_VIEW_MAX, &snapshot->customers);
+
+    if (m_netRole != Host)
+        return;
+    PlayerView self;
+    self.id = m_netId;
+    self.tile = m_player;
+    self.position = m_position;
+    self.facing = m_facing;
+    self.moving = m_moving;
+    self.inventory = inventoryNames(m_inventory);
+    snapshot->players.append(self);
+    for (const RemotePlayer &r : m_remotes)
+    {
+        PlayerView v;
+        v.id = r.id;
+        v.tile = r.tile;
+        v.position = r.position;
+        v.facing = r.facing;
+        v.moving = r.moving;
+        v.inputTick = r.inputTick;
+        v.inventory = inventoryNames(r.inventory);
+        snapshot->players.append(v);
+    }
+}
+
+QVector<SimEvent> Simulation::takeEvents()
+{
+    QVector<SimEvent> events;
+    events.swap(m_events);
+    return events;
+}
+
+QByteArray Simulation::checksum() const
+{
+    // 只放逻辑状态：与画面、摄像机、真实时间有关的东西都不算
+    QByteArray bytes;
+    QDataStream out(&bytes, QIODevice::WriteOnly);
+    out << m_tick << m_rng.state() << m_map.path()
+        << qint32(m_player.x()) << qint32(m_player.y()) << m_position << m_facing
+        << m_moving << m_edgeTried << m_heldKeys;
+    for (const ItemState &item : m_inventory)
+        out << item.name << item.toolType;
+    m_crowd.writeState(out);
+    out << m_map.width() << m_map.height() << m_map.layerCount();
+
+    // 地图也是逻辑状态：物品和热重载改过的格子不一样，后面的事就都不一样了
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(bytes);
+    m_map.hashTiles(&hash);
+    return hash.result().toHex();
+}
+
+void Simulation::startRecording()
+{
+    m_record = InputLog();
+    m_record.seed = m_rng.seed();
+    m_record.map = m_map.path();
+    m_record.tickMs = TICK_MS;
+    m_recordClock.start();
+    m_recording = true;
+}
+
+InputLog Simulation::finishRecording() const
+{
+    InputLog log = m_record;
+    log.ticks = m_tick;
+    log.checksum = checksum();
+    return log;
+}
+
+void Simulation::startReplay(const InputLog &log)
+{
+    if (log.tickMs != TICK_MS)
+        qWarning() << "Input log was recorded with" << log.tickMs << "ms ticks, replaying with" << TICK_MS;
+
+    m_replay = log;
+    m_replayIndex = 0;
+    m_replaying = true;
+    m_pendingInput.clear();
+    if (m_tick >= m_replay.ticks)
+        post(SimEvent::ReplayFinished, QString::fromLatin1(checksum()));
+}
@@ -0,0 +1,290 @@
+// simulation.h - 与画面无关的游戏逻辑（在模拟线程里运行）
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QPoint>
+#include <QElapsedTimer>
+#include "layerdata.h"
+#include "world.h"
+#include "inputlog.h"
+#include "gamerandom.h"
+#include "itemdatabase.h"
+#include "crowd.h"
+#include "collision.h"
+#include "netprotocol.h"
+
+class QCryptographicHash;
+
+class TmxMap;
+
+/*
+ SimMap：模拟线程用的地图副本，只有图层数据，没有图块集、图片和场景图元
+ 地图缓存在工作线程里从 TmxMap 复制一份、建好碰撞形状（LayerData 是隐式共享的，复制只增加引用计数），
+ 进入地图时 GUI 再从这份准备好的副本复制，之后两边各改各的：模拟改了的格子记在 changes 里，由 Simulation 作为事件发给 GUI
+*/
+class SimMap
+{
+public:
+    struct TileChange
+    {
+        int layer;
+        int x;
+        int y;
+        int gid;
+    };
+
+    SimMap() {}
+    /* generation：GUI 每进入一次地图加一，用来丢掉发给旧地图的事件 */
+    SimMap(const TmxMap &map, const QString &path, int generation);
+    /* 再次进入同一张地图：沿用 prepared 里建好的碰撞形状，图层换成 map 现在的内容（GUI 这边的修改都在里面）
+     只复制隐式共享的数据，不遍历地图，可以在 GUI 线程里做 */
+    SimMap(const SimMap &prepared, const TmxMap &map, int generation);
+
+    bool isNull() const { return m_layers.isEmpty(); }
+    QString path() const { return m_path; }
+    int generation() const { return m_generation; }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int tileWidth() const { return m_tileWidth; }
+    int tileHeight() const { return m_tileHeight; }
+    bool contains(int x, int y) const { return x >= 0 && y >= 0 && x < m_width && y < m_height; }
+
+    int layerCount() const { return m_layers.size(); }
+    QString layerName(int layer) const { return m_layerNames[layer]; }
+    /* 与 TmxMap 相同：越界读到 0，越界写入返回 false；地图外和没有障碍物层时都不算障碍 */
+    int tileAt(int layer, int x, int y) const;
+    bool setTile(int layer, int x, int y, int gid);
+    bool isObstacle(int x, int y) const;
+    int obstacleLayerIndex() const { return m_obstacleLayer; }
+
+    /* 像素级碰撞：障碍物层的格子整格挡住（瓦片带碰撞形状时只挡形状），其他图层只有带形状的瓦片挡路
+     格子多的地图要花些时间，在模拟线程里建；之后 setTile 只更新改到的格子 */
+    void buildCollision();
+    const CollisionGrid &collision() const { return m_collision; }
+
+    /* 取走上次以来 setTile 改动过的格子 */
+    QVector<TileChange> takeChanges();
+    /* 全部图层的内容按行放进 hash（校验和用）：只看格子里的 GID，与稀疏还是稠密存储无关
+     要走遍整张地图，只在录制结束、回放结束这种时候用 */
+    void hashTiles(QCryptographicHash *hash) const;
+
+private:
+    QString m_path;
+    int m_generation = 0;
+    int m_width = 0;
+    int m_height = 0;
+    int m_tileWidth = 0;
+    int m_tileHeight = 0;
+    QStringList m_layerNames;
+    QVector<LayerData> m_layers;
+    int m_obstacleLayer = -1;
+    QVector<TileChange> m_changes;
+    TileShapes m_shapes;
+    CollisionGrid m_collision;
+    bool m_collisionBuilt = false;
+
+    void updateCollision(int x, int y);
+};
+
+/* GUI → 模拟 */
+struct SimCommand
+{
+    enum Type : quint8
+    {
+        Input,            // 玩家输入，下一个逻辑步处理
+        EnterMap,         // 换到 map，玩家放在 tile（进入第一张地图、过门、热重载）
+        TransitionFailed, // 切换请求的地图加载失败，留在原地继续
+        SetTile,          // GUI 那边改了瓦片（热重载），同步到模拟的地图副本
+        // 联机（主机）：客户端加入、离开和它的一个逻辑步的输入
+        RemoteJoin,
+        RemoteLeave,
+        RemoteInput,
+        // 联机（客户端）：主机分到了玩家编号；收到主机的一份世界状态
+        NetJoined,
+        NetState
+    };
+
+    Type type = Input;
+    InputEvent input;
+    SimMap map;
+    QPoint tile;
+    int layer = 0;
+    int gid = 0;
+    int generation = 0;
+    int player = 0;          // 联机的玩家编号
+    NetInputFrame frame;     // RemoteInput
+    NetWorldState state;     // NetState
+};
+
+/* 模拟 → GUI：不能丢的消息；位置之类每帧只要最新值的状态走 SimSnapshot */
+struct SimEvent
+{
+    enum Type : quint8
+    {
+        Status,          // 提示文字
+        TileChanged,     // 模拟改了瓦片，GUI 的 TmxMap 跟着改（区块、视野、小地图随之更新）
+        Transition,      // 走到门或地图边缘，GUI 加载目标地图后回一个 EnterMap 或 TransitionFailed
+        ReplayFinished,  // 回放到录制的最后一步，text 为最终状态的校验和
+        NetInput         // 联机（客户端）：这一步的输入，由 GUI 发给主机
+    };
+
+    Type type = Status;
+    QString text;
+    int generation = 0;
+    int layer = 0;
+    QPoint tile;
+    int gid = 0;
+    WorldTransition transition;
+    NetInputFrame frame;
+};
+
+/* 联机时的一个玩家 */
+struct PlayerView
+{
+    int id = 0;
+    QPoint tile;             // 脚下的格子
+    QPointF position;        // 脚下的位置（像素）
+    QPoint facing = QPoint(0, 1);
+    bool moving = false;
+    qint32 inputTick = -1;   // 主机：这个客户端的输入处理到了它的哪个逻辑步
+    QStringList inventory;   // 每格物品的名字
+};
+
+/* 每个逻辑步之后发布的状态，GUI 每帧取最新的一份画出来 */
+struct SimSnapshot
+{
+    qint64 tick = 0;
+    int mapGeneration = 0;   // 与 GUI 当前地图不一致时说明模拟还没换过来，忽略这份
+    QPoint player;           // 脚下的格子
+    QPointF position;        // 脚下的位置（像素，碰撞框的中心）
+    QPoint facing = QPoint(0, 1);
+    bool moving = false;     // 这一步走动了（动画用）
+    QVector<CustomerView> customers; // 玩家附近的顾客（格子坐标）；主机上是所有玩家附近的
+    QVector<PlayerView> players;     // 联机时的所有玩家，包括本机
+};
+
+/*
+ Simulation：固定步长的游戏逻辑——处理输入、按像素推进移动（扫掠 AABB 碰撞）、使用物品、
+ 街上的顾客（Crowd）、判断地图切换
+ 不碰 QPixmap、场景和窗口，也不加锁：只由一个线程驱动（SimulationThread），
+ 构造和 reset / 录制 / 回放的设置在驱动线程没有运行时由 GUI 线程调用。
+ 所有随机数来自自己的 GameRandom；地图切换时暂停逻辑步，等 GUI 把地图准备好再继续，
+ 所以地图加载花多久都不影响逻辑步的序列，录制和回放逐位相同。
+ 联机（NetRole）：
+ - 主机（Host）：权威的模拟，客户端的玩家每收到一个输入就按它走一步、用物品，
+   积压时一个逻辑步处理多个，位置与客户端按同样输入预测出来的一致
+ - 客户端（Client）：本机玩家照常按输入移动（预测），每步的输入发给主机并留底；
+   收到主机状态时回到主机处理过的那一步的位置，把之后的输入重新走一遍。
+   物品由主机使用，瓦片修改随状态回来；顾客和其他玩家直接用主机发来的
+ - 联机时不切换地图（门和地图边缘不起作用），客户端不推进顾客
+*/
+class Simulation
+{
+public:
+    static const int TICK_MS = 16;   // 逻辑步长：输入和移动都按它推进，与帧率无关
+    static const int WALK_SPEED = 4; // 每个逻辑步走几个像素
+    static const int BODY_WIDTH = 20;  // 玩家脚下的碰撞框（像素），比一格小，能从桌角边擦过去
+    static const int BODY_HEIGHT = 12;
+
+    enum NetRole : quint8 { Standalone, Host, Client };
+
+    /* world 和 items 各复制一份，构造之后与 GUI 线程的那份互不影响 */
+    Simulation(const World &world, const ItemDatabase &items);
+
+    /* 重新播种，逻辑步归零，丢掉排队的输入和按着的键，按新种子重新生成顾客；地图和玩家位置不变 */
+    void reset(quint32 seed);
+    void setInventory(const QVector<ItemState> &items);
+    /* 联机的角色；和 reset 一样在驱动线程没有运行时调用。主机自己的玩家编号为 0 */
+    void setNetRole(NetRole role);
+
+    void apply(const SimCommand &command);
+    /* 没有地图、等 GUI 切换地图、回放已经结束时为 false */
+    bool canTick() const;
+    void tick();
+
+    void writeSnapshot(SimSnapshot *snapshot) const;
+    /* 取走上次以来产生的事件 */
+    QVector<SimEvent> takeEvents();
+
+    qint64 tickCount() const { return m_tick; }
+    /* 当前逻辑状态的校验和（十六进制 SHA-1），只含逻辑状态 */
+    QByteArray checksum() const;
+
+    /* 录制从当前逻辑步开始（一般紧跟在 reset 之后），finishRecording 补上步数和校验和 */
+    void startRecording();
+    InputLog finishRecording() const;
+    /* 按录制的逻辑步喂回输入，不再接受 Input 命令；走完 log.ticks 步发出 ReplayFinished */
+    void startReplay(const InputLog &log);
+
+private:
+    /* 主机上的客户端玩家 */
+    struct RemotePlayer
+    {
+        int id = 0;
+        QPointF position;
+        QPoint tile;
+        QPoint facing = QPoint(0, 1);
+        bool moving = false;
+        qint32 inputTick = -1;          // 处理过的最后一个输入（客户端的逻辑步）
+        QVector<NetInputFrame> input;   // 收到还没处理的输入
+        QVector<ItemState> inventory;
+    };
+
+    void handleInput(const InputEvent &event);
+    void useItem(int slotIndex);
+    QString applyItem(const ItemState &item, const QPoint &tile, const QPoint &facing,
+                      const QVector<ItemState> &inventory); // 返回提示文字
+    void publishChanges();  // 模拟改过的瓦片发给 GUI
+    void advanceMove();
+    /* 按 dir 走一个逻辑步：扫掠碰撞、不出地图；返回实际的位移，edge 为顶到的地图边缘 */
+    QPointF walk(QPointF *position, const QPoint &dir, QPoint *edge) const;
+    QPoint tileOf(const QPointF &position) const;
+    QRectF bodyBox(const QPointF &position) const;
+    void advanceRemotes();
+    void recordNetInput();
+    void applyNetState(const NetWorldState &state);
+    bool tryTransition(const QPoint &tile); // 走到门或地图边缘时请求切换地图
+    void post(SimEvent::Type type, const QString &text);
+    void populateCrowd(quint32 seed); // 按当前地图重新生成顾客
+    void syncObstacles(const QVector<SimMap::TileChange> &changes);
+
+    World m_world;
+    ItemDatabase m_items;
+    SimMap m_map;
+    bool m_waitingForMap = true;  // 还没有地图，或者切换请求发出后 GUI 还没答复
+
+    GameRandom m_rng;
+    qint64 m_tick = 0;
+    QVector<InputEvent> m_pendingInput;
+    QVector<SimEvent> m_events;
+
+    QPoint m_player;                // 脚下的格子（由 m_position 算出）
+    QPointF m_position;             // 脚下的位置（像素）
+    QPoint m_facing = QPoint(0, 1); // 玩家朝向（默认向下）
+    QVector<int> m_heldKeys;        // 按住的方向键，按下的先后顺序
+    bool m_moving = false;
+    bool m_edgeTried = false;       // 顶着地图边缘时只请求一次切换，换了格子或重新按键才再试
+    QVector<ItemState> m_inventory;
+    Crowd m_crowd;
+
+    NetRole m_netRole = Standalone;
+    int m_netId = -1;                   // 本机玩家的编号；客户端在主机答复之前为 -1
+    QVector<RemotePlayer> m_remotes;    // 主机：客户端的玩家
+    QVector<NetInputFrame> m_netHistory;  // 客户端：主机还没处理的输入，校正时重新走一遍
+    qint8 m_netSlot = -1;               // 客户端：这一步要用的物品格
+    quint32 m_netEditSeq = 0;           // 客户端：已经用上的最后一条瓦片修改
+    QVector<PlayerView> m_netPlayers;   // 客户端：主机发来的玩家
+    QVector<CustomerView> m_netCustomers; // 客户端：主机发来的顾客
+
+    bool m_recording = false;
+    InputLog m_record;
+    QElapsedTimer m_recordClock;
+    bool m_replaying = false;
+    InputLog m_replay;
+    int m_replayIndex = 0;
+};
+
+#endif // SIMULATION_H
@@ -0,0 +1,136 @@
+// softwarerenderer.cpp - 软件渲染器实现
+#include "softwarerenderer.h"
+#include "tileblitter.h"
+#include "tmxmap.h"
+#include <cstring>
+#include <algorithm>
+
+SoftwareRenderer::SoftwareRenderer(const TmxMap *map, BakedMap *baked)
+    : m_map(map),
+      m_baked(baked)
+{
+}
+
+QImage SoftwareRenderer::render(const QRect &sceneRect, int firstGroup, int lastGroup, int level, QRect *covered)
+{
+    m_stats = BakedMap::DrawStats();
+    if (sceneRect.isEmpty())
+        return QImage();
+    if (!m_baked->tilesetsLoaded())
+        m_baked->loadTilesets();
+
+    // 之后的坐标都是缩小后的像素；level 为 0 时就是场景坐标
+    const QRect rect(QPoint(sceneRect.left() >> level, sceneRect.top() >> level),
+                     QPoint(sceneRect.right() >> level, sceneRect.bottom() >> level));
+    if (covered)
+        *covered = QRect(rect.x() << level, rect.y() << level, rect.width() << level, rect.height() << level);
+
+    // 缓冲区只增不减；返回的图像直接引用它的像素，行距沿用大缓冲区的行距
+    if (m_buffer.width() < rect.width() || m_buffer.height() < rect.height())
+        m_buffer = QImage(qMax(m_buffer.width(), rect.width()), qMax(m_buffer.height(), rect.height()),
+                          QImage::Format_ARGB32_Premultiplied);
+    QImage frame(m_buffer.bits(), rect.width(), rect.height(), m_buffer.bytesPerLine(),
+                 QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < rect.height(); ++y)
+        std::memset(frame.scanLine(y), 0, size_t(rect.width()) * sizeof(quint32));
+
+    const int tw = m_map->m_tileWidth >> level;
+    const int th = m_map->m_tileHeight >> level;
+    const int layers = m_map->layerCount();
+    const int first = m_baked->group(firstGroup).first;
+    const int last = m_baked->group(lastGroup).last;
+    const int tx0 = qMax(0, rect.left() / tw);
+    const int ty0 = qMax(0, rect.top() / th);
+    const int tx1 = qMin(m_map->m_mapWidth - 1, rect.right() / tw);
+    const int ty1 = qMin(m_map->m_mapHeight - 1, rect.bottom() / th);
+
+    for (int ty = ty0; ty <= ty1; ++ty)
+    {
+        for (int tx = tx0; tx <= tx1; ++tx)
+        {
+            // 与 BakedMap::collectDraws 相同：更高图层（包括范围外的）的不透明瓦片盖住下面的一切
+            int cover = first;
+            for (int l = layers - 1; l > first; --l)
+            {
+                const int gid = m_map->layer(l).data.at(tx, ty);
+                if (gid != 0 && m_baked->opacity(gid) == BakedMap::Opaque)
+                {
+                    cover = l;
+                    break;
+                }
+            }
+
+            bool started = false;
+            for (int l = first; l <= last; ++l)
+            {
+                const int gid = m_map->layer(l).data.at(tx, ty);
+                if (gid == 0)
+                    continue;
+                if (l < cover)
+                {
+                    ++m_stats.covered;
+                    continue;
+                }
+                const BakedMap::TileOpacity opacity = m_baked->opacity(gid);
+                if (opacity == BakedMap::Transparent)
+                {
+                    ++m_stats.transparent;
+                    continue;
+                }
+                ++m_stats.drawn;
+                // 格子最底下的瓦片下面是清空的缓冲区，复制和叠加结果一样
+                drawTile(frame, rect, QPoint(tx * tw, ty * th), gid, !started || opacity == BakedMap::Opaque, level);
+                started = true;
+            }
+        }
+    }
+    return frame;
+}
+
+void SoftwareRenderer::drawTile(QImage &frame, const QRect &rect, const QPoint &cellPos, int gid, bool copy, int level)
+{
+    const int tw = m_map->m_tileWidth >> level;
+    const int th = m_map->m_tileHeight >> level;
+    const int dstStride = frame.bytesPerLine() / int(sizeof(quint32));
+
+    QRect source;
+    const QImage *atlas = m_baked->tileImage(gid, &source, level);
+    if (!atlas)
+    {
+        // 与 TileScene 相同的占位色块
+        const QRect target = QRect(cellPos, QSize(tw, th)).intersected(rect);
+        const quint32 color = 0xff000000u | (quint32((gid * 37) % 255) << 16) |
+                              (quint32((gid * 61) % 255) << 8) | quint32((gid * 113) % 255);
+        for (int y = target.top(); y <= target.bottom(); ++y)
+        {
+            quint32 *line = reinterpret_cast<quint32 *>(frame.scanLine(y - rect.top())) + (target.left() - rect.left());
+            std::fill(line, line + target.width(), color);
+        }
+        return;
+    }
+
+    // 只画图块落在图片内、且不超出本格的部分（超出的部分 bake 时同样会被区块边缘裁掉）
+    const QRect valid = source.intersected(atlas->rect());
+    const QRect inCell = valid.translated(-source.topLeft()).intersected(QRect(0, 0, tw, th));
+    const QRect target = inCell.translated(cellPos).intersected(rect);
+    if (target.isEmpty())
+        return;
+
+    const QPoint srcPos = source.topLeft() + (target.topLeft() - cellPos);
+    const int srcStride = atlas->bytesPerLine() / int(sizeof(quint32));
+    const quint32 *src = reinterpret_cast<const quint32 *>(atlas->constScanLine(srcPos.y())) + srcPos.x();
+    quint32 *dst = reinterpret_cast<quint32 *>(frame.scanLine(target.top() - rect.top())) + (target.left() - rect.left());
+
+    if (target.width() == TileBlitter::TILE && target.height() == TileBlitter::TILE)
+    {
+        if (copy)
+            TileBlitter::copyTile32(dst, dstStride, src, srcStride);
+        else
+            TileBlitter::blendTile32(dst, dstStride, src, srcStride);
+        return;
+    }
+    if (copy)
+        TileBlitter::copy(dst, dstStride, src, srcStride, target.width(), target.height());
+    else
+        TileBlitter::blend(dst, dstStride, src, srcStride, target.width(), target.height());
+}
@@ -0,0 +1,43 @@
+// softwarerenderer.h - 把可见瓦片直接合成到一张帧缓冲区的软件渲染器
+#ifndef SOFTWARERENDERER_H
+#define SOFTWARERENDERER_H
+
+#include <QImage>
+#include <QRect>
+#include "bakedmap.h"
+
+class TmxMap;
+
+/*
+ SoftwareRenderer：不经过 QPainter，逐格把瓦片像素合成到一张预乘 ARGB32 的帧缓冲区
+ - 像素直接取 BakedMap 解码好的图块集，透明度分类也沿用 BakedMap：
+   每格从最上面的图层往下找第一块不透明瓦片，它下面的都不画，完全透明的瓦片跳过
+ - 每格最底下的瓦片和不透明瓦片直接复制，其余用 TileBlitter 的 SIMD 内核按 alpha 叠加；
+   32x32 的完整瓦片走专门的内核，被裁剪的边缘瓦片走通用版本
+ - 合成按场景像素 1:1，或者用 BakedMap 的缩小版图块集按 1/2^level 合成；
+   剩下的缩放留给呈现时的一次 drawImage
+ - 帧缓冲区在多次调用之间复用，只在需要更大时重新分配
+*/
+class SoftwareRenderer
+{
+public:
+    SoftwareRenderer(const TmxMap *map, BakedMap *baked);
+
+    /* 把绘制组 firstGroup..lastGroup 在场景矩形 sceneRect 内的部分合成出来。
+     level > 0 时缩小 2^level 倍合成，covered 返回图像实际覆盖的场景矩形（sceneRect 向外取整到 2^level）。
+     返回的图像引用内部缓冲区，下次调用前有效 */
+    QImage render(const QRect &sceneRect, int firstGroup, int lastGroup, int level = 0, QRect *covered = nullptr);
+
+    /* 上一次 render 贴了多少瓦片、省掉多少 */
+    const BakedMap::DrawStats &lastStats() const { return m_stats; }
+
+private:
+    void drawTile(QImage &frame, const QRect &rect, const QPoint &cellPos, int gid, bool copy, int level);
+
+    const TmxMap *m_map;
+    BakedMap *m_baked;
+    QImage m_buffer;
+    BakedMap::DrawStats m_stats;
+};
+
+#endif // SOFTWARERENDERER_H
@@ -0,0 +1,106 @@
+// spriteanimator.cpp - 精灵动画实现
+#include "spriteanimator.h"
+#include <QGraphicsPixmapItem>
+
+SpriteClips SpriteClips::columnsPerDirection(const SpriteSheet &sheet, int frameMs)
+{
+    SpriteClips clips;
+    const int columns = qMin(sheet.columns(), 4);
+    for (int d = 0; d < 4; ++d)
+    {
+        // 列不够四个方向时用第一列
+        const int column = d < columns ? d : 0;
+        clips.idle[d].frames.append(column);
+        clips.idle[d].frameMs = frameMs;
+        // 从第 1 行开始走，一起步就能看出在迈腿
+        for (int r = 1; r <= sheet.rows(); ++r)
+            clips.walk[d].frames.append((r % sheet.rows()) * sheet.columns() + column);
+        clips.walk[d].frameMs = frameMs;
+    }
+    return clips;
+}
+
+SpriteAnimator::Direction SpriteAnimator::directionOf(const QPoint &facing)
+{
+    if (facing.x() < 0) return Left;
+    if (facing.x() > 0) return Right;
+    if (facing.y() < 0) return Up;
+    return Down;
+}
+
+int SpriteAnimator::add(QGraphicsPixmapItem *item, const SpriteSheetPtr &sheet, const SpriteClips *clips)
+{
+    int handle;
+    if (!m_free.isEmpty())
+    {
+        handle = m_free.takeLast();
+    }
+    else
+    {
+        handle = m_sprites.size();
+        m_sprites.append(Sprite());
+    }
+    Sprite &s = m_sprites[handle];
+    s.item = item;
+    s.sheet = sheet;
+    s.clips = clips;
+    s.clip = &clips->idle[Down];
+    s.start = m_time;
+    s.shown = -1;
+    show(s);
+    return handle;
+}
+
+void SpriteAnimator::remove(int handle)
+{
+    if (handle < 0 || handle >= m_sprites.size() || !m_sprites[handle].item)
+        return;
+    m_sprites[handle] = Sprite();
+    m_free.append(handle);
+}
+
+void SpriteAnimator::play(int handle, Action action, Direction direction)
+{
+    if (handle < 0 || handle >= m_sprites.size() || !m_sprites[handle].item)
+        return;
+    Sprite &s = m_sprites[handle];
+    const SpriteClip *clip = action == Walk ? &s.clips->walk[direction] : &s.clips->idle[direction];
+    if (clip == s.clip)
+        return;
+    // 走路中途转向：接着原来的步子，不从头开始
+    const bool keepPhase = action == Walk && s.clip >= s.clips->walk && s.clip < s.clips->walk + 4;
+    s.clip = clip;
+    if (!keepPhase)
+        s.start = m_time;
+    show(s);
+}
+
+void SpriteAnimator::advance(int dtMs)
+{
+    m_time += dtMs;
+    for (Sprite &s : m_sprites)
+    {
+        // 只有一帧的（站立）不会变
+        if (s.item && s.clip->frames.size() > 1)
+            show(s);
+    }
+}
+
+int SpriteAnimator::frameAt(const SpriteClip &clip, qint64 start) const
+{
+    if (clip.frames.isEmpty())
+        return -1;
+    const qint64 step = qMax<qint64>(0, m_time - start) / qMax(1, clip.frameMs);
+    const int n = clip.frames.size();
+    const int index = clip.loop ? int(step % n) : int(qMin<qint64>(step, n - 1));
+    return clip.frames[index];
+}
+
+void SpriteAnimator::show(Sprite &sprite)
+{
+    const int frame = frameAt(*sprite.clip, sprite.start);
+    if (frame == sprite.shown || frame < 0 || frame >= sprite.sheet->frameCount())
+        return;
+    sprite.shown = frame;
+    sprite.item->setPixmap(sprite.sheet->frame(frame));
+}
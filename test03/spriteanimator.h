@@ -0,0 +1,78 @@
+// spriteanimator.h - 精灵动画
+#ifndef SPRITEANIMATOR_H
+#define SPRITEANIMATOR_H
+
+#include <QVector>
+#include <QPoint>
+#include "spritesheet.h"
+
+class QGraphicsPixmapItem;
+
+/* 一段动画：依次显示精灵图里的这些帧，每帧 frameMs 毫秒 */
+struct SpriteClip
+{
+    QVector<int> frames;
+    int frameMs = 120;
+    bool loop = true;
+};
+
+/* 一个角色的全部动画：站立和走路，每种四个方向，下标是 SpriteAnimator::Direction */
+struct SpriteClips
+{
+    SpriteClip idle[4];
+    SpriteClip walk[4];
+
+    /* 每一列是一个方向（下、左、右、上），每一行是一帧：第 0 行站立，整列循环就是走路 */
+    static SpriteClips columnsPerDirection(const SpriteSheet &sheet, int frameMs);
+};
+
+/*
+ SpriteAnimator：所有动画共用的一个时钟
+ - 每帧 advance 一次，按各自开始播放的时间算出当前帧；帧号变了才把帧的 QPixmap 交给图元
+   （隐式共享，只增加引用计数），没变的什么都不做
+ - 精灵放在一个连续的数组里，advance 只是顺序扫一遍，几千个也远不到一毫秒
+ - play 切换到同一段动画时不重新开始，连续走路时步子不会断
+ 图元和 SpriteClips 由调用方持有，要在 remove 之后才能释放；精灵图由动画持有引用。
+*/
+class SpriteAnimator
+{
+public:
+    enum Direction { Down, Left, Right, Up };
+    enum Action { Idle, Walk };
+
+    /* 停下来这么久才换回站立：帧和逻辑步（或快照）错开、某一步没走动时不会闪一下站立 */
+    static const int WALK_LINGER_MS = 80;
+
+    /* 朝向（格子方向）→ 精灵图方向；没有朝向时朝下 */
+    static Direction directionOf(const QPoint &facing);
+
+    /* 返回句柄；从站立朝下开始 */
+    int add(QGraphicsPixmapItem *item, const SpriteSheetPtr &sheet, const SpriteClips *clips);
+    void remove(int handle);
+    void play(int handle, Action action, Direction direction);
+
+    void advance(int dtMs);
+    qint64 time() const { return m_time; }
+    /* 从 start 开始播放的 clip 现在该显示的帧号；不经过图元成批画的精灵（别的玩家、顾客）用它跟着同一个时钟 */
+    int frameAt(const SpriteClip &clip, qint64 start = 0) const;
+    int count() const { return m_sprites.size() - m_free.size(); }
+
+private:
+    struct Sprite
+    {
+        QGraphicsPixmapItem *item = nullptr;   // 空表示这个位置空着
+        SpriteSheetPtr sheet;
+        const SpriteClips *clips = nullptr;
+        const SpriteClip *clip = nullptr;
+        qint64 start = 0;
+        int shown = -1;                        // 图元当前显示的帧号
+    };
+
+    void show(Sprite &sprite);
+
+    QVector<Sprite> m_sprites;
+    QVector<int> m_free;
+    qint64 m_time = 0;
+};
+
+#endif // SPRITEANIMATOR_H
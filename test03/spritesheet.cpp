@@ -0,0 +1,71 @@
+// spritesheet.cpp - 切好的精灵图实现
+#include "spritesheet.h"
+#include "assetpack.h"
+#include "tracing.h"
+#include <QHash>
+#include <QDebug>
+
+namespace {
+// 路径 → 正在用的精灵图；没人用了就自动失效，下次 load 重新读
+QHash<QString, QWeakPointer<const SpriteSheet>> &sheetCache()
+{
+    static QHash<QString, QWeakPointer<const SpriteSheet>> cache;
+    return cache;
+}
+}
+
+SpriteSheet::SpriteSheet(const QPixmap &pixmap, int columns, int rows)
+    : m_columns(columns),
+      m_rows(rows),
+      m_frameSize(pixmap.width() / columns, pixmap.height() / rows),
+      m_atlas(pixmap)
+{
+    m_rects.reserve(columns * rows);
+    m_frames.reserve(columns * rows);
+    for (int r = 0; r < rows; ++r)
+    {
+        for (int c = 0; c < columns; ++c)
+        {
+            const QRect rect(QPoint(c * m_frameSize.width(), r * m_frameSize.height()), m_frameSize);
+            m_rects.append(rect);
+            m_frames.append(pixmap.copy(rect));
+        }
+    }
+}
+
+SpriteSheetPtr SpriteSheet::load(const QString &path, int columns, int rows)
+{
+    TRACE_SCOPE("SpriteSheet::load");
+    const QString key = QString("%1|%2x%3").arg(path).arg(columns).arg(rows);
+    SpriteSheetPtr sheet = sheetCache().value(key).toStrongRef();
+    if (sheet)
+        return sheet;
+
+    const QPixmap pixmap = AssetPack::instance().pixmap(path);
+    if (pixmap.isNull())
+    {
+        qWarning() << "Cannot load sprite sheet" << path;
+        return SpriteSheetPtr();
+    }
+    sheet = slice(pixmap, columns, rows);
+    if (sheet)
+        sheetCache().insert(key, sheet);
+    return sheet;
+}
+
+SpriteSheetPtr SpriteSheet::fromImage(const QImage &image, int columns, int rows)
+{
+    return slice(QPixmap::fromImage(image), columns, rows);
+}
+
+SpriteSheetPtr SpriteSheet::slice(const QPixmap &pixmap, int columns, int rows)
+{
+    if (pixmap.isNull() || columns <= 0 || rows <= 0 || pixmap.width() < columns || pixmap.height() < rows)
+    {
+        qWarning() << "Invalid sprite sheet layout" << pixmap.size() << columns << rows;
+        return SpriteSheetPtr();
+    }
+    if (pixmap.width() % columns != 0 || pixmap.height() % rows != 0)
+        qWarning() << "Sprite sheet" << pixmap.size() << "does not divide evenly into" << columns << "x" << rows;
+    return SpriteSheetPtr(new SpriteSheet(pixmap, columns, rows));
+}
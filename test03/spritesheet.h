@@ -0,0 +1,50 @@
+// spritesheet.h - 切好的精灵图
+#ifndef SPRITESHEET_H
+#define SPRITESHEET_H
+
+#include <QPixmap>
+#include <QImage>
+#include <QVector>
+#include <QRectF>
+#include <QSharedPointer>
+
+class SpriteSheet;
+typedef QSharedPointer<const SpriteSheet> SpriteSheetPtr;
+
+/*
+ SpriteSheet：把一张等分成 columns × rows 格的精灵图切成帧，帧号按行优先（row * columns + column）
+ - 只在加载时切一次，每帧一个 QPixmap；动画换帧时只是把这些句柄交给图元，不再切图、不分配
+ - 同一路径的精灵图在用的时候只有一份（按路径缓存弱引用），所有角色共用
+ - 整张图也留着，成批画很多精灵时用一张图加每帧的源矩形，一次画完
+ 只能在主线程使用（QPixmap）。
+*/
+class SpriteSheet
+{
+public:
+    /* 从资源包或磁盘读；读不到返回空指针 */
+    static SpriteSheetPtr load(const QString &path, int columns, int rows);
+    /* 不经过缓存，直接切一张图（生成的图、基准测试） */
+    static SpriteSheetPtr fromImage(const QImage &image, int columns, int rows);
+
+    int columns() const { return m_columns; }
+    int rows() const { return m_rows; }
+    int frameCount() const { return m_frames.size(); }
+    QSize frameSize() const { return m_frameSize; }
+    const QPixmap &frame(int index) const { return m_frames[index]; }
+    /* 整张图和每帧在图上的位置：批量绘制（drawPixmapFragments）用 */
+    const QPixmap &atlas() const { return m_atlas; }
+    QRectF frameRect(int index) const { return m_rects[index]; }
+
+private:
+    SpriteSheet(const QPixmap &pixmap, int columns, int rows);
+    static SpriteSheetPtr slice(const QPixmap &pixmap, int columns, int rows);
+
+    int m_columns;
+    int m_rows;
+    QSize m_frameSize;
+    QPixmap m_atlas;
+    QVector<QRectF> m_rects;
+    QVector<QPixmap> m_frames;
+};
+
+#endif // SPRITESHEET_H
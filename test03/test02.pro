@@ -1,5 +1,5 @@
 # test02.pro - Qt项目文件
-QT += core gui widgets xml
+QT += core gui widgets xml concurrent network
 CONFIG += c++11
 
 TARGET = test02
@@ -8,10 +8,45 @@ TEMPLATE = app
 # 源文件
 SOURCES += \
     StartWidget.cpp \
+    assetpack.cpp \
+    bakedmap.cpp \
+    camera.cpp \
+    collision.cpp \
+    crowd.cpp \
+    crowditem.cpp \
+    entitylayer.cpp \
+    fieldofview.cpp \
+    fogofwar.cpp \
+    framebufferitem.cpp \
+    frameprofiler.cpp \
+    gameview.cpp \
+    headless.cpp \
+    hotreload.cpp \
+    inputlog.cpp \
     inventoryslot.cpp \
+    itemdatabase.cpp \
+    layerdata.cpp \
     main.cpp \
+    mapcache.cpp \
+    maplayeritem.cpp \
+    minimap.cpp \
+    mipmap.cpp \
+    netprotocol.cpp \
+    netsession.cpp \
+    profileroverlay.cpp \
+    scriptcompiler.cpp \
+    scriptvm.cpp \
+    simthread.cpp \
+    simulation.cpp \
+    softwarerenderer.cpp \
+    spriteanimator.cpp \
+    spritesheet.cpp \
+    tileblitter.cpp \
     widget.cpp \
-    tmxmap.cpp
+    tmxmap.cpp \
+    tracing.cpp \
+    world.cpp \
+    worldgenerator.cpp
 
 # 头文件
 HEADERS += \
@@ -19,9 +54,49 @@ HEADERS += \
     Item.h \
     PlayerItem.h \
     StartWidget.h \
+    assetpack.h \
+    bakedmap.h \
+    camera.h \
+    collision.h \
+    crowd.h \
+    crowditem.h \
+    entitylayer.h \
+    fieldofview.h \
+    fogofwar.h \
+    framebufferitem.h \
+    frameprofiler.h \
+    gamerandom.h \
+    gameview.h \
+    headless.h \
+    hotreload.h \
+    inputlog.h \
     inventoryslot.h \
+    itemdatabase.h \
+    layerdata.h \
+    lockfree.h \
+    mapcache.h \
+    maplayeritem.h \
+    minimap.h \
+    mipmap.h \
+    netprotocol.h \
+    netsession.h \
+    profileroverlay.h \
+    scriptcompiler.h \
+    scriptvm.h \
+    simthread.h \
+    simulation.h \
+    softwarerenderer.h \
+    spriteanimator.h \
+    spritesheet.h \
+    tileblitter.h \
     widget.h \
-    tmxmap.h
+    tmxmap.h \
+    tracing.h \
+    world.h \
+    worldgenerator.h
+
+# 时间线追踪：qmake CONFIG+=trace 时编译进来（见 tracing.h），否则 TRACE_SCOPE 展开为空
+trace: DEFINES += LZU_TRACE
 
 # 翻译文件（如果需要）
 TRANSLATIONS += test02_zh_CN.ts
@@ -33,4 +108,6 @@ FORMS +=
 QMAKE_CXXFLAGS += -std=c++11
 
 DISTFILES += \
-    E:/tiled/myexmples/c.tmx
+    E:/tiled/myexmples/c.tmx \
+    E:/tiled/myexmples/items.json \
+    E:/tiled/myexmples/mushao.lzs
@@ -0,0 +1,264 @@
+/* tileblitter.cpp - 软件瓦片合成内核实现
+每一行像素交给一个“行函数”处理，三套实现只有行函数不同：
+1. 先看这一组像素是不是全不透明（直接写入）或全为 0（跳过）——瓦片大部分像素属于这两类
+2. 剩下的按 16 位通道做 dst * (255 - alpha)，用 (t + (t >> 8) + 0x80) >> 8 近似除以 255，
+   与 Qt 的 BYTE_MUL 逐位相同，所以三套实现的结果完全一样
+*/
+#include "tileblitter.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TILEBLITTER_SSE2
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define TILEBLITTER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TILEBLITTER_TARGET_AVX2
+#endif
+
+namespace {
+typedef void (*BlendRow)(quint32 *dst, const quint32 *src, int count);
+typedef void (*BlendTile)(quint32 *dst, int dstStride, const quint32 *src, int srcStride);
+
+/* 一套实现：任意宽度的行函数 + 32x32 瓦片函数（内联行函数，宽度是常数，循环完全展开） */
+struct Kernels
+{
+    BlendRow row;
+    BlendTile tile32;
+};
+
+/* x 的每个通道乘以 a / 255（Qt 的 BYTE_MUL） */
+inline quint32 byteMul(quint32 x, quint32 a)
+{
+    quint32 t = (x & 0xff00ff) * a;
+    t = (t + ((t >> 8) & 0xff00ff) + 0x800080) >> 8;
+    t &= 0xff00ff;
+    x = ((x >> 8) & 0xff00ff) * a;
+    x = x + ((x >> 8) & 0xff00ff) + 0x800080;
+    x &= 0xff00ff00;
+    return x | t;
+}
+
+inline void blendPixel(quint32 &d, quint32 s)
+{
+    if (s >= 0xff000000u)
+        d = s;
+    else if (s != 0)
+        d = s + byteMul(d, 255 - (s >> 24));
+}
+
+inline void blendRowScalar(quint32 *dst, const quint32 *src, int count)
+{
+    for (int i = 0; i < count; ++i)
+        blendPixel(dst[i], src[i]);
+}
+
+void blendTile32Scalar(quint32 *dst, int dstStride, const quint32 *src, int srcStride)
+{
+    for (int y = 0; y < TileBlitter::TILE; ++y)
+        blendRowScalar(dst + y * dstStride, src + y * srcStride, TileBlitter::TILE);
+}
+
+#ifdef TILEBLITTER_SSE2
+/* 4 个像素的 src over dst */
+inline __m128i blend4(__m128i s, __m128i d)
+{
+    const __m128i zero = _mm_setzero_si128();
+    // 每个像素的 255 - alpha，复制到该像素的 4 个 16 位通道
+    __m128i ia = _mm_sub_epi32(_mm_set1_epi32(255), _mm_srli_epi32(s, 24));
+    ia = _mm_or_si128(ia, _mm_slli_epi32(ia, 16));
+    const __m128i iaLo = _mm_unpacklo_epi32(ia, ia);
+    const __m128i iaHi = _mm_unpackhi_epi32(ia, ia);
+
+    const __m128i bias = _mm_set1_epi16(0x80);
+    __m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), iaLo);
+    __m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), iaHi);
+    lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), bias), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), bias), 8);
+    return _mm_add_epi32(s, _mm_packus_epi16(lo, hi));
+}
+
+inline void blendRowSse2(quint32 *dst, const quint32 *src, int count)
+{
+    const __m128i alphaMask = _mm_set1_epi32(int(0xff000000u));
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(s, alphaMask), alphaMask)) == 0xffff)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), s);
+            continue;
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(s, zero)) == 0xffff)
+            continue;
+        __m128i *d = reinterpret_cast<__m128i *>(dst + i);
+        _mm_storeu_si128(d, blend4(s, _mm_loadu_si128(d)));
+    }
+    for (; i < count; ++i)
+        blendPixel(dst[i], src[i]);
+}
+
+/* 与 blend4 相同，一次 8 个像素（unpack / pack 都在各自的 128 位半边内进行，顺序一致） */
+TILEBLITTER_TARGET_AVX2 inline __m256i blend8(__m256i s, __m256i d)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i ia = _mm256_sub_epi32(_mm256_set1_epi32(255), _mm256_srli_epi32(s, 24));
+    ia = _mm256_or_si256(ia, _mm256_slli_epi32(ia, 16));
+    const __m256i iaLo = _mm256_unpacklo_epi32(ia, ia);
+    const __m256i iaHi = _mm256_unpackhi_epi32(ia, ia);
+
+    const __m256i bias = _mm256_set1_epi16(0x80);
+    __m256i lo = _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), iaLo);
+    __m256i hi = _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), iaHi);
+    lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), bias), 8);
+    hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), bias), 8);
+    return _mm256_add_epi32(s, _mm256_packus_epi16(lo, hi));
+}
+
+TILEBLITTER_TARGET_AVX2 inline void blendRowAvx2(quint32 *dst, const quint32 *src, int count)
+{
+    const __m256i alphaMask = _mm256_set1_epi32(int(0xff000000u));
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(s, alphaMask), alphaMask)) == -1)
+        {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), s);
+            continue;
+        }
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi32(s, zero)) == -1)
+            continue;
+        __m256i *d = reinterpret_cast<__m256i *>(dst + i);
+        _mm256_storeu_si256(d, blend8(s, _mm256_loadu_si256(d)));
+    }
+    for (; i < count; ++i)
+        blendPixel(dst[i], src[i]);
+}
+
+void blendTile32Sse2(quint32 *dst, int dstStride, const quint32 *src, int srcStride)
+{
+    for (int y = 0; y < TileBlitter::TILE; ++y)
+        blendRowSse2(dst + y * dstStride, src + y * srcStride, TileBlitter::TILE);
+}
+
+TILEBLITTER_TARGET_AVX2 void blendTile32Avx2(quint32 *dst, int dstStride, const quint32 *src, int srcStride)
+{
+    for (int y = 0; y < TileBlitter::TILE; ++y)
+        blendRowAvx2(dst + y * dstStride, src + y * srcStride, TileBlitter::TILE);
+}
+
+/* 行函数本身被内联进瓦片函数，任意宽度时通过函数指针调用需要一个不内联的版本 */
+void blendRowSse2Call(quint32 *dst, const quint32 *src, int count) { blendRowSse2(dst, src, count); }
+TILEBLITTER_TARGET_AVX2 void blendRowAvx2Call(quint32 *dst, const quint32 *src, int count) { blendRowAvx2(dst, src, count); }
+
+bool cpuHasAvx2()
+{
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER)
+    // 除了 CPU 支持，还要操作系统保存 YMM 寄存器（OSXSAVE + XCR0 的第 1、2 位）
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return false;
+#endif
+}
+#endif // TILEBLITTER_SSE2
+
+void blendRowScalarCall(quint32 *dst, const quint32 *src, int count) { blendRowScalar(dst, src, count); }
+
+Kernels kernelsFor(TileBlitter::Kernel kernel)
+{
+    switch (kernel)
+    {
+#ifdef TILEBLITTER_SSE2
+    case TileBlitter::Avx2: return Kernels{ blendRowAvx2Call, blendTile32Avx2 };
+    case TileBlitter::Sse2: return Kernels{ blendRowSse2Call, blendTile32Sse2 };
+#endif
+    default:                return Kernels{ blendRowScalarCall, blendTile32Scalar };
+    }
+}
+
+TileBlitter::Kernel g_kernel = TileBlitter::bestKernel();
+Kernels g_kernels = kernelsFor(g_kernel);
+}
+
+namespace TileBlitter
+{
+Kernel bestKernel()
+{
+#ifdef TILEBLITTER_SSE2
+    static const Kernel best = cpuHasAvx2() ? Avx2 : Sse2;
+    return best;
+#else
+    return Scalar;
+#endif
+}
+
+void setKernel(Kernel kernel)
+{
+    if (kernel > bestKernel())
+        kernel = bestKernel();
+    g_kernel = kernel;
+    g_kernels = kernelsFor(kernel);
+}
+
+Kernel kernel()
+{
+    return g_kernel;
+}
+
+const char *kernelName(Kernel kernel)
+{
+    switch (kernel)
+    {
+    case Avx2: return "avx2";
+    case Sse2: return "sse2";
+    default:   return "scalar";
+    }
+}
+
+void blend(quint32 *dst, int dstStride, const quint32 *src, int srcStride, int width, int height)
+{
+    const BlendRow row = g_kernels.row;
+    for (int y = 0; y < height; ++y)
+        row(dst + y * dstStride, src + y * srcStride, width);
+}
+
+void copy(quint32 *dst, int dstStride, const quint32 *src, int srcStride, int width, int height)
+{
+    for (int y = 0; y < height; ++y)
+        std::memcpy(dst + y * dstStride, src + y * srcStride, size_t(width) * sizeof(quint32));
+}
+
+void blendTile32(quint32 *dst, int dstStride, const quint32 *src, int srcStride)
+{
+    g_kernels.tile32(dst, dstStride, src, srcStride);
+}
+
+void copyTile32(quint32 *dst, int dstStride, const quint32 *src, int srcStride)
+{
+    for (int y = 0; y < TILE; ++y)
+        std::memcpy(dst + y * dstStride, src + y * srcStride, TILE * sizeof(quint32));
+}
+}
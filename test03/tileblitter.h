@@ -0,0 +1,42 @@
+// tileblitter.h - 软件瓦片合成内核
+#ifndef TILEBLITTER_H
+#define TILEBLITTER_H
+
+#include <QtGlobal>
+
+/*
+ TileBlitter：把预乘 ARGB32 的瓦片叠加（src over dst）到帧缓冲区
+ - 三套实现：AVX2（一次 8 像素）、SSE2（一次 4 像素）、标量；启动时按 CPU 选最快的一套，
+   基准程序可以用 setKernel 强制指定
+ - 4 / 8 个像素全不透明时直接写入，全透明时跳过，只有边缘像素真正做乘法
+ - 混合公式与 QPainter 的 SourceOver 相同：dst = src + dst * (255 - src.alpha) / 255
+ 步长（stride）都以像素为单位
+*/
+namespace TileBlitter
+{
+enum Kernel
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+/* 当前 CPU 支持的最快实现 */
+Kernel bestKernel();
+/* 强制使用某一套实现（CPU 不支持时退回 bestKernel） */
+void setKernel(Kernel kernel);
+Kernel kernel();
+const char *kernelName(Kernel kernel);
+
+const int TILE = 32; // blendTile32 / copyTile32 专门处理的瓦片边长
+
+/* 任意大小的矩形（裁剪过的瓦片） */
+void blend(quint32 *dst, int dstStride, const quint32 *src, int srcStride, int width, int height);
+void copy(quint32 *dst, int dstStride, const quint32 *src, int srcStride, int width, int height);
+
+/* 完整的 32x32 瓦片：循环次数固定，编译器可以完全展开 */
+void blendTile32(quint32 *dst, int dstStride, const quint32 *src, int srcStride);
+void copyTile32(quint32 *dst, int dstStride, const quint32 *src, int srcStride);
+}
+
+#endif // TILEBLITTER_H
@@ -0,0 +1,87 @@
+// tilescene.cpp - 每格一个图元的场景实现
+#include "tilescene.h"
+#include "tmxmap.h"
+#include "assetpack.h"
+#include "tracing.h"
+#include <QGraphicsPixmapItem>
+#include <QPixmap>
+#include <QPen>
+#include <QDebug>
+
+TileScene::TileScene(TmxMap *map, QObject *parent) : QObject(parent), m_map(map)
+{
+    connect(map, &TmxMap::tileChanged, this, &TileScene::onTileChanged);
+}
+
+//将各个图层的瓦片添加到场景中，并设置场景边界大小
+void TileScene::build(QGraphicsScene *scene)
+{
+    if (!scene) return;
+    TRACE_SCOPE("TileScene::build");
+
+    scene->clear();
+    m_scene = scene;
+    const int w = m_map->m_mapWidth;
+    const int h = m_map->m_mapHeight;
+    m_tileItems.fill(nullptr, m_map->layerCount() * w * h);
+    //遍历所有图层（Layer）先绘制的图层在底层（如地面,后绘制的在上层（如装饰物、角色）
+    for (int l = 0; l < m_map->layerCount(); ++l)
+    {
+        //只遍历非空瓦片（gid 为 0 表示空瓦片），稀疏图层直接跳过整块的空白
+        m_map->layer(l).data.forEachTile([&](int x, int y, int gid)
+        {
+            m_tileItems[(l * h + y) * w + x] = addTileItem(l, x, y, gid);
+        });
+    }
+
+    // 设置场景大小
+    scene->setSceneRect(0, 0, w * m_map->m_tileWidth, h * m_map->m_tileHeight);
+}
+
+void TileScene::onTileChanged(int layerIndex, int tileX, int tileY, int gid)
+{
+    // 场景已建立时只替换这一个格子的图元
+    const int itemIndex = (layerIndex * m_map->m_mapHeight + tileY) * m_map->m_mapWidth + tileX;
+    if (!m_scene || itemIndex >= m_tileItems.size())
+        return;
+    delete m_tileItems[itemIndex];
+    m_tileItems[itemIndex] = gid ? addTileItem(layerIndex, tileX, tileY, gid) : nullptr;
+}
+
+QGraphicsItem *TileScene::addTileItem(int layerIndex, int tileX, int tileY, int gid)
+{
+    const Tile *t = m_map->findTile(gid);
+    if (!t) {
+        qWarning() << "Tile ID not found:" << gid;
+        return nullptr;
+    }
+
+    const int tw = m_map->m_tileWidth;
+    const int th = m_map->m_tileHeight;
+    // 加载瓦片图片并裁剪
+    QString imagePath = m_map->resolvePath(t->image);
+    //从指定的文件路径 imagePath 加载一张图像，并将其存储在 QPixmap 对象 tilePixmap 中，供后续绘制使用。
+    QPixmap tilePixmap = AssetPack::instance().pixmap(imagePath);
+
+    QGraphicsItem *item;
+    if (tilePixmap.isNull()) {
+        qWarning() << "Cannot load image:" << imagePath;
+        // 如果图片加载失败，绘制一个彩色矩形作为占位符
+        item = m_scene->addRect(
+            tileX * tw, tileY * th, tw, th,
+            QPen(Qt::black),
+            QColor((gid * 37) % 255, (gid * 61) % 255, (gid * 113) % 255)
+        );
+    } else {
+        // 从图块集中裁剪出指定瓦片
+        //t->source 是一个 QRect，表示该瓦片在大图中的位置和尺寸（如 (32, 0, 32, 32)）
+        //copy() 提取子图像
+        QPixmap subPixmap = tilePixmap.copy(t->source);
+        //添加到场景并定位
+        item = m_scene->addPixmap(subPixmap);
+        item->setPos(tileX * tw, tileY * th);
+    }
+    // 图层顺序由 z 值保证，之后替换的图元也不会跑到上层图层之上
+    item->setZValue(layerIndex);
+    return item;
+}
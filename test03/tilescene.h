@@ -0,0 +1,39 @@
+// tilescene.h - 把 TmxMap 画成每格一个图元的场景
+#ifndef TILESCENE_H
+#define TILESCENE_H
+
+#include <QObject>
+#include <QVector>
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+
+class TmxMap;
+
+/*
+ TileScene：最早的绘制方式，每个非空格子一个 QGraphicsPixmapItem，z 值为图层序号
+ 游戏已经改用烘焙区块（BakedMap），这里留给基准程序和简单的工具。
+ 从 TmxMap 里分出来以后，地图数据本身不再依赖 QPixmap 和场景，无界面模式只用得到数据部分
+ - build() 之后跟着 TmxMap::tileChanged 只替换改到的那个格子的图元
+ - scene 被别处 clear()、或者地图重新 load() 以后，记下的图元失效，必须重新 build()
+*/
+class TileScene : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TileScene(TmxMap *map, QObject *parent = nullptr);
+
+    /* 清空 scene，把地图的所有图层画上去，并设置场景边界 */
+    void build(QGraphicsScene *scene);
+
+private:
+    void onTileChanged(int layerIndex, int tileX, int tileY, int gid);
+    /* 为一个格子创建图元并加到场景中；gid 找不到时返回 nullptr */
+    QGraphicsItem *addTileItem(int layerIndex, int tileX, int tileY, int gid);
+
+    TmxMap *m_map;
+    QGraphicsScene *m_scene = nullptr;
+    /* 下标 layerIndex * 宽 * 高 + y * 宽 + x */
+    QVector<QGraphicsItem *> m_tileItems;
+};
+
+#endif // TILESCENE_H
@@ -1,21 +1,25 @@
 /* tmxmap.cpp - 地图解析器实现
 解析图块集 → 构建 m_tiles（GID → 图像裁剪位置）
 解析图层 → 构建 m_layers（每层的 GID 网格）
-buildScene() → 遍历每层，查 GID，贴图，叠加
+只有数据，不碰 QPixmap 和场景（画成图元见 tilescene.h，烘焙区块见 bakedmap.h），无界面模式也能用
 */
 #include "tmxmap.h"
 #include <QFile>
 #include <QTextStream>
 #include <QDebug>
 #include <QDir>
+#include <QPolygonF>
+#include "assetpack.h"
+#include "tracing.h"
 
 TmxMap::TmxMap(QObject *parent) : QObject(parent) {}
 
 bool TmxMap::load(const QString &fileName)
 {
-    QFile file(fileName);
-    //只读模式+文本模式
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+    TRACE_SCOPE("TmxMap::load");
+    // 通过资源包读取（资源包里没有时读磁盘上的文件），内容直接指向映射内存，不拷贝
+    const QByteArray file = AssetPack::instance().data(fileName);
+    if (file.isNull())
     {
         qWarning() << "Cannot open" << fileName;
         return false;
@@ -23,25 +27,31 @@ bool TmxMap::load(const QString &fileName)
 
     // 获取文件所在目录(不包括文件名本身)，用于解析相对路径
     m_basePath = QFileInfo(fileName).absolutePath();
+    clear(); // 同一个 TmxMap 可以重复加载
+    m_sourceFiles.append(QFileInfo(fileName).absoluteFilePath());
 
 
     /*
       整个部分的作用:把打开的TMX文件解析成qt能操作的XML文件
       QDomDocument doc;
       这里创建了一个QDomDocument对象doc。用于存储和操作解析后的XML文件。QDomDocument是Qt框架中用于处理XML文档的类，它提供了对XML文档进行操作的方法。
-      doc.setContent(&file, &err, &el, &ec)：从打开的文件对象 file 中读取内容，并解析为 XML 结构；
+      doc.setContent(file, &err, &el, &ec)：把读到的文件内容 file 解析为 XML 结构；
       QString err; int el, ec;
       定义了三个变量：err是一个QString类型的变量，用来存储可能出现的错误信息；el和ec是两个整数类型的变量，分别代表错误发生的行号（line）和列号（column）。
     */
     QDomDocument doc;
     QString err;
     int el, ec;
-    if (!doc.setContent(&file, &err, &el, &ec))
+    bool parsed;
+    {
+        TRACE_SCOPE("TmxMap::parseXml");
+        parsed = doc.setContent(file, &err, &el, &ec);
+    }
+    if (!parsed)
     {
         qWarning() << "XML error:" << err << "at" << el << ec;
         return false;
     }
-    file.close();
 
     /*
     整个部分作用:确保当前文件是标准的 TMX 文件，而非其他 XML 文件；
@@ -114,6 +124,22 @@ bool TmxMap::load(const QString &fileName)
             return false;
     }
 
+    /* 4. 实体层
+    Tiled 里第一个对象层（<objectgroup>）的位置就是玩家和 NPC 所在的位置，
+    它之前的瓦片图层画在实体下面，之后的（屋顶、树冠）画在实体上面；没有对象层时全部在下面
+    */
+    int below = 0;
+    for (QDomElement e = root.firstChildElement(); !e.isNull(); e = e.nextSiblingElement())
+    {
+        if (e.tagName() == "objectgroup")
+        {
+            m_entityLayerIndex = below;
+            break;
+        }
+        if (e.tagName() == "layer")
+            ++below;
+    }
+
     qDebug() << "Successfully loaded map:" << m_mapWidth << "x" << m_mapHeight
              << "with" << m_layers.size() << "layers and" << m_tiles.size() << "tiles";
     return true;
@@ -124,6 +150,7 @@ bool TmxMap::load(const QString &fileName)
 //为后续地图渲染提供“GID → 图像裁剪位置”的映射基础
 bool TmxMap::parseTileset(const QDomElement &ts)
 {
+    TRACE_SCOPE("TmxMap::parseTileset");
     //firstgid 是 Tiled 的关键属性，表示这个图块集的第一个瓦片的全局 ID（GID）
     int firstGid = ts.attribute("firstgid").toInt();
 
@@ -145,22 +172,22 @@ bool TmxMap::parseTileset(const QDomElement &ts)
         获取根元素（即 <tileset>）
         调用 parseInlineTileset ——
         */
-        QFile tsx(tsxFile);
-        if (!tsx.open(QIODevice::ReadOnly | QIODevice::Text))
+        const QByteArray tsx = AssetPack::instance().data(tsxFile);
+        if (tsx.isNull())
         {
             qWarning() << "Cannot open external tsx:" << tsxFile;
             return false;
         }
         //XML 文档对象。
         QDomDocument tsxDoc;
-       // 从已打开的 QFile 对象 tsx 中读取数据，并尝试解析为 XML 文档。
-        if (!tsxDoc.setContent(&tsx))
+       // 把读到的 tsx 内容解析为 XML 文档。
+        if (!tsxDoc.setContent(tsx))
         {
             qWarning() << "Invalid tsx XML";
             return false;
         }
-        tsx.close();
         //根据解析后的XML文档，为每个瓦片分配GID
+        m_sourceFiles.append(tsxFile);
         return parseInlineTileset(tsxDoc.documentElement(), firstGid);
     }
 
@@ -180,6 +207,7 @@ bool TmxMap::parseTileset(const QDomElement &ts)
 */
 bool TmxMap::parseLayer(const QDomElement &layerElem)
 {
+    TRACE_SCOPE("TmxMap::parseLayer");
     Layer lay;
     lay.name = layerElem.attribute("name");
     lay.width = layerElem.attribute("width").toInt();
@@ -208,7 +236,8 @@ bool TmxMap::parseLayer(const QDomElement &layerElem)
         return false;
     }
 
-    lay.data.reserve(tiles.size());
+    QVector<int> gids;
+    gids.reserve(tiles.size());
     for (const QString &s : tiles)
     {
         bool ok;
@@ -217,89 +246,106 @@ bool TmxMap::parseLayer(const QDomElement &layerElem)
             qWarning() << "Invalid tile ID in layer" << lay.name << ":" << s;
             return false;
         }
-        lay.data.append(gid);
+        gids.append(gid);
     }
-    if (lay.name == "Obstacle") //障碍物层
+    lay.data = LayerData(lay.width, lay.height, gids);
+
+    // 图层自定义属性：布尔属性 dynamic=true 表示运行时会变化
+    const QDomElement props = layerElem.firstChildElement("properties");
+    for (QDomElement p = props.firstChildElement("property"); !p.isNull(); p = p.nextSiblingElement("property"))
     {
-        m_obstacleLayerIndex = m_layers.size(); // 记录当前图层索引
+        if (p.attribute("name") == "dynamic")
+            lay.dynamic = p.attribute("value") == "true";
     }
-
-    m_layers.append(lay);
-    return true;
+    return addLayer(lay);
 }
 
+void TmxMap::clear()
+{
+    m_tiles.clear();
+    m_layers.clear();
+    m_obstacleLayerIndex = -1;
+    m_entityLayerIndex = -1;
+    m_sourceFiles.clear();
+}
 
-//将各个图层的瓦片添加到场景中，并设置场景边界大小
-void TmxMap::buildScene(QGraphicsScene *scene)
+void TmxMap::create(int mapWidth, int mapHeight, int tileWidth, int tileHeight, const QString &basePath)
 {
-    if (!scene) return;
+    clear();
+    m_mapWidth = mapWidth;
+    m_mapHeight = mapHeight;
+    m_tileWidth = tileWidth;
+    m_tileHeight = tileHeight;
+    m_basePath = basePath;
+}
 
-    scene->clear();
-    //遍历所有图层（Layer）先绘制的图层在底层（如地面,后绘制的在上层（如装饰物、角色）
-    for (const Layer &lay : m_layers)
+bool TmxMap::addLayer(const Layer &layer)
+{
+    if (layer.width != m_mapWidth || layer.height != m_mapHeight ||
+        layer.data.size() != layer.width * layer.height)
     {
-        for (int y = 0; y < lay.height; ++y)
-        {
-            for (int x = 0; x < lay.width; ++x)
-            {
-                //获取图层中每一个瓦片的gid
-                int gid = lay.data[y * lay.width + x];
-                if (gid == 0) continue;   // 0 表示空瓦片
-
-                const Tile *t = nullptr;
-                //通过gid在瓦片集中寻找对应的瓦片
-                for (const Tile &tile : m_tiles) {
-                    if (tile.id == gid) {
-                        t = &tile;
-                        break;
-                    }
-                }
+        qWarning() << "Layer dimensions mismatch:" << layer.name;
+        return false;
+    }
 
-                if (!t) {
-                    qWarning() << "Tile ID not found:" << gid;
-                    continue;
-               }
+    if (layer.name == "Obstacle") //障碍物层
+    {
+        m_obstacleLayerIndex = m_layers.size(); // 记录当前图层索引
+    }
 
-                // 加载瓦片图片并裁剪
-                QString imagePath = t->image;
-                //路径检查
-                if (!imagePath.startsWith(":/") && !imagePath.startsWith("/")) {
-                    imagePath = QDir(m_basePath).absoluteFilePath(imagePath);
-                }
-                //从指定的文件路径 imagePath 加载一张图像，并将其存储在 QPixmap 对象 tilePixmap 中，供后续绘制使用。
-                QPixmap tilePixmap(imagePath);
-
-                if (tilePixmap.isNull()) {
-                    qWarning() << "Cannot load image:" << imagePath;
-                    // 如果图片加载失败，绘制一个彩色矩形作为占位符
-                    QGraphicsRectItem *item = scene->addRect(
-                        x * m_tileWidth, y * m_tileHeight,
-                        m_tileWidth, m_tileHeight,
-                        QPen(Qt::black),
-                        QColor((gid * 37) % 255, (gid * 61) % 255, (gid * 113) % 255)
-                    );
-                    continue;
-                }
+    m_layers.append(layer);
+    return true;
+}
 
-                // 从图块集中裁剪出指定瓦片
-                //t->source 是一个 QRect，表示该瓦片在大图中的位置和尺寸（如 (32, 0, 32, 32)）
-                //copy() 提取子图像
-                QPixmap subPixmap = tilePixmap.copy(t->source);
-                //添加到场景并定位
-                QGraphicsPixmapItem *item = scene->addPixmap(subPixmap);
-                item->setPos(x * m_tileWidth, y * m_tileHeight);
-            }
-        }
+const Tile *TmxMap::findTile(int gid) const
+{
+    //通过gid在瓦片集中寻找对应的瓦片
+    for (const Tile &tile : m_tiles) {
+        if (tile.id == gid)
+            return &tile;
     }
+    return nullptr;
+}
 
-    // 设置场景大小
-    scene->setSceneRect(0, 0, m_mapWidth * m_tileWidth, m_mapHeight * m_tileHeight);
+QString TmxMap::resolvePath(const QString &path) const
+{
+    //路径检查
+    if (!path.startsWith(":/") && !path.startsWith("/"))
+        return QDir(m_basePath).absoluteFilePath(path);
+    return path;
 }
 
+int TmxMap::tileAt(int layerIndex, int tileX, int tileY) const
+{
+    if (layerIndex < 0 || layerIndex >= m_layers.size() ||
+        tileX < 0 || tileX >= m_mapWidth || tileY < 0 || tileY >= m_mapHeight)
+    {
+        return 0;
+    }
+    return m_layers[layerIndex].data.at(tileX, tileY);
+}
+
+bool TmxMap::setTile(int layerIndex, int tileX, int tileY, int gid)
+{
+    if (layerIndex < 0 || layerIndex >= m_layers.size() ||
+        tileX < 0 || tileX >= m_mapWidth || tileY < 0 || tileY >= m_mapHeight)
+    {
+        qWarning() << "setTile out of range:" << layerIndex << tileX << tileY;
+        return false;
+    }
+
+    LayerData &data = m_layers[layerIndex].data;
+    if (data.at(tileX, tileY) == gid)
+        return true;
+    data.set(tileX, tileY, gid);
+    emit tileChanged(layerIndex, tileX, tileY, gid);
+    return true;
+}
 
 //解析一个内联（或已加载的外部）图块集（tileset）XML 元素，并为每个瓦片分配 GID 和裁剪区域
 bool TmxMap::parseInlineTileset(const QDomElement &tilesetElem, int firstGid)
 {
+    TRACE_SCOPE("TmxMap::parseInlineTileset");
     int tw = tilesetElem.attribute("tilewidth").toInt();
     int th = tilesetElem.attribute("tileheight").toInt();
     int columns = tilesetElem.attribute("columns").toInt();
@@ -324,28 +370,77 @@ bool TmxMap::parseInlineTileset(const QDomElement &tilesetElem, int firstGid)
 
     if (columns <= 0) {
         // 如果没有columns属性，根据图像尺寸计算
-        QPixmap tempPixmap(imgPath);
-        if (!tempPixmap.isNull()) {
-            columns = tempPixmap.width() / tw;
+        // 只读图片头得到尺寸；可以在后台线程使用（QPixmap 不行）
+        QSize imageSize = AssetPack::instance().imageSize(resolvePath(imgPath));
+        if (imageSize.isValid()) {
+            columns = imageSize.width() / tw;
         } else {
             // 如果图片加载失败，使用默认值
             columns = 10; // 假设默认有10列
         }
     }
 
+    if (!addTileset(imgPath, firstGid, tw, th, columns, tileCount))
+        return false;
+
+    // 瓦片的碰撞形状：<tile id="N"><objectgroup><object .../></objectgroup></tile>
+    // 矩形和椭圆用 x/y/width/height，多边形和折线取外接矩形，点忽略
+    const int base = m_tiles.size() - tileCount;
+    for (QDomElement tileElem = tilesetElem.firstChildElement("tile"); !tileElem.isNull();
+         tileElem = tileElem.nextSiblingElement("tile")) {
+        const int id = tileElem.attribute("id").toInt();
+        if (id < 0 || id >= tileCount)
+            continue;
+        const QDomElement group = tileElem.firstChildElement("objectgroup");
+        for (QDomElement obj = group.firstChildElement("object"); !obj.isNull();
+             obj = obj.nextSiblingElement("object")) {
+            const QPointF origin(obj.attribute("x").toDouble(), obj.attribute("y").toDouble());
+            QRectF box(origin, QSizeF(obj.attribute("width").toDouble(), obj.attribute("height").toDouble()));
+            QDomElement points = obj.firstChildElement("polygon");
+            if (points.isNull())
+                points = obj.firstChildElement("polyline");
+            if (!points.isNull()) {
+                QPolygonF polygon;
+                for (const QString &pair : points.attribute("points").split(' ', QString::SkipEmptyParts)) {
+                    const QStringList xy = pair.split(',');
+                    if (xy.size() == 2)
+                        polygon.append(origin + QPointF(xy[0].toDouble(), xy[1].toDouble()));
+                }
+                box = polygon.boundingRect();
+            }
+            if (box.width() > 0 && box.height() > 0)
+                m_tiles[base + id].collision.append(box);
+        }
+    }
+    if (!m_sourceFiles.contains(resolvePath(imgPath)))
+        m_sourceFiles.append(resolvePath(imgPath));
+
+    qDebug() << "Loaded tileset with" << tileCount << "tiles from" << imgPath;
+    return true;
+}
+//为图块集中的每个瓦片分配 GID 和裁剪区域
+bool TmxMap::addTileset(const QString &image, int firstGid, int tileWidth, int tileHeight,
+                        int columns, int tileCount)
+{
+    if (tileWidth <= 0 || tileHeight <= 0 || columns <= 0 || tileCount <= 0)
+    {
+        qWarning() << "Invalid tileset dimensions";
+        return false;
+    }
+
+    m_tiles.reserve(m_tiles.size() + tileCount);
     for (int i = 0; i < tileCount; ++i) {
         Tile t;
         t.id = firstGid + i;
-        t.image = imgPath;
+        t.image = image;
         int row = i / columns;
         int col = i % columns;
-        t.source = QRect(col * tw, row * th, tw, th);
+        t.source = QRect(col * tileWidth, row * tileHeight, tileWidth, tileHeight);
         m_tiles.append(t);
     }
-
-    qDebug() << "Loaded tileset with" << tileCount << "tiles from" << imgPath;
     return true;
 }
+
 /*
  判断障碍物的接口
 */
@@ -365,8 +460,7 @@ bool TmxMap::isObstacle(int tileX, int tileY) const
 
     // 3. 获取障碍物图层的数据
     const Layer &obstacleLayer = m_layers[m_obstacleLayerIndex];
-    // 4. 计算该瓦片在图层数据中的索引（data 是一维数组，存储顺序：行优先）
-    int index = tileY * obstacleLayer.width + tileX;
-    // 5. GID != 0 → 该位置有障碍物瓦片（Tiled 中绘制的瓦片 GID 不为 0）
-    return obstacleLayer.data[index] != 0;
+    // 4. GID != 0 → 该位置有障碍物瓦片（Tiled 中绘制的瓦片 GID 不为 0）
+    //    障碍物层大多是空的，一般是稀疏存储：空块直接返回 0
+    return obstacleLayer.data.at(tileX, tileY) != 0;
 }
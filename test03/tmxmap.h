@@ -5,12 +5,13 @@
 #include <QObject>
 #include <QVector>
 #include <QDomDocument>
-#include <QGraphicsScene>
-#include <QGraphicsPixmapItem>
-#include <QPixmap>
+#include <QRect>
+#include <QRectF>
+#include <QStringList>
 #include <QDir>
 #include <QFileInfo>
 #include <QDebug>
+#include "layerdata.h"
 
 /* 单个瓦片信息 */
 struct Tile
@@ -18,6 +19,7 @@ struct Tile
     int id;          // 全局 GID（Global ID）
     QRect source;    // 在图块集图片中的裁剪区域（x, y, w, h）
     QString image;   // 图块集图片路径（如 "tiles.png"）
+    QVector<QRectF> collision; // 瓦片内的碰撞框（像素），来自图块集里这个瓦片的 <objectgroup>
 };
 
 /* 一个图层 */
@@ -26,33 +28,64 @@ struct Layer
     QString name;
     int width;
     int height;
-    QVector<int> data;
-    /* data 存储的是每个格子的 GID
-    顺序是：
+    LayerData data;
+    bool dynamic = false; // 运行时会变化（门、机关……），烘焙时不与其他图层合并
+    /* data 存储的是每个格子的 GID，用 data.at(x, y) 读取
+    格子宽度（1/2/4 字节）和稠密 / 稀疏存储由 LayerData 按内容自动选择，
+    需要行优先的普通数组时用 data.toVector()：
     [ (0,0), (1,0), ..., (width-1,0), (0,1), (1,1), ... ]
-    所以 (x, y) 对应的索引是：y * width + x
     */
 };
 
 class TmxMap : public QObject
 {
     Q_OBJECT
+    friend class MapBenchmark; // 基准程序直接测试私有的解析函数
 public:
     explicit TmxMap(QObject *parent = nullptr);
 
     /* 解析 .tmx 文件，返回 true 表示成功 */
     bool load(const QString &fileName);
 
-    /* 把解析结果画到 scene 上 */
-    void buildScene(QGraphicsScene *scene);
+    /* 不经过 XML 直接建立一张空地图（程序化生成时使用），之后用 addTileset / addLayer 填充 */
+    void create(int mapWidth, int mapHeight, int tileWidth, int tileHeight, const QString &basePath);
+    /* 添加图块集：image 为图块集图片路径（相对路径相对于地图目录） */
+    bool addTileset(const QString &image, int firstGid, int tileWidth, int tileHeight,
+                    int columns, int tileCount);
+    /* 添加图层：尺寸必须与地图一致，名为 "Obstacle" 的图层作为障碍物层 */
+    bool addLayer(const Layer &layer);
+
     /*检测瓦片是否为障碍物*/
     bool isObstacle(int tileX, int tileY) const;
+
+    /* 读取 / 修改某个图层上的瓦片（gid 为 0 表示清空）
+    修改后发出 tileChanged 信号，画面（区块、TileScene 的图元）跟着它更新 */
+    int tileAt(int layerIndex, int tileX, int tileY) const;
+    bool setTile(int layerIndex, int tileX, int tileY, int gid);
+    int layerCount() const { return m_layers.size(); }
+    const Layer &layer(int index) const { return m_layers[index]; }
+
+    const QVector<Tile> &tiles() const { return m_tiles; }
+    /* 按 GID 查找瓦片，找不到返回 nullptr */
+    const Tile *findTile(int gid) const;
+    /* 图块集图片的实际路径（相对路径相对于地图目录） */
+    QString resolvePath(const QString &path) const;
+    /* 地图所在目录（生成的地图为 create 时传入的目录，可能为空） */
+    QString basePath() const { return m_basePath; }
+    /* load() 读过的所有文件：TMX、外部 TSX 和图块集图片（绝对路径），热重载时监视它们 */
+    const QStringList &sourceFiles() const { return m_sourceFiles; }
+    int obstacleLayerIndex() const { return m_obstacleLayerIndex; }
+    /* 实体（玩家、NPC）所在的位置：下标小于它的图层画在实体下面，其余画在实体上面 */
+    int entityLayerIndex() const { return m_entityLayerIndex < 0 ? m_layers.size() : m_entityLayerIndex; }
     // 添加公共成员变量，以便在widget.cpp中访问
     int m_tileWidth = 0;
     int m_tileHeight = 0;
     int m_mapWidth = 0;
     int m_mapHeight = 0;
 
+signals:
+    void tileChanged(int layerIndex, int tileX, int tileY, int gid);
+
 private:
     /* 解析图块集（仅支持单个外部 TSX）
     图块集 = 一张大图 + 瓦片定义
@@ -76,13 +109,17 @@ private:
 
     /* 解析内联图块集 */
     bool parseInlineTileset(const QDomElement &elem, int firstGid);
+    /* 清空已加载的图块集和图层 */
+    void clear();
     //把瓦片存在m_tiles容器，图层存在m_layers容器
     QVector<Tile> m_tiles;     // 全局 id -> Tile
     QVector<Layer> m_layers;
 
     QString m_basePath;// TMX文件所在目录，用于相对路径解析
+    QStringList m_sourceFiles;
     /*记录障碍物图层的索引*/
     int m_obstacleLayerIndex = -1;//障碍物图层的索引
+    int m_entityLayerIndex = -1;  // -1 表示没有对象层，所有图层都在实体下面
 };
 
 #endif // TMXMAP_H
@@ -0,0 +1,176 @@
+/* tracing.cpp - 时间线追踪的实现
+记录流程：
+1. TRACE_SCOPE 析构时调用 record()，写进当前线程自己的环形缓冲区，再用 release 发布写入计数
+2. writeJson() 先读计数、拷出最近的条目、再读一次计数，拷贝期间被覆盖的条目丢掉
+3. 输出 Chrome trace-event 格式：每段一个 "ph":"X"（完整事件，ts / dur 为微秒，保留到纳秒），
+   每个线程一条 thread_name 元数据
+*/
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QThread>
+#include <QFile>
+#include <QMutexLocker>
+#include <QDebug>
+#include <QtAlgorithms>
+
+namespace {
+const int TRACE_PID = 1;
+
+/* 微秒，小数点后三位就是纳秒 */
+QByteArray micros(qint64 ns)
+{
+    return QByteArray::number(double(ns) / 1000.0, 'f', 3);
+}
+
+QByteArray jsonString(const QString &text)
+{
+    QByteArray out = "\"";
+    for (const char c : text.toUtf8())
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        if (uchar(c) < 0x20)
+            out += ' ';
+        else
+            out += c;
+    }
+    out += '"';
+    return out;
+}
+}
+
+QAtomicInteger<int> Tracer::s_enabled(0);
+thread_local Tracer::Buffer *Tracer::s_threadBuffer = nullptr;
+
+Tracer &Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer()
+{
+    m_clock.start();
+}
+
+Tracer::~Tracer()
+{
+    qDeleteAll(m_buffers);
+}
+
+bool Tracer::compiledIn()
+{
+#ifdef LZU_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Tracer::start()
+{
+    if (!compiledIn())
+    {
+        qWarning() << "Tracing is not compiled in (build with qmake CONFIG+=trace)";
+        return false;
+    }
+    s_enabled.storeRelease(1);
+    return true;
+}
+
+void Tracer::stop()
+{
+    s_enabled.storeRelease(0);
+}
+
+/* 线程第一次记录时才分配；缓冲区一直留着，线程结束后照样能导出 */
+Tracer::Buffer *Tracer::threadBuffer()
+{
+    Buffer *b = new Buffer;
+    b->events.resize(EVENTS_PER_THREAD);
+    QThread *thread = QThread::currentThread();
+    QCoreApplication *app = QCoreApplication::instance();
+    b->threadName = app && thread == app->thread() ? QString("main") : thread->objectName();
+
+    QMutexLocker lock(&m_mutex);
+    b->tid = m_buffers.size() + 1;
+    if (b->threadName.isEmpty())
+        b->threadName = QString("thread %1").arg(b->tid);
+    m_buffers.append(b);
+    s_threadBuffer = b;
+    return b;
+}
+
+void Tracer::record(const char *name, qint64 startNs, qint64 endNs)
+{
+    Buffer *b = s_threadBuffer ? s_threadBuffer : threadBuffer();
+    const quint64 n = b->written.loadAcquire();   // 只有本线程写这个计数
+    Event &e = b->events[int(n & (EVENTS_PER_THREAD - 1))];
+    e.name = name;
+    e.startNs = startNs;
+    e.durationNs = endNs - startNs;
+    b->written.storeRelease(n + 1);
+}
+
+bool Tracer::writeJson(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Cannot write trace:" << fileName;
+        return false;
+    }
+
+    QVector<Buffer *> buffers;
+    {
+        QMutexLocker lock(&m_mutex);
+        buffers = m_buffers;
+    }
+
+    const quint64 capacity = EVENTS_PER_THREAD;
+    QByteArray out;
+    out.reserve(1 << 20);
+    out += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + QByteArray::number(TRACE_PID)
+            + ",\"args\":{\"name\":" + jsonString(QCoreApplication::applicationName()) + "}}";
+    qint64 total = 0;
+    quint64 dropped = 0;
+    for (const Buffer *b : buffers)
+    {
+        const QByteArray ids = ",\"pid\":" + QByteArray::number(TRACE_PID) + ",\"tid\":" + QByteArray::number(b->tid);
+        out += ",\n{\"name\":\"thread_name\",\"ph\":\"M\"" + ids
+                + ",\"args\":{\"name\":" + jsonString(b->threadName) + "}}";
+
+        const quint64 end = b->written.loadAcquire();
+        const quint64 begin = end > capacity ? end - capacity : 0;
+        QVector<Event> events;
+        events.reserve(int(end - begin));
+        for (quint64 i = begin; i < end; ++i)
+            events.append(b->events[int(i & (capacity - 1))]);
+        // 拷贝期间这个线程又写了的话，开头那几条已经（或正在）被覆盖
+        const quint64 after = b->written.loadAcquire();
+        const quint64 valid = after == end ? begin : after >= capacity ? after - capacity + 1 : 0;
+        const int skip = valid > begin ? int(qMin(valid - begin, end - begin)) : 0;
+        dropped += qMax(begin, valid);
+
+        for (int i = skip; i < events.size(); ++i)
+        {
+            const Event &e = events[i];
+            out += ",\n{\"name\":\"";
+            out += e.name;
+            out += "\",\"cat\":\"lzu\",\"ph\":\"X\",\"ts\":" + micros(e.startNs)
+                    + ",\"dur\":" + micros(e.durationNs) + ids + '}';
+        }
+        total += events.size() - skip;
+    }
+    out += "\n]}\n";
+
+    if (file.write(out) != out.size())
+    {
+        qWarning() << "Cannot write trace:" << fileName << file.errorString();
+        return false;
+    }
+    qDebug() << "Wrote" << total << "trace events from" << buffers.size() << "threads to" << fileName
+             << "(" << dropped << "overwritten)";
+    return true;
+}
@@ -0,0 +1,100 @@
+// tracing.h - 加载和逐帧阶段的时间线追踪（导出 Chrome trace-event JSON）
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QString>
+#include <QVector>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QAtomicInteger>
+
+/*
+ Tracer：记录每一段 TRACE_SCOPE 的开始时间和耗时（纳秒），导出成 Chrome 的 trace-event JSON，
+ 用 Perfetto（ui.perfetto.dev）或 chrome://tracing 打开，按线程看出启动和每一帧的时间花在哪里。
+ 和 FrameProfiler 的区别：FrameProfiler 只按子系统累加每帧的总数，这里留下每一段的时间线。
+ - 编译开关：qmake CONFIG+=trace（定义 LZU_TRACE）。没定义时 TRACE_SCOPE 展开为空，一条指令也不多
+ - 编进去以后，start() 之前每个 TRACE_SCOPE 只多读一个原子整数
+ - 每个线程第一次记录时分到自己的环形缓冲区（EVENTS_PER_THREAD 条），写入不加锁；
+   写满后覆盖最老的，导出时报告丢了多少条。缓冲区归 Tracer 所有，线程结束后记录还在
+ - 名字只能是字符串字面量（只存指针）
+*/
+class Tracer
+{
+public:
+    static const int EVENTS_PER_THREAD = 1 << 16;   // 每条 24 字节，一个线程 1.5 MB
+
+    static Tracer &instance();
+
+    /* 编译时是否带着追踪（LZU_TRACE） */
+    static bool compiledIn();
+    static bool enabled() { return s_enabled.loadAcquire() != 0; }
+
+    /* 开始 / 停止记录；没有编译进来时 start() 警告并返回 false */
+    bool start();
+    void stop();
+
+    /* 所有线程到目前为止的记录写成 trace-event JSON；记录中的线程照常写，正被覆盖的几条会跳过 */
+    bool writeJson(const QString &fileName) const;
+
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+    /* 由 TraceScope 调用：把一段记到当前线程的缓冲区 */
+    void record(const char *name, qint64 startNs, qint64 endNs);
+
+private:
+    struct Event
+    {
+        const char *name;
+        qint64 startNs;
+        qint64 durationNs;
+    };
+
+    /* 一个线程的环形缓冲区：只有这个线程写，written 之前的条目（最近 EVENTS_PER_THREAD 条）可读 */
+    struct Buffer
+    {
+        QVector<Event> events;
+        QAtomicInteger<quint64> written;
+        int tid = 0;
+        QString threadName;
+    };
+
+    Tracer();
+    ~Tracer();
+    Buffer *threadBuffer();
+
+    static QAtomicInteger<int> s_enabled;
+    static thread_local Buffer *s_threadBuffer;   // 当前线程的缓冲区，第一次记录前为 nullptr
+    QElapsedTimer m_clock;
+    mutable QMutex m_mutex;     // 只保护 m_buffers 列表本身，线程第一次记录和导出时才用
+    QVector<Buffer *> m_buffers;
+};
+
+/* 作用域追踪：构造时记下时间，析构时记一段；没有 start() 时什么都不做 */
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name)
+        : m_name(name), m_start(Tracer::enabled() ? Tracer::instance().now() : -1) {}
+    ~TraceScope()
+    {
+        if (m_start >= 0)
+        {
+            Tracer &t = Tracer::instance();
+            t.record(m_name, m_start, t.now());
+        }
+    }
+
+private:
+    const char *m_name;
+    qint64 m_start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+/* 用法：TRACE_SCOPE("TmxMap::load"); 记到当前作用域结束 */
+#ifdef LZU_TRACE
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name) do {} while (0)
+#endif
+
+#endif // TRACING_H
@@ -6,20 +6,55 @@
 #include <QMessageBox>
 #include <QDebug>
 #include <QKeyEvent>
-#include <QPropertyAnimation>
 #include <QPainter>
-#include <QScrollBar>        // ← 新增：用于滚动条动画
-#include <QEasingCurve>      // ← 新增：缓动曲线
+#include <QScrollBar>        // ← 摄像机通过滚动条定位视口
+#include <QRandomGenerator>
+#include <algorithm>
 #include "PlayerItem.h"
 #include "Item.h"
 #include "inventoryslot.h"
+#include "frameprofiler.h"
+#include "tracing.h"
+#include "profileroverlay.h"
+#include "fogofwar.h"
+#include "minimap.h"
+#include "maplayeritem.h"
+#include "framebufferitem.h"
+#include "tileblitter.h"
+#include "bakedmap.h"
+#include "assetpack.h"
+#include "hotreload.h"
+#include "crowditem.h"
+#include "netsession.h"
+#include <QHostInfo>
+
+namespace {
+// 场景中的层次：绘制组的 z 值是组内最上面图层的序号，玩家在实体下面的图层之上，迷雾盖住一切
+const qreal PLAYER_Z = 1000;
+const qreal CROWD_Z = 999;           // 顾客和玩家在同一层，玩家压在顾客上面
+const qreal OTHER_PLAYERS_Z = 999.5; // 联机时别的玩家：压在顾客上面，本机玩家下面
+const qreal ABOVE_ENTITIES_Z = 1500; // 对象层之后的图层（屋顶、树冠）盖在玩家上面
+const qreal FOG_Z = 2000;
+const int FOV_RADIUS = 12; // 视野半径（格）
+const int WALK_FRAME_MS = 120; // 走路动画每帧的时间
+const int PRELOAD_RADIUS = 6; // 离门或地图边缘多少格时开始预加载
+const qint64 MAP_CACHE_BYTES = 256 * 1024 * 1024; // 地图缓存的内存预算
+// 视图缩放的档位；缩小时地图按 BakedMap 的缩小版绘制，看整张大图也不会变慢
+const qreal ZOOM_STEPS[] = { 1.0, 0.75, 0.5, 0.35, 0.25, 0.18, 0.125 };
+const int ZOOM_STEP_COUNT = int(sizeof(ZOOM_STEPS) / sizeof(ZOOM_STEPS[0]));
+
+bool isMoveKey(int key)
+{
+    return key == Qt::Key_Left || key == Qt::Key_Right || key == Qt::Key_Up || key == Qt::Key_Down;
+}
+}
 
 Widget::Widget(QWidget *parent)
     : QWidget(parent),
       m_scene(new QGraphicsScene(this)),
-      m_view(new QGraphicsView(m_scene, this)),
+      m_view(new GameView(m_scene, this)),
       m_statusLabel(new QLabel("准备加载地图...")),
-      m_map(new TmxMap(this))
+      m_mapCache(new MapCache(MAP_CACHE_BYTES, this))
 {
     setWindowTitle("Qt TMX 瓦片地图 RPG 游戏");
     resize(1000, 800);  // 增大窗口大小
@@ -34,52 +69,92 @@ Widget::Widget(QWidget *parent)
     lay->setContentsMargins(5, 5, 5, 5);
 
     // 设置视图属性
-    /*下列函数作用依次为
-     抗锯齿，使图形边缘平滑
-     缩放图片时使用双线性插值，避免像素块
-     窗口缩放时以视图中心为锚点
-     鼠标滚轮缩放时以鼠标位置为中心
+    /*瓦片和玩家都落在整数像素上，不需要抗锯齿和平滑缩放：
+     开着 Antialiasing 时视图会把每个重绘区域向外多扩 2 像素，
+     开着 SmoothPixmapTransform 时非整数位置的贴图会被插值模糊
      */
-    m_view->setRenderHint(QPainter::Antialiasing);
-    m_view->setRenderHint(QPainter::SmoothPixmapTransform);
+    m_view->setRenderHint(QPainter::Antialiasing, false);
+    m_view->setRenderHint(QPainter::SmoothPixmapTransform, false);
     m_view->setFocusPolicy(Qt::NoFocus);
-    m_view->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-    m_view->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
 
-    //关键：隐藏滚动条
+    //关键：隐藏滚动条（滚动由摄像机控制）
     m_view->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     m_view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 
     // 性能优化
-    m_view->setOptimizationFlags(QGraphicsView::DontSavePainterState);
-    m_view->setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
-    m_view->setCacheMode(QGraphicsView::CacheBackground);
-    m_view->setFocusPolicy(Qt::NoFocus);
+    /*MinimalViewportUpdate：只重绘真正变化的区域。
+     只要不是 FullViewportUpdate，滚动条变化时 QGraphicsView 会直接平移视口里已绘制的像素
+     （viewport()->scroll），只重绘新露出来的条带；摄像机保证每次滚动都是整数像素。
+     场景没有背景画刷，CacheBackground 只会多维护一张整屏缓存，所以关掉。
+     */
+    m_view->setOptimizationFlags(QGraphicsView::DontSavePainterState |
+                                 QGraphicsView::DontAdjustForAntialiasing);
+    m_view->setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+    m_view->setCacheMode(QGraphicsView::CacheNone);
+
+    // 视口位置完全由摄像机决定，窗口缩放时不要让视图自己挪动
+    m_view->setResizeAnchor(QGraphicsView::NoAnchor);
+    m_view->setTransformationAnchor(QGraphicsView::NoAnchor);
+
+    // 帧循环：约 60 FPS 推进摄像机
+    m_frameTimer = new QTimer(this);
+    m_frameTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_frameTimer, &QTimer::timeout, this, &Widget::onFrame);
 
-    // 设置视图缩放模式
-    m_view->setResizeAnchor(QGraphicsView::AnchorViewCenter);
-    m_view->setTransformationAnchor(QGraphicsView::AnchorViewCenter);
+    // 性能面板：叠在视图左上角，默认隐藏
+    m_profilerOverlay = new ProfilerOverlay(this);
+    m_profilerOverlay->setScene(m_scene);
+    m_profilerOverlay->hide();
+
+    // 小地图：叠在视图右上角
+    m_minimap = new Minimap(this);
 
     loadMap();
     initInventoryUI();
     updateInventoryUI();
     setFocusPolicy(Qt::StrongFocus); // 允许接收键盘事件
     setFocus(); // 主动获取焦点
+
+    // 逻辑在模拟线程里跑，用自己的随机数；平时随机播种，录制时种子写进文件
+    m_simThread->simulation().reset(QRandomGenerator::global()->generate());
+    m_simThread->start();
+    m_frameClock.start();
+    m_frameTimer->start(16);
 }
 
 Widget::~Widget()
 {
-    delete m_map;  // 清理资源
+    delete m_netHost;    // 告诉对方离开了
+    delete m_netClient;
+    m_simThread->stop(); // 先停模拟线程，之后不会再有事件
+    leaveMap();  // 图层图元引用着缓存里的区块，先于缓存清理
+    FrameProfiler::instance().stopCsv();   // 还开着的 CSV 记录写完关掉
 }
 
 
 void Widget::loadMap()
 {
+    TRACE_SCOPE("Widget::loadMap");
+    QString worldPath = "E:\\tiled\\myexmples\\lzu.world"; // 多地图世界（可选）
     QString tmxPath ="E:\\tiled\\myexmples\\c.tmx";  // ← 需要修改的实际路径
+    QString itemsPath = "E:\\tiled\\myexmples\\items.json"; // 物品类型和初始物品（可选）
+    QString playerSheetPath = "E:\\tiled\\myexmples\\image\\renwu\\Player.png"; // 玩家精灵图（可选）
+
+    // 物品定义要在创建模拟线程之前加载：模拟带走一份，进入地图时把动作引用的图层名换算成下标
+    if (!AssetPack::instance().exists(itemsPath) || !m_itemDb.load(itemsPath))
+        m_itemDb.loadDefaults();
 
-    m_statusLabel->setText("正在加载地图: " + tmxPath);
+    // 没有 .world 文件时退回到只有一张地图的世界
+    if (!AssetPack::instance().exists(worldPath) || !m_world.load(worldPath))
+        m_world.setSingleMap(tmxPath);
 
-    if (!m_map->load(tmxPath))
+    // 模拟线程带走世界和物品定义的副本，之后由 enterMap 把地图发过去
+    m_simThread = new SimulationThread(m_world, m_itemDb, this);
+
+    m_statusLabel->setText("正在加载地图: " + m_world.startMap());
+
+    LoadedMapPtr start = m_mapCache->acquire(m_world.startMap());
+    if (!start)
     {
         QString errorMsg = "加载 TMX 失败！请检查文件路径和格式。";
         qWarning() << errorMsg;
@@ -88,202 +163,770 @@ void Widget::loadMap()
         return;
     }
 
-    m_map->buildScene(m_scene);
-
-
-
-       // 创建玩家图像（红色圆圈）
-   QPixmap playerPixmap(32, 32);
-   playerPixmap.fill(Qt::red); // 全红，无透明
-
-   QPainter painter(&playerPixmap);
-   painter.setRenderHint(QPainter::Antialiasing);
-   painter.setBrush(Qt::red);
-   painter.drawEllipse(4, 4, 24, 24);
-
        // 创建 PlayerItem 并添加到场景
    m_playerItem = new PlayerItem(this);
-   m_playerItem->setPixmap(playerPixmap);
+
+       // 玩家精灵图：4 列是下、左、右、上四个方向，4 行是走路的四帧
+   if (AssetPack::instance().exists(playerSheetPath))
+       m_playerSheet = SpriteSheet::load(playerSheetPath, 4, 4);
+   if (m_playerSheet)
+   {
+       m_playerClips = SpriteClips::columnsPerDirection(*m_playerSheet, WALK_FRAME_MS);
+       m_playerSprite = m_animator.add(m_playerItem, m_playerSheet, &m_playerClips);
+       m_idleMs = SpriteAnimator::WALK_LINGER_MS;
+   }
+   else
+   {
+       // 没有精灵图时退回到红色圆圈
+       QPixmap playerPixmap(32, 32);
+       playerPixmap.fill(Qt::transparent);
+
+       QPainter painter(&playerPixmap);
+       painter.setRenderHint(QPainter::Antialiasing);
+       painter.setBrush(Qt::red);
+       painter.drawEllipse(4, 4, 24, 24);
+       painter.end();
+       m_playerItem->setPixmap(playerPixmap);
+       // 联机时别的玩家也画成红圈
+       m_playerSheet = SpriteSheet::fromImage(playerPixmap.toImage(), 1, 1);
+       m_playerClips = SpriteClips::columnsPerDirection(*m_playerSheet, WALK_FRAME_MS);
+   }
+   // 顾客也用这套动画，按心情着色
+   if (m_playerSheet)
+       m_customerSheet = CrowdItem::moodAtlas(*m_playerSheet);
 
    m_playerItem->setFlag(QGraphicsItem::ItemIsFocusable, false); // ← 关键
    m_playerItem->clearFocus();
+   m_playerItem->setZValue(PLAYER_Z);
 
    m_scene->addItem(m_playerItem);
 
-       // 设置初始位置
-   m_playerX = 5;
-   m_playerY = 5;
-   updatePlayerPosition();  // 更新屏幕坐标
+       // 进入第一张地图，玩家出生在 (5, 5)
+   m_camera.setViewportSize(m_view->viewport()->size());
+   enterMap(start, QPoint(5, 5));
 
-       // 视角居中（仅初始化时调用一次）
-   m_view->centerOn(m_playerItem);
+       // 初始物品来自物品数据文件（菜刀、锅铲、汤勺……）；模拟只拿不带图标的那部分
+   for (const Item &item : m_itemDb.startingItems())
+       m_playerItem->addItemToInventory(item);
+   QVector<ItemState> items;
+   for (const Item &item : m_playerItem->inventory().items())
+       items.append(ItemState(item));
+   m_simThread->simulation().setInventory(items);
 
-       // 1. 菜刀（工具类型：菜刀，功能：砍树/破箱）
-   QPixmap kitchenKnifeIcon("E:\\tiled\\myexmples\\caidao.png"); // 替换为你的菜刀图标路径
-   Item kitchenKnife("崭新的菜刀", "菜刀", "可以切菜", kitchenKnifeIcon);
-   m_playerItem->addItemToInventory(kitchenKnife);
+    qDebug() << "Player focusable:" << m_playerItem->flags().testFlag(QGraphicsItem::ItemIsFocusable);//测试
+}
 
-       // 2. 锅铲（工具类型：锅铲，功能：炒菜/格挡）
-   QPixmap spatulaIcon("E:\\tiled\\myexmples\\guochan.png"); // 替换为你的锅铲图标路径
-   Item spatula("铁制锅铲", "锅铲", "烹饪必备", spatulaIcon);
-   m_playerItem->addItemToInventory(spatula);
+/* 切换到 loaded 这张地图，玩家放在 tile
+ 画面立刻换过去；模拟收到地图副本之前发布的状态还属于旧地图，按 m_mapGeneration 丢掉 */
+void Widget::enterMap(const LoadedMapPtr &loaded, const QPoint &tile)
+{
+    const TmxMap *map = loaded->map;
+    m_snapshot.player = QPoint(qBound(0, tile.x(), map->m_mapWidth - 1),
+                               qBound(0, tile.y(), map->m_mapHeight - 1));
+    m_snapshot.position = QPointF((m_snapshot.player.x() + 0.5) * map->m_tileWidth,
+                                  (m_snapshot.player.y() + 0.5) * map->m_tileHeight);
+    m_snapshot.moving = false;  // 走到一半换了地图（门、热重载）：直接落在新位置
+    m_snapshot.mapGeneration = ++m_mapGeneration;
+    showMap(loaded);
+
+    SimCommand command;
+    command.type = SimCommand::EnterMap;
+    command.map = SimMap(*loaded->sim, *map, m_mapGeneration);
+    command.tile = m_snapshot.player;
+    m_simThread->post(command);
+}
+
+/* 地图数据、区块、视野网格和小地图底图都已经在缓存里，这里只替换少量图元、换上它们，一帧之内完成 */
+void Widget::showMap(const LoadedMapPtr &loaded)
+{
+    TRACE_SCOPE("Widget::showMap");
+    QElapsedTimer timer;
+    timer.start();
+
+    leaveMap();
+    m_current = loaded;
+    m_map = loaded->map;
+    m_mapCache->setPinned(loaded->path);
+    m_world.setMapSize(loaded->path, QSize(m_map->m_mapWidth * m_map->m_tileWidth,
+                                           m_map->m_mapHeight * m_map->m_tileHeight));
+
+    const QRectF bounds(0, 0, m_map->m_mapWidth * m_map->m_tileWidth, m_map->m_mapHeight * m_map->m_tileHeight);
+    BakedMap *baked = loaded->baked;
+    if (m_softwareRendering)
+    {
+        // 软件渲染：实体下面和上面的绘制组各用一个图元，每帧把可见瓦片合成到帧缓冲区
+        int below = 0;
+        while (below < baked->groupCount() && !baked->group(below).aboveEntities)
+            ++below;
+        if (below > 0)
+            m_framebufferItems.append(new FramebufferItem(m_map, baked, 0, below - 1, bounds));
+        if (below < baked->groupCount())
+        {
+            FramebufferItem *above = new FramebufferItem(m_map, baked, below, baked->groupCount() - 1, bounds);
+            above->setZValue(ABOVE_ENTITIES_Z);
+            m_framebufferItems.append(above);
+        }
+        for (FramebufferItem *item : m_framebufferItems)
+            m_scene->addItem(item);
+    }
+    else
+    {
+        // 每个绘制组一个图元，从烘焙好的区块绘制；实体下面的静态图层已经合成了一组
+        for (int g = 0; g < baked->groupCount(); ++g)
+        {
+            MapLayerItem *item = new MapLayerItem(baked, g, bounds);
+            if (baked->group(g).aboveEntities)
+                item->setZValue(ABOVE_ENTITIES_Z + g);
+            m_scene->addItem(item);
+            m_layerItems.append(item);
+        }
+    }
+    m_scene->setSceneRect(bounds);
+    m_camera.setBounds(bounds);
+
+    // 视野的遮挡网格在预加载时已经从障碍物层读好；之后障碍物被修改时只更新对应格子
+    m_fov = loaded->fov;
+    m_fogItem = new FogOfWarItem(m_fov, m_map->m_tileWidth, m_map->m_tileHeight);
+    m_fogItem->setZValue(FOG_Z);
+    m_scene->addItem(m_fogItem);
+
+    // 顾客由模拟推进，这里只画快照里玩家附近的那些
+    m_crowdItem = new CrowdItem(bounds, m_map->m_tileWidth, m_map->m_tileHeight, m_customerSheet, m_playerClips,
+                                &m_animator);
+    m_crowdItem->setZValue(CROWD_Z);
+    m_scene->addItem(m_crowdItem);
+
+    // 联机时别的玩家，和本机玩家共用精灵图
+    if (m_playerSheet)
+    {
+        m_playersItem = new EntityLayerItem(bounds, m_playerSheet);
+        m_playersItem->setZValue(OTHER_PLAYERS_Z);
+        m_scene->addItem(m_playersItem);
+    }
+
+    // 瓦片变化：作废所在区块、更新视野；GUI 这边的修改（热重载）同步给模拟
+    connect(m_map, &TmxMap::tileChanged, this, [this](int layerIndex, int x, int y, int gid)
+    {
+        if (!m_applyingSimEdit)
+        {
+            SimCommand command;
+            command.type = SimCommand::SetTile;
+            command.layer = layerIndex;
+            command.tile = QPoint(x, y);
+            command.gid = gid;
+            command.generation = m_mapGeneration;
+            m_simThread->post(command);
+        }
+        const int group = m_current->baked->groupOf(layerIndex);
+        m_current->baked->invalidate(layerIndex, x, y);
+        // 新出现的 GID：马上重建图块表（这一帧烘焙区块时反正要建），后面连着的小地图取颜色也要用
+        if (!m_current->baked->tilesetsLoaded())
+            m_current->baked->loadTilesets();
+        if (!m_layerItems.isEmpty())
+            m_layerItems[group]->updateTile(x, y, m_map->m_tileWidth, m_map->m_tileHeight);
+        // 上面图层的不透明度变了也会影响下面的组，两个帧缓冲图元都重画这一格
+        for (FramebufferItem *item : m_framebufferItems)
+            item->updateTile(x, y, m_map->m_tileWidth, m_map->m_tileHeight);
+        if (layerIndex != m_map->obstacleLayerIndex())
+            return;
+        m_fov->setOpaque(x, y, gid != 0);
+        updateVisibility();
+    });
+
+    // 小地图底图也是预加载时生成的，之后瓦片变化只改对应的像素
+    m_minimap->setMap(m_map, loaded->minimap);
+    connect(m_map, &TmxMap::tileChanged, m_minimap, &Minimap::onTileChanged);
+
+    updatePlayerPosition();  // 更新屏幕坐标
+    updateVisibility();
+
+    // 视角直接对准玩家，之后由摄像机平滑跟随
+    m_camera.follow(m_playerItem->sceneBoundingRect().center(), m_snapshot.facing);
+    m_camera.snapToTarget();
+    applyCamera();
+
+    preloadNearby();
+    if (m_hotReloader)
+        m_hotReloader->watch(m_map, loaded->path);
 
-       // 3. 汤勺（工具类型：汤勺，功能：舀汤/挖宝）
-   QPixmap ladleIcon("E:\\tiled\\myexmples\\mushao.png"); // 替换为你的汤勺图标路径
-   Item ladle("木汤勺", "汤勺", "可以舀取汤", ladleIcon);
-   m_playerItem->addItemToInventory(ladle);
     //%1和%2分别是是m_map->m_mapWidth，m_map->m_mapHeight的占位符
     //实际作用是在状态栏（比如窗口底部的 QLabel）显示一条成功提示信息，告诉用户地图的逻辑尺寸，例如："地图加载成功: 100x66 瓦片"
     m_statusLabel->setText(QString("地图加载成功: %1x%2 瓦片").arg(m_map->m_mapWidth).arg(m_map->m_mapHeight));
+    if (timer.elapsed() > 16)
+        qWarning() << "Map transition took" << timer.elapsed() << "ms (longer than one frame):" << loaded->path;
+}
 
+void Widget::leaveMap()
+{
+    if (m_hotReloader)
+        m_hotReloader->stop();
+    if (m_map)
+    {
+        disconnect(m_map, nullptr, this, nullptr);
+        disconnect(m_map, nullptr, m_minimap, nullptr);
+    }
+    qDeleteAll(m_layerItems);   // 图元析构时会自动从场景中移除
+    m_layerItems.clear();
+    qDeleteAll(m_framebufferItems);
+    m_framebufferItems.clear();
+    delete m_fogItem;
+    m_fogItem = nullptr;
+    m_fov = nullptr;
+    m_minimap->setMap(nullptr, nullptr);   // 底图属于 m_current，下面可能随它一起释放
+    delete m_crowdItem;
+    m_crowdItem = nullptr;
+    delete m_playersItem;
+    m_playersItem = nullptr;
+    m_map = nullptr;
+    m_current.reset();
+}
 
-    qDebug() << "Player focusable:" << m_playerItem->flags().testFlag(QGraphicsItem::ItemIsFocusable);//测试
+void Widget::setHotReloadEnabled(bool enabled)
+{
+    if (enabled == (m_hotReloader != nullptr))
+        return;
+    if (!enabled)
+    {
+        delete m_hotReloader;
+        m_hotReloader = nullptr;
+        return;
+    }
+
+    m_hotReloader = new HotReloader(this);
+    connect(m_hotReloader, &HotReloader::reloadRequired, this, &Widget::reloadCurrentMap);
+    if (m_map)
+        m_hotReloader->watch(m_map, m_current->path);
 }
 
-void Widget::updatePlayerPosition()
+void Widget::setSoftwareRendering(bool enabled)
 {
-    if (!m_playerItem || !m_map) return;
+    if (enabled == m_softwareRendering)
+        return;
+    m_softwareRendering = enabled;
+    if (m_current)
+    {
+        const LoadedMapPtr loaded = m_current; // showMap 会先 leaveMap 清掉 m_current
+        showMap(loaded);
+    }
+    m_statusLabel->setText(enabled ? QString("软件渲染（%1）").arg(TileBlitter::kernelName(TileBlitter::kernel()))
+                                   : QString("区块渲染"));
+}
+
+void Widget::setZoom(int step)
+{
+    step = qBound(0, step, ZOOM_STEP_COUNT - 1);
+    if (step == m_zoomStep)
+        return;
+    m_zoomStep = step;
+    const qreal zoom = ZOOM_STEPS[step];
+    m_view->setTransform(QTransform::fromScale(zoom, zoom));
+
+    // 摄像机按场景坐标工作：视口在场景里变大了
+    m_camera.setViewportSize(QSizeF(m_view->viewport()->size()) / zoom);
+    if (m_playerItem)
+    {
+        m_camera.snapToTarget();
+        applyCamera();
+    }
+    m_statusLabel->setText(QString("缩放 %1%").arg(qRound(zoom * 100)));
+}
+
+void Widget::reloadCurrentMap()
+{
+    if (!m_current)
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    const QString path = m_current->path;
+    m_mapCache->invalidate(path);
+    LoadedMapPtr fresh = m_mapCache->acquire(path);
+    if (!fresh)
+    {
+        m_statusLabel->setText("重新加载失败，保留当前地图: " + path);
+        return;
+    }
+    enterMap(fresh, m_snapshot.player);
+    qDebug() << "Hot reload: full reload of" << path << "in" << timer.elapsed() << "ms";
+}
+
+/* 模拟走到了门或通往相邻地图的边缘，正停着等地图：加载成功就切换，失败就让它留在原地 */
+void Widget::enterTransition(const WorldTransition &t)
+{
+    LoadedMapPtr next = m_mapCache->acquire(t.map);
+    if (!next)
+    {
+        m_statusLabel->setText("加载地图失败: " + t.map);
+        SimCommand command;
+        command.type = SimCommand::TransitionFailed;
+        m_simThread->post(command);
+        return;
+    }
+    // 走出边缘时按目标地图自己的格子大小换算落脚点
+    const QPoint target = t.fromEdge
+            ? m_world.tileIn(t.map, t.worldPos, QSize(next->map->m_tileWidth, next->map->m_tileHeight))
+            : t.tile;
+    enterMap(next, target);
+}
+
+/* 靠近门或地图边缘时，在后台预加载另一侧的地图 */
+void Widget::preloadNearby()
+{
+    const QSize tileSize(m_map->m_tileWidth, m_map->m_tileHeight);
+    for (const QString &path : m_world.nearbyMaps(m_current->path, m_snapshot.player,
+                                                  PRELOAD_RADIUS, tileSize))
+        m_mapCache->preload(path);
+}
+
+void Widget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+
+    m_profilerOverlay->move(m_view->geometry().topLeft() + QPoint(8, 8));
+    m_minimap->move(m_view->geometry().topRight() + QPoint(-m_minimap->width() - 8, 8));
+    m_minimap->raise();
+
+    // 视口大小变了，摄像机的边界限制也跟着变；直接跳到新位置，不做平滑
+    m_camera.setViewportSize(QSizeF(m_view->viewport()->size()) / ZOOM_STEPS[m_zoomStep]);
+    if (m_playerItem)
+    {
+        m_camera.snapToTarget();
+        applyCamera();
+    }
+}
+
+void Widget::onFrame()
+{
+    TRACE_SCOPE("Widget::onFrame");
+    FrameProfiler &profiler = FrameProfiler::instance();
+    profiler.nextFrame();
+    const qreal dt = qreal(m_frameClock.restart());
+
+    if (m_replaying)
+    {
+        // 刚封存的是上一帧（含上一帧的绘制）；第一帧之前还没开始回放
+        if (m_replayClock.isValid())
+            m_replayFrames.append(profiler.sample(profiler.sampleCount() - 1));
+        else
+            m_replayClock.start();
+    }
+
+    syncSimulation();
+
+    {
+        PROFILE_SCOPE(Rendering);
+        if (m_playerSprite >= 0)
+        {
+            m_idleMs = m_snapshot.moving ? 0 : m_idleMs + int(dt);
+            m_animator.play(m_playerSprite, m_idleMs < SpriteAnimator::WALK_LINGER_MS ? SpriteAnimator::Walk : SpriteAnimator::Idle,
+                            SpriteAnimator::directionOf(m_snapshot.facing));
+        }
+        m_animator.advance(int(dt));
+        // 别的玩家和顾客成批画，帧号也按 m_animator 的时钟算，与本机玩家的步子一致
+        updateOtherPlayers();
+        if (m_crowdItem)
+            m_crowdItem->animate();
+    }
 
-    qreal x = m_playerX * m_map->m_tileWidth + m_map->m_tileWidth / 2.0;
-    qreal y = m_playerY * m_map->m_tileHeight + m_map->m_tileHeight / 2.0;
+    if (m_playerItem && m_map)
+    {
+        PROFILE_SCOPE(Rendering);
+        // 玩家动画中的位置是浮点，摄像机自己做平滑，最后只输出整数像素
+        m_camera.follow(m_playerItem->sceneBoundingRect().center(), m_snapshot.facing);
+        if (m_camera.update(dt))
+            applyCamera();
+
+        // 小地图标记以格子为单位；只有标记真的挪动了才会重绘小地图
+        const QPointF tileSize(m_map->m_tileWidth, m_map->m_tileHeight);
+        const QPointF center = m_playerItem->sceneBoundingRect().center();
+        m_minimap->setPlayerPosition(QPointF(center.x() / tileSize.x(), center.y() / tileSize.y()));
+        const QRectF view = m_view->mapToScene(m_view->viewport()->rect()).boundingRect();
+        m_minimap->setViewRect(QRectF(view.x() / tileSize.x(), view.y() / tileSize.y(),
+                                      view.width() / tileSize.x(), view.height() / tileSize.y()));
+    }
+}
+
+void Widget::applyCamera()
+{
+    /*滚动条数值是视口左上角的视图坐标：未缩放时就是场景坐标，缩放时乘以缩放比例。
+     两个滚动条各触发一次 scrollContentsBy，视图只平移已绘制的像素并重绘露出的条带。
+     地图比视口小时滚动条范围为 0，setValue 无效果，视图按默认对齐方式居中显示，
+     与摄像机的居中规则一致。*/
+    const QPoint tl = m_camera.topLeft();
+    const qreal zoom = ZOOM_STEPS[m_zoomStep];
+    m_view->horizontalScrollBar()->setValue(qRound(tl.x() * zoom));
+    m_view->verticalScrollBar()->setValue(qRound(tl.y() * zoom));
+}
+
+void Widget::updateVisibility()
+{
+    if (!m_fogItem)
+        return;
+
+    PROFILE_SCOPE(Simulation);
+    // 视点和遮挡都没变时 update() 直接返回；变了也只重绘状态变化的区块
+    m_fov->setOrigin(m_snapshot.player, FOV_RADIUS);
+    if (m_fov->update())
+        m_fogItem->refreshChunks(m_fov->takeDirtyChunks());
+}
 
-    x -= m_playerItem->boundingRect().width() / 2.0;
-    y -= m_playerItem->boundingRect().height() / 2.0;
+void Widget::updatePlayerPosition()
+{
+    if (!m_playerItem || !m_map) return;
 
-    m_playerItem->setPos(x, y);
+    // 模拟给的是脚下碰撞框的中心（像素）；精灵的脚踩在碰撞框底边上，比格子高的部分往上伸出去
+    const QPointF feet = m_snapshot.position + QPointF(0, Simulation::BODY_HEIGHT / 2.0);
+    m_playerItem->setPos(feet.x() - m_playerItem->boundingRect().width() / 2.0,
+                         feet.y() - m_playerItem->boundingRect().height());
 }
 
-//实现键盘控制与平滑移动（无抽搐版本：使用滚动条动画）
+//键盘输入：调试按键立即处理，游戏输入发给模拟线程，下一个逻辑步处理
 void Widget::keyPressEvent(QKeyEvent *event)
 {
-    if (m_isMoving || !m_map || !m_playerItem)
+    if (!m_map || !m_playerItem)
     {
         event->ignore();
         return;
     }
 
-    int dx = 0, dy = 0;
-    bool isMoveKet = true;
-    switch (event->key())
+    // 调试按键：F3 开关性能面板，F4 开始/停止把帧采样记录到 CSV，F6 切换软件渲染，- / = 缩放视图
+    if (event->key() == Qt::Key_F3)
     {
-    case Qt::Key_Left:  dx = -1; break;
-    case Qt::Key_Right: dx = 1;  break;
-    case Qt::Key_Up:    dy = -1; break;
-    case Qt::Key_Down:  dy = 1;  break;
-    default:
-        isMoveKet = false;
+        m_profilerOverlay->setVisible(!m_profilerOverlay->isVisible());
+        m_profilerOverlay->raise();
         return;
     }
-    if(isMoveKet)
+    if (event->key() == Qt::Key_M)
     {
-        int newX = m_playerX + dx;
-        int newY = m_playerY + dy;
-
-        //地图边界检测
-        if (newX < 0 || newX >= m_map->m_mapWidth ||
-            newY < 0 || newY >= m_map->m_mapHeight)
+        m_minimap->setVisible(!m_minimap->isVisible());
+        return;
+    }
+    if (event->key() == Qt::Key_F4)
+    {
+        FrameProfiler &profiler = FrameProfiler::instance();
+        if (profiler.isCapturing())
         {
+            const QString file = profiler.csvFileName();
+            const int frames = profiler.stopCsv();
+            m_statusLabel->setText(QString("性能数据已写入: %1（%2 帧）").arg(file).arg(frames));
             return;
         }
+        QString file = m_profilerOverlay->startCsv();
+        m_statusLabel->setText(file.isEmpty() ? "性能数据导出失败" : "性能数据记录中: " + file);
+        return;
+    }
+    if (event->key() == Qt::Key_F6)
+    {
+        setSoftwareRendering(!m_softwareRendering);
+        return;
+    }
+    if (event->key() == Qt::Key_Minus)
+    {
+        setZoom(m_zoomStep + 1);
+        return;
+    }
+    if (event->key() == Qt::Key_Equal || event->key() == Qt::Key_Plus)
+    {
+        setZoom(m_zoomStep - 1);
+        return;
+    }
 
-        //地图障碍物检测
-        if (m_map->isObstacle(newX, newY))
-        {
-                return; // 是障碍物 → 不移动，直接返回
-        }
+    // 回放时输入全部来自录制文件
+    if (m_replaying)
+    {
+        event->ignore();
+        return;
+    }
+    // 方向键按住期间一直走，松开时停；自动重复只对数字键（连续使用工具）有意义
+    if (event->isAutoRepeat() && isMoveKey(event->key()))
+        return;
+    postInput(InputEvent::Key, event->key());
+}
 
-        m_isMoving = true;
-
-        const qreal tileW = m_map->m_tileWidth;
-        const qreal tileH = m_map->m_tileHeight;
-        const qreal playerW = m_playerItem->boundingRect().width();
-        const qreal playerH = m_playerItem->boundingRect().height();
-
-        // 计算玩家目标位置（强制整数像素，避免亚像素抖动）
-        qreal targetPlayerX = qRound(newX * tileW + tileW / 2.0 - playerW / 2.0);
-        qreal targetPlayerY = qRound(newY * tileH + tileH / 2.0 - playerH / 2.0);
-        QPointF playerTargetPos(targetPlayerX, targetPlayerY);
-
-        // 视图应滚动到的目标中心 = 玩家中心
-        QPointF targetViewCenter(
-        targetPlayerX + playerW / 2.0,
-        targetPlayerY + playerH / 2.0
-    );
-
-        // 获取当前视图中心（场景坐标）
-        QPointF currentViewCenter = m_view->mapToScene(m_view->viewport()->rect().center());
-
-        // 计算滚动条目标值
-        int currentH = m_view->horizontalScrollBar()->value();
-        int currentV = m_view->verticalScrollBar()->value();
-        int targetH = currentH + qRound(targetViewCenter.x() - currentViewCenter.x());
-        int targetV = currentV + qRound(targetViewCenter.y() - currentViewCenter.y());
-
-        // === 动画1：平滑移动玩家 ===
-        QPropertyAnimation *animPlayer = new QPropertyAnimation(m_playerItem, "pos");
-        animPlayer->setDuration(60);
-        animPlayer->setEasingCurve(QEasingCurve::OutQuad); // 更自然的缓动
-        animPlayer->setStartValue(m_playerItem->pos());
-        animPlayer->setEndValue(playerTargetPos);
-
-        // === 动画2：平滑滚动视图（通过滚动条）===
-        QPropertyAnimation *animH = new QPropertyAnimation(m_view->horizontalScrollBar(), "value");
-        QPropertyAnimation *animV = new QPropertyAnimation(m_view->verticalScrollBar(), "value");
-
-        animH->setDuration(60);
-        animV->setDuration(60);
-        animH->setEasingCurve(QEasingCurve::OutQuad);
-        animV->setEasingCurve(QEasingCurve::OutQuad);
-        animH->setStartValue(currentH);
-        animH->setEndValue(targetH);
-        animV->setStartValue(currentV);
-        animV->setEndValue(targetV);
-
-        // 启动所有动画
-        animPlayer->start(QAbstractAnimation::DeleteWhenStopped);
-        animH->start(QAbstractAnimation::DeleteWhenStopped);
-        animV->start(QAbstractAnimation::DeleteWhenStopped);
-
-        // 动画结束后更新逻辑坐标
-        connect(animPlayer, &QPropertyAnimation::finished, this, [this, newX, newY]()
-        {
-            m_playerX = newX;
-            m_playerY = newY;
-            m_isMoving = false;
-        });
+void Widget::keyReleaseEvent(QKeyEvent *event)
+{
+    if (event->isAutoRepeat() || !isMoveKey(event->key()) || m_replaying || !m_simThread)
+    {
+        event->ignore();
         return;
     }
-    // 工具使用逻辑（数字键1-9）
-    if (event->key() >= Qt::Key_1 && event->key() <= Qt::Key_9)
+    postInput(InputEvent::KeyRelease, event->key());
+}
+
+void Widget::postInput(InputEvent::Type type, int code)
+{
+    SimCommand command;
+    command.type = SimCommand::Input;
+    command.input.type = type;
+    command.input.code = code;
+    m_simThread->post(command);
+}
+
+/* 每帧一次：先处理模拟发来的事件，再取它最新发布的状态 */
+void Widget::syncSimulation()
+{
+    TRACE_SCOPE("Widget::syncSimulation");
+    SimEvent event;
+    while (m_simThread->pollEvent(&event))
+        handleSimEvent(event);
+    if (m_netClient)
+        m_netClient->flushInput();   // 这一帧攒下的输入一个报文发出去
+
+    const QPoint tile = m_snapshot.player;
+    bool fresh = false;
+    if (m_simThread->updateSnapshot() && m_simThread->snapshot().mapGeneration == m_mapGeneration)
     {
-        int slotIndex = event->key() - Qt::Key_1;
-        Item item = m_playerItem->inventory().getItem(slotIndex);
+        m_snapshot = m_simThread->snapshot();
+        fresh = true;
+    }
+    if (!m_map)
+        return;
+
+    if (fresh && m_crowdItem)
+        m_crowdItem->setCustomers(m_snapshot.customers);
+    if (fresh && m_minimap->isVisible())
+    {
+        // 小地图上的顾客：格子坐标，与玩家标记一样取格子中心
+        QVector<QPointF> customers;
+        customers.reserve(m_snapshot.customers.size());
+        for (const CustomerView &c : m_snapshot.customers)
+            customers.append(QPointF(c.x + 0.5, c.y + 0.5));
+        m_minimap->setNpcPositions(customers);
+    }
+    if (fresh && m_netHost)
+        m_netHost->setSnapshot(m_snapshot);
 
-        if (!item.isValid())
+    updatePlayerPosition();
+    if (m_snapshot.player != tile)
+    {
+        updateVisibility();
+        preloadNearby();
+    }
+}
+
+void Widget::handleSimEvent(const SimEvent &event)
+{
+    switch (event.type)
+    {
+    case SimEvent::Status:
+        m_statusLabel->setText(event.text);
+        break;
+    case SimEvent::TileChanged:
+        // 模拟在它的地图副本上已经改过了；区块、视野、小地图跟着 tileChanged 信号更新
+        if (m_map && event.generation == m_mapGeneration)
         {
-            m_statusLabel->setText("槽位 " + QString::number(slotIndex+1) + " 无工具！");
-            return;
+            m_applyingSimEdit = true;
+            m_map->setTile(event.layer, event.tile.x(), event.tile.y(), event.gid);
+            m_applyingSimEdit = false;
+            if (m_netHost)
+                m_netHost->addTileEdit(event.layer, event.tile.x(), event.tile.y(), event.gid);
         }
+        break;
+    case SimEvent::Transition:
+        enterTransition(event.transition);
+        break;
+    case SimEvent::ReplayFinished:
+        finishReplay(event.text.toLatin1());
+        break;
+    case SimEvent::NetInput:
+        if (m_netClient)
+            m_netClient->addInput(event.frame);
+        break;
+    }
+}
+
+void Widget::setNetRole(Simulation::NetRole role)
+{
+    m_simThread->stop();
+    m_simThread->simulation().setNetRole(role);
+    m_simThread->start();
+}
+
+bool Widget::startHost(quint16 port)
+{
+    if (!m_current || m_netHost || m_netClient)
+        return false;
+    m_netHost = new NetHost(this);
+    if (!m_netHost->listen(port, m_current->path))
+    {
+        delete m_netHost;
+        m_netHost = nullptr;
+        return false;
+    }
+    setNetRole(Simulation::Host);
+    m_netId = 0;
+
+    // 客户端的加入、离开和输入都交给模拟，下一个逻辑步处理
+    connect(m_netHost, &NetHost::clientJoined, this, [this](int playerId)
+    {
+        SimCommand command;
+        command.type = SimCommand::RemoteJoin;
+        command.player = playerId;
+        m_simThread->post(command);
+        m_statusLabel->setText(QString("玩家 %1 加入了").arg(playerId));
+    });
+    connect(m_netHost, &NetHost::clientLeft, this, [this](int playerId)
+    {
+        SimCommand command;
+        command.type = SimCommand::RemoteLeave;
+        command.player = playerId;
+        m_simThread->post(command);
+        m_statusLabel->setText(QString("玩家 %1 离开了").arg(playerId));
+    });
+    connect(m_netHost, &NetHost::inputReceived, this, [this](int playerId, const NetInputFrame &frame)
+    {
+        SimCommand command;
+        command.type = SimCommand::RemoteInput;
+        command.player = playerId;
+        command.frame = frame;
+        m_simThread->post(command);
+    });
+    m_statusLabel->setText(QString("等待其他玩家加入（端口 %1）").arg(port));
+    return true;
+}
 
-        // 使用工具
-        bool used = m_playerItem->useInventoryItem(slotIndex);
-        if (used)
+bool Widget::connectToHost(const QString &host, quint16 port)
+{
+    if (!m_current || m_netHost || m_netClient)
+        return false;
+    QHostAddress address;
+    if (!address.setAddress(host))
+    {
+        const QHostInfo info = QHostInfo::fromName(host);
+        if (info.addresses().isEmpty())
         {
-            QString toolType = item.toolType();
-            if (toolType == "菜刀")
-            {
-                m_statusLabel->setText("使用【" + item.name() + "】→ " + item.description() + "（切了菜）");
-            }
-            else if (toolType == "锅铲")
-            {
-                m_statusLabel->setText("使用【" + item.name() + "】→ " + item.description() + "（抄了菜）");
-            }
-            else if (toolType == "汤勺")
-            {
-                m_statusLabel->setText("使用【" + item.name() + "】→ " + item.description() + "（舀取了汤）");
-            }
+            qWarning() << "Net: cannot resolve" << host;
+            return false;
         }
+        address = info.addresses().first();
+    }
+    m_netClient = new NetClient(this);
+    if (!m_netClient->connectToHost(address, port, m_current->path))
+    {
+        delete m_netClient;
+        m_netClient = nullptr;
+        return false;
+    }
+    setNetRole(Simulation::Client);
+
+    connect(m_netClient, &NetClient::welcomed, this, [this](int playerId, const QString &hostMap)
+    {
+        m_netId = playerId;
+        SimCommand command;
+        command.type = SimCommand::NetJoined;
+        command.player = playerId;
+        m_simThread->post(command);
+        if (m_current && hostMap != m_current->path)
+            qWarning() << "Net: the host is on" << hostMap << "but this client is on" << m_current->path;
+        m_statusLabel->setText(QString("已加入，玩家编号 %1").arg(playerId));
+    });
+    connect(m_netClient, &NetClient::stateReceived, this, [this](const NetWorldState &state)
+    {
+        SimCommand command;
+        command.type = SimCommand::NetState;
+        command.state = state;
+        m_simThread->post(command);
+    });
+    m_statusLabel->setText("正在连接 " + host);
+    return true;
+}
+
+/* 联机时别的玩家：和本机玩家用同一套动画帧，所有人一个图元画完 */
+void Widget::updateOtherPlayers()
+{
+    if (!m_playersItem || m_netId < 0)
+        return;
+    m_playerSprites.clear();
+    const qreal halfHeight = m_playerSheet->frameSize().height() / 2.0;
+    for (const PlayerView &p : m_snapshot.players)
+    {
+        if (p.id == m_netId)
+            continue;
+        const int d = SpriteAnimator::directionOf(p.facing);
+        const SpriteClip &clip = p.moving ? m_playerClips.walk[d] : m_playerClips.idle[d];
+        // 和本机玩家一样，精灵的脚踩在碰撞框底边上
+        const QPointF feet = p.position + QPointF(0, Simulation::BODY_HEIGHT / 2.0);
+        EntitySprite s;
+        s.id = p.id;
+        s.pos = QPointF(feet.x(), feet.y() - halfHeight);
+        s.frame = m_animator.frameAt(clip);
+        m_playerSprites.append(s);
     }
+    m_playersItem->setSprites(m_playerSprites);
+}
+
+void Widget::startRecording(quint32 seed)
+{
+    m_simThread->stop();
+    Simulation &sim = m_simThread->simulation();
+    sim.reset(seed);
+    sim.startRecording();
+    m_recording = true;
+    m_simThread->start();
+}
+
+bool Widget::saveRecording(const QString &fileName)
+{
+    if (!m_recording)
+        return false;
+    m_simThread->stop();
+    const InputLog log = m_simThread->simulation().finishRecording();
+    m_simThread->start();
+    return log.save(fileName);
+}
+
+void Widget::startReplay(const InputLog &log, bool fast, const QString &framesCsv)
+{
+    m_simThread->stop();
+    if (m_current && log.map != m_current->path)
+        qWarning() << "Input log starts on" << log.map << "but the world starts on" << m_current->path;
+
+    Simulation &sim = m_simThread->simulation();
+    sim.reset(log.seed);
+    sim.startReplay(log);
+    m_replay = log;
+    m_replayCsv = framesCsv;
+    m_replayFrames.clear();
+    m_replayFrames.reserve(int(log.ticks));
+    m_replayClock.invalidate();
+    m_replaying = true;
+    m_simThread->setThrottled(!fast);
+    m_simThread->start();
+    m_frameTimer->start(fast ? 0 : Simulation::TICK_MS);
+}
+
+void Widget::finishReplay(const QByteArray &checksum)
+{
+    m_replaying = false;
+    m_frameTimer->stop();
+    const qint64 wallMs = m_replayClock.elapsed();
+
+    const bool matched = m_replay.checksum.isEmpty() || checksum == m_replay.checksum;
+
+    QVector<qint64> times;
+    times.reserve(m_replayFrames.size());
+    for (const FrameProfiler::Sample &s : m_replayFrames)
+        times.append(s.frameNs);
+    std::sort(times.begin(), times.end());
+    auto percentileMs = [&times](double p) {
+        return times.isEmpty() ? 0.0 : times[qBound(0, int(p * (times.size() - 1) + 0.5), times.size() - 1)] / 1e6;
+    };
+
+    qDebug().nospace() << "Replay: " << m_replay.ticks << " ticks, " << m_replay.events.size() << " events, "
+                       << wallMs << " ms wall (" << m_replay.ticks * Simulation::TICK_MS << " ms game time), "
+                       << m_replayFrames.size() << " frames, frame p50 "
+                       << percentileMs(0.5) << " ms, p99 " << percentileMs(0.99) << " ms, max "
+                       << percentileMs(1.0) << " ms";
+    QByteArray verdict = " matches the recording";
+    if (m_replay.checksum.isEmpty())
+        verdict = " (no recorded checksum)";
+    else if (!matched)
+        verdict = " DIFFERS from the recording " + m_replay.checksum;
+    qDebug().noquote().nospace() << "Replay checksum " << checksum << verdict;
+    if (!m_replayCsv.isEmpty())
+        FrameProfiler::writeCsv(m_replayCsv, m_replayFrames);
+
+    emit replayFinished(matched);
 }
 
 void Widget::initInventoryUI()
@@ -306,8 +949,9 @@ void Widget::initInventoryUI()
         InventorySlot *slot = new InventorySlot(this);
         connect(slot, &InventorySlot::clicked, this, [this, i]()
         {
-            if (m_playerItem)
-            m_playerItem->useInventoryItem(i);
+            // 和按键一样发给模拟，下一个逻辑步处理，录制 / 回放才对得上
+            if (!m_replaying)
+                postInput(InputEvent::SlotClick, i);
 
         });
         m_inventorySlots.append(slot);
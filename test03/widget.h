@@ -9,9 +9,31 @@
 #include <QLabel>
 #include <QMessageBox>
 #include <QGraphicsPixmapItem> // 添加头文件
+#include <QTimer>
+#include <QElapsedTimer>
 #include "PlayerItem.h"
+#include "camera.h"
+#include "gameview.h"
+#include "fieldofview.h"
+#include "world.h"
+#include "mapcache.h"
+#include "inputlog.h"
+#include "frameprofiler.h"
+#include "itemdatabase.h"
+#include "simthread.h"
+#include "spriteanimator.h"
+#include "entitylayer.h"
 class TmxMap;   // 前向声明，避免循环 include
 class InventorySlot;
+class ProfilerOverlay;
+class FogOfWarItem;
+class CrowdItem;
+class Minimap;
+class MapLayerItem;
+class FramebufferItem;
+class HotReloader;
+class NetHost;
+class NetClient;
 
 class Widget : public QWidget
 {
@@ -21,10 +43,54 @@ public:
     explicit Widget(QWidget *parent = nullptr);
     ~Widget();
 
+    /* 开发模式：地图文件保存后自动热重载 */
+    void setHotReloadEnabled(bool enabled);
+
+    /* 输入录制与回放：都要在构造之后、事件循环开始之前调用，从第 0 个逻辑步开始
+     startRecording 用 seed 重新开局并记下之后的所有输入，saveRecording 写出文件；
+     startReplay 用录制的种子重新开局，按录制的逻辑步喂回输入，不再接受键盘输入。
+     fast 为 true 时模拟线程不按真实时间限速、画面也不等待，否则按 16ms 一步；
+     回放结束后逐帧耗时写到 framesCsv（为空则不写），并发出 replayFinished */
+    void startRecording(quint32 seed);
+    bool saveRecording(const QString &fileName);
+    void startReplay(const InputLog &log, bool fast, const QString &framesCsv);
+
+    /* 局域网联机：在构造之后调用，两者只能选一个。
+     startHost 在 port 上等别的玩家加入，这一局的逻辑由本机说了算；
+     connectToHost 加入 host 上的一局（两边要在同一张地图上），自己的移动先在本机预测 */
+    bool startHost(quint16 port);
+    bool connectToHost(const QString &host, quint16 port);
+
+signals:
+    /* matched：最终状态与录制时的校验和一致（录制文件里没有校验和时为 true） */
+    void replayFinished(bool matched);
+
 private:
-    void loadMap();      // 解析 tmx 并加载到场景
+    void loadMap();      // 读取世界并进入第一张地图
+    void enterMap(const LoadedMapPtr &loaded, const QPoint &tile); // 切换到已加载的地图，模拟跟着换
+    void showMap(const LoadedMapPtr &loaded); // 只建立地图的图元、视野和小地图
+    void leaveMap();     // 移除当前地图的图元
+    void enterTransition(const WorldTransition &t); // 模拟走到门或地图边缘时加载目标地图
+    void preloadNearby(); // 预加载附近的门和边缘通往的地图
+    void reloadCurrentMap(); // 整张重新加载当前地图，玩家留在原地
+    void setSoftwareRendering(bool enabled); // 切换地图渲染方式（F6），重新进入当前地图
+    void setZoom(int step);   // 视图缩放（- / = 键），step 为 ZOOM_STEPS 的下标
     void keyPressEvent(QKeyEvent *event) override; // ← 新增键盘事件
+    void keyReleaseEvent(QKeyEvent *event) override;
     void updatePlayerPosition();//辅助函数：更新玩家屏幕坐标
+    void resizeEvent(QResizeEvent *event) override;
+
+    void onFrame();      // 每帧驱动：取模拟的最新状态，推进摄像机
+    void applyCamera();  // 把摄像机的整数位置写入视图滚动条
+    void updateVisibility(); // 玩家所在格子或障碍物变化后更新视野和迷雾
+
+    // 游戏逻辑在模拟线程里跑（simulation.h），这里只发输入、取状态和事件
+    void syncSimulation();
+    void handleSimEvent(const SimEvent &event);
+    void postInput(InputEvent::Type type, int code); // 输入发给模拟，下一个逻辑步处理
+    void finishReplay(const QByteArray &checksum);
+    void setNetRole(Simulation::NetRole role);
+    void updateOtherPlayers(); // 联机时画别的玩家
 
     void initInventoryUI();
     void updateInventoryUI();
@@ -32,14 +98,65 @@ private:
 
 private:
     QGraphicsScene *m_scene;
-    QGraphicsView *m_view;
+    GameView *m_view;
     QLabel *m_statusLabel;
-    TmxMap *m_map; // 我们的解析器
+    TmxMap *m_map = nullptr; // 当前地图（属于 m_current）
+
+    // 多地图世界
+    World m_world;
+    MapCache *m_mapCache;
+    LoadedMapPtr m_current;
+    QVector<MapLayerItem *> m_layerItems; // 每个绘制组一个
+    QVector<FramebufferItem *> m_framebufferItems; // 软件渲染：实体下面一个、上面一个
+    bool m_softwareRendering = false;
+    HotReloader *m_hotReloader = nullptr; // 开发模式才创建
     PlayerItem *m_playerItem = nullptr;
 
-    int m_playerX = 0;
-    int m_playerY = 0;
-    bool m_isMoving = false;
+    // 精灵动画：所有角色共用一个时钟，每帧推进一次
+    SpriteAnimator m_animator;
+    SpriteClips m_playerClips;
+    int m_playerSprite = -1;        // 没有精灵图时为 -1，玩家画成红圈
+    int m_idleMs = 0;               // 玩家停下来多久了
+    SpriteSheetPtr m_playerSheet;   // 没有精灵图时是红圈切成的一帧
+    SpriteSheetPtr m_customerSheet; // 玩家精灵图按顾客的四种心情着色
+
+    // 模拟线程和它最近一次发布的状态
+    SimulationThread *m_simThread = nullptr;
+    SimSnapshot m_snapshot;
+    int m_mapGeneration = 0;        // 每次 enterMap 加一，模拟还在旧地图上的状态和事件不用
+    bool m_applyingSimEdit = false; // 正在把模拟的瓦片修改写进 m_map，不用再同步回去
+
+    // 输入录制 / 回放
+    bool m_recording = false;
+    bool m_replaying = false;
+    InputLog m_replay;
+    QString m_replayCsv;
+    QElapsedTimer m_replayClock;
+    QVector<FrameProfiler::Sample> m_replayFrames; // 回放的每一帧
+
+    // 局域网联机
+    NetHost *m_netHost = nullptr;
+    NetClient *m_netClient = nullptr;
+    int m_netId = -1;               // 本机玩家的编号，没联机时为 -1
+    EntityLayerItem *m_playersItem = nullptr; // 别的玩家
+    QVector<EntitySprite> m_playerSprites;
+
+    // 摄像机与帧循环
+    Camera m_camera;
+    int m_zoomStep = 0;      // 0 为原尺寸
+    QTimer *m_frameTimer;
+    QElapsedTimer m_frameClock;
+
+    ProfilerOverlay *m_profilerOverlay; // 性能面板（F3）
+
+    // 视野与战争迷雾
+    FieldOfView *m_fov = nullptr;   // 属于 m_current
+    FogOfWarItem *m_fogItem = nullptr;
+    CrowdItem *m_crowdItem = nullptr;
+
+    Minimap *m_minimap; // 小地图（M 键开关）
+
+    ItemDatabase m_itemDb;  // 物品类型和动作（items.json）
 
     // 物品栏UI成员
     QWidget *m_inventoryWidget;
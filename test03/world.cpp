@@ -0,0 +1,195 @@
+// world.cpp - 多地图世界的布局实现
+#include "world.h"
+#include "assetpack.h"
+#include "tracing.h"
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+bool World::load(const QString &fileName)
+{
+    TRACE_SCOPE("World::load");
+    const QByteArray bytes = AssetPack::instance().data(fileName);
+    if (bytes.isNull())
+    {
+        qWarning() << "Cannot open world file" << fileName;
+        return false;
+    }
+
+    QJsonParseError err;
+    const QJsonDocument doc = QJsonDocument::fromJson(bytes, &err);
+    if (doc.isNull() || !doc.isObject())
+    {
+        qWarning() << "Invalid world file" << fileName << err.errorString();
+        return false;
+    }
+
+    // 路径相对于 .world 文件所在目录
+    const QDir dir = QFileInfo(fileName).absoluteDir();
+    auto absolute = [&dir](const QString &path) {
+        return QDir::cleanPath(dir.absoluteFilePath(path));
+    };
+
+    m_maps.clear();
+    m_doors.clear();
+    const QJsonObject root = doc.object();
+    for (const QJsonValue &v : root.value("maps").toArray())
+    {
+        const QJsonObject o = v.toObject();
+        Entry e;
+        e.path = absolute(o.value("fileName").toString());
+        e.rect = QRect(o.value("x").toInt(), o.value("y").toInt(),
+                       o.value("width").toInt(), o.value("height").toInt());
+        m_maps.append(e);
+    }
+    for (const QJsonValue &v : root.value("doors").toArray())
+    {
+        const QJsonObject o = v.toObject();
+        WorldDoor d;
+        d.map = absolute(o.value("map").toString());
+        d.tile = QPoint(o.value("x").toInt(), o.value("y").toInt());
+        d.target = absolute(o.value("target").toString());
+        d.targetTile = QPoint(o.value("targetX").toInt(), o.value("targetY").toInt());
+        m_doors.append(d);
+    }
+
+    if (m_maps.isEmpty())
+    {
+        qWarning() << "World file has no maps:" << fileName;
+        return false;
+    }
+    qDebug() << "Loaded world with" << m_maps.size() << "maps and" << m_doors.size() << "doors";
+    return true;
+}
+
+void World::setSingleMap(const QString &tmxPath)
+{
+    m_maps.clear();
+    m_doors.clear();
+    Entry e;
+    e.path = QDir::cleanPath(QFileInfo(tmxPath).absoluteFilePath());
+    m_maps.append(e);
+}
+
+QString World::startMap() const
+{
+    return m_maps.isEmpty() ? QString() : m_maps.first().path;
+}
+
+QStringList World::maps() const
+{
+    QStringList list;
+    for (const Entry &e : m_maps)
+        list.append(e.path);
+    return list;
+}
+
+int World::indexOf(const QString &map) const
+{
+    for (int i = 0; i < m_maps.size(); ++i)
+        if (m_maps[i].path == map)
+            return i;
+    return -1;
+}
+
+QRect World::mapRect(const QString &map) const
+{
+    const int i = indexOf(map);
+    return i < 0 ? QRect() : m_maps[i].rect;
+}
+
+void World::setMapSize(const QString &map, const QSize &size)
+{
+    const int i = indexOf(map);
+    if (i >= 0 && m_maps[i].rect.isEmpty())
+        m_maps[i].rect.setSize(size);
+}
+
+QString World::mapAt(const QPoint &worldPos, const QString &exclude) const
+{
+    for (const Entry &e : m_maps)
+        if (e.path != exclude && e.rect.contains(worldPos))
+            return e.path;
+    return QString();
+}
+
+QPoint World::worldPosOf(const QString &map, const QPoint &tile, const QSize &tileSize) const
+{
+    // 取格子中心，避免落在两张地图的分界线上
+    const QRect r = mapRect(map);
+    return QPoint(r.x() + tile.x() * tileSize.width() + tileSize.width() / 2,
+                  r.y() + tile.y() * tileSize.height() + tileSize.height() / 2);
+}
+
+QPoint World::tileIn(const QString &map, const QPoint &worldPos, const QSize &tileSize) const
+{
+    const QRect r = mapRect(map);
+    if (tileSize.isEmpty())
+        return QPoint();
+    return QPoint((worldPos.x() - r.x()) / tileSize.width(), (worldPos.y() - r.y()) / tileSize.height());
+}
+
+bool World::transitionAt(const QString &map, const QPoint &tile, const QSize &tileSize,
+                         WorldTransition *out) const
+{
+    // 1. 门
+    for (const WorldDoor &d : m_doors)
+    {
+        if (d.map == map && d.tile == tile)
+        {
+            out->map = d.target;
+            out->tile = d.targetTile;
+            out->fromEdge = false;
+            return true;
+        }
+    }
+
+    // 2. 走出地图边缘：看世界坐标上挨着的地图
+    const QRect r = mapRect(map);
+    if (r.isEmpty())
+        return false;
+    const QPoint pos = worldPosOf(map, tile, tileSize);
+    if (r.contains(pos))
+        return false;
+    const QString next = mapAt(pos, map);
+    if (next.isEmpty())
+        return false;
+    out->map = next;
+    out->worldPos = pos;
+    out->fromEdge = true;
+    return true;
+}
+
+QStringList World::nearbyMaps(const QString &map, const QPoint &tile, int radius, const QSize &tileSize) const
+{
+    QStringList result;
+    for (const WorldDoor &d : m_doors)
+    {
+        if (d.map == map && qAbs(d.tile.x() - tile.x()) <= radius && qAbs(d.tile.y() - tile.y()) <= radius &&
+            !result.contains(d.target))
+            result.append(d.target);
+    }
+
+    const QRect r = mapRect(map);
+    if (r.isEmpty() || tileSize.isEmpty())
+        return result;
+
+    // 离哪条边不超过 radius 格，就看那条边外面一格是哪张地图
+    const int w = r.width() / tileSize.width();
+    const int h = r.height() / tileSize.height();
+    QVector<QPoint> probes;
+    if (tile.x() <= radius)         probes.append(QPoint(-1, tile.y()));
+    if (tile.x() >= w - 1 - radius) probes.append(QPoint(w, tile.y()));
+    if (tile.y() <= radius)         probes.append(QPoint(tile.x(), -1));
+    if (tile.y() >= h - 1 - radius) probes.append(QPoint(tile.x(), h));
+    for (const QPoint &p : probes)
+    {
+        const QString next = mapAt(worldPosOf(map, p, tileSize), map);
+        if (!next.isEmpty() && !result.contains(next))
+            result.append(next);
+    }
+    return result;
+}
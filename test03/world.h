@@ -0,0 +1,77 @@
+// world.h - 多地图世界的布局
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QRect>
+#include <QSize>
+
+/* 门：踩到 map 上的 tile 时传送到 target 的 targetTile */
+struct WorldDoor
+{
+    QString map;
+    QPoint tile;
+    QString target;
+    QPoint targetTile;
+};
+
+/* 一次地图切换 */
+struct WorldTransition
+{
+    QString map;        // 目标地图
+    QPoint tile;        // 目标格子（走出边缘时由 tileIn() 按目标地图的格子大小换算）
+    QPoint worldPos;    // 走出边缘时的世界坐标（像素）
+    bool fromEdge = false;
+};
+
+/*
+ World：读取 Tiled 的 .world 文件（JSON），描述多张地图在世界中的摆放位置
+ {
+   "type": "world",
+   "maps": [ { "fileName": "c.tmx", "x": 0, "y": 0, "width": 960, "height": 640 }, ... ],
+   "doors": [ { "map": "c.tmx", "x": 3, "y": 4, "target": "house.tmx", "targetX": 1, "targetY": 8 } ]
+ }
+ - 相邻地图靠世界坐标拼接：走出一张地图的边缘，就进入世界坐标上挨着的那张
+ - "doors" 是我们自己加的字段（Tiled 会原样保留），用于不相邻地图之间的传送
+ 所有路径都换算成绝对路径，作为地图的唯一标识。
+*/
+class World
+{
+public:
+    bool load(const QString &fileName);
+    /* 只有一张地图的世界（没有 .world 文件时使用） */
+    void setSingleMap(const QString &tmxPath);
+
+    QString startMap() const;
+    QStringList maps() const;
+    QRect mapRect(const QString &map) const;
+    /* .world 里没写尺寸的地图，加载后补上（像素） */
+    void setMapSize(const QString &map, const QSize &size);
+
+    /* 世界坐标（像素）所在的地图，exclude 不参与查找 */
+    QString mapAt(const QPoint &worldPos, const QString &exclude = QString()) const;
+    /* 世界坐标换算成某张地图上的格子 */
+    QPoint tileIn(const QString &map, const QPoint &worldPos, const QSize &tileSize) const;
+
+    /* 玩家要走到 map 的 tile（可以在地图外）时是否切换地图 */
+    bool transitionAt(const QString &map, const QPoint &tile, const QSize &tileSize,
+                      WorldTransition *out) const;
+    /* 距离 tile 不超过 radius 格的门和边缘通往的地图（用于预加载） */
+    QStringList nearbyMaps(const QString &map, const QPoint &tile, int radius, const QSize &tileSize) const;
+
+private:
+    struct Entry
+    {
+        QString path;
+        QRect rect;    // 世界坐标（像素）
+    };
+    int indexOf(const QString &map) const;
+    QPoint worldPosOf(const QString &map, const QPoint &tile, const QSize &tileSize) const;
+
+    QVector<Entry> m_maps;
+    QVector<WorldDoor> m_doors;
+};
+
+#endif // WORLD_H
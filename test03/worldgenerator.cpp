@@ -0,0 +1,377 @@
+/* worldgenerator.cpp - 程序化街区生成器实现
+生成一个区块的步骤：
+1. 元胞自动机：在区块外扩 CA_MARGIN 格的范围内初始化并迭代，得到建筑轮廓
+2. 逐格确定地面（街道/人行道/草地/广场）、建筑（墙/屋顶）、摊位
+3. 空地按行扫描做波函数坍缩，摆放装饰
+所有随机数都是全局坐标的哈希，区块之间没有任何共享状态。
+*/
+#include "worldgenerator.h"
+#include <QtConcurrent>
+#include <QDebug>
+#include <vector>
+
+namespace {
+const int CA_ITERATIONS = 4;
+// 每迭代一次，边界误差向内传播一格：迭代完外面 CA_ITERATIONS 圈不可信；
+// 区块边上的格子判断墙还是屋顶要看外面一圈，所以再多算一圈
+const int CA_MARGIN = CA_ITERATIONS + 1;
+
+// 不同用途的随机数用不同的 salt，互不相关
+const quint32 SALT_NOISE = 1;
+const quint32 SALT_CA = 2;
+const quint32 SALT_STALL = 3;
+const quint32 SALT_WFC = 4;
+
+enum Layers { GroundLayer, DecorationLayer, ObstacleLayer, LayerCount };
+
+/* 装饰瓦片（波函数坍缩的候选） */
+enum Deco { DecoNone, DecoTuft, DecoFlower, DecoBush, DecoFenceLeft, DecoFenceMid, DecoFenceRight, DecoCount };
+
+inline bool isFence(int d) { return d >= DecoFenceLeft; }
+inline bool continuesFence(int d) { return d == DecoFenceLeft || d == DecoFenceMid; }
+
+/* SplitMix64 的混合函数：输入相差 1 位，输出约一半的位会翻转 */
+inline quint64 mix64(quint64 x)
+{
+    x ^= x >> 30; x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27; x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+/* 向负无穷取整的除法 / 取模，负坐标的街区也能正确对齐 */
+inline int floorDiv(int a, int b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+inline int floorMod(int a, int b) { int m = a % b; return m < 0 ? m + b : m; }
+
+inline float smooth(float t) { return t * t * (3.0f - 2.0f * t); }
+}
+
+/* 区块写入的目标：直接指向街区图层数据，区块之间写的区域互不重叠 */
+struct WorldGenerator::ChunkOutput
+{
+    int *layer[LayerCount];
+    quint8 *collision;
+    int stride;        // 街区宽度
+    QPoint origin;     // 街区左上角的全局格子坐标
+};
+
+WorldGenerator::WorldGenerator(const GeneratorConfig &config) : m_config(config) {}
+
+quint64 WorldGenerator::hash(int gx, int gy, quint32 salt) const
+{
+    quint64 key = (quint64(quint32(gx)) << 32) | quint32(gy);
+    return mix64(m_config.seed ^ mix64(key ^ (quint64(salt) << 59 | salt)));
+}
+
+float WorldGenerator::random01(int gx, int gy, quint32 salt) const
+{
+    return float(hash(gx, gy, salt) >> 40) / float(1 << 24);
+}
+
+float WorldGenerator::noise(int gx, int gy) const
+{
+    // 两个倍频的 value noise：大尺度决定城区类型，小尺度加一点变化
+    static const int scales[2] = { 48, 16 };
+    static const float weights[2] = { 0.7f, 0.3f };
+    float sum = 0;
+    for (int o = 0; o < 2; ++o)
+    {
+        const int s = scales[o];
+        const int ix = floorDiv(gx, s);
+        const int iy = floorDiv(gy, s);
+        const float tx = smooth(float(floorMod(gx, s)) / s);
+        const float ty = smooth(float(floorMod(gy, s)) / s);
+        const quint32 salt = SALT_NOISE + 16 * o;
+        const float a = random01(ix, iy, salt);
+        const float b = random01(ix + 1, iy, salt);
+        const float c = random01(ix, iy + 1, salt);
+        const float d = random01(ix + 1, iy + 1, salt);
+        sum += weights[o] * ((a + (b - a) * tx) * (1 - ty) + (c + (d - c) * tx) * ty);
+    }
+    return sum;
+}
+
+WorldGenerator::Zone WorldGenerator::zoneAt(int gx, int gy) const
+{
+    // 以街区中心的噪声决定整个街区的类型，避免一个街区里混着公园和集市
+    const int s = m_config.blockSize;
+    const float n = noise(floorDiv(gx, s) * s + s / 2, floorDiv(gy, s) * s + s / 2);
+    if (n < 0.38f) return Park;
+    if (n > 0.58f) return Market;
+    return Residential;
+}
+
+bool WorldGenerator::isStreet(int gx, int gy) const
+{
+    return floorMod(gx, m_config.blockSize) < m_config.streetWidth ||
+           floorMod(gy, m_config.blockSize) < m_config.streetWidth;
+}
+
+bool WorldGenerator::isSidewalk(int gx, int gy) const
+{
+    if (isStreet(gx, gy))
+        return false;
+    const int mx = floorMod(gx, m_config.blockSize);
+    const int my = floorMod(gy, m_config.blockSize);
+    const int w = m_config.streetWidth;
+    const int last = m_config.blockSize - 1;
+    return mx == w || mx == last || my == w || my == last;
+}
+
+GeneratedDistrict WorldGenerator::generateDistrict(const QPoint &originChunk,
+                                                   int widthChunks, int heightChunks) const
+{
+    GeneratedDistrict d;
+    const int cs = m_config.chunkSize;
+    d.originChunk = originChunk;
+    d.width = widthChunks * cs;
+    d.height = heightChunks * cs;
+    if (widthChunks <= 0 || heightChunks <= 0)
+        return d;
+
+    const int cells = d.width * d.height;
+    d.collision.fill(0, cells);
+
+    // 工作线程先写普通的 int 数组，全部完成后再压缩成图层存储
+    QVector<int> grids[LayerCount];
+    for (int i = 0; i < LayerCount; ++i)
+        grids[i].fill(0, cells);
+
+    // 在主线程取出裸指针（这里会完成 detach），工作线程只写各自区块的格子
+    ChunkOutput out;
+    for (int i = 0; i < LayerCount; ++i)
+        out.layer[i] = grids[i].data();
+    out.collision = d.collision.data();
+    out.stride = d.width;
+    out.origin = originChunk * cs;
+
+    QVector<QPoint> chunks;
+    chunks.reserve(widthChunks * heightChunks);
+    for (int cy = 0; cy < heightChunks; ++cy)
+        for (int cx = 0; cx < widthChunks; ++cx)
+            chunks.append(originChunk + QPoint(cx, cy));
+
+    // 每个区块的摊位点单独收集，最后按区块顺序合并，结果与线程调度无关
+    QVector<QVector<QPoint>> stalls(chunks.size());
+    QVector<int> indices(chunks.size());
+    for (int i = 0; i < indices.size(); ++i)
+        indices[i] = i;
+
+    QtConcurrent::blockingMap(indices, [&](int i) {
+        generateChunk(chunks[i], out, stalls[i]);
+    });
+
+    static const char *names[LayerCount] = { "Ground", "Decoration", "Obstacle" };
+    for (int i = 0; i < LayerCount; ++i)
+    {
+        Layer lay;
+        lay.name = names[i];
+        lay.width = d.width;
+        lay.height = d.height;
+        lay.data = LayerData(d.width, d.height, grids[i]);
+        d.layers.append(lay);
+    }
+
+    for (const QVector<QPoint> &s : stalls)
+        d.stallSites += s;
+    return d;
+}
+
+QFuture<GeneratedDistrict> WorldGenerator::generateDistrictAsync(const QPoint &originChunk,
+                                                                 int widthChunks, int heightChunks) const
+{
+    const WorldGenerator gen(m_config);
+    return QtConcurrent::run([gen, originChunk, widthChunks, heightChunks]() {
+        return gen.generateDistrict(originChunk, widthChunks, heightChunks);
+    });
+}
+
+void WorldGenerator::generateChunk(const QPoint &chunk, const ChunkOutput &out,
+                                   QVector<QPoint> &stalls) const
+{
+    const GeneratorPalette &pal = m_config.palette;
+    const int cs = m_config.chunkSize;
+    const int gx0 = chunk.x() * cs;
+    const int gy0 = chunk.y() * cs;
+    const int span = cs + 2 * CA_MARGIN;
+
+    /* 1. 元胞自动机：初始密度由城区类型决定，街道和人行道上永远没有建筑 */
+    std::vector<quint8> cur(span * span), next(span * span);
+    std::vector<quint8> buildable(span * span);
+    for (int j = 0; j < span; ++j)
+    {
+        for (int i = 0; i < span; ++i)
+        {
+            const int gx = gx0 - CA_MARGIN + i;
+            const int gy = gy0 - CA_MARGIN + j;
+            const bool canBuild = !isStreet(gx, gy) && !isSidewalk(gx, gy);
+            float density = 0;
+            if (canBuild)
+            {
+                Zone z = zoneAt(gx, gy);
+                density = z == Residential ? 0.56f : (z == Market ? 0.32f : 0.0f);
+            }
+            buildable[j * span + i] = canBuild;
+            cur[j * span + i] = canBuild && random01(gx, gy, SALT_CA) < density;
+        }
+    }
+
+    // 4-5 规则：周围 ≥5 个建筑则变成建筑，原本是建筑且周围 ≥4 则保留
+    // 最外一圈不更新，误差每轮向内一格，迭代完外面 CA_ITERATIONS 圈以内的结果与相邻区块一致
+    for (int it = 0; it < CA_ITERATIONS; ++it)
+    {
+        next = cur;
+        for (int j = 1; j < span - 1; ++j)
+        {
+            for (int i = 1; i < span - 1; ++i)
+            {
+                const int k = j * span + i;
+                if (!buildable[k]) { next[k] = 0; continue; }
+                const int n = cur[k - span - 1] + cur[k - span] + cur[k - span + 1]
+                            + cur[k - 1] + cur[k + 1]
+                            + cur[k + span - 1] + cur[k + span] + cur[k + span + 1];
+                next[k] = n >= 5 || (cur[k] && n >= 4);
+            }
+        }
+        cur.swap(next);
+    }
+
+    /* 2. 地面、建筑、摊位 */
+    std::vector<quint8> decoratable(cs * cs);
+    std::vector<Zone> zones(cs * cs);
+    for (int j = 0; j < cs; ++j)
+    {
+        for (int i = 0; i < cs; ++i)
+        {
+            const int gx = gx0 + i;
+            const int gy = gy0 + j;
+            const int idx = (gy - out.origin.y()) * out.stride + (gx - out.origin.x());
+            const int k = (j + CA_MARGIN) * span + (i + CA_MARGIN);
+            const Zone zone = zoneAt(gx, gy);
+            zones[j * cs + i] = zone;
+
+            int ground;
+            if (isStreet(gx, gy)) ground = pal.street;
+            else if (isSidewalk(gx, gy)) ground = pal.sidewalk;
+            else ground = zone == Market ? pal.plaza : pal.grass;
+            out.layer[GroundLayer][idx] = pal.firstGid + ground;
+
+            if (cur[k])
+            {
+                // 建筑边缘是墙，内部是屋顶
+                const bool edge = !cur[k - 1] || !cur[k + 1] || !cur[k - span] || !cur[k + span];
+                out.layer[ObstacleLayer][idx] = pal.firstGid + (edge ? pal.wall : pal.roof);
+                out.collision[idx] = 1;
+            }
+            else if (zone == Market && isSidewalk(gx, gy) && floorMod(gx + gy, 3) == 0 &&
+                     random01(gx, gy, SALT_STALL) < 0.35f)
+            {
+                out.layer[ObstacleLayer][idx] = pal.firstGid + pal.stall;
+                out.collision[idx] = 1;
+                stalls.append(QPoint(gx - out.origin.x(), gy - out.origin.y()));
+            }
+            else
+            {
+                decoratable[j * cs + i] = !isStreet(gx, gy) && !isSidewalk(gx, gy);
+            }
+        }
+    }
+
+    /* 3. 波函数坍缩（按行扫描）
+     每个格子的候选集合由已经确定的左、上邻居约束：
+     - 栅栏左端/中段的右边必须是栅栏中段/右端，其余瓦片右边不能接栅栏中段/右端
+     - 栅栏不能上下相叠，灌木不能上下相叠
+     再加一步前瞻：右边不能放装饰或右上是栅栏时，不允许开始/延续栅栏。
+     这样候选集合永远非空，不需要回溯。区块边界外视为空，保证区块独立。*/
+    static const int weights[3][DecoCount] = {
+        // None Tuft Flower Bush FenceL FenceM FenceR
+        {  60,  14,   10,    8,    3,     4,     4 },   // Park
+        {  76,  10,    6,    4,    2,     2,     2 },   // Residential
+        {  86,   5,    4,    2,    1,     2,     2 },   // Market
+    };
+    const int decoGid[DecoCount] = {
+        0, pal.tuft, pal.flower, pal.bush, pal.fenceLeft, pal.fenceMid, pal.fenceRight
+    };
+
+    std::vector<quint8> deco(cs * cs, DecoNone);
+    for (int j = 0; j < cs; ++j)
+    {
+        for (int i = 0; i < cs; ++i)
+        {
+            const int c = j * cs + i;
+            if (!decoratable[c])
+                continue;
+
+            const int left = i > 0 ? int(deco[c - 1]) : int(DecoNone);
+            const int up = j > 0 ? int(deco[c - cs]) : int(DecoNone);
+            const int upRight = (j > 0 && i + 1 < cs) ? int(deco[c - cs + 1]) : int(DecoNone);
+            const bool rightOpen = i + 1 < cs && decoratable[c + 1] && !isFence(upRight);
+
+            bool allowed[DecoCount];
+            for (int t = 0; t < DecoCount; ++t)
+            {
+                bool ok = continuesFence(left) ? (t == DecoFenceMid || t == DecoFenceRight)
+                                               : (t != DecoFenceMid && t != DecoFenceRight);
+                if (isFence(t) && isFence(up)) ok = false;
+                if (t == DecoBush && up == DecoBush) ok = false;
+                if (continuesFence(t) && !rightOpen) ok = false;
+                allowed[t] = ok;
+            }
+
+            const int *w = weights[zones[c]];
+            int total = 0;
+            for (int t = 0; t < DecoCount; ++t)
+                if (allowed[t]) total += w[t];
+
+            const int gx = gx0 + i;
+            const int gy = gy0 + j;
+            int pick = int(random01(gx, gy, SALT_WFC) * total);
+            int chosen = DecoNone;
+            for (int t = 0; t < DecoCount; ++t)
+            {
+                if (!allowed[t]) continue;
+                if (pick < w[t]) { chosen = t; break; }
+                pick -= w[t];
+            }
+            deco[c] = quint8(chosen);
+
+            if (chosen == DecoNone)
+                continue;
+            const int idx = (gy - out.origin.y()) * out.stride + (gx - out.origin.x());
+            const int gid = pal.firstGid + decoGid[chosen];
+            if (chosen == DecoTuft || chosen == DecoFlower)
+            {
+                out.layer[DecorationLayer][idx] = gid;
+            }
+            else
+            {
+                // 灌木和栅栏挡路，和 c.tmx 一样画在 Obstacle 层
+                out.layer[ObstacleLayer][idx] = gid;
+                out.collision[idx] = 1;
+            }
+        }
+    }
+}
+
+bool WorldGenerator::applyTo(const GeneratedDistrict &district, TmxMap *map, const QString &basePath) const
+{
+    if (!map || district.width <= 0 || district.height <= 0)
+        return false;
+
+    const GeneratorPalette &pal = m_config.palette;
+    map->create(district.width, district.height, m_config.tileWidth, m_config.tileHeight, basePath);
+    if (!map->addTileset(pal.tilesetImage, pal.firstGid, m_config.tileWidth, m_config.tileHeight,
+                         pal.columns, pal.tileCount))
+        return false;
+
+    for (const Layer &lay : district.layers)
+    {
+        if (!map->addLayer(lay))
+            return false;
+    }
+
+    qDebug() << "Generated district at chunk" << district.originChunk << ":"
+             << district.width << "x" << district.height << "with"
+             << district.stallSites.size() << "stall sites";
+    return true;
+}
@@ -0,0 +1,108 @@
+// worldgenerator.h - 程序化街区生成器
+#ifndef WORLDGENERATOR_H
+#define WORLDGENERATOR_H
+
+#include <QVector>
+#include <QPoint>
+#include <QString>
+#include <QFuture>
+#include "tmxmap.h"
+
+/*
+ 生成用的瓦片（图块集内的局部编号，实际 GID = firstGid + 编号）。
+ 默认值对应 buch-outdoor.png（12 列 × 6 行），换图块集时只需改这里。
+*/
+struct GeneratorPalette
+{
+    QString tilesetImage = "tilesets/buch-outdoor.png";
+    int firstGid = 1;
+    int columns = 12;
+    int tileCount = 72;
+
+    // 地面层
+    int street = 17;      // 街道（土路）
+    int sidewalk = 5;     // 人行道（街道边缘）
+    int grass = 15;       // 公园草地
+    int plaza = 41;       // 集市广场
+    // 建筑（整块不可通行）
+    int wall = 45;
+    int roof = 57;
+    // 摊位点（放在装饰层，不可通行）
+    int stall = 22;
+    // 装饰（由波函数坍缩摆放）
+    int tuft = 3;
+    int flower = 27;
+    int bush = 60;        // 不可通行
+    int fenceLeft = 66;   // 栅栏左端 / 中段 / 右端，必须横向连成一排，不可通行
+    int fenceMid = 67;
+    int fenceRight = 68;
+};
+
+struct GeneratorConfig
+{
+    quint64 seed = 20251126;
+    int chunkSize = 32;     // 区块边长（格子），区块是并行生成的最小单位
+    int blockSize = 20;     // 街区间距：每 blockSize 格一条街
+    int streetWidth = 3;
+    int tileWidth = 32;
+    int tileHeight = 32;
+    GeneratorPalette palette;
+};
+
+/* 生成结果：与 TmxMap 的图层格式一致，另附碰撞格和摊位点 */
+struct GeneratedDistrict
+{
+    QPoint originChunk;          // 左上角区块的全局坐标
+    int width = 0;               // 格子数
+    int height = 0;
+    QVector<Layer> layers;       // Ground / Decoration / Obstacle
+    QVector<quint8> collision;   // 1 = 不可通行，下标 y * width + x
+    QVector<QPoint> stallSites;  // 摊位点（街区内的格子坐标）
+};
+
+/*
+ WorldGenerator：按区块生成无限延伸的城区
+ 1. 噪声（value noise）把城区划分为公园 / 住宅 / 集市
+ 2. 街道是全局网格，人行道为街道外一圈
+ 3. 建筑用元胞自动机在街区内部“长”出来
+ 4. 集市的人行道上按间隔放摊位
+ 5. 空地上的装饰用按行扫描的波函数坍缩摆放（栅栏必须连成一排等约束）
+ 所有随机数都来自 (世界种子, 全局格子坐标) 的哈希，因此：
+ - 结果与线程数、生成顺序无关
+ - 相邻区块、相邻街区在边界上无缝衔接（元胞自动机在区块外多算一圈来保证这一点）
+ 区块之间互不依赖，用 QtConcurrent 分给所有核心并行生成。
+*/
+class WorldGenerator
+{
+public:
+    explicit WorldGenerator(const GeneratorConfig &config = GeneratorConfig());
+
+    const GeneratorConfig &config() const { return m_config; }
+
+    /* 生成 widthChunks × heightChunks 个区块组成的街区（阻塞，内部多线程） */
+    GeneratedDistrict generateDistrict(const QPoint &originChunk, int widthChunks, int heightChunks) const;
+
+    /* 在后台线程生成，玩家靠近之前提前调用 */
+    QFuture<GeneratedDistrict> generateDistrictAsync(const QPoint &originChunk,
+                                                     int widthChunks, int heightChunks) const;
+
+    /* 把生成结果装入 TmxMap（不经过 XML），basePath 用于解析图块集相对路径 */
+    bool applyTo(const GeneratedDistrict &district, TmxMap *map, const QString &basePath) const;
+
+private:
+    enum Zone { Park, Residential, Market };
+    struct ChunkOutput;
+
+    void generateChunk(const QPoint &chunk, const ChunkOutput &out, QVector<QPoint> &stalls) const;
+
+    Zone zoneAt(int gx, int gy) const;
+    bool isStreet(int gx, int gy) const;
+    bool isSidewalk(int gx, int gy) const;
+    float noise(int gx, int gy) const;                      // 0~1 的平滑噪声
+    quint64 hash(int gx, int gy, quint32 salt) const;       // 坐标哈希
+    float random01(int gx, int gy, quint32 salt) const;     // 0~1 的坐标随机数
+
+    GeneratorConfig m_config;
+};
+
+#endif // WORLDGENERATOR_H